@@ -0,0 +1,37 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include "oneflow/api/python/of_api_registry.h"
+#include "oneflow/core/framework/ddp_reducer.h"
+#include "oneflow/core/framework/tensor.h"
+
+namespace py = pybind11;
+
+namespace oneflow {
+
+ONEFLOW_API_PYBIND11_MODULE("", m) {
+  py::class_<one::DDPReducer, std::shared_ptr<one::DDPReducer>>(m, "DDPReducer")
+      .def(py::init([](const std::vector<std::shared_ptr<one::Tensor>>& params,
+                       int64_t bucket_cap_bytes) {
+        return one::DDPReducer::New(params, bucket_cap_bytes).GetPtrOrThrow();
+      }))
+      .def("reset", &one::DDPReducer::Reset)
+      .def_property_readonly("num_buckets", &one::DDPReducer::num_buckets)
+      .def("bucket_param_indices", &one::DDPReducer::bucket_param_indices);
+}
+
+}  // namespace oneflow
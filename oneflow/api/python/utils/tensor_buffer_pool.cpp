@@ -0,0 +1,42 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <pybind11/pybind11.h>
+#include "oneflow/api/python/of_api_registry.h"
+#include "oneflow/core/common/tensor_buffer_pool.h"
+
+namespace py = pybind11;
+
+namespace oneflow {
+
+ONEFLOW_API_PYBIND11_MODULE("", m) {
+  m.def("GetTensorBufferPoolStats", []() {
+    const TensorBufferPoolStats stats = TensorBufferPool::Get()->GetStats();
+    py::dict ret;
+    ret["num_allocations"] = stats.num_allocations;
+    ret["num_deallocations"] = stats.num_deallocations;
+    ret["num_thread_cache_hits"] = stats.num_thread_cache_hits;
+    ret["num_pool_hits"] = stats.num_pool_hits;
+    ret["num_system_allocations"] = stats.num_system_allocations;
+    ret["num_system_deallocations"] = stats.num_system_deallocations;
+    ret["num_bytes_in_use"] = stats.num_bytes_in_use;
+    ret["num_bytes_cached"] = stats.num_bytes_cached;
+    ret["pinned"] = TensorBufferPool::Get()->pinned();
+    return ret;
+  });
+  m.def("TrimTensorBufferPool", []() { TensorBufferPool::Get()->Trim(); });
+}
+
+}  // namespace oneflow
@@ -28,6 +28,7 @@ limitations under the License.
 #include "oneflow/core/framework/dtype.h"
 #include "oneflow/core/framework/instructions_builder.h"
 #include "oneflow/core/framework/tensor.h"
+#include "oneflow/core/framework/tensor_methods.h"
 #include "oneflow/core/framework/nd_sbp.h"
 #include "oneflow/core/functional/functional_api.yaml.h"
 #include "oneflow/core/framework/stride.h"
@@ -89,6 +90,12 @@ inline Maybe<void> CopyBetweenMirroredTensorAndNumpy(
   CHECK_OR_RETURN(t->is_eager()) << "eager tensors supported only";
   if (t->is_local()) {
     tensor = JUST(t->AsMirroredTensor());
+    if (!JUST(IsContiguous(t))) {
+      // Numpy arrays are copied as contiguous memory, so read views through a contiguous copy.
+      CHECK_OR_RETURN(modifier == "const")
+          << "copying to non-contiguous tensor is not supported, call contiguous() first";
+      tensor = JUST(JUST(functional::ToContiguous(t))->AsMirroredTensor());
+    }
   } else {
     const Symbol<ConsistentTensorMeta>& tensor_meta = JUST(t->consistent_tensor_meta());
     const Symbol<cfg::NdSbp>& nd_sbp = tensor_meta->nd_sbp();
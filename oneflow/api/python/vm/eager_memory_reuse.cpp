@@ -0,0 +1,47 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <pybind11/pybind11.h>
+#include "oneflow/api/python/of_api_registry.h"
+#include "oneflow/core/common/global.h"
+#include "oneflow/core/eager/eager_memory_reuse.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace py = pybind11;
+
+namespace oneflow {
+namespace vm {
+
+ONEFLOW_API_PYBIND11_MODULE("vm", m) {
+  m.def("SetEagerMemoryReuseEnabled", [](bool enabled) { SetEagerMemoryReuseEnabled(enabled); });
+  m.def("IsEagerMemoryReuseEnabled", []() { return IsEagerMemoryReuseEnabled(); });
+  m.def("GetEagerMemoryStats", []() {
+    const EagerMemoryReuseStats stats = GetEagerMemoryReuseStats();
+    const auto* cpu_allocator = Global<CpuAllocator>::Get();
+    py::dict ret;
+    ret["num_reused_blobs"] = stats.num_reused_blobs;
+    ret["num_reused_bytes"] = stats.num_reused_bytes;
+    ret["cpu_live_bytes"] = cpu_allocator->live_bytes();
+    ret["cpu_peak_bytes"] = cpu_allocator->peak_bytes();
+    return ret;
+  });
+  m.def("ResetEagerMemoryStats", []() {
+    ResetEagerMemoryReuseStats();
+    Global<CpuAllocator>::Get()->ResetPeakBytes();
+  });
+}
+
+}  // namespace vm
+}  // namespace oneflow
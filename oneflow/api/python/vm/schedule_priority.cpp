@@ -0,0 +1,90 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <memory>
+#include <pybind11/pybind11.h>
+#include "oneflow/api/python/of_api_registry.h"
+#include "oneflow/core/framework/device.h"
+#include "oneflow/core/vm/schedule_priority.h"
+#include "oneflow/core/vm/virtual_machine.h"
+
+namespace py = pybind11;
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+// A python context manager, the priority is set in __enter__ and restored in __exit__ rather than
+// when the object is created and collected.
+class SchedulePriorityScope final {
+ public:
+  explicit SchedulePriorityScope(SchedulePriority priority) : priority_(priority) {}
+  ~SchedulePriorityScope() = default;
+
+  Maybe<void> Enter() {
+    CHECK_OR_RETURN(!guard_) << "schedule_priority is already entered";
+    guard_.reset(new SchedulePriorityGuard(priority_));
+    return Maybe<void>::Ok();
+  }
+  void Exit() { guard_.reset(); }
+
+ private:
+  SchedulePriority priority_;
+  std::unique_ptr<SchedulePriorityGuard> guard_;
+};
+
+Maybe<SchedulePriorityScope> MakeSchedulePriorityScope(const std::string& priority) {
+  return std::make_shared<SchedulePriorityScope>(JUST(ParseSchedulePriority(priority)));
+}
+
+std::string ThreadLocalSchedulePriorityName() {
+  switch (ThreadLocalSchedulePriority()) {
+    case kLowSchedulePriority: return "low";
+    case kNormalSchedulePriority: return "normal";
+    case kHighSchedulePriority: return "high";
+    default: return "stream";
+  }
+}
+
+Maybe<void> SetStreamSchedulePriority(const std::string& device_type,
+                                      const std::string& priority) {
+  const auto& instr_type_name = JUST(GetLocalCallInstructionName(device_type));
+  auto* vm = JUST(GlobalMaybe<VirtualMachine>())->mut_vm();
+  return vm->SetStreamSchedulePriority(instr_type_name, JUST(ParseSchedulePriority(priority)));
+}
+
+}  // namespace
+
+ONEFLOW_API_PYBIND11_MODULE("vm", m) {
+  py::class_<SchedulePriorityScope, std::shared_ptr<SchedulePriorityScope>>(
+      m, "SchedulePriorityScope")
+      .def(py::init([](const std::string& priority) {
+        return MakeSchedulePriorityScope(priority).GetPtrOrThrow();
+      }))
+      .def("__enter__", [](SchedulePriorityScope* scope) { scope->Enter().GetOrThrow(); })
+      .def("__exit__", [](SchedulePriorityScope* scope, const py::object& type,
+                          const py::object& value, const py::object& traceback) { scope->Exit(); });
+  // The priority instructions built on this thread get, "stream" if they take the priority of
+  // their streams.
+  m.def("ThreadLocalSchedulePriority", &ThreadLocalSchedulePriorityName);
+  m.def("SetStreamSchedulePriority", [](const std::string& device_type,
+                                        const std::string& priority) {
+    return SetStreamSchedulePriority(device_type, priority).GetOrThrow();
+  });
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -59,8 +59,10 @@ Maybe<void> CopyOrAccGrad(AutogradMeta* autograd_meta, bool autograd_mode) {
         functional::Add(autograd_meta->acc_grad(), current_grad, /*alpha=*/1, /*inplace=*/false));
     JUST(autograd_meta->set_acc_grad(output));
   } else {
-    JUST(autograd_meta->set_acc_grad(current_grad));
+    // Gradients may be views of other tensors, which must not be updated in place through them.
+    JUST(autograd_meta->set_acc_grad(JUST(functional::ToContiguous(current_grad))));
   }
+  for (const auto& hook : autograd_meta->post_acc_grad_hooks()) { JUST(hook()); }
   return Maybe<void>::Ok();
 }
 
@@ -0,0 +1,105 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/attr_map.h"
+#include "oneflow/core/framework/op_expr_grad_function.h"
+#include "oneflow/core/framework/op_builder.h"
+#include "oneflow/core/framework/op_interpreter/op_interpreter_util.h"
+#include "oneflow/core/framework/op_expr.h"
+#include "oneflow/core/functional/functional.h"
+
+namespace oneflow {
+namespace one {
+
+struct EmbeddingLookupCaptureState : public AutoGradCaptureState {
+  bool requires_grad;
+  std::string name;
+  int64_t embedding_dim;
+  std::string optimizer;
+  float epsilon;
+};
+
+// The backward of embedding_lookup updates the rows in place by embedding_update, and the gradient
+// of shadow is zeros.
+class EmbeddingLookup : public OpExprGradFunction<EmbeddingLookupCaptureState> {
+ public:
+  Maybe<void> Init(const OpExpr& op) override;
+  Maybe<void> Capture(EmbeddingLookupCaptureState* ctx, const TensorTuple& inputs,
+                      const TensorTuple& outputs, const AttrMap& attrs) const override;
+  Maybe<void> Apply(const EmbeddingLookupCaptureState* ctx, const TensorTuple& out_grads,
+                    TensorTuple* in_grads) const override;
+
+ private:
+  AttrMap base_attrs_;
+  std::shared_ptr<OpExpr> update_op_;
+};
+
+Maybe<void> EmbeddingLookup::Init(const OpExpr& op) {
+  const auto* fw_op_expr = dynamic_cast<const UserOpExpr*>(&op);
+  CHECK_NOTNULL_OR_RETURN(fw_op_expr);
+  base_attrs_ = MakeAttrMapFromUserOpConf(fw_op_expr->proto());
+  update_op_ = JUST(one::OpBuilder("embedding_update", GradientOpName(fw_op_expr->op_name()))
+                        .Input("unique_ids")
+                        .Input("inverse_indices")
+                        .Input("num_unique")
+                        .Input("embedding_grad")
+                        .Input("learning_rate")
+                        .Build());
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> EmbeddingLookup::Capture(EmbeddingLookupCaptureState* ctx, const TensorTuple& inputs,
+                                     const TensorTuple& outputs, const AttrMap& attrs) const {
+  CHECK_EQ_OR_RETURN(inputs.size(), 3);
+  CHECK_EQ_OR_RETURN(outputs.size(), 4);
+  ctx->requires_grad = inputs.at(0)->requires_grad();
+  if (!ctx->requires_grad) { return Maybe<void>::Ok(); }
+  ctx->SaveTensorForBackward(inputs.at(0));
+  ctx->SaveTensorForBackward(outputs.at(1));
+  ctx->SaveTensorForBackward(outputs.at(2));
+  ctx->SaveTensorForBackward(outputs.at(3));
+  ctx->SaveTensorForBackward(inputs.at(2));
+  ComposedAttrMap composed_attrs(attrs, base_attrs_);
+  ctx->name = JUST(composed_attrs.GetAttr<std::string>("name"));
+  ctx->embedding_dim = JUST(composed_attrs.GetAttr<int64_t>("embedding_dim"));
+  ctx->optimizer = JUST(composed_attrs.GetAttr<std::string>("optimizer"));
+  ctx->epsilon = JUST(composed_attrs.GetAttr<float>("epsilon"));
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> EmbeddingLookup::Apply(const EmbeddingLookupCaptureState* ctx,
+                                   const TensorTuple& out_grads, TensorTuple* in_grads) const {
+  if (!ctx->requires_grad) { return Maybe<void>::Ok(); }
+  CHECK_EQ_OR_RETURN(out_grads.size(), 4);
+  const auto& shadow = ctx->SavedTensors().at(0);
+  MutableAttrMap attrs;
+  JUST(attrs.SetAttr<std::string>("name", ctx->name));
+  JUST(attrs.SetAttr<int64_t>("embedding_dim", ctx->embedding_dim));
+  JUST(attrs.SetAttr<std::string>("optimizer", ctx->optimizer));
+  JUST(attrs.SetAttr<float>("epsilon", ctx->epsilon));
+  JUST(OpInterpUtil::Dispatch<TensorTuple>(
+      *update_op_,
+      {ctx->SavedTensors().at(1), ctx->SavedTensors().at(2), ctx->SavedTensors().at(3),
+       out_grads.at(0), ctx->SavedTensors().at(4)},
+      attrs));
+  in_grads->resize(3);
+  in_grads->at(0) = JUST(functional::ZerosLike(shadow));
+  return Maybe<void>::Ok();
+}
+
+REGISTER_OP_EXPR_GRAD_FUNCTION("embedding_lookup", EmbeddingLookup);
+
+}  // namespace one
+}  // namespace oneflow
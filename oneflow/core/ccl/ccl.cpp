@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/ccl/ccl.h"
+#include "oneflow/core/ccl/cpu_shm_comm.h"
 #include "oneflow/core/device/nccl_util.h"
 #include "oneflow/core/framework/transport_util.h"
 #include "oneflow/core/job/parallel_desc.h"
@@ -50,8 +51,15 @@ int64_t RingDecrease(int64_t n, int64_t size) { return (n - 1 + size) % size; }
 
 int64_t RingIncrease(int64_t n, int64_t size) { return (n + 1 + size) % size; }
 
+constexpr size_t kParallelVecAddMinSize = 32768;
+constexpr int64_t kMaxRingChunkNum = 64;
+
 template<typename T>
 void VecAdd(size_t size, T* out, const T* in0, const T* in1) {
+  if (size < kParallelVecAddMinSize) {
+    for (size_t i = 0; i < size; ++i) { out[i] = in0[i] + in1[i]; }
+    return;
+  }
   size_t thread_num = Global<ThreadPool>::Get()->thread_num();
   BalancedSplitter bs(size, thread_num);
   MultiThreadLoop(thread_num, [&](size_t thread_idx) {
@@ -60,6 +68,315 @@ void VecAdd(size_t size, T* out, const T* in0, const T* in1) {
   });
 }
 
+// Bytes of a ring all-reduce message, each ring step sends its part in chunks of this size so
+// that receiving, reducing and forwarding different chunks overlap.
+int64_t RingChunkBytes() {
+  static const int64_t chunk_bytes = ParseIntegerFromEnv("ONEFLOW_CCL_RING_CHUNK_BYTES", 1 << 20);
+  return chunk_bytes;
+}
+
+// All-reduces up to this size take log(n) halving-doubling steps instead of 2(n - 1) ring steps.
+int64_t HalvingDoublingMaxBytes() {
+  static const int64_t max_bytes =
+      ParseIntegerFromEnv("ONEFLOW_CCL_HALVING_DOUBLING_MAX_BYTES", 256 << 10);
+  return max_bytes;
+}
+
+// Receive buffer kept across calls, every all-reduce of a step would allocate one otherwise.
+template<typename T>
+T* GetThreadLocalRecvBuffer(size_t elem_cnt) {
+  static thread_local std::vector<T> buffer;
+  if (buffer.size() < elem_cnt) { buffer.resize(elem_cnt); }
+  return buffer.data();
+}
+
+// The buffer is set before each send or receive, so that one context tracks any number of
+// messages.
+class BufferTransportCtx final : public AsyncTransportCtx {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BufferTransportCtx);
+  explicit BufferTransportCtx(const TransportToken& transport_token)
+      : AsyncTransportCtx(transport_token), buffer_(nullptr), size_(0) {}
+  ~BufferTransportCtx() override = default;
+
+  void set_buffer(const void* buffer, size_t size) {
+    buffer_ = const_cast<void*>(buffer);
+    size_ = size;
+  }
+
+  Maybe<void> PrepareSendBufferAndCallback(int64_t rank, void** buffer, std::size_t* size,
+                                           std::function<void()>* Callback) override {
+    *buffer = buffer_;
+    *size = size_;
+    *Callback = [] {};
+    return Maybe<void>::Ok();
+  }
+
+  Maybe<void> PrepareRecvBufferAndCallback(int64_t rank, void** buffer, std::size_t* size,
+                                           std::function<void()>* Callback) override {
+    *buffer = buffer_;
+    *size = size_;
+    *Callback = [] {};
+    return Maybe<void>::Ok();
+  }
+
+ private:
+  void* buffer_;
+  size_t size_;
+};
+
+// Ring all-reduce, n - 1 reduce-scatter steps followed by n - 1 all-gather steps. The part received
+// in a step is the one sent in the next, so every part is split into chunks and chunk c of step
+// s + 1 is sent as soon as chunk c of step s is received and reduced, with the chunks of a step in
+// flight at the same time.
+template<typename T>
+Maybe<void> RingAllReduce(const T* in, T* out, size_t elem_cnt, Symbol<ParallelDesc> parallel_desc,
+                          int64_t parallel_id) {
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  BalancedSplitter bs(elem_cnt, parallel_num);
+  const int64_t chunk_num = std::min<int64_t>(
+      kMaxRingChunkNum,
+      std::max<int64_t>((bs.At(0).size() * sizeof(T) + RingChunkBytes() - 1) / RingChunkBytes(),
+                        1));
+  const auto ChunkRange = [&](int64_t part_id, int64_t chunk_id) -> Range {
+    const Range chunk = BalancedSplitter(bs.At(part_id).size(), chunk_num).At(chunk_id);
+    return Range(bs.At(part_id).begin() + chunk.begin(), bs.At(part_id).begin() + chunk.end());
+  };
+  // Every chunk id has a fixed slot in the receive buffer. Parts differ in size by one element,
+  // so offsets within the part would let chunk c of a step overwrite chunk c + 1 of the previous
+  // step before it is reduced.
+  const int64_t chunk_slot_size = (bs.At(0).size() + chunk_num - 1) / chunk_num;
+  T* recv_buffer = GetThreadLocalRecvBuffer<T>(chunk_slot_size * chunk_num);
+  const auto& rank_group = JUST(RankGroup::New(parallel_desc));
+  TransportToken transport_token =
+      JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
+  BufferTransportCtx send_ctx(transport_token);
+  std::vector<std::unique_ptr<BufferTransportCtx>> recv_ctxs(chunk_num);
+  for (auto& recv_ctx : recv_ctxs) { recv_ctx.reset(new BufferTransportCtx(transport_token)); }
+
+  const int64_t reduce_step_num = parallel_num - 1;
+  const int64_t step_num = 2 * reduce_step_num;
+  // Part sent in each step, the part received in a step is the one sent in the next.
+  std::vector<int64_t> send_part_ids(step_num + 1);
+  send_part_ids[0] = parallel_id;
+  for (int64_t i = 0; i < step_num; ++i) {
+    send_part_ids[i + 1] = RingDecrease(send_part_ids[i], parallel_num);
+  }
+  // Both ends post the chunks in step major order, which pairs the messages up.
+  const auto PostChunk = [&](int64_t step, int64_t chunk_id) -> Maybe<void> {
+    const Range send_range = ChunkRange(send_part_ids[step], chunk_id);
+    if (send_range.size() > 0) {
+      const T* send_ptr = (step == 0 ? in : out) + send_range.begin();
+      send_ctx.set_buffer(send_ptr, send_range.size() * sizeof(T));
+      JUST(TransportUtil::SendToNextRankInRing(rank_group, transport_token, &send_ctx));
+    }
+    const int64_t recv_part_id = send_part_ids[step + 1];
+    const Range recv_range = ChunkRange(recv_part_id, chunk_id);
+    if (recv_range.size() > 0) {
+      T* recv_ptr = step < reduce_step_num ? recv_buffer + chunk_id * chunk_slot_size
+                                           : out + recv_range.begin();
+      recv_ctxs[chunk_id]->set_buffer(recv_ptr, recv_range.size() * sizeof(T));
+      JUST(TransportUtil::ReceiveFromPrevRankInRing(rank_group, transport_token,
+                                                    recv_ctxs[chunk_id].get()));
+    }
+    return Maybe<void>::Ok();
+  };
+  for (int64_t chunk_id = 0; chunk_id < chunk_num; ++chunk_id) { JUST(PostChunk(0, chunk_id)); }
+  for (int64_t step = 0; step < step_num; ++step) {
+    const int64_t recv_part_id = send_part_ids[step + 1];
+    for (int64_t chunk_id = 0; chunk_id < chunk_num; ++chunk_id) {
+      JUST(TransportUtil::WaitUntilDoneOrTimeout(*recv_ctxs[chunk_id],
+                                                 TransportUtil::TimeoutSeconds()));
+      if (step < reduce_step_num) {
+        const Range range = ChunkRange(recv_part_id, chunk_id);
+        VecAdd(range.size(), out + range.begin(), in + range.begin(),
+               recv_buffer + chunk_id * chunk_slot_size);
+      }
+      if (step + 1 < step_num) { JUST(PostChunk(step + 1, chunk_id)); }
+    }
+  }
+  JUST(TransportUtil::WaitUntilDoneOrTimeout(send_ctx, TransportUtil::TimeoutSeconds()));
+  return Maybe<void>::Ok();
+}
+
+// Recursive halving reduce-scatter and recursive doubling all-gather among the largest power of
+// two number of ranks, the first 2 * (n - power) ranks are folded pairwise before and unfolded
+// after. Takes O(log(n)) steps, which is what matters for small messages.
+template<typename T>
+Maybe<void> HalvingDoublingAllReduce(const T* in, T* out, size_t elem_cnt,
+                                     Symbol<ParallelDesc> parallel_desc, int64_t parallel_id) {
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  if (in != out) { std::memcpy(out, in, elem_cnt * sizeof(T)); }
+  int64_t pow2_num = 1;
+  while (pow2_num * 2 <= parallel_num) { pow2_num *= 2; }
+  const int64_t fold_num = parallel_num - pow2_num;
+  T* recv_buffer = GetThreadLocalRecvBuffer<T>(elem_cnt);
+  TransportToken transport_token =
+      JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
+  const auto Exchange = [&](int64_t peer_parallel_id, const T* send_ptr, size_t send_size,
+                            T* recv_ptr, size_t recv_size) -> Maybe<void> {
+    const int64_t peer_rank = JUST(parallel_desc->MachineId4ParallelId(peer_parallel_id));
+    BufferTransportCtx send_ctx(transport_token);
+    BufferTransportCtx recv_ctx(transport_token);
+    if (send_size > 0) {
+      send_ctx.set_buffer(send_ptr, send_size * sizeof(T));
+      JUST(TransportUtil::SendDataToRank(peer_rank, transport_token, &send_ctx));
+    }
+    if (recv_size > 0) {
+      recv_ctx.set_buffer(recv_ptr, recv_size * sizeof(T));
+      JUST(TransportUtil::ReceiveDataFromRank(peer_rank, transport_token, &recv_ctx));
+    }
+    JUST(TransportUtil::WaitUntilDoneOrTimeout(recv_ctx, TransportUtil::TimeoutSeconds()));
+    JUST(TransportUtil::WaitUntilDoneOrTimeout(send_ctx, TransportUtil::TimeoutSeconds()));
+    return Maybe<void>::Ok();
+  };
+
+  // Rank in the power of two group, -1 for ranks folded into their neighbour.
+  int64_t group_id = -1;
+  if (parallel_id < 2 * fold_num) {
+    if (parallel_id % 2 == 0) {
+      JUST(Exchange(parallel_id + 1, out, elem_cnt, nullptr, 0));
+    } else {
+      JUST(Exchange(parallel_id - 1, nullptr, 0, recv_buffer, elem_cnt));
+      VecAdd(elem_cnt, out, out, recv_buffer);
+      group_id = parallel_id / 2;
+    }
+  } else {
+    group_id = parallel_id - fold_num;
+  }
+  const auto ParallelId4GroupId = [&](int64_t id) {
+    return id < fold_num ? id * 2 + 1 : id + fold_num;
+  };
+  if (group_id >= 0) {
+    BalancedSplitter bs(elem_cnt, pow2_num);
+    // Blocks [block_begin, block_end) of bs owned by this rank.
+    int64_t block_begin = 0;
+    int64_t block_end = pow2_num;
+    for (int64_t mask = pow2_num / 2; mask > 0; mask /= 2) {
+      const int64_t block_mid = block_begin + mask;
+      const bool keep_lower = (group_id & mask) == 0;
+      const Range keep_range = keep_lower ? bs.At(block_begin, block_mid - 1)
+                                          : bs.At(block_mid, block_end - 1);
+      const Range send_range = keep_lower ? bs.At(block_mid, block_end - 1)
+                                          : bs.At(block_begin, block_mid - 1);
+      JUST(Exchange(ParallelId4GroupId(group_id ^ mask), out + send_range.begin(),
+                    send_range.size(), recv_buffer, keep_range.size()));
+      VecAdd(keep_range.size(), out + keep_range.begin(), out + keep_range.begin(), recv_buffer);
+      if (keep_lower) {
+        block_end = block_mid;
+      } else {
+        block_begin = block_mid;
+      }
+    }
+    for (int64_t mask = 1; mask < pow2_num; mask *= 2) {
+      const int64_t peer_block_begin = block_begin ^ mask;
+      const Range own_range = bs.At(block_begin, block_end - 1);
+      const Range peer_range = bs.At(peer_block_begin, peer_block_begin + mask - 1);
+      JUST(Exchange(ParallelId4GroupId(group_id ^ mask), out + own_range.begin(),
+                    own_range.size(), out + peer_range.begin(), peer_range.size()));
+      block_begin = std::min(block_begin, peer_block_begin);
+      block_end = block_begin + 2 * mask;
+    }
+  }
+  if (parallel_id < 2 * fold_num) {
+    if (parallel_id % 2 == 0) {
+      JUST(Exchange(parallel_id + 1, nullptr, 0, out, elem_cnt));
+    } else {
+      JUST(Exchange(parallel_id - 1, out, elem_cnt, nullptr, 0));
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+template<typename T>
+Maybe<void> NetworkAllReduce(const T* in, T* out, size_t elem_cnt,
+                             Symbol<ParallelDesc> parallel_desc) {
+  Optional<int64_t> parallel_id;
+  JUST(GetTensorDevice4CurrentProcessCtx(parallel_desc, &parallel_id));
+  if (parallel_desc->parallel_num() == 1) {
+    if (in != out) { std::memcpy(out, in, elem_cnt * sizeof(T)); }
+    return Maybe<void>::Ok();
+  }
+  if (static_cast<int64_t>(elem_cnt * sizeof(T)) <= HalvingDoublingMaxBytes()) {
+    return HalvingDoublingAllReduce<T>(in, out, elem_cnt, parallel_desc, JUST(parallel_id));
+  }
+  return RingAllReduce<T>(in, out, elem_cnt, parallel_desc, JUST(parallel_id));
+}
+
+// Ranks of `parallel_desc` grouped by host, each group in the order of parallel ids. Left empty
+// if a rank holds more than one device of `parallel_desc`.
+Maybe<void> InitNodeId2Ranks(std::map<int64_t, std::vector<int64_t>>* node_id2ranks,
+                             Symbol<ParallelDesc> parallel_desc) {
+  node_id2ranks->clear();
+  const int64_t parallel_num = parallel_desc->parallel_num();
+  if (parallel_num != static_cast<int64_t>(parallel_desc->sorted_machine_ids().size())) {
+    return Maybe<void>::Ok();
+  }
+  for (int64_t i = 0; i < parallel_num; ++i) {
+    const int64_t rank = JUST(parallel_desc->MachineId4ParallelId(i));
+    (*node_id2ranks)[GlobalProcessCtx::NodeId(rank)].push_back(rank);
+  }
+  return Maybe<void>::Ok();
+}
+
+// Shared memory communicator among all ranks of `parallel_desc`, nullptr unless there are several
+// of them and they all run on the host of the current rank. Local ids are parallel ids.
+Maybe<CpuShmComm*> GetLocalShmComm(Symbol<ParallelDesc> parallel_desc) {
+  if (!IsCpuShmCommEnabled() || parallel_desc->parallel_num() == 1) {
+    return static_cast<CpuShmComm*>(nullptr);
+  }
+  std::map<int64_t, std::vector<int64_t>> node_id2ranks;
+  JUST(InitNodeId2Ranks(&node_id2ranks, parallel_desc));
+  if (node_id2ranks.size() != 1) { return static_cast<CpuShmComm*>(nullptr); }
+  return GetCpuShmComm(node_id2ranks.begin()->second, "all");
+}
+
+// All-reduce among the ranks of each host through shared memory, then among the first rank of
+// every host over the network, then a broadcast from that rank within each host. A host where the
+// shared memory segment is not available does its part over the network, so the hosts still agree
+// on who talks to whom.
+template<typename T>
+Maybe<void> HierarchicalAllReduce(const T* in, T* out, size_t elem_cnt,
+                                  const std::map<int64_t, std::vector<int64_t>>& node_id2ranks) {
+  const std::vector<int64_t>& node_ranks = node_id2ranks.at(GlobalProcessCtx::ThisNodeId());
+  const auto& node_rank_group =
+      JUST(RankGroup::New(std::set<int64_t>(node_ranks.begin(), node_ranks.end())));
+  const auto& node_parallel_desc =
+      JUST(RankGroup::GetDefaultParallelDesc(DeviceType::kCPU, node_rank_group));
+  CpuShmComm* comm = nullptr;
+  if (node_ranks.size() > 1) { comm = JUST(GetCpuShmComm(node_ranks, "node")); }
+  if (comm != nullptr) {
+    JUST(comm->AllReduce(in, out, elem_cnt));
+  } else {
+    JUST(NetworkAllReduce<T>(in, out, elem_cnt, node_parallel_desc));
+  }
+  if (GlobalProcessCtx::Rank() == node_ranks.front()) {
+    std::set<int64_t> leaders;
+    for (const auto& pair : node_id2ranks) { leaders.insert(pair.second.front()); }
+    const auto& leader_parallel_desc = JUST(
+        RankGroup::GetDefaultParallelDesc(DeviceType::kCPU, JUST(RankGroup::New(leaders))));
+    JUST(NetworkAllReduce<T>(out, out, elem_cnt, leader_parallel_desc));
+  }
+  if (comm != nullptr) {
+    JUST(comm->Broadcast(out, out, elem_cnt * sizeof(T), 0));
+  } else if (node_ranks.size() > 1) {
+    const auto& transport_token = JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
+    JUST(CpuBroadcast(out, out, elem_cnt * sizeof(T), node_ranks.front(), node_parallel_desc,
+                      transport_token));
+  }
+  return Maybe<void>::Ok();
+}
+
+// Point to point messages between two ranks of one host go through a communicator of the two,
+// one per direction, as a broadcast from the sender.
+Maybe<CpuShmComm*> GetP2PShmComm(int64_t src, int64_t dst) {
+  if (!IsCpuShmCommEnabled() || src == dst
+      || GlobalProcessCtx::NodeId(src) != GlobalProcessCtx::NodeId(dst)) {
+    return static_cast<CpuShmComm*>(nullptr);
+  }
+  return GetCpuShmComm({src, dst}, "p2p");
+}
+
 }  // namespace
 
 template<typename T, ReduceType reduce_type>
@@ -71,83 +388,19 @@ struct DtypeAllReduce<T, kSum> {
                           Symbol<ParallelDesc> parallel_desc) {
     const T* in = reinterpret_cast<const T*>(void_in);
     T* out = reinterpret_cast<T*>(void_out);
-    int64_t parallel_num = parallel_desc->parallel_num();
-    BalancedSplitter bs(elem_cnt, parallel_num);
-    std::vector<T> recv_buffer(bs.At(0).size());
-    Optional<int64_t> parallel_id;
-    JUST(GetTensorDevice4CurrentProcessCtx(parallel_desc, &parallel_id));
-    const auto& rank_group = JUST(RankGroup::New(parallel_desc));
-    TransportToken transport_token =
-        JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
-    for (int64_t i = 0, part_id = JUST(parallel_id); i < parallel_num - 1;
-         ++i, part_id = RingDecrease(part_id, parallel_num)) {
-      int64_t send_part_id = part_id;
-      const T* send_ptr = nullptr;
-      if (i == 0) {
-        send_ptr = &in[bs.At(send_part_id).begin()];
-      } else {
-        send_ptr = &out[bs.At(send_part_id).begin()];
-      }
-      size_t send_size = bs.At(send_part_id).size();
-      int64_t recv_part_id = RingDecrease(part_id, parallel_num);
-      T* recv_ptr = recv_buffer.data();
-      size_t recv_size = bs.At(recv_part_id).size();
-      NaiveAsyncTransportCtx ctx(
-          transport_token,
-          [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
-            *buffer = const_cast<T*>(send_ptr);
-            *size = send_size * sizeof(T);
-            *Cb = [] {};
-            return Maybe<void>::Ok();
-          },
-          [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
-            *buffer = recv_ptr;
-            *size = recv_size * sizeof(T);
-            *Cb = [] {};
-            return Maybe<void>::Ok();
-          });
-      if (send_size > 0) {
-        JUST(TransportUtil::SendToNextRankInRing(rank_group, transport_token, &ctx));
+    const int64_t parallel_num = parallel_desc->parallel_num();
+    if (parallel_num > 1 && IsCpuShmCommEnabled()) {
+      std::map<int64_t, std::vector<int64_t>> node_id2ranks;
+      JUST(InitNodeId2Ranks(&node_id2ranks, parallel_desc));
+      if (node_id2ranks.size() == 1) {
+        CpuShmComm* comm = JUST(GetCpuShmComm(node_id2ranks.begin()->second, "all"));
+        if (comm != nullptr) { return comm->AllReduce(in, out, elem_cnt); }
+      } else if (node_id2ranks.size() > 1
+                 && static_cast<int64_t>(node_id2ranks.size()) < parallel_num) {
+        return HierarchicalAllReduce<T>(in, out, elem_cnt, node_id2ranks);
       }
-      if (recv_size > 0) {
-        JUST(TransportUtil::ReceiveFromPrevRankInRing(rank_group, transport_token, &ctx));
-      }
-      JUST(TransportUtil::WaitUntilDoneOrTimeout(ctx, TransportUtil::TimeoutSeconds()));
-      const T* cur_in = &in[bs.At(recv_part_id).begin()];
-      T* cur_out = &out[bs.At(recv_part_id).begin()];
-      if (recv_size > 0) { VecAdd(recv_size, cur_out, cur_in, recv_ptr); }
     }
-    for (int64_t i = 0, part_id = RingIncrease(JUST(parallel_id), parallel_num);
-         i < parallel_num - 1; ++i, part_id = RingDecrease(part_id, parallel_num)) {
-      int64_t send_part_id = part_id;
-      const T* send_ptr = &out[bs.At(send_part_id).begin()];
-      size_t send_size = bs.At(send_part_id).size();
-      int64_t recv_part_id = RingDecrease(part_id, parallel_num);
-      T* recv_ptr = &out[bs.At(recv_part_id).begin()];
-      size_t recv_size = bs.At(recv_part_id).size();
-      NaiveAsyncTransportCtx ctx(
-          transport_token,
-          [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
-            *buffer = const_cast<T*>(send_ptr);
-            *size = send_size * sizeof(T);
-            *Cb = [] {};
-            return Maybe<void>::Ok();
-          },
-          [&](void** buffer, std::size_t* size, std::function<void()>* Cb) -> Maybe<void> {
-            *buffer = recv_ptr;
-            *size = recv_size * sizeof(T);
-            *Cb = [] {};
-            return Maybe<void>::Ok();
-          });
-      if (send_size > 0) {
-        JUST(TransportUtil::SendToNextRankInRing(rank_group, transport_token, &ctx));
-      }
-      if (recv_size > 0) {
-        JUST(TransportUtil::ReceiveFromPrevRankInRing(rank_group, transport_token, &ctx));
-      }
-      JUST(TransportUtil::WaitUntilDoneOrTimeout(ctx, TransportUtil::TimeoutSeconds()));
-    }
-    return Maybe<void>::Ok();
+    return NetworkAllReduce<T>(in, out, elem_cnt, parallel_desc);
   }
 };
 
@@ -174,6 +427,8 @@ struct DtypeReduceScatter<T, kSum> {
                           Symbol<ParallelDesc> parallel_desc) {
     const T* in = reinterpret_cast<const T*>(void_in);
     T* out = reinterpret_cast<T*>(void_out);
+    CpuShmComm* comm = JUST(GetLocalShmComm(parallel_desc));
+    if (comm != nullptr) { return comm->ReduceScatter(in, out, elem_cnt); }
 
     int64_t parallel_num = parallel_desc->parallel_num();
     BalancedSplitter bs(elem_cnt * parallel_num, parallel_num);
@@ -248,6 +503,8 @@ Maybe<void> AllGather<DeviceType::kCPU>(const void* in, void* out, size_t elem_c
   char* char_out = reinterpret_cast<char*>(out);
   int64_t parallel_num = parallel_desc->parallel_num();
   size_t chunk_size = elem_cnt * GetSizeOfDataType(dtype);
+  CpuShmComm* comm = JUST(GetLocalShmComm(parallel_desc));
+  if (comm != nullptr) { return comm->AllGather(in, out, chunk_size); }
   BalancedSplitter bs(chunk_size * parallel_num, parallel_num);
   const auto& opt_parallel_id = JUST(GetParallelId4CurrentProcessCtx(parallel_desc));
   CHECK_OR_RETURN(opt_parallel_id->has_value());
@@ -298,6 +555,14 @@ Maybe<void> Broadcast<DeviceType::kCPU>(const void* in, void* out, size_t elem_c
   CHECK_EQ_OR_RETURN(parallel_desc->device_type(), DeviceType::kCPU);
   CHECK_OR_RETURN(IsPODDataType(dtype));
   size_t buffer_size = elem_cnt * GetSizeOfDataType(dtype);
+  CpuShmComm* comm = JUST(GetLocalShmComm(parallel_desc));
+  if (comm != nullptr) {
+    int64_t root_parallel_id = -1;
+    for (int64_t i = 0; i < parallel_desc->parallel_num(); ++i) {
+      if (JUST(parallel_desc->MachineId4ParallelId(i)) == root) { root_parallel_id = i; }
+    }
+    return comm->Broadcast(in, out, buffer_size, root_parallel_id);
+  }
   const auto& transport_token = JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
   return CpuBroadcast(in, out, buffer_size, root, parallel_desc, transport_token);
 }
@@ -480,6 +745,8 @@ Maybe<void> Send<DeviceType::kCPU>(const void* in, size_t elem_cnt, DataType dty
                                    ep::Stream* stream) {
   CHECK_OR_RETURN(IsPODDataType(dtype));
   size_t buffer_size = elem_cnt * GetSizeOfDataType(dtype);
+  CpuShmComm* comm = JUST(GetP2PShmComm(GlobalProcessCtx::Rank(), dst));
+  if (comm != nullptr) { return comm->Broadcast(in, const_cast<void*>(in), buffer_size, 0); }
   TransportToken transport_token = JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
   NaiveAsyncTransportCtx transport_ctx(
       transport_token,
@@ -519,6 +786,8 @@ Maybe<void> Recv<DeviceType::kCPU>(void* out, size_t elem_cnt, DataType dtype, i
                                    ep::Stream* stream) {
   CHECK_OR_RETURN(IsPODDataType(dtype));
   size_t buffer_size = elem_cnt * GetSizeOfDataType(dtype);
+  CpuShmComm* comm = JUST(GetP2PShmComm(src, GlobalProcessCtx::Rank()));
+  if (comm != nullptr) { return comm->Broadcast(nullptr, out, buffer_size, 0); }
   TransportToken transport_token = JUST(TransportToken::NewTransportToken(kTransportTokenTypeData));
   NaiveAsyncTransportCtx transport_ctx(
       transport_token,
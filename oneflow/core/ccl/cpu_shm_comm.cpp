@@ -0,0 +1,312 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ccl/cpu_shm_comm.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <tuple>
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/data_type_seq.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/rpc/include/global_process_ctx.h"
+#include "oneflow/core/thread/thread_consistent_id.h"
+
+namespace oneflow {
+namespace ccl {
+
+struct CpuShmCommHeader {
+  std::atomic<int64_t> attach_cnt;
+  int64_t size;
+  int64_t slot_bytes;
+};
+
+struct alignas(64) CpuShmCommFlag {
+  std::atomic<uint64_t> value;
+};
+
+namespace {
+
+constexpr size_t kCacheLineSize = 64;
+constexpr int64_t kSpinCntPerYield = 1024;
+constexpr int64_t kBarrierTimeoutSeconds = 60 * 5;
+
+size_t MetaBytes(int64_t size) {
+  return RoundUp(sizeof(CpuShmCommHeader), kCacheLineSize) + size * sizeof(CpuShmCommFlag);
+}
+
+size_t SlotBytes() {
+  static const size_t slot_bytes = ParseIntegerFromEnv("ONEFLOW_CCL_SHM_SLOT_BYTES", 1 << 20);
+  return slot_bytes;
+}
+
+}  // namespace
+
+CpuShmComm::CpuShmComm(const std::string& name, void* ptr, size_t mapped_bytes,
+                       int64_t local_id)
+    : name_(name),
+      ptr_(ptr),
+      mapped_bytes_(mapped_bytes),
+      header_(static_cast<CpuShmCommHeader*>(ptr)),
+      local_id_(local_id),
+      round_(0),
+      barrier_seq_(0) {
+  size_ = header_->size;
+  slot_bytes_ = header_->slot_bytes;
+  half_bytes_ = slot_bytes_ / 2;
+  flags_ = reinterpret_cast<CpuShmCommFlag*>(static_cast<char*>(ptr)
+                                             + RoundUp(sizeof(CpuShmCommHeader), kCacheLineSize));
+  data_ = static_cast<char*>(ptr) + MetaBytes(size_);
+}
+
+CpuShmComm::~CpuShmComm() { munmap(ptr_, mapped_bytes_); }
+
+/*static*/ Maybe<CpuShmComm> CpuShmComm::Create(const std::string& name, int64_t size,
+                                                size_t slot_bytes) {
+  slot_bytes = RoundUp(std::max<size_t>(slot_bytes, 2 * kCacheLineSize), 2 * kCacheLineSize);
+  const size_t total_bytes = MetaBytes(size) + size * slot_bytes;
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  CHECK_GE_OR_RETURN(fd, 0) << "shm_open " << name << " failed: " << strerror(errno);
+  // Reserves the pages up front, a full tmpfs would raise SIGBUS on first touch otherwise.
+  const int err = posix_fallocate(fd, 0, total_bytes);
+  void* ptr = err == 0 ? mmap(nullptr, total_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                       : MAP_FAILED;
+  close(fd);
+  if (ptr == MAP_FAILED) { shm_unlink(name.c_str()); }
+  CHECK_EQ_OR_RETURN(err, 0) << "can not allocate " << total_bytes << " bytes for " << name
+                             << ": " << strerror(err);
+  CHECK_OR_RETURN(ptr != MAP_FAILED) << "mmap " << name << " failed: " << strerror(errno);
+  auto* header = new (ptr) CpuShmCommHeader();
+  header->size = size;
+  header->slot_bytes = slot_bytes;
+  auto* flags = reinterpret_cast<CpuShmCommFlag*>(
+      static_cast<char*>(ptr) + RoundUp(sizeof(CpuShmCommHeader), kCacheLineSize));
+  FOR_RANGE(int64_t, i, 0, size) { new (flags + i) CpuShmCommFlag{{0}}; }
+  header->attach_cnt.store(1, std::memory_order_release);
+  if (size == 1) { shm_unlink(name.c_str()); }
+  return std::shared_ptr<CpuShmComm>(new CpuShmComm(name, ptr, total_bytes, 0));
+}
+
+/*static*/ Maybe<CpuShmComm> CpuShmComm::Open(const std::string& name, int64_t size,
+                                              int64_t local_id) {
+  const int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  CHECK_GE_OR_RETURN(fd, 0) << "shm_open " << name << " failed: " << strerror(errno);
+  struct stat st;
+  const int stat_ret = fstat(fd, &st);
+  void* ptr = stat_ret == 0 ? mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                            : MAP_FAILED;
+  close(fd);
+  CHECK_OR_RETURN(ptr != MAP_FAILED) << "mmap " << name << " failed: " << strerror(errno);
+  auto* header = static_cast<CpuShmCommHeader*>(ptr);
+  if (header->size != size) { munmap(ptr, st.st_size); }
+  CHECK_EQ_OR_RETURN(header->size, size);
+  if (header->attach_cnt.fetch_add(1, std::memory_order_acq_rel) + 1 == size) {
+    shm_unlink(name.c_str());
+  }
+  return std::shared_ptr<CpuShmComm>(new CpuShmComm(name, ptr, st.st_size, local_id));
+}
+
+char* CpuShmComm::NextRound() {
+  ++round_;
+  return Half(local_id_);
+}
+
+char* CpuShmComm::Half(int64_t local_id) const {
+  return data_ + local_id * slot_bytes_ + (round_ % 2) * half_bytes_;
+}
+
+Maybe<void> CpuShmComm::Barrier() {
+  ++barrier_seq_;
+  flags_[local_id_].value.store(barrier_seq_, std::memory_order_release);
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, size_) {
+    int64_t spin_cnt = 0;
+    while (flags_[i].value.load(std::memory_order_acquire) < barrier_seq_) {
+      if (++spin_cnt % kSpinCntPerYield != 0) { continue; }
+      // Lets the other processes run on an oversubscribed host.
+      std::this_thread::yield();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      CHECK_LT_OR_RETURN(elapsed.count(), kBarrierTimeoutSeconds)
+          << Error::TimeoutError() << "local id " << i << " of " << name_
+          << " did not reach the barrier in " << kBarrierTimeoutSeconds << " seconds";
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+template<typename T>
+Maybe<void> CpuShmComm::AllReduce(const T* in, T* out, size_t elem_cnt) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t round_elem_cnt = half_bytes_ / sizeof(T);
+  for (size_t offset = 0; offset < elem_cnt; offset += round_elem_cnt) {
+    const size_t cnt = std::min(round_elem_cnt, elem_cnt - offset);
+    std::memcpy(NextRound(), in + offset, cnt * sizeof(T));
+    JUST(Barrier());
+    // Every process sums up one range of all slots into its own slot, which no other process
+    // reads before the next barrier.
+    BalancedSplitter bs(cnt, size_);
+    const Range range = bs.At(local_id_);
+    T* acc = reinterpret_cast<T*>(Half(local_id_)) + range.begin();
+    FOR_RANGE(int64_t, i, 0, size_) {
+      if (i == local_id_) { continue; }
+      const T* src = reinterpret_cast<const T*>(Half(i)) + range.begin();
+      FOR_RANGE(int64_t, j, 0, range.size()) { acc[j] += src[j]; }
+    }
+    JUST(Barrier());
+    FOR_RANGE(int64_t, i, 0, size_) {
+      const Range reduced = bs.At(i);
+      std::memcpy(out + offset + reduced.begin(),
+                  reinterpret_cast<const T*>(Half(i)) + reduced.begin(),
+                  reduced.size() * sizeof(T));
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+template<typename T>
+Maybe<void> CpuShmComm::ReduceScatter(const T* in, T* out, size_t elem_cnt) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t round_elem_cnt = half_bytes_ / sizeof(T) / size_;
+  CHECK_GT_OR_RETURN(round_elem_cnt, 0);
+  for (size_t offset = 0; offset < elem_cnt; offset += round_elem_cnt) {
+    const size_t cnt = std::min(round_elem_cnt, elem_cnt - offset);
+    T* half = reinterpret_cast<T*>(NextRound());
+    FOR_RANGE(int64_t, i, 0, size_) {
+      std::memcpy(half + i * cnt, in + i * elem_cnt + offset, cnt * sizeof(T));
+    }
+    JUST(Barrier());
+    T* dst = out + offset;
+    std::memcpy(dst, reinterpret_cast<const T*>(Half(0)) + local_id_ * cnt, cnt * sizeof(T));
+    FOR_RANGE(int64_t, i, 1, size_) {
+      const T* src = reinterpret_cast<const T*>(Half(i)) + local_id_ * cnt;
+      FOR_RANGE(size_t, j, 0, cnt) { dst[j] += src[j]; }
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CpuShmComm::AllGather(const void* in, void* out, size_t buffer_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const char* char_in = static_cast<const char*>(in);
+  char* char_out = static_cast<char*>(out);
+  for (size_t offset = 0; offset < buffer_size; offset += half_bytes_) {
+    const size_t cnt = std::min(half_bytes_, buffer_size - offset);
+    std::memcpy(NextRound(), char_in + offset, cnt);
+    JUST(Barrier());
+    FOR_RANGE(int64_t, i, 0, size_) {
+      std::memcpy(char_out + i * buffer_size + offset, Half(i), cnt);
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CpuShmComm::Broadcast(const void* in, void* out, size_t buffer_size, int64_t root) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CHECK_OR_RETURN(root >= 0 && root < size_);
+  const char* char_in = static_cast<const char*>(in);
+  char* char_out = static_cast<char*>(out);
+  for (size_t offset = 0; offset < buffer_size; offset += half_bytes_) {
+    const size_t cnt = std::min(half_bytes_, buffer_size - offset);
+    char* half = NextRound();
+    if (local_id_ == root) { std::memcpy(half, char_in + offset, cnt); }
+    JUST(Barrier());
+    if (local_id_ != root) { std::memcpy(char_out + offset, Half(root), cnt); }
+  }
+  if (local_id_ == root && in != out) { std::memcpy(out, in, buffer_size); }
+  return Maybe<void>::Ok();
+}
+
+#define INSTANTIATE_CPU_SHM_COMM_REDUCE(T, type_proto)                                 \
+  template Maybe<void> CpuShmComm::AllReduce<T>(const T* in, T* out, size_t elem_cnt); \
+  template Maybe<void> CpuShmComm::ReduceScatter<T>(const T* in, T* out, size_t elem_cnt);
+OF_PP_FOR_EACH_TUPLE(INSTANTIATE_CPU_SHM_COMM_REDUCE, POD_DATA_TYPE_SEQ)
+#undef INSTANTIATE_CPU_SHM_COMM_REDUCE
+
+bool IsCpuShmCommEnabled() {
+  static const bool enabled = ParseBooleanFromEnv("ONEFLOW_CCL_SHM", false);
+  return enabled;
+}
+
+Maybe<CpuShmComm*> GetCpuShmComm(const std::vector<int64_t>& ranks, const std::string& tag) {
+  static std::mutex mutex;
+  static std::map<std::tuple<int64_t, std::string, std::vector<int64_t>>,
+                  std::shared_ptr<CpuShmComm>>
+      comms;
+  // Like transport tokens, collectives of different threads do not share a communicator, threads
+  // of the same consistent id are paired up across processes.
+  const int64_t thread_consistent_id = JUST(GetThisThreadConsistentId());
+  std::lock_guard<std::mutex> lock(mutex);
+  const auto key = std::make_tuple(thread_consistent_id, tag, ranks);
+  auto iter = comms.find(key);
+  if (iter != comms.end()) { return iter->second.get(); }
+  const auto rank_iter = std::find(ranks.begin(), ranks.end(), GlobalProcessCtx::Rank());
+  CHECK_OR_RETURN(rank_iter != ranks.end());
+  const int64_t local_id = rank_iter - ranks.begin();
+  std::string rpc_key = "cpu_shm_comm_" + std::to_string(thread_consistent_id) + "_" + tag;
+  for (int64_t rank : ranks) { rpc_key += "," + std::to_string(rank); }
+  std::shared_ptr<CpuShmComm> comm;
+  std::string name;
+  if (local_id == 0) {
+    name = "/oneflow_ccl_" + std::to_string(getpid()) + "_" + std::to_string(comms.size());
+    const auto& maybe_comm = CpuShmComm::Create(name, ranks.size(), SlotBytes());
+    if (maybe_comm.IsOk()) {
+      comm = CHECK_JUST(maybe_comm);
+    } else {
+      LOG(WARNING) << "falling back to the network for " << rpc_key << ", "
+                   << maybe_comm.GetSerializedError();
+      name.clear();
+    }
+    // An empty name tells the others to fall back as well.
+    Global<CtrlClient>::Get()->PushKV(rpc_key, name);
+  } else {
+    Global<CtrlClient>::Get()->PullKV(rpc_key, &name);
+    if (!name.empty()) {
+      const auto& maybe_comm = CpuShmComm::Open(name, ranks.size(), local_id);
+      if (maybe_comm.IsOk()) {
+        comm = CHECK_JUST(maybe_comm);
+      } else {
+        LOG(WARNING) << "falling back to the network for " << rpc_key << ", "
+                     << maybe_comm.GetSerializedError();
+      }
+    }
+  }
+  if (!name.empty()) {
+    // Any rank that failed to attach makes all of them fall back, a rank on the network path
+    // would otherwise wait forever for peers that went through shared memory.
+    Global<CtrlClient>::Get()->PushKV(rpc_key + "/" + std::to_string(local_id), comm ? "1" : "0");
+    bool all_attached = true;
+    FOR_RANGE(int64_t, id, 0, ranks.size()) {
+      if (id == local_id) { continue; }
+      std::string attached;
+      Global<CtrlClient>::Get()->PullKV(rpc_key + "/" + std::to_string(id), &attached);
+      all_attached = all_attached && attached == "1";
+    }
+    if (!all_attached) {
+      if (comm) { LOG(WARNING) << "falling back to the network for " << rpc_key; }
+      comm.reset();
+      if (local_id == 0) { shm_unlink(name.c_str()); }
+    }
+  }
+  return comms.emplace(key, comm).first->second.get();
+}
+
+}  // namespace ccl
+}  // namespace oneflow
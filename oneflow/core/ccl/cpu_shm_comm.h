@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_CCL_CPU_SHM_COMM_H_
+#define ONEFLOW_CORE_CCL_CPU_SHM_COMM_H_
+
+#include <mutex>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+
+namespace oneflow {
+namespace ccl {
+
+struct CpuShmCommHeader;
+struct CpuShmCommFlag;
+
+// Collectives among the processes of one host through a POSIX shared memory segment. Each process
+// owns a slot of the segment and a flag it bumps when it reaches a barrier. A round copies data
+// into the slot of the process, waits for the flags of the others and then reads their slots.
+// Slots are split in two halves used by alternate rounds, so that a process may start the next
+// round while the others still read the last one.
+class CpuShmComm final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuShmComm);
+  ~CpuShmComm();
+
+  // The process of local id 0 creates the segment, the others open it once Create returned. The
+  // name is unlinked when the last process has opened it.
+  static Maybe<CpuShmComm> Create(const std::string& name, int64_t size, size_t slot_bytes);
+  static Maybe<CpuShmComm> Open(const std::string& name, int64_t size, int64_t local_id);
+
+  int64_t size() const { return size_; }
+  int64_t local_id() const { return local_id_; }
+
+  template<typename T>
+  Maybe<void> AllReduce(const T* in, T* out, size_t elem_cnt);
+  // `in` holds size() blocks of elem_cnt elements, block i is summed up on local id i.
+  template<typename T>
+  Maybe<void> ReduceScatter(const T* in, T* out, size_t elem_cnt);
+  Maybe<void> AllGather(const void* in, void* out, size_t buffer_size);
+  Maybe<void> Broadcast(const void* in, void* out, size_t buffer_size, int64_t root);
+
+ private:
+  CpuShmComm(const std::string& name, void* ptr, size_t mapped_bytes, int64_t local_id);
+
+  char* NextRound();
+  char* Half(int64_t local_id) const;
+  Maybe<void> Barrier();
+
+  std::string name_;
+  void* ptr_;
+  size_t mapped_bytes_;
+  CpuShmCommHeader* header_;
+  CpuShmCommFlag* flags_;
+  char* data_;
+  int64_t size_;
+  int64_t local_id_;
+  size_t slot_bytes_;
+  size_t half_bytes_;
+  uint64_t round_;
+  uint64_t barrier_seq_;
+  std::mutex mutex_;
+};
+
+// With ONEFLOW_CCL_SHM=1, cpu all-reduce, reduce-scatter, all-gather and broadcast among ranks that
+// all run on one host go through a segment of ONEFLOW_CCL_SHM_SLOT_BYTES (1MB by default) per rank
+// in /dev/shm instead of the network. Groups fall back to the network when the segment can't be
+// created on any of their ranks. It is off by default.
+bool IsCpuShmCommEnabled();
+
+// Returns the communicator among `ranks`, which all run on the host of the current rank, and
+// creates it on first use, so every rank of the group has to ask for it at the same point like
+// for a collective. Groups of the same ranks with different `tag`s get different communicators, and
+// so do different threads.
+// Returns nullptr if the segment could not be created, callers then use the network.
+Maybe<CpuShmComm*> GetCpuShmComm(const std::vector<int64_t>& ranks, const std::string& tag);
+
+}  // namespace ccl
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_CCL_CPU_SHM_COMM_H_
@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <unistd.h>
+#include <thread>
+#include <gtest/gtest.h>
+#include "oneflow/core/ccl/cpu_shm_comm.h"
+#include "oneflow/core/common/benchmark_util.h"
+
+namespace oneflow {
+namespace ccl {
+namespace test {
+
+using oneflow::test::ElapsedMs;
+
+// Logs the all-reduce bandwidth among 4 local ids, threads stand in for the processes of one
+// host.
+TEST(CpuShmCommBenchmark, all_reduce) {
+  const int64_t size = 4;
+  for (size_t elem_cnt : {1 << 10, 1 << 16, 1 << 20, 1 << 22}) {
+    const std::string name = "/oneflow_ccl_benchmark_" + std::to_string(getpid()) + "_"
+                             + std::to_string(elem_cnt);
+    std::shared_ptr<CpuShmComm> creator = CHECK_JUST(CpuShmComm::Create(name, size, 1 << 20));
+    const auto Run = [&](CpuShmComm* comm) {
+      std::vector<float> in(elem_cnt, 1);
+      std::vector<float> out(elem_cnt);
+      CHECK_JUST(comm->AllReduce(in.data(), out.data(), elem_cnt));
+      const double ms = ElapsedMs(
+          [&]() { CHECK_JUST(comm->AllReduce(in.data(), out.data(), elem_cnt)); }, 10);
+      if (comm->local_id() == 0) {
+        const double bytes = elem_cnt * sizeof(float);
+        LOG(INFO) << "shm all_reduce " << bytes << " bytes on " << size << " local ids: " << ms
+                  << "ms, bus bandwidth " << 2.0 * (size - 1) / size * bytes / ms / 1e6 << "GB/s";
+      }
+    };
+    std::vector<std::thread> threads;
+    FOR_RANGE(int64_t, i, 1, size) {
+      threads.emplace_back([&, i]() {
+        std::shared_ptr<CpuShmComm> comm = CHECK_JUST(CpuShmComm::Open(name, size, i));
+        Run(comm.get());
+      });
+    }
+    Run(creator.get());
+    for (auto& thread : threads) { thread.join(); }
+  }
+}
+
+}  // namespace test
+}  // namespace ccl
+}  // namespace oneflow
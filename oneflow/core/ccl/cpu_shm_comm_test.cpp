@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <unistd.h>
+#include <thread>
+#include <gtest/gtest.h>
+#include "oneflow/core/ccl/cpu_shm_comm.h"
+
+namespace oneflow {
+namespace ccl {
+namespace test {
+
+namespace {
+
+// Threads stand in for the processes of one host, they map the segment at different addresses
+// just like processes do.
+void RunOnEachLocalId(int64_t size, size_t slot_bytes,
+                      const std::function<void(CpuShmComm*)>& Run) {
+  static int64_t segment_cnt = 0;
+  const std::string name =
+      "/oneflow_ccl_test_" + std::to_string(getpid()) + "_" + std::to_string(segment_cnt++);
+  std::shared_ptr<CpuShmComm> creator = CHECK_JUST(CpuShmComm::Create(name, size, slot_bytes));
+  std::vector<std::thread> threads;
+  FOR_RANGE(int64_t, i, 1, size) {
+    threads.emplace_back([&, i]() {
+      std::shared_ptr<CpuShmComm> comm = CHECK_JUST(CpuShmComm::Open(name, size, i));
+      Run(comm.get());
+    });
+  }
+  Run(creator.get());
+  for (auto& thread : threads) { thread.join(); }
+}
+
+}  // namespace
+
+TEST(CpuShmComm, collectives) {
+  const int64_t size = 4;
+  // Small slots, so that the larger buffers take many rounds.
+  const size_t slot_bytes = 1024;
+  for (size_t elem_cnt : {1, 7, 64, 1000, 4097}) {
+    RunOnEachLocalId(size, slot_bytes, [&](CpuShmComm* comm) {
+      const int64_t id = comm->local_id();
+      std::vector<float> in(elem_cnt);
+      FOR_RANGE(size_t, j, 0, elem_cnt) { in[j] = id * 1000 + j % 13; }
+      std::vector<float> out(elem_cnt);
+      CHECK_JUST(comm->AllReduce(in.data(), out.data(), elem_cnt));
+      FOR_RANGE(size_t, j, 0, elem_cnt) { ASSERT_EQ(out[j], 6000 + 4 * (j % 13)); }
+
+      std::vector<int64_t> blocks(size * elem_cnt);
+      FOR_RANGE(size_t, j, 0, blocks.size()) { blocks[j] = id + j; }
+      std::vector<int64_t> reduced(elem_cnt);
+      CHECK_JUST(comm->ReduceScatter(blocks.data(), reduced.data(), elem_cnt));
+      FOR_RANGE(size_t, j, 0, elem_cnt) {
+        ASSERT_EQ(reduced[j], static_cast<int64_t>(6 + 4 * (id * elem_cnt + j)));
+      }
+
+      std::vector<float> gathered(size * elem_cnt);
+      CHECK_JUST(comm->AllGather(in.data(), gathered.data(), elem_cnt * sizeof(float)));
+      FOR_RANGE(size_t, j, 0, gathered.size()) {
+        ASSERT_EQ(gathered[j], (j / elem_cnt) * 1000 + (j % elem_cnt) % 13);
+      }
+
+      std::vector<float> broadcast(elem_cnt);
+      CHECK_JUST(comm->Broadcast(in.data(), broadcast.data(), elem_cnt * sizeof(float), 2));
+      FOR_RANGE(size_t, j, 0, elem_cnt) { ASSERT_EQ(broadcast[j], 2000 + j % 13); }
+    });
+  }
+}
+
+}  // namespace test
+}  // namespace ccl
+}  // namespace oneflow
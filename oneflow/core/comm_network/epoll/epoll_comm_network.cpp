@@ -88,6 +88,7 @@ EpollCommNet::~EpollCommNet() {
     pollers_[i]->Stop();
   }
   OF_ENV_BARRIER();
+  LogPeerStats();
   for (IOEventPoller* poller : pollers_) { delete poller; }
   for (auto& pair : sockfd2helper_) { delete pair.second; }
 }
@@ -125,6 +126,7 @@ EpollCommNet::EpollCommNet() : CommNetIf() {
   for (size_t i = 0; i < pollers_.size(); ++i) { pollers_[i] = new IOEventPoller; }
   InitSockets();
   for (IOEventPoller* poller : pollers_) { poller->Start(); }
+  start_time_ = std::chrono::steady_clock::now();
 }
 
 void EpollCommNet::InitSockets() {
@@ -198,6 +200,20 @@ void EpollCommNet::InitSockets() {
   }
 }
 
+void EpollCommNet::LogPeerStats() const {
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+  FOR_RANGE(size_t, machine_id, 0, machine_id2sockfd_.size()) {
+    if (machine_id2sockfd_.at(machine_id) == -1) { continue; }
+    const SocketHelper* helper = sockfd2helper_.at(machine_id2sockfd_.at(machine_id));
+    const int64_t num_msgs = helper->num_sent_msgs();
+    const int64_t num_frames = helper->num_sent_frames();
+    LOG(INFO) << "CommNet to machine " << machine_id << ": " << num_msgs << " msgs in "
+              << num_frames << " frames, " << num_msgs / seconds << " msgs/s, "
+              << num_frames / seconds << " frames/s";
+  }
+}
+
 SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id) {
   int sockfd = machine_id2sockfd_.at(machine_id);
   return sockfd2helper_.at(sockfd);
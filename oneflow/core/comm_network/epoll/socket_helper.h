@@ -34,6 +34,9 @@ class SocketHelper final {
 
   void AsyncWrite(const SocketMsg& msg);
 
+  int64_t num_sent_msgs() const { return write_helper_->num_msgs(); }
+  int64_t num_sent_frames() const { return write_helper_->num_frames(); }
+
  private:
   SocketReadHelper* read_helper_;
   SocketWriteHelper* write_helper_;
@@ -0,0 +1,226 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include <gtest/gtest.h>
+#include <netinet/tcp.h>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include "oneflow/core/comm_network/epoll/io_event_poller.h"
+#include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+#include "oneflow/core/comm_network/epoll/socket_read_helper.h"
+#include "oneflow/core/comm_network/epoll/socket_write_helper.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+// The read helper sets TCP options on its socket, so the two ends are a loopback TCP connection
+// rather than a socketpair(2). The reading end is non-blocking like the sockets of EpollCommNet.
+void NewConnectedSockets(int* write_fd, int* read_fd) {
+  const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(listen_fd != -1);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  PCHECK(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+  PCHECK(listen(listen_fd, 1) == 0);
+  socklen_t addr_len = sizeof(addr);
+  PCHECK(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0);
+  *write_fd = socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(*write_fd != -1);
+  PCHECK(connect(*write_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+  const int val = 1;
+  PCHECK(setsockopt(*write_fd, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(val)) == 0);
+  *read_fd = accept(listen_fd, nullptr, nullptr);
+  PCHECK(*read_fd != -1);
+  PCHECK(close(listen_fd) == 0);
+  const int opt = fcntl(*read_fd, F_GETFL);
+  PCHECK(opt != -1);
+  PCHECK(fcntl(*read_fd, F_SETFL, opt | O_NONBLOCK) == 0);
+}
+
+class SocketPair final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(SocketPair);
+  SocketPair() { NewConnectedSockets(&write_fd_, &read_fd_); }
+  ~SocketPair() {
+    PCHECK(close(write_fd_) == 0);
+    PCHECK(close(read_fd_) == 0);
+  }
+
+  int write_fd() const { return write_fd_; }
+  int read_fd() const { return read_fd_; }
+
+  void WriteAll(const void* data, size_t size) {
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0) {
+      const ssize_t n = write(write_fd_, ptr, size);
+      PCHECK(n > 0);
+      ptr += n;
+      size -= n;
+    }
+  }
+
+ private:
+  int write_fd_;
+  int read_fd_;
+};
+
+SocketMsg NewRequestWriteMsg(int64_t id) {
+  SocketMsg msg;
+  msg.msg_type = SocketMsgType::kRequestWrite;
+  msg.request_write_msg.src_token = nullptr;
+  msg.request_write_msg.dst_machine_id = 0;
+  msg.request_write_msg.dst_token = nullptr;
+  msg.request_write_msg.read_id = reinterpret_cast<void*>(id);
+  return msg;
+}
+
+// Both tokens point to `mem_desc`, the writer reads the body from it and the reader writes there.
+SocketMsg NewRequestReadMsg(int64_t id, SocketMemDesc* mem_desc) {
+  SocketMsg msg;
+  msg.msg_type = SocketMsgType::kRequestRead;
+  msg.request_read_msg.src_token = mem_desc;
+  msg.request_read_msg.dst_token = mem_desc;
+  msg.request_read_msg.read_id = reinterpret_cast<void*>(id);
+  return msg;
+}
+
+int64_t MsgId(const SocketMsg& msg) {
+  if (msg.msg_type == SocketMsgType::kRequestRead) {
+    return reinterpret_cast<int64_t>(msg.request_read_msg.read_id);
+  }
+  return reinterpret_cast<int64_t>(msg.request_write_msg.read_id);
+}
+
+std::vector<char> NewBody(size_t size, char seed) {
+  std::vector<char> body(size);
+  FOR_RANGE(size_t, i, 0, size) { body[i] = static_cast<char>(seed + i * 7); }
+  return body;
+}
+
+class Reader final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Reader);
+  explicit Reader(int sockfd)
+      : helper_(sockfd, [this](const SocketMsg& msg) { msg_ids_.push_back(MsgId(msg)); }) {}
+
+  // Reads until `msg_num` messages are handled, the data written on loopback may arrive late.
+  const std::vector<int64_t>& ReadMsgs(size_t msg_num) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (true) {
+      helper_.NotifyMeSocketReadable();
+      if (msg_ids_.size() >= msg_num || std::chrono::steady_clock::now() > deadline) { break; }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return msg_ids_;
+  }
+
+ private:
+  std::vector<int64_t> msg_ids_;
+  SocketReadHelper helper_;
+};
+
+}  // namespace
+
+TEST(SocketReadHelper, frame_of_several_msgs) {
+  SocketPair sockets;
+  Reader reader(sockets.read_fd());
+  std::vector<SocketMsg> frame{NewRequestWriteMsg(1), NewRequestWriteMsg(2),
+                               NewRequestWriteMsg(3)};
+  sockets.WriteAll(frame.data(), frame.size() * sizeof(SocketMsg));
+  ASSERT_EQ(reader.ReadMsgs(3), (std::vector<int64_t>{1, 2, 3}));
+}
+
+TEST(SocketReadHelper, frame_split_across_reads) {
+  SocketPair sockets;
+  Reader reader(sockets.read_fd());
+  std::vector<char> body = NewBody(1000, 3);
+  std::vector<char> dst(body.size());
+  SocketMemDesc mem_desc{dst.data(), dst.size()};
+  std::vector<char> bytes(3 * sizeof(SocketMsg) + body.size());
+  const SocketMsg msgs[] = {NewRequestWriteMsg(1), NewRequestReadMsg(2, &mem_desc),
+                            NewRequestWriteMsg(3)};
+  std::memcpy(bytes.data(), &msgs[0], 2 * sizeof(SocketMsg));
+  std::memcpy(bytes.data() + 2 * sizeof(SocketMsg), body.data(), body.size());
+  std::memcpy(bytes.data() + 2 * sizeof(SocketMsg) + body.size(), &msgs[2], sizeof(SocketMsg));
+  // Cut in the middle of the second head, then in the middle of the body.
+  const size_t cuts[] = {0, sizeof(SocketMsg) + sizeof(SocketMsg) / 2,
+                         2 * sizeof(SocketMsg) + body.size() / 2, bytes.size()};
+  const size_t msg_nums[] = {1, 1, 3};
+  FOR_RANGE(int, i, 0, 3) {
+    sockets.WriteAll(bytes.data() + cuts[i], cuts[i + 1] - cuts[i]);
+    ASSERT_EQ(reader.ReadMsgs(msg_nums[i]).size(), msg_nums[i]);
+  }
+  ASSERT_EQ(reader.ReadMsgs(3), (std::vector<int64_t>{1, 2, 3}));
+  ASSERT_EQ(dst, body);
+}
+
+TEST(SocketReadHelper, body_in_read_ahead_buffer) {
+  // The first body is read ahead with the heads, the second one is larger than the buffer and
+  // only its first part is.
+  const size_t read_buf_size = SocketFrameMaxMsgNum() * sizeof(SocketMsg);
+  for (size_t body_size : {size_t(100), 3 * read_buf_size + 5}) {
+    SocketPair sockets;
+    Reader reader(sockets.read_fd());
+    std::vector<char> body = NewBody(body_size, 5);
+    std::vector<char> dst(body.size());
+    SocketMemDesc mem_desc{dst.data(), dst.size()};
+    const SocketMsg head = NewRequestReadMsg(1, &mem_desc);
+    const SocketMsg next = NewRequestWriteMsg(2);
+    std::vector<char> bytes(2 * sizeof(SocketMsg) + body.size());
+    std::memcpy(bytes.data(), &head, sizeof(SocketMsg));
+    std::memcpy(bytes.data() + sizeof(SocketMsg), body.data(), body.size());
+    std::memcpy(bytes.data() + sizeof(SocketMsg) + body.size(), &next, sizeof(SocketMsg));
+    sockets.WriteAll(bytes.data(), bytes.size());
+    ASSERT_EQ(reader.ReadMsgs(2), (std::vector<int64_t>{1, 2}));
+    ASSERT_EQ(dst, body);
+  }
+}
+
+TEST(SocketWriteHelper, frames) {
+  SocketPair sockets;
+  IOEventPoller poller;
+  SocketWriteHelper writer(sockets.write_fd(), &poller);
+  Reader reader(sockets.read_fd());
+  std::vector<char> body = NewBody(5000, 7);
+  std::vector<char> dst(body.size());
+  SocketMemDesc mem_desc{body.data(), body.size()};
+  SocketMemDesc dst_mem_desc{dst.data(), dst.size()};
+  // A frame is cut after a kRequestRead message, its body follows, and at the frame size limit.
+  const int64_t msg_num = SocketFrameMaxMsgNum() + 3;
+  writer.AsyncWrite(NewRequestWriteMsg(0));
+  SocketMsg request_read = NewRequestReadMsg(1, &mem_desc);
+  request_read.request_read_msg.dst_token = &dst_mem_desc;
+  writer.AsyncWrite(request_read);
+  FOR_RANGE(int64_t, i, 2, msg_num) { writer.AsyncWrite(NewRequestWriteMsg(i)); }
+  writer.NotifyMeSocketWriteable();
+  std::vector<int64_t> expected(msg_num);
+  std::iota(expected.begin(), expected.end(), 0);
+  ASSERT_EQ(reader.ReadMsgs(msg_num), expected);
+  ASSERT_EQ(dst, body);
+  ASSERT_EQ(writer.num_msgs(), msg_num);
+  ASSERT_EQ(writer.num_frames(), 3);
+}
+
+}  // namespace test
+}  // namespace oneflow
+
+#endif  // __linux__
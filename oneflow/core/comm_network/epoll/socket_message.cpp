@@ -0,0 +1,30 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/comm_network/epoll/socket_message.h"
+
+namespace oneflow {
+
+size_t SocketFrameMaxMsgNum() {
+  static const size_t max_msg_num = ParseIntegerFromEnv("ONEFLOW_COMM_NET_FRAME_MAX_MSG_NUM", 64);
+  CHECK_GT(max_msg_num, 0);
+  return max_msg_num;
+}
+
+}  // namespace oneflow
+
+#endif  // __linux__
@@ -71,6 +71,11 @@ struct SocketMsg {
 
 using CallBackList = std::list<std::function<void()>>;
 
+// SocketMsgs queued for the same peer are written back to back in frames of at most this many
+// messages, a frame is also cut at a message followed by a body and when the queue runs empty.
+// Frames are a plain sequence of SocketMsgs, so the reader needs no framing.
+size_t SocketFrameMaxMsgNum();
+
 }  // namespace oneflow
 
 #endif  // OF_PLATFORM_POSIX
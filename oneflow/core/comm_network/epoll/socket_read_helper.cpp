@@ -21,15 +21,51 @@ limitations under the License.
 #include "oneflow/core/transport/transport.h"
 
 #include <netinet/tcp.h>
+#include <cstring>
 
 namespace oneflow {
 
+namespace {
+
+void HandleSocketMsg(const SocketMsg& msg) {
+  switch (msg.msg_type) {
+    case SocketMsgType::kRequestWrite: {
+      SocketMsg msg_to_send;
+      msg_to_send.msg_type = SocketMsgType::kRequestRead;
+      msg_to_send.request_read_msg.src_token = msg.request_write_msg.src_token;
+      msg_to_send.request_read_msg.dst_token = msg.request_write_msg.dst_token;
+      msg_to_send.request_read_msg.read_id = msg.request_write_msg.read_id;
+      Global<EpollCommNet>::Get()->SendSocketMsg(msg.request_write_msg.dst_machine_id,
+                                                 msg_to_send);
+      break;
+    }
+    case SocketMsgType::kRequestRead:
+      Global<EpollCommNet>::Get()->ReadDone(msg.request_read_msg.read_id);
+      break;
+    case SocketMsgType::kActor:
+      Global<ActorMsgBus>::Get()->SendMsgWithoutCommNet(msg.actor_msg);
+      break;
+    case SocketMsgType::kTransport:
+      Global<Transport>::Get()->EnqueueTransportMsg(msg.transport_msg);
+      break;
+    default: UNIMPLEMENTED();
+  }
+}
+
+}  // namespace
+
 SocketReadHelper::~SocketReadHelper() {
   // do nothing
 }
 
-SocketReadHelper::SocketReadHelper(int sockfd) {
+SocketReadHelper::SocketReadHelper(int sockfd) : SocketReadHelper(sockfd, &HandleSocketMsg) {}
+
+SocketReadHelper::SocketReadHelper(int sockfd, const SocketMsgHandler& msg_handler)
+    : msg_handler_(msg_handler) {
   sockfd_ = sockfd;
+  read_buf_.resize(SocketFrameMaxMsgNum() * sizeof(SocketMsg));
+  read_buf_begin_ = 0;
+  read_buf_end_ = 0;
   SwitchToMsgHeadReadHandle();
 }
 
@@ -37,8 +73,8 @@ void SocketReadHelper::NotifyMeSocketReadable() { ReadUntilSocketNotReadable();
 
 void SocketReadHelper::SwitchToMsgHeadReadHandle() {
   cur_read_handle_ = &SocketReadHelper::MsgHeadReadHandle;
-  read_ptr_ = reinterpret_cast<char*>(&cur_msg_);
-  read_size_ = sizeof(cur_msg_);
+  read_ptr_ = nullptr;
+  read_size_ = 0;
 }
 
 void SocketReadHelper::ReadUntilSocketNotReadable() {
@@ -46,13 +82,47 @@ void SocketReadHelper::ReadUntilSocketNotReadable() {
 }
 
 bool SocketReadHelper::MsgHeadReadHandle() {
-  return DoCurRead(&SocketReadHelper::SetStatusWhenMsgHeadDone);
+  if (read_buf_end_ - read_buf_begin_ < sizeof(cur_msg_)) { return FillReadBuf(); }
+  std::memcpy(&cur_msg_, read_buf_.data() + read_buf_begin_, sizeof(cur_msg_));
+  read_buf_begin_ += sizeof(cur_msg_);
+  SetStatusWhenMsgHeadDone();
+  return true;
 }
 
 bool SocketReadHelper::MsgBodyReadHandle() {
+  // The part of the body read ahead with the heads is copied, the rest is read in place.
+  const size_t buffered_size = std::min(read_size_, read_buf_end_ - read_buf_begin_);
+  if (buffered_size > 0) {
+    std::memcpy(read_ptr_, read_buf_.data() + read_buf_begin_, buffered_size);
+    read_buf_begin_ += buffered_size;
+    read_ptr_ += buffered_size;
+    read_size_ -= buffered_size;
+    if (read_size_ == 0) {
+      SetStatusWhenMsgBodyDone();
+      return true;
+    }
+  }
   return DoCurRead(&SocketReadHelper::SetStatusWhenMsgBodyDone);
 }
 
+bool SocketReadHelper::FillReadBuf() {
+  std::memmove(read_buf_.data(), read_buf_.data() + read_buf_begin_,
+               read_buf_end_ - read_buf_begin_);
+  read_buf_end_ -= read_buf_begin_;
+  read_buf_begin_ = 0;
+  ssize_t n = read(sockfd_, read_buf_.data() + read_buf_end_, read_buf_.size() - read_buf_end_);
+  const int val = 1;
+  PCHECK(setsockopt(sockfd_, IPPROTO_TCP, TCP_QUICKACK, (char*)&val, sizeof(int)) == 0);
+  if (n >= 0) {
+    read_buf_end_ += n;
+    return true;
+  } else {
+    CHECK_EQ(n, -1);
+    PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+    return false;
+  }
+}
+
 bool SocketReadHelper::DoCurRead(void (SocketReadHelper::*set_cur_read_done)()) {
   ssize_t n = read(sockfd_, read_ptr_, read_size_);
   const int val = 1;
@@ -82,20 +152,12 @@ void SocketReadHelper::SetStatusWhenMsgHeadDone() {
 }
 
 void SocketReadHelper::SetStatusWhenMsgBodyDone() {
-  if (cur_msg_.msg_type == SocketMsgType::kRequestRead) {
-    Global<EpollCommNet>::Get()->ReadDone(cur_msg_.request_read_msg.read_id);
-  }
+  msg_handler_(cur_msg_);
   SwitchToMsgHeadReadHandle();
 }
 
 void SocketReadHelper::SetStatusWhenRequestWriteMsgHeadDone() {
-  SocketMsg msg_to_send;
-  msg_to_send.msg_type = SocketMsgType::kRequestRead;
-  msg_to_send.request_read_msg.src_token = cur_msg_.request_write_msg.src_token;
-  msg_to_send.request_read_msg.dst_token = cur_msg_.request_write_msg.dst_token;
-  msg_to_send.request_read_msg.read_id = cur_msg_.request_write_msg.read_id;
-  Global<EpollCommNet>::Get()->SendSocketMsg(cur_msg_.request_write_msg.dst_machine_id,
-                                             msg_to_send);
+  msg_handler_(cur_msg_);
   SwitchToMsgHeadReadHandle();
 }
 
@@ -107,12 +169,12 @@ void SocketReadHelper::SetStatusWhenRequestReadMsgHeadDone() {
 }
 
 void SocketReadHelper::SetStatusWhenActorMsgHeadDone() {
-  Global<ActorMsgBus>::Get()->SendMsgWithoutCommNet(cur_msg_.actor_msg);
+  msg_handler_(cur_msg_);
   SwitchToMsgHeadReadHandle();
 }
 
 void SocketReadHelper::SetStatusWhenTransportMsgHeadDone() {
-  Global<Transport>::Get()->EnqueueTransportMsg(cur_msg_.transport_msg);
+  msg_handler_(cur_msg_);
   SwitchToMsgHeadReadHandle();
 }
 
@@ -22,13 +22,18 @@ limitations under the License.
 
 namespace oneflow {
 
+// Called with every message read, once its body, if any, is read too.
+using SocketMsgHandler = std::function<void(const SocketMsg&)>;
+
 class SocketReadHelper final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SocketReadHelper);
   SocketReadHelper() = delete;
   ~SocketReadHelper();
 
+  // Hands the messages to EpollCommNet, ActorMsgBus and Transport.
   SocketReadHelper(int sockfd);
+  SocketReadHelper(int sockfd, const SocketMsgHandler& msg_handler);
 
   void NotifyMeSocketReadable();
 
@@ -38,6 +43,7 @@ class SocketReadHelper final {
 
   bool MsgHeadReadHandle();
   bool MsgBodyReadHandle();
+  bool FillReadBuf();
 
   bool DoCurRead(void (SocketReadHelper::*set_cur_read_done)());
   void SetStatusWhenMsgHeadDone();
@@ -48,6 +54,12 @@ class SocketReadHelper final {
 #undef MAKE_ENTRY
 
   int sockfd_;
+  SocketMsgHandler msg_handler_;
+
+  // Bytes read ahead of the messages already handled, a frame of heads usually arrives in one read.
+  std::vector<char> read_buf_;
+  size_t read_buf_begin_;
+  size_t read_buf_end_;
 
   SocketMsg cur_msg_;
   bool (SocketReadHelper::*cur_read_handle_)();
@@ -43,6 +43,9 @@ SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller) {
   cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
   write_ptr_ = nullptr;
   write_size_ = 0;
+  frame_.reserve(SocketFrameMaxMsgNum());
+  num_msgs_ = 0;
+  num_frames_ = 0;
 }
 
 void SocketWriteHelper::AsyncWrite(const SocketMsg& msg) {
@@ -71,18 +74,26 @@ void SocketWriteHelper::WriteUntilMsgQueueEmptyOrSocketNotWriteable() {
 }
 
 bool SocketWriteHelper::InitMsgWriteHandle() {
-  if (cur_msg_queue_->empty()) {
-    {
-      std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
-      std::swap(cur_msg_queue_, pending_msg_queue_);
+  frame_.clear();
+  while (frame_.size() < SocketFrameMaxMsgNum()) {
+    if (cur_msg_queue_->empty()) {
+      {
+        std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
+        std::swap(cur_msg_queue_, pending_msg_queue_);
+      }
+      if (cur_msg_queue_->empty()) { break; }
     }
-    if (cur_msg_queue_->empty()) { return false; }
+    frame_.push_back(cur_msg_queue_->front());
+    cur_msg_queue_->pop();
+    if (frame_.back().msg_type == SocketMsgType::kRequestRead) { break; }
   }
-  cur_msg_ = cur_msg_queue_->front();
-  cur_msg_queue_->pop();
-  write_ptr_ = reinterpret_cast<const char*>(&cur_msg_);
-  write_size_ = sizeof(cur_msg_);
+  if (frame_.empty()) { return false; }
+  cur_msg_ = frame_.back();
+  write_ptr_ = reinterpret_cast<const char*>(frame_.data());
+  write_size_ = frame_.size() * sizeof(SocketMsg);
   cur_write_handle_ = &SocketWriteHelper::MsgHeadWriteHandle;
+  num_msgs_ += frame_.size();
+  num_frames_ += 1;
   return true;
 }
 
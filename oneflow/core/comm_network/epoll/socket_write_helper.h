@@ -35,6 +35,10 @@ class SocketWriteHelper final {
 
   void NotifyMeSocketWriteable();
 
+  // Only meaningful once the poller of this helper has stopped.
+  int64_t num_msgs() const { return num_msgs_; }
+  int64_t num_frames() const { return num_frames_; }
+
  private:
   void SendQueueNotEmptyEvent();
   void ProcessQueueNotEmptyEvent();
@@ -60,10 +64,15 @@ class SocketWriteHelper final {
   std::mutex pending_msg_queue_mtx_;
   std::queue<SocketMsg>* pending_msg_queue_;
 
+  // cur_msg_ is the last message of frame_, the one whose body, if any, follows the frame.
+  std::vector<SocketMsg> frame_;
   SocketMsg cur_msg_;
   bool (SocketWriteHelper::*cur_write_handle_)();
   const char* write_ptr_;
   size_t write_size_;
+
+  int64_t num_msgs_;
+  int64_t num_frames_;
 };
 
 }  // namespace oneflow
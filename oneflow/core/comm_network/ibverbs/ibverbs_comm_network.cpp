@@ -139,14 +139,15 @@ IBVerbsCommNet::IBVerbsCommNet() : CommNetIf(), poll_exit_flag_(ATOMIC_FLAG_INIT
   const uint8_t port = user_port == 0 ? 1 : user_port;
   CHECK_EQ(ibv::wrapper.ibv_query_port_wrap(context_, port, &port_attr), 0);
   ibv_gid gid{};
-  const int64_t gid_index = ParseIntegerFromEnv("ONEFLOW_COMM_NET_IB_GID_INDEX", 0);
+  const int64_t gid_index = IBVerbsGidIndex(context_, port, port_attr);
   CHECK_EQ(ibv::wrapper.ibv_query_gid(context_, port, gid_index, &gid), 0);
   LOG(INFO) << "Using IB device " << device->name << " port " << static_cast<int32_t>(port)
-            << " gid index " << gid_index;
+            << " gid index " << gid_index << " link layer "
+            << (port_attr.link_layer == IBV_LINK_LAYER_ETHERNET ? "Ethernet" : "InfiniBand");
   int64_t this_machine_id = GlobalProcessCtx::Rank();
   qp_vec_.assign(Global<ResourceDesc, ForEnv>::Get()->process_ranks().size(), nullptr);
   for (int64_t peer_id : peer_machine_id()) {
-    IBVerbsQP* cur_qp = new IBVerbsQP(context_, pd_, port, cq_, cq_);
+    IBVerbsQP* cur_qp = new IBVerbsQP(context_, pd_, port, gid_index, cq_, cq_);
     qp_vec_.at(peer_id) = cur_qp;
     IBVerbsConnectionInfo conn_info;
     conn_info.set_lid(port_attr.lid);
@@ -203,7 +204,8 @@ void IBVerbsCommNet::PollCQ() {
       IBVerbsQP* qp = wr_id->qp;
       switch (wc.opcode) {
         case IBV_WC_RDMA_READ: {
-          qp->ReadDone(wr_id);
+          void* read_id = qp->ReadDone(wr_id);
+          if (read_id != nullptr) { ReadDone(read_id); }
           break;
         }
         case IBV_WC_SEND: {
@@ -211,7 +213,7 @@ void IBVerbsCommNet::PollCQ() {
           break;
         }
         case IBV_WC_RECV: {
-          qp->RecvDone(wr_id);
+          RecvActorMsg(qp->RecvDone(wr_id));
           break;
         }
         default: UNIMPLEMENTED();
@@ -14,10 +14,6 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/comm_network/ibverbs/ibverbs_qp.h"
-#include "oneflow/core/comm_network/comm_network.h"
-#include "oneflow/core/lazy/actor/actor_message_bus.h"
-#include "oneflow/core/job/resource_desc.h"
-#include "oneflow/core/job/global_for.h"
 #include "oneflow/core/platform/include/ibv.h"
 #include "oneflow/core/comm_network/ibverbs/ibverbs_comm_network.h"
 
@@ -29,15 +25,48 @@ namespace {
 
 constexpr uint32_t kDefaultQueueDepth = 1024;
 constexpr uint64_t kDefaultMemBlockSize = 8388608;  // 8M
+constexpr int64_t kDefaultMaxPostSendWRNum = 32;
+
+bool IsIPv4MappedGid(const ibv_gid& gid) {
+  // ::ffff:a.b.c.d
+  FOR_RANGE(int, i, 0, 10) {
+    if (gid.raw[i] != 0) { return false; }
+  }
+  return gid.raw[10] == 0xff && gid.raw[11] == 0xff;
+}
 
 }  // namespace
 
-IBVerbsQP::IBVerbsQP(ibv_context* ctx, ibv_pd* pd, uint8_t port_num, ibv_cq* send_cq,
-                     ibv_cq* recv_cq) {
+int64_t IBVerbsGidIndex(ibv_context* ctx, uint8_t port_num, const ibv_port_attr& port_attr) {
+  const int64_t user_gid_index = ParseIntegerFromEnv("ONEFLOW_COMM_NET_IB_GID_INDEX", -1);
+  if (user_gid_index >= 0) { return user_gid_index; }
+  if (port_attr.link_layer == IBV_LINK_LAYER_ETHERNET) {
+    // RoCE v2 GIDs are routable, prefer them over the RoCE v1 GIDs of the same addresses. Without
+    // the type of the GIDs, take the first IPv4 one.
+    int64_t ipv4_gid_index = -1;
+    FOR_RANGE(int, i, 0, port_attr.gid_tbl_len) {
+      ibv_gid gid{};
+      if (ibv::wrapper.ibv_query_gid(ctx, port_num, i, &gid) != 0) { continue; }
+      if (!IsIPv4MappedGid(gid)) { continue; }
+      if (ipv4_gid_index == -1) { ipv4_gid_index = i; }
+      int gid_type = -1;
+      if (ibv::wrapper.ibv_query_gid_type_wrap(ctx, port_num, i, &gid_type) == 0
+          && gid_type == ibv::kIBVGidTypeRoCEv2) {
+        return i;
+      }
+    }
+    if (ipv4_gid_index != -1) { return ipv4_gid_index; }
+  }
+  return 0;
+}
+
+IBVerbsQP::IBVerbsQP(ibv_context* ctx, ibv_pd* pd, uint8_t port_num, int64_t gid_index,
+                     ibv_cq* send_cq, ibv_cq* recv_cq) {
   // ctx_, pd_
   ctx_ = ctx;
   pd_ = pd;
   port_num_ = port_num;
+  gid_index_ = gid_index;
   // qp_
   ibv_device_attr device_attr{};
   CHECK_EQ(ibv::wrapper.ibv_query_device(ctx, &device_attr), 0);
@@ -65,6 +94,8 @@ IBVerbsQP::IBVerbsQP(ibv_context* ctx, ibv_pd* pd, uint8_t port_num, ibv_cq* sen
   CHECK(send_msg_buf_.empty());
   num_outstanding_send_wr_ = 0;
   max_outstanding_send_wr_ = queue_depth;
+  max_post_send_wr_num_ = std::max<int64_t>(
+      ParseIntegerFromEnv("ONEFLOW_COMM_NET_IB_MAX_POST_SEND_WR_NUM", kDefaultMaxPostSendWRNum), 1);
   read_block_size_ =
       ParseIntegerFromEnv("ONEFLOW_COMM_NET_IB_MEM_BLOCK_SIZE", kDefaultMemBlockSize);
 }
@@ -104,8 +135,7 @@ void IBVerbsQP::Connect(const IBVerbsConnectionInfo& peer_info) {
     qp_attr.ah_attr.grh.dgid.global.subnet_prefix = peer_info.subnet_prefix();
     qp_attr.ah_attr.grh.dgid.global.interface_id = peer_info.interface_id();
     qp_attr.ah_attr.grh.flow_label = 0;
-    const int64_t gid_index = ParseIntegerFromEnv("ONEFLOW_COMM_NET_IB_GID_INDEX", 0);
-    qp_attr.ah_attr.grh.sgid_index = gid_index;
+    qp_attr.ah_attr.grh.sgid_index = gid_index_;
     qp_attr.ah_attr.grh.hop_limit = 255;
     // TODO(liujuncheng): Make traffic_class configurable;
     qp_attr.ah_attr.grh.traffic_class = 0;
@@ -151,6 +181,7 @@ void IBVerbsQP::PostReadRequest(const IBVerbsCommNetRMADesc& remote_mem,
   const size_t block_num = RoundUp(remote_mem.mem_size, read_block_size_) / read_block_size_;
   wr_id->outstanding_sge_cnt = static_cast<int32_t>(block_num);
   wr_id->read_id = read_id;
+  std::vector<std::pair<ibv_send_wr, ibv_sge>> wrs(block_num);
   FOR_RANGE(size_t, i, 0, block_num) {
     ibv_send_wr wr{};
     ibv_sge sge{};
@@ -166,8 +197,9 @@ void IBVerbsQP::PostReadRequest(const IBVerbsCommNetRMADesc& remote_mem,
     wr.imm_data = 0;
     wr.wr.rdma.remote_addr = remote_mem.mem_ptr + i * read_block_size_;
     wr.wr.rdma.rkey = remote_mem.mr_rkey;
-    EnqueuePostSendReadWR(wr, sge);
+    wrs.at(i) = std::make_pair(wr, sge);
   }
+  EnqueuePostSendReadWRs(wrs);
 }
 
 void IBVerbsQP::PostSendRequest(const ActorMsg& msg) {
@@ -188,29 +220,25 @@ void IBVerbsQP::PostSendRequest(const ActorMsg& msg) {
   wr.send_flags = 0;
   wr.imm_data = 0;
   memset(&(wr.wr), 0, sizeof(wr.wr));
-  EnqueuePostSendReadWR(wr, sge);
+  EnqueuePostSendReadWRs({std::make_pair(wr, sge)});
 }
 
-void IBVerbsQP::EnqueuePostSendReadWR(ibv_send_wr wr, ibv_sge sge) {
+void IBVerbsQP::EnqueuePostSendReadWRs(const std::vector<std::pair<ibv_send_wr, ibv_sge>>& wrs) {
   std::unique_lock<std::mutex> pending_send_wr_lock_(pending_send_wr_mutex_);
-  if (num_outstanding_send_wr_ < max_outstanding_send_wr_) {
-    num_outstanding_send_wr_++;
-    ibv_send_wr* bad_wr = nullptr;
-    CHECK_EQ(ibv_post_send(qp_, &wr, &bad_wr), 0);
-  } else {
-    std::pair<ibv_send_wr, ibv_sge> ibv_send_wr_sge = std::make_pair(wr, sge);
-    pending_send_wr_queue_.push(ibv_send_wr_sge);
-  }
+  for (const auto& wr : wrs) { pending_send_wr_queue_.push(wr); }
+  PostPendingSendReadWRs();
 }
 
-void IBVerbsQP::ReadDone(WorkRequestId* wr_id) {
+void* IBVerbsQP::ReadDone(WorkRequestId* wr_id) {
   CHECK_GE(wr_id->outstanding_sge_cnt, 1);
   wr_id->outstanding_sge_cnt -= 1;
+  void* read_id = nullptr;
   if (wr_id->outstanding_sge_cnt == 0) {
-    Global<CommNet>::Get()->ReadDone(wr_id->read_id);
+    read_id = wr_id->read_id;
     DeleteWorkRequestId(wr_id);
   }
-  PostPendingSendWR();
+  SendReadWRDone();
+  return read_id;
 }
 
 void IBVerbsQP::SendDone(WorkRequestId* wr_id) {
@@ -219,28 +247,43 @@ void IBVerbsQP::SendDone(WorkRequestId* wr_id) {
     send_msg_buf_.push(wr_id->msg_mr);
   }
   DeleteWorkRequestId(wr_id);
-  PostPendingSendWR();
+  SendReadWRDone();
 }
 
-void IBVerbsQP::RecvDone(WorkRequestId* wr_id) {
-  auto* ibv_comm_net = dynamic_cast<IBVerbsCommNet*>(Global<CommNet>::Get());
-  CHECK(ibv_comm_net != nullptr);
-  ibv_comm_net->RecvActorMsg(wr_id->msg_mr->msg());
+ActorMsg IBVerbsQP::RecvDone(WorkRequestId* wr_id) {
+  const ActorMsg msg = wr_id->msg_mr->msg();
   PostRecvRequest(wr_id->msg_mr);
   DeleteWorkRequestId(wr_id);
+  return msg;
 }
 
-void IBVerbsQP::PostPendingSendWR() {
+void IBVerbsQP::SendReadWRDone() {
   std::unique_lock<std::mutex> pending_send_wr_lock_(pending_send_wr_mutex_);
-  if (pending_send_wr_queue_.empty() == false) {
-    std::pair<ibv_send_wr, ibv_sge> ibv_send_wr_sge = std::move(pending_send_wr_queue_.front());
-    ibv_send_wr wr = ibv_send_wr_sge.first;
-    wr.sg_list = &ibv_send_wr_sge.second;
-    pending_send_wr_queue_.pop();
+  CHECK_GT(num_outstanding_send_wr_, 0);
+  num_outstanding_send_wr_--;
+  PostPendingSendReadWRs();
+}
+
+void IBVerbsQP::PostPendingSendReadWRs() {
+  // pending_send_wr_mutex_ is held by the caller.
+  while (!pending_send_wr_queue_.empty() && num_outstanding_send_wr_ < max_outstanding_send_wr_) {
+    const size_t wr_num =
+        std::min({pending_send_wr_queue_.size(), max_post_send_wr_num_,
+                  static_cast<size_t>(max_outstanding_send_wr_ - num_outstanding_send_wr_)});
+    post_send_wrs_.resize(wr_num);
+    post_send_sges_.resize(wr_num);
+    FOR_RANGE(size_t, i, 0, wr_num) {
+      post_send_wrs_.at(i) = pending_send_wr_queue_.front().first;
+      post_send_sges_.at(i) = pending_send_wr_queue_.front().second;
+      pending_send_wr_queue_.pop();
+    }
+    FOR_RANGE(size_t, i, 0, wr_num) {
+      post_send_wrs_.at(i).sg_list = &post_send_sges_.at(i);
+      post_send_wrs_.at(i).next = i + 1 < wr_num ? &post_send_wrs_.at(i + 1) : nullptr;
+    }
     ibv_send_wr* bad_wr = nullptr;
-    CHECK_EQ(ibv_post_send(qp_, &wr, &bad_wr), 0);
-  } else {
-    if (num_outstanding_send_wr_ > 0) { num_outstanding_send_wr_--; }
+    CHECK_EQ(ibv_post_send(qp_, post_send_wrs_.data(), &bad_wr), 0);
+    num_outstanding_send_wr_ += wr_num;
   }
 }
 
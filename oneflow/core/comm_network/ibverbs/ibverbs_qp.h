@@ -50,11 +50,17 @@ struct WorkRequestId {
 
 struct IBVerbsCommNetRMADesc;
 
+// Index of the GID to connect port with, ONEFLOW_COMM_NET_IB_GID_INDEX if set. Otherwise it is the
+// first IPv4-mapped GID of a RoCE port, such as one of a soft-RoCE (rxe) device, as RoCE v2 routes
+// over IPv4 with it, and 0 for other ports.
+int64_t IBVerbsGidIndex(ibv_context* ctx, uint8_t port_num, const ibv_port_attr& port_attr);
+
 class IBVerbsQP final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(IBVerbsQP);
   IBVerbsQP() = delete;
-  IBVerbsQP(ibv_context*, ibv_pd*, uint8_t port_num, ibv_cq* send_cq, ibv_cq* recv_cq);
+  IBVerbsQP(ibv_context*, ibv_pd*, uint8_t port_num, int64_t gid_index, ibv_cq* send_cq,
+            ibv_cq* recv_cq);
   ~IBVerbsQP();
 
   uint32_t qp_num() const { return qp_->qp_num; }
@@ -65,13 +71,16 @@ class IBVerbsQP final {
                        void* read_id);
   void PostSendRequest(const ActorMsg& msg);
 
-  void ReadDone(WorkRequestId*);
+  // Returns the read id once all blocks of the read are done, nullptr otherwise.
+  void* ReadDone(WorkRequestId*);
   void SendDone(WorkRequestId*);
-  void RecvDone(WorkRequestId*);
+  // Returns the received message.
+  ActorMsg RecvDone(WorkRequestId*);
 
  private:
-  void EnqueuePostSendReadWR(ibv_send_wr wr, ibv_sge sge);
-  void PostPendingSendWR();
+  void EnqueuePostSendReadWRs(const std::vector<std::pair<ibv_send_wr, ibv_sge>>& wrs);
+  void SendReadWRDone();
+  void PostPendingSendReadWRs();
   WorkRequestId* NewWorkRequestId();
   void DeleteWorkRequestId(WorkRequestId* wr_id);
   ActorMsgMR* GetOneSendMsgMRFromBuf();
@@ -80,6 +89,7 @@ class IBVerbsQP final {
   ibv_context* ctx_;
   ibv_pd* pd_;
   uint8_t port_num_;
+  int64_t gid_index_;
   ibv_qp* qp_;
   std::vector<ActorMsgMR*> recv_msg_buf_;
 
@@ -89,6 +99,11 @@ class IBVerbsQP final {
   uint32_t num_outstanding_send_wr_;
   uint32_t max_outstanding_send_wr_;
   std::queue<std::pair<ibv_send_wr, ibv_sge>> pending_send_wr_queue_;
+  // Pending work requests are posted in chains of up to max_post_send_wr_num_ in one
+  // ibv_post_send call.
+  size_t max_post_send_wr_num_;
+  std::vector<ibv_send_wr> post_send_wrs_;
+  std::vector<ibv_sge> post_send_sges_;
   size_t read_block_size_;
 };
 
@@ -0,0 +1,241 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include <gtest/gtest.h>
+#include "oneflow/core/comm_network/ibverbs/ibverbs_comm_network.h"
+#include "oneflow/core/comm_network/ibverbs/ibverbs_qp.h"
+#include "oneflow/core/platform/include/ibv.h"
+
+#if defined(WITH_RDMA) && defined(OF_PLATFORM_POSIX)
+
+// Loopback tests and benchmarks of IBVerbsQP, with two QPs of a device connected to each other.
+// Without InfiniBand hardware they run on a soft-RoCE device, for example one added by
+//
+//   rdma link add rxe0 type rxe netdev eth0
+//
+// and picked with ONEFLOW_COMM_NET_IB_HCA=rxe0. They are skipped if there is no device.
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+class IBVerbsLoopback final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(IBVerbsLoopback);
+  IBVerbsLoopback() : context_(nullptr), pd_(nullptr), cq_(nullptr) {}
+  ~IBVerbsLoopback() {
+    qps_.clear();
+    if (cq_ != nullptr) { CHECK_EQ(ibv::wrapper.ibv_destroy_cq(cq_), 0); }
+    if (pd_ != nullptr) { CHECK_EQ(ibv::wrapper.ibv_dealloc_pd(pd_), 0); }
+    if (context_ != nullptr) { CHECK_EQ(ibv::wrapper.ibv_close_device(context_), 0); }
+  }
+
+  // Returns false if there is no device to run on.
+  bool Init() {
+    if (!ibv::IsAvailable()) { return false; }
+    int num_device = 0;
+    ibv_device** device_list = ibv::wrapper.ibv_get_device_list(&num_device);
+    if (device_list == nullptr) { return false; }
+    const std::string user_device_port = GetStringFromEnv("ONEFLOW_COMM_NET_IB_HCA", "");
+    const std::string user_device = user_device_port.substr(0, user_device_port.find(':'));
+    ibv_device* device = nullptr;
+    FOR_RANGE(int, i, 0, num_device) {
+      if (user_device.empty() || user_device == device_list[i]->name) {
+        device = device_list[i];
+        break;
+      }
+    }
+    if (device != nullptr) { context_ = ibv::wrapper.ibv_open_device(device); }
+    ibv::wrapper.ibv_free_device_list(device_list);
+    if (context_ == nullptr) { return false; }
+    pd_ = ibv::wrapper.ibv_alloc_pd(context_);
+    CHECK(pd_);
+    ibv_device_attr device_attr{};
+    CHECK_EQ(ibv::wrapper.ibv_query_device(context_, &device_attr), 0);
+    cq_ = ibv::wrapper.ibv_create_cq(context_, device_attr.max_cqe, nullptr, nullptr, 0);
+    CHECK(cq_);
+    const uint8_t port = 1;
+    ibv_port_attr port_attr{};
+    CHECK_EQ(ibv::wrapper.ibv_query_port_wrap(context_, port, &port_attr), 0);
+    const int64_t gid_index = IBVerbsGidIndex(context_, port, port_attr);
+    ibv_gid gid{};
+    CHECK_EQ(ibv::wrapper.ibv_query_gid(context_, port, gid_index, &gid), 0);
+    LOG(INFO) << "Using IB device " << device->name << " gid index " << gid_index;
+    std::vector<IBVerbsConnectionInfo> conn_infos(2);
+    FOR_RANGE(int, i, 0, 2) {
+      qps_.emplace_back(new IBVerbsQP(context_, pd_, port, gid_index, cq_, cq_));
+      conn_infos.at(i).set_lid(port_attr.lid);
+      conn_infos.at(i).set_qp_num(qps_.at(i)->qp_num());
+      conn_infos.at(i).set_subnet_prefix(gid.global.subnet_prefix);
+      conn_infos.at(i).set_interface_id(gid.global.interface_id);
+      conn_infos.at(i).set_port_num(port);
+      conn_infos.at(i).set_mtu(static_cast<int>(port_attr.active_mtu));
+    }
+    FOR_RANGE(int, i, 0, 2) {
+      qps_.at(i)->Connect(conn_infos.at(1 - i));
+      qps_.at(i)->PostAllRecvRequest();
+    }
+    return true;
+  }
+
+  ibv_pd* pd() const { return pd_; }
+  IBVerbsQP* qp(int i) const { return qps_.at(i).get(); }
+
+  // Polls until num_reads reads are done and num_msgs messages are received, which are appended
+  // to msgs if it is not null.
+  void Poll(int64_t num_reads, int64_t num_msgs, std::vector<ActorMsg>* msgs) {
+    std::vector<ibv_wc> wcs(32);
+    while (num_reads > 0 || num_msgs > 0) {
+      const int found_wc_num = ibv_poll_cq(cq_, wcs.size(), wcs.data());
+      CHECK_GE(found_wc_num, 0);
+      FOR_RANGE(int, i, 0, found_wc_num) {
+        const ibv_wc& wc = wcs.at(i);
+        CHECK_EQ(wc.status, IBV_WC_SUCCESS) << wc.opcode;
+        auto* wr_id = reinterpret_cast<WorkRequestId*>(wc.wr_id);
+        if (wc.opcode == IBV_WC_RDMA_READ) {
+          if (wr_id->qp->ReadDone(wr_id) != nullptr) { num_reads -= 1; }
+        } else if (wc.opcode == IBV_WC_SEND) {
+          wr_id->qp->SendDone(wr_id);
+        } else if (wc.opcode == IBV_WC_RECV) {
+          const ActorMsg msg = wr_id->qp->RecvDone(wr_id);
+          if (msgs != nullptr) { msgs->emplace_back(msg); }
+          num_msgs -= 1;
+        } else {
+          UNIMPLEMENTED();
+        }
+      }
+    }
+  }
+
+ private:
+  ibv_context* context_;
+  ibv_pd* pd_;
+  ibv_cq* cq_;
+  std::vector<std::unique_ptr<IBVerbsQP>> qps_;
+};
+
+double SecondsSince(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Sets an environment variable, unless it is set and overwrite is false, and restores its former
+// value when it goes out of scope.
+class ScopedEnv final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ScopedEnv);
+  ScopedEnv(const std::string& name, const std::string& value, bool overwrite) : name_(name) {
+    const char* old_value = std::getenv(name.c_str());
+    has_old_value_ = old_value != nullptr;
+    if (has_old_value_) { old_value_ = old_value; }
+    CHECK_EQ(setenv(name.c_str(), value.c_str(), overwrite), 0);
+  }
+  ~ScopedEnv() {
+    if (has_old_value_) {
+      CHECK_EQ(setenv(name_.c_str(), old_value_.c_str(), 1), 0);
+    } else {
+      CHECK_EQ(unsetenv(name_.c_str()), 0);
+    }
+  }
+
+ private:
+  std::string name_;
+  bool has_old_value_;
+  std::string old_value_;
+};
+
+// Runs f with the work requests of the QPs posted in chains of at most each of these lengths.
+void ForEachMaxPostSendWRNum(const std::function<void(int64_t)>& f) {
+  for (int64_t max_post_send_wr_num : {1, 32}) {
+    ScopedEnv env("ONEFLOW_COMM_NET_IB_MAX_POST_SEND_WR_NUM",
+                  std::to_string(max_post_send_wr_num), true);
+    f(max_post_send_wr_num);
+  }
+}
+
+}  // namespace
+
+TEST(IBVerbsQP, send_msg) {
+  ForEachMaxPostSendWRNum([](int64_t max_post_send_wr_num) {
+    IBVerbsLoopback loopback;
+    if (!loopback.Init()) { GTEST_SKIP() << "no IB device"; }
+    // Throughput of messages sent back to back, in order. A window of messages is more than the
+    // QP takes at once, so that the rest of them are posted in chains. The first window is a warm
+    // up, which allocates the send buffers.
+    const int64_t window = 4096;
+    const int64_t num_windows = 25;
+    std::vector<ActorMsg> msgs;
+    double seconds = 0;
+    FOR_RANGE(int64_t, w, 0, num_windows + 1) {
+      const auto start = std::chrono::steady_clock::now();
+      FOR_RANGE(int64_t, i, 0, window) {
+        loopback.qp(0)->PostSendRequest(ActorMsg::BuildCommandMsg(i, ActorCmd::kStart));
+      }
+      msgs.clear();
+      loopback.Poll(0, window, &msgs);
+      if (w > 0) { seconds += SecondsSince(start); }
+      ASSERT_EQ(static_cast<int64_t>(msgs.size()), window);
+      FOR_RANGE(int64_t, i, 0, window) { ASSERT_EQ(msgs.at(i).dst_actor_id(), i); }
+    }
+    // Latency of messages sent back and forth.
+    const int64_t num_round_trips = 10000;
+    const auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, num_round_trips) {
+      loopback.qp(0)->PostSendRequest(ActorMsg::BuildCommandMsg(i, ActorCmd::kStart));
+      loopback.Poll(0, 1, nullptr);
+      loopback.qp(1)->PostSendRequest(ActorMsg::BuildCommandMsg(i, ActorCmd::kStart));
+      loopback.Poll(0, 1, nullptr);
+    }
+    LOG(INFO) << "max_post_send_wr_num " << max_post_send_wr_num << ": "
+              << window * num_windows / seconds << " msgs/s, "
+              << SecondsSince(start) * 1e6 / (num_round_trips * 2) << " us per msg";
+  });
+}
+
+TEST(IBVerbsQP, read) {
+  // Small blocks so that every read takes many work requests.
+  ScopedEnv env("ONEFLOW_COMM_NET_IB_MEM_BLOCK_SIZE", "65536", false);
+  ForEachMaxPostSendWRNum([](int64_t max_post_send_wr_num) {
+    IBVerbsLoopback loopback;
+    if (!loopback.Init()) { GTEST_SKIP() << "no IB device"; }
+    const size_t size = 64 * 1024 * 1024;
+    std::vector<char> src(size);
+    std::vector<char> dst(size, 0);
+    FOR_RANGE(size_t, i, 0, size) { src.at(i) = static_cast<char>(i * 7 + 1); }
+    IBVerbsMemDesc src_mem(loopback.pd(), src.data(), size);
+    IBVerbsMemDesc dst_mem(loopback.pd(), dst.data(), size);
+    IBVerbsCommNetRMADesc src_rma{};
+    src_rma.mem_ptr = reinterpret_cast<uint64_t>(src_mem.mem_ptr());
+    src_rma.mem_size = src_mem.mem_size();
+    src_rma.mr_rkey = src_mem.mr()->rkey;
+    const int64_t num_reads = 16;
+    int read_id = 0;
+    const auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, num_reads) {
+      loopback.qp(1)->PostReadRequest(src_rma, dst_mem, &read_id);
+    }
+    loopback.Poll(num_reads, 0, nullptr);
+    const double seconds = SecondsSince(start);
+    ASSERT_EQ(src, dst);
+    LOG(INFO) << "max_post_send_wr_num " << max_post_send_wr_num << ": "
+              << num_reads * size / seconds / 1e9 << " GB/s";
+  });
+}
+
+}  // namespace test
+}  // namespace oneflow
+
+#endif  // WITH_RDMA && OF_PLATFORM_POSIX
@@ -0,0 +1,52 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_BENCHMARK_UTIL_H_
+#define ONEFLOW_CORE_COMMON_BENCHMARK_UTIL_H_
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+namespace test {
+
+// Installs a global thread pool for the lifetime of the guard, for tests and benchmarks of code
+// that runs on Global<ThreadPool>.
+class ThreadPoolGuard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ThreadPoolGuard);
+  explicit ThreadPoolGuard(int32_t thread_num) { Global<ThreadPool>::New(thread_num); }
+  ~ThreadPoolGuard() { Global<ThreadPool>::Delete(); }
+};
+
+inline int32_t HardwareThreadNum() {
+  return std::max<int32_t>(static_cast<int32_t>(std::thread::hardware_concurrency()), 1);
+}
+
+// Average wall time of one call of Run over `repeat` calls, in milliseconds.
+inline double ElapsedMs(const std::function<void()>& Run, int repeat) {
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int, i, 0, repeat) { Run(); }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() / repeat;
+}
+
+}  // namespace test
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_BENCHMARK_UTIL_H_
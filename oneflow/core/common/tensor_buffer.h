@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/shape.h"
 #include "oneflow/core/common/data_type.h"
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/tensor_buffer_pool.h"
 #include "oneflow/core/memory/memory_allocator.h"
 
 namespace oneflow {
@@ -31,7 +32,8 @@ inline void CheckTensorBufferDataType(DataType val) {
 class TensorBuffer {
  public:
   struct Deleter {
-    void operator()(void* ptr) { MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr); }
+    size_t block_size = 0;
+    void operator()(void* ptr) { TensorBufferPool::Get()->Deallocate(ptr, block_size); }
   };
   typedef std::unique_ptr<void, Deleter> BufferType;
 
@@ -79,8 +81,10 @@ class TensorBuffer {
   void reserve(size_t new_num_bytes) {
     if (new_num_bytes <= num_bytes_) { return; }
     data_.reset();
-    data_.reset(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes));
-    num_bytes_ = new_num_bytes;
+    TensorBufferPool* pool = TensorBufferPool::Get();
+    const size_t block_size = pool->GetBlockSize(new_num_bytes);
+    data_ = BufferType(pool->Allocate(block_size), Deleter{block_size});
+    num_bytes_ = block_size;
   }
 
   int64_t elem_cnt() const { return shape_.elem_cnt(); }
@@ -105,7 +109,8 @@ class TensorBuffer {
       new_num_bytes =
           std::max(new_num_bytes, RoundUp(num_bytes_ * growth_factor_, kTensorBufferAlignedSize));
       reserve(new_num_bytes);
-    } else if (new_num_bytes < num_bytes_ * shrink_threshold_) {
+    } else if (new_num_bytes < num_bytes_ * shrink_threshold_
+               && TensorBufferPool::Get()->GetBlockSize(new_num_bytes) < num_bytes_) {
       data_.reset();
       num_bytes_ = 0;
       reserve(new_num_bytes);
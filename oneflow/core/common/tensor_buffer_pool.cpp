@@ -0,0 +1,231 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/tensor_buffer_pool.h"
+#include "oneflow/core/memory/memory_allocator.h"
+#include "oneflow/core/ep/include/device_manager_registry.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr size_t kDefaultMaxBlockSize = 64 * 1024 * 1024;
+constexpr size_t kDefaultThreadCacheBytes = 8 * 1024 * 1024;
+
+size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t ret = 1;
+  while (ret < n) { ret <<= 1; }
+  return ret;
+}
+
+#ifdef WITH_CUDA
+const MemoryCase& GetPinnedMemoryCase() {
+  static MemoryCase mem_case = [] {
+    MemoryCase mem_case;
+    mem_case.mutable_host_mem()->mutable_cuda_pinned_mem()->set_device_id(0);
+    return mem_case;
+  }();
+  return mem_case;
+}
+#endif  // WITH_CUDA
+
+}  // namespace
+
+class TensorBufferThreadCache final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TensorBufferThreadCache);
+  explicit TensorBufferThreadCache(TensorBufferPool* pool)
+      : pool_(pool), free_blocks_(pool->num_size_classes_) {}
+  ~TensorBufferThreadCache() {
+    FOR_RANGE(size_t, i, 0, free_blocks_.size()) {
+      std::vector<void*>* blocks = &free_blocks_.at(i);
+      if (!blocks->empty()) { pool_->PushToSharedList(i, blocks->data(), blocks->size()); }
+    }
+  }
+
+  void* Pop(int index) {
+    std::vector<void*>* blocks = &free_blocks_.at(index);
+    if (blocks->empty()) { return nullptr; }
+    void* ptr = blocks->back();
+    blocks->pop_back();
+    return ptr;
+  }
+
+  void Push(int index, void* ptr) {
+    std::vector<void*>* blocks = &free_blocks_.at(index);
+    blocks->push_back(ptr);
+    const size_t max_num_blocks =
+        std::max<size_t>(pool_->thread_cache_bytes_ / pool_->GetSizeClassBlockSize(index), 1);
+    if (blocks->size() > max_num_blocks) {
+      // Hand the older half over to the shared list so that other threads can reuse them.
+      const size_t num_flush = blocks->size() / 2;
+      pool_->PushToSharedList(index, blocks->data(), num_flush);
+      blocks->erase(blocks->begin(), blocks->begin() + num_flush);
+    }
+  }
+
+ private:
+  TensorBufferPool* pool_;
+  std::vector<std::vector<void*>> free_blocks_;
+};
+
+namespace {
+
+TensorBufferThreadCache* GetThreadCache() {
+  static thread_local TensorBufferThreadCache cache(TensorBufferPool::Get());
+  return &cache;
+}
+
+}  // namespace
+
+constexpr size_t TensorBufferPool::kMinBlockSize;
+
+TensorBufferPool::TensorBufferPool()
+    : enabled_(ParseBooleanFromEnv("ONEFLOW_TENSOR_BUFFER_POOL_ENABLE", true)),
+      pinned_(false),
+      num_size_classes_(0),
+      max_block_size_(0),
+      thread_cache_bytes_(ParseIntegerFromEnv("ONEFLOW_TENSOR_BUFFER_POOL_THREAD_CACHE_BYTES",
+                                              kDefaultThreadCacheBytes)),
+      num_allocations_(0),
+      num_deallocations_(0),
+      num_thread_cache_hits_(0),
+      num_pool_hits_(0),
+      num_system_allocations_(0),
+      num_system_deallocations_(0),
+      num_bytes_in_use_(0),
+      num_bytes_cached_(0) {
+  const size_t max_block_size =
+      ParseIntegerFromEnv("ONEFLOW_TENSOR_BUFFER_POOL_MAX_BLOCK_BYTES", kDefaultMaxBlockSize);
+  max_block_size_ = RoundUpToPowerOfTwo(std::max(max_block_size, kMinBlockSize));
+  while (GetSizeClassBlockSize(num_size_classes_) <= max_block_size_) { ++num_size_classes_; }
+  FOR_RANGE(int, i, 0, num_size_classes_) { size_classes_.emplace_back(new SizeClass()); }
+  if (ParseBooleanFromEnv("ONEFLOW_TENSOR_BUFFER_POOL_PINNED", false)) {
+#ifdef WITH_CUDA
+    if (Global<ep::DeviceManagerRegistry>::Get() != nullptr) {
+      pinned_ = true;
+    } else {
+      LOG(WARNING) << "TensorBufferPool falls back to pageable memory because the device manager "
+                      "registry is not initialized.";
+    }
+#else
+    LOG(WARNING) << "ONEFLOW_TENSOR_BUFFER_POOL_PINNED is ignored without CUDA.";
+#endif  // WITH_CUDA
+  }
+}
+
+TensorBufferPool* TensorBufferPool::Get() {
+  // Intentionally leaked, TensorBuffers and thread caches may outlive static destructors.
+  static TensorBufferPool* pool = new TensorBufferPool();
+  return pool;
+}
+
+size_t TensorBufferPool::GetBlockSize(size_t size) const {
+  if (!enabled_ || size > max_block_size_) { return size; }
+  return RoundUpToPowerOfTwo(std::max(size, kMinBlockSize));
+}
+
+int TensorBufferPool::GetSizeClassIndex(size_t block_size) const {
+  int index = 0;
+  while (GetSizeClassBlockSize(index) < block_size) { ++index; }
+  CHECK_EQ(GetSizeClassBlockSize(index), block_size);
+  return index;
+}
+
+void* TensorBufferPool::Allocate(size_t block_size) {
+  num_allocations_.fetch_add(1, std::memory_order_relaxed);
+  num_bytes_in_use_.fetch_add(block_size, std::memory_order_relaxed);
+  if (!enabled_ || block_size > max_block_size_) { return SystemAllocate(block_size); }
+  const int index = GetSizeClassIndex(block_size);
+  void* ptr = GetThreadCache()->Pop(index);
+  if (ptr != nullptr) {
+    num_thread_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    ptr = PopFromSharedList(index);
+    if (ptr == nullptr) { return SystemAllocate(block_size); }
+    num_pool_hits_.fetch_add(1, std::memory_order_relaxed);
+  }
+  num_bytes_cached_.fetch_sub(block_size, std::memory_order_relaxed);
+  return ptr;
+}
+
+void TensorBufferPool::Deallocate(void* ptr, size_t block_size) {
+  if (ptr == nullptr) { return; }
+  num_deallocations_.fetch_add(1, std::memory_order_relaxed);
+  num_bytes_in_use_.fetch_sub(block_size, std::memory_order_relaxed);
+  if (!enabled_ || block_size > max_block_size_) { return SystemDeallocate(ptr, block_size); }
+  num_bytes_cached_.fetch_add(block_size, std::memory_order_relaxed);
+  GetThreadCache()->Push(GetSizeClassIndex(block_size), ptr);
+}
+
+void* TensorBufferPool::PopFromSharedList(int index) {
+  SizeClass* size_class = size_classes_.at(index).get();
+  std::unique_lock<std::mutex> lock(size_class->mutex);
+  if (size_class->free_blocks.empty()) { return nullptr; }
+  void* ptr = size_class->free_blocks.back();
+  size_class->free_blocks.pop_back();
+  return ptr;
+}
+
+void TensorBufferPool::PushToSharedList(int index, void** ptrs, size_t num) {
+  SizeClass* size_class = size_classes_.at(index).get();
+  std::unique_lock<std::mutex> lock(size_class->mutex);
+  size_class->free_blocks.insert(size_class->free_blocks.end(), ptrs, ptrs + num);
+}
+
+void* TensorBufferPool::SystemAllocate(size_t size) {
+  num_system_allocations_.fetch_add(1, std::memory_order_relaxed);
+#ifdef WITH_CUDA
+  if (pinned_) { return MemoryAllocatorImpl::Allocate(GetPinnedMemoryCase(), size); }
+#endif  // WITH_CUDA
+  return MemoryAllocatorImpl::AllocateUnPinnedHostMem(size);
+}
+
+void TensorBufferPool::SystemDeallocate(void* ptr, size_t size) {
+  num_system_deallocations_.fetch_add(1, std::memory_order_relaxed);
+#ifdef WITH_CUDA
+  if (pinned_) { return MemoryAllocatorImpl::Deallocate(ptr, GetPinnedMemoryCase()); }
+#endif  // WITH_CUDA
+  MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr);
+}
+
+void TensorBufferPool::Trim() {
+  FOR_RANGE(int, i, 0, num_size_classes_) {
+    std::vector<void*> free_blocks;
+    {
+      SizeClass* size_class = size_classes_.at(i).get();
+      std::unique_lock<std::mutex> lock(size_class->mutex);
+      free_blocks.swap(size_class->free_blocks);
+    }
+    const size_t block_size = GetSizeClassBlockSize(i);
+    for (void* ptr : free_blocks) { SystemDeallocate(ptr, block_size); }
+    num_bytes_cached_.fetch_sub(block_size * free_blocks.size(), std::memory_order_relaxed);
+  }
+}
+
+TensorBufferPoolStats TensorBufferPool::GetStats() const {
+  TensorBufferPoolStats stats{};
+  stats.num_allocations = num_allocations_.load(std::memory_order_relaxed);
+  stats.num_deallocations = num_deallocations_.load(std::memory_order_relaxed);
+  stats.num_thread_cache_hits = num_thread_cache_hits_.load(std::memory_order_relaxed);
+  stats.num_pool_hits = num_pool_hits_.load(std::memory_order_relaxed);
+  stats.num_system_allocations = num_system_allocations_.load(std::memory_order_relaxed);
+  stats.num_system_deallocations = num_system_deallocations_.load(std::memory_order_relaxed);
+  stats.num_bytes_in_use = num_bytes_in_use_.load(std::memory_order_relaxed);
+  stats.num_bytes_cached = num_bytes_cached_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace oneflow
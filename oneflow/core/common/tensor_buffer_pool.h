@@ -0,0 +1,103 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_TENSOR_BUFFER_POOL_H_
+#define ONEFLOW_CORE_COMMON_TENSOR_BUFFER_POOL_H_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+struct TensorBufferPoolStats {
+  int64_t num_allocations;
+  int64_t num_deallocations;
+  int64_t num_thread_cache_hits;
+  int64_t num_pool_hits;
+  int64_t num_system_allocations;
+  int64_t num_system_deallocations;
+  int64_t num_bytes_in_use;
+  int64_t num_bytes_cached;
+};
+
+// Size-class pool for TensorBuffer payloads. Blocks are rounded up to a power of two and cached in
+// a thread local free list first, then in a process wide free list shared by all data loader
+// threads. Blocks larger than the biggest size class go straight to the system allocator.
+//
+// Environment variables:
+//   ONEFLOW_TENSOR_BUFFER_POOL_ENABLE: set to false to bypass the pool entirely.
+//   ONEFLOW_TENSOR_BUFFER_POOL_MAX_BLOCK_BYTES: biggest size class, 64MB by default.
+//   ONEFLOW_TENSOR_BUFFER_POOL_THREAD_CACHE_BYTES: per size class limit of a thread cache.
+//   ONEFLOW_TENSOR_BUFFER_POOL_PINNED: allocate blocks from cuda pinned host memory, so that the
+//     following host to device copies can be asynchronous.
+class TensorBufferPool final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TensorBufferPool);
+  ~TensorBufferPool() = default;
+
+  static TensorBufferPool* Get();
+
+  // Returns the capacity of the block that will be handed out for a request of `size` bytes.
+  size_t GetBlockSize(size_t size) const;
+  void* Allocate(size_t block_size);
+  void Deallocate(void* ptr, size_t block_size);
+
+  // Returns all blocks cached in the shared free lists to the system.
+  void Trim();
+  TensorBufferPoolStats GetStats() const;
+
+  bool enabled() const { return enabled_; }
+  bool pinned() const { return pinned_; }
+
+ private:
+  friend class TensorBufferThreadCache;
+  TensorBufferPool();
+
+  struct SizeClass {
+    std::mutex mutex;
+    std::vector<void*> free_blocks;
+  };
+
+  int GetSizeClassIndex(size_t block_size) const;
+  size_t GetSizeClassBlockSize(int index) const { return kMinBlockSize << index; }
+  void* SystemAllocate(size_t size);
+  void SystemDeallocate(void* ptr, size_t size);
+  void* PopFromSharedList(int index);
+  void PushToSharedList(int index, void** ptrs, size_t num);
+
+  static constexpr size_t kMinBlockSize = 1024;
+
+  bool enabled_;
+  bool pinned_;
+  int num_size_classes_;
+  size_t max_block_size_;
+  size_t thread_cache_bytes_;
+  std::vector<std::unique_ptr<SizeClass>> size_classes_;
+
+  std::atomic<int64_t> num_allocations_;
+  std::atomic<int64_t> num_deallocations_;
+  std::atomic<int64_t> num_thread_cache_hits_;
+  std::atomic<int64_t> num_pool_hits_;
+  std::atomic<int64_t> num_system_allocations_;
+  std::atomic<int64_t> num_system_deallocations_;
+  std::atomic<int64_t> num_bytes_in_use_;
+  std::atomic<int64_t> num_bytes_cached_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_TENSOR_BUFFER_POOL_H_
@@ -0,0 +1,104 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <algorithm>
+#include <thread>
+#include <gtest/gtest.h>
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/common/tensor_buffer_pool.h"
+
+namespace oneflow {
+namespace test {
+
+TEST(TensorBufferPool, block_size) {
+  TensorBufferPool* pool = TensorBufferPool::Get();
+  if (!pool->enabled()) { return; }
+  ASSERT_EQ(pool->GetBlockSize(1), 1024);
+  ASSERT_EQ(pool->GetBlockSize(1024), 1024);
+  ASSERT_EQ(pool->GetBlockSize(1025), 2048);
+  ASSERT_EQ(pool->GetBlockSize(3000), 4096);
+}
+
+TEST(TensorBufferPool, reuse_in_same_thread) {
+  TensorBufferPool* pool = TensorBufferPool::Get();
+  if (!pool->enabled()) { return; }
+  const size_t block_size = pool->GetBlockSize(5000);
+  void* ptr = pool->Allocate(block_size);
+  pool->Deallocate(ptr, block_size);
+  const int64_t num_hits = pool->GetStats().num_thread_cache_hits;
+  void* reused = pool->Allocate(block_size);
+  ASSERT_EQ(reused, ptr);
+  ASSERT_EQ(pool->GetStats().num_thread_cache_hits, num_hits + 1);
+  pool->Deallocate(reused, block_size);
+}
+
+TEST(TensorBufferPool, tensor_buffer_resize) {
+  TensorBufferPool* pool = TensorBufferPool::Get();
+  const int64_t num_bytes_in_use = pool->GetStats().num_bytes_in_use;
+  {
+    TensorBuffer buffer;
+    buffer.Resize(Shape({100, 3}), DataType::kFloat);
+    ASSERT_GE(buffer.capacity(), 100 * 3 * sizeof(float));
+    const void* ptr = buffer.data();
+    buffer.Resize(Shape({90, 3}), DataType::kFloat);
+    // Shrinking within the same size class keeps the block.
+    ASSERT_EQ(buffer.data(), ptr);
+    buffer.Resize(Shape({1000, 3}), DataType::kFloat);
+    ASSERT_GE(buffer.capacity(), 1000 * 3 * sizeof(float));
+    TensorBuffer other;
+    other.CopyFrom(buffer);
+    ASSERT_EQ(other.nbytes(), buffer.nbytes());
+    other.Swap(&buffer);
+  }
+  ASSERT_EQ(pool->GetStats().num_bytes_in_use, num_bytes_in_use);
+}
+
+TEST(TensorBufferPool, cross_thread_return) {
+  TensorBufferPool* pool = TensorBufferPool::Get();
+  const size_t block_size = pool->GetBlockSize(64 * 1024);
+  const int num_blocks = 256;
+  std::vector<void*> ptrs(num_blocks);
+  std::thread producer([&]() {
+    for (int i = 0; i < num_blocks; ++i) { ptrs[i] = pool->Allocate(block_size); }
+  });
+  producer.join();
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < 4; ++t) {
+    consumers.emplace_back([&, t]() {
+      for (int i = t; i < num_blocks; i += 4) { pool->Deallocate(ptrs[i], block_size); }
+    });
+  }
+  for (std::thread& consumer : consumers) { consumer.join(); }
+  if (!pool->enabled()) { return; }
+  // The consumers have exited and handed their caches over to the shared list, so a thread with an
+  // empty cache gets one of their blocks.
+  const int64_t num_pool_hits = pool->GetStats().num_pool_hits;
+  void* reused = nullptr;
+  std::thread([&]() { reused = pool->Allocate(block_size); }).join();
+  ASSERT_EQ(pool->GetStats().num_pool_hits, num_pool_hits + 1);
+  ASSERT_NE(std::find(ptrs.begin(), ptrs.end(), reused), ptrs.end());
+  pool->Deallocate(reused, block_size);
+  // The other blocks are still in the shared list, Trim frees them.
+  const int64_t num_bytes_cached = pool->GetStats().num_bytes_cached;
+  const int64_t num_system_deallocations = pool->GetStats().num_system_deallocations;
+  pool->Trim();
+  ASSERT_LE(pool->GetStats().num_bytes_cached,
+            num_bytes_cached - (num_blocks - 1) * static_cast<int64_t>(block_size));
+  ASSERT_GE(pool->GetStats().num_system_deallocations,
+            num_system_deallocations + num_blocks - 1);
+}
+
+}  // namespace test
+}  // namespace oneflow
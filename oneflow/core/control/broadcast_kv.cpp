@@ -0,0 +1,207 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/control/broadcast_kv.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include <zlib.h>
+#include <sstream>
+
+namespace oneflow {
+
+namespace {
+
+size_t ChunkBytes() {
+  static const size_t chunk_bytes =
+      ParseIntegerFromEnv("ONEFLOW_CTRL_BROADCAST_KV_CHUNK_BYTES", 4 << 20);
+  CHECK_GT(chunk_bytes, 0);
+  return chunk_bytes;
+}
+
+int64_t Parallelism() {
+  static const int64_t parallelism = ParseIntegerFromEnv("ONEFLOW_CTRL_BROADCAST_KV_THREADS", 4);
+  CHECK_GT(parallelism, 0);
+  return parallelism;
+}
+
+bool NeedCompress(size_t size) {
+  static const bool compress = ParseBooleanFromEnv("ONEFLOW_CTRL_BROADCAST_KV_COMPRESS", true);
+  static const size_t min_bytes =
+      ParseIntegerFromEnv("ONEFLOW_CTRL_BROADCAST_KV_COMPRESS_MIN_BYTES", 64 << 10);
+  return compress && size >= min_bytes;
+}
+
+struct BroadcastKVHeader {
+  bool compressed;
+  size_t raw_size;
+  size_t size;
+  size_t num_chunks;
+
+  std::string Serialize() const {
+    std::ostringstream oss;
+    oss << compressed << " " << raw_size << " " << size << " " << num_chunks;
+    return oss.str();
+  }
+
+  void Parse(const std::string& str) {
+    std::istringstream iss(str);
+    CHECK(iss >> compressed >> raw_size >> size >> num_chunks) << str;
+  }
+};
+
+std::string HeaderKey(const std::string& k, int64_t rank) {
+  return k + "/broadcast/" + std::to_string(rank);
+}
+
+std::string ChunkKey(const std::string& k, int64_t rank, size_t chunk_id) {
+  return HeaderKey(k, rank) + "/" + std::to_string(chunk_id);
+}
+
+bool HasChildren(int64_t rank, int64_t root, int64_t world_size) {
+  const int64_t relative_rank = (rank - root + world_size) % world_size;
+  return relative_rank % 2 == 0 && relative_rank + 1 < world_size;
+}
+
+// Calls Handler(chunk_id) for all chunks, each thread takes the chunks in increasing order so
+// that the early chunks are relayed first.
+void ForEachChunk(size_t num_chunks, const std::function<void(size_t)>& Handler) {
+  const size_t num_threads = std::min<size_t>(num_chunks, Parallelism());
+  const auto Work = [&](size_t thread_id) {
+    for (size_t i = thread_id; i < num_chunks; i += num_threads) { Handler(i); }
+  };
+  std::vector<std::thread> threads;
+  FOR_RANGE(size_t, thread_id, 1, num_threads) { threads.emplace_back(Work, thread_id); }
+  if (num_threads > 0) { Work(0); }
+  for (std::thread& thread : threads) { thread.join(); }
+}
+
+void Compress(const std::string& in, std::string* out) {
+  uLongf size = compressBound(in.size());
+  out->resize(size);
+  CHECK_EQ(compress2(reinterpret_cast<Bytef*>(&out->at(0)), &size,
+                     reinterpret_cast<const Bytef*>(in.data()), in.size(), Z_BEST_SPEED),
+           Z_OK);
+  out->resize(size);
+}
+
+void Decompress(const std::string& in, size_t raw_size, std::string* out) {
+  out->resize(raw_size);
+  uLongf size = raw_size;
+  if (raw_size > 0) {
+    CHECK_EQ(uncompress(reinterpret_cast<Bytef*>(&out->at(0)), &size,
+                        reinterpret_cast<const Bytef*>(in.data()), in.size()),
+             Z_OK);
+  }
+  CHECK_EQ(size, raw_size);
+}
+
+std::mutex broadcast_kv_mutex;
+// Number of chunks this process pushed for each header key.
+HashMap<std::string, size_t> header_key2num_pushed_chunks;
+
+}  // namespace
+
+int64_t BroadcastKVParentRank(int64_t rank, int64_t root, int64_t world_size) {
+  if (rank == root) { return -1; }
+  const int64_t relative_rank = (rank - root + world_size) % world_size;
+  // Clearing the lowest set bit gives the parent in a binomial tree.
+  return ((relative_rank & (relative_rank - 1)) + root) % world_size;
+}
+
+void BroadcastKV(const std::string& k, int64_t root, std::string* v) {
+  BroadcastKV(Global<CtrlClient>::Get(), GlobalProcessCtx::Rank(), GlobalProcessCtx::WorldSize(),
+              k, root, v);
+}
+
+void BroadcastKV(CtrlClient* client, int64_t rank, int64_t world_size, const std::string& k,
+                 int64_t root, std::string* v) {
+  CHECK_GE(root, 0);
+  CHECK_LT(root, world_size);
+  BroadcastKVHeader header{};
+  std::string buffer;
+  const std::string* data = nullptr;
+  if (rank == root) {
+    header.raw_size = v->size();
+    header.compressed = NeedCompress(v->size());
+    if (header.compressed) {
+      Compress(*v, &buffer);
+      data = &buffer;
+    } else {
+      data = v;
+    }
+    header.size = data->size();
+    header.num_chunks = RoundUp(header.size, ChunkBytes()) / ChunkBytes();
+  } else {
+    client->PullKV(HeaderKey(k, BroadcastKVParentRank(rank, root, world_size)),
+                   [&](const std::string& str) { header.Parse(str); });
+    buffer.resize(header.size);
+    data = &buffer;
+  }
+  const bool need_push = HasChildren(rank, root, world_size);
+  if (need_push) { client->PushKV(HeaderKey(k, rank), header.Serialize()); }
+  ForEachChunk(header.num_chunks, [&](size_t chunk_id) {
+    const size_t offset = chunk_id * ChunkBytes();
+    const size_t size = std::min(ChunkBytes(), header.size - offset);
+    if (rank != root) {
+      client->PullKV(ChunkKey(k, BroadcastKVParentRank(rank, root, world_size), chunk_id),
+                     [&](const std::string& chunk) {
+                       CHECK_EQ(chunk.size(), size);
+                       chunk.copy(&buffer.at(offset), size);
+                     });
+    }
+    if (need_push) {
+      client->PushKV(ChunkKey(k, rank, chunk_id),
+                     [&](std::string* chunk) { chunk->assign(data->data() + offset, size); });
+    }
+  });
+  if (need_push) {
+    std::unique_lock<std::mutex> lock(broadcast_kv_mutex);
+    CHECK(header_key2num_pushed_chunks.emplace(HeaderKey(k, rank), header.num_chunks).second)
+        << k;
+  }
+  if (rank != root) {
+    if (header.compressed) {
+      Decompress(buffer, header.raw_size, v);
+    } else {
+      v->swap(buffer);
+    }
+  }
+}
+
+void BroadcastKV(const std::string& k, int64_t root, PbMessage* msg) {
+  std::string v;
+  if (GlobalProcessCtx::Rank() == root) { msg->SerializeToString(&v); }
+  BroadcastKV(k, root, &v);
+  if (GlobalProcessCtx::Rank() != root) { CHECK(msg->ParseFromString(v)); }
+}
+
+void ClearBroadcastKV(const std::string& k) {
+  ClearBroadcastKV(Global<CtrlClient>::Get(), GlobalProcessCtx::Rank(), k);
+}
+
+void ClearBroadcastKV(CtrlClient* client, int64_t rank, const std::string& k) {
+  size_t num_chunks = 0;
+  {
+    std::unique_lock<std::mutex> lock(broadcast_kv_mutex);
+    auto it = header_key2num_pushed_chunks.find(HeaderKey(k, rank));
+    if (it == header_key2num_pushed_chunks.end()) { return; }
+    num_chunks = it->second;
+    header_key2num_pushed_chunks.erase(it);
+  }
+  FOR_RANGE(size_t, chunk_id, 0, num_chunks) { client->ClearKV(ChunkKey(k, rank, chunk_id)); }
+  client->ClearKV(HeaderKey(k, rank));
+}
+
+}  // namespace oneflow
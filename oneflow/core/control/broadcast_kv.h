@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_CONTROL_BROADCAST_KV_H_
+#define ONEFLOW_CORE_CONTROL_BROADCAST_KV_H_
+
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+class CtrlClient;
+
+// BroadcastKV sends a large value, such as a plan, from rank root to all ranks through the ctrl
+// KV store. Every rank calls it, with v set on root. The value is compressed with zlib and split
+// into chunks that are pushed and pulled in parallel. Every rank pulls the chunks from its parent
+// in a binomial tree rooted at root and pushes them again for its own children, so the value is
+// served by log(world_size) ranks instead of by a single server, and the hops are pipelined by
+// chunk.
+void BroadcastKV(const std::string& k, int64_t root, std::string* v);
+void BroadcastKV(const std::string& k, int64_t root, PbMessage* msg);
+
+// Clears what this rank pushed in BroadcastKV(k, ...). Call it on every rank once all the ranks
+// have returned from BroadcastKV, e.g. after a barrier.
+void ClearBroadcastKV(const std::string& k);
+
+// The same with the client and the rank given instead of taken from the globals, so that the ranks
+// can also be threads of one process.
+void BroadcastKV(CtrlClient* client, int64_t rank, int64_t world_size, const std::string& k,
+                 int64_t root, std::string* v);
+void ClearBroadcastKV(CtrlClient* client, int64_t rank, const std::string& k);
+
+// The rank that rank pulls from, -1 for root.
+int64_t BroadcastKVParentRank(int64_t rank, int64_t root, int64_t world_size);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_CONTROL_BROADCAST_KV_H_
@@ -0,0 +1,105 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "gtest/gtest.h"
+#include "oneflow/core/control/broadcast_kv.h"
+#include "oneflow/core/rpc/include/local.h"
+#include <random>
+#include <thread>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::string RandomBytes(size_t size) {
+  std::mt19937 gen(size);
+  std::string ret(size, '\0');
+  for (char& c : ret) { c = static_cast<char>(gen()); }
+  return ret;
+}
+
+std::string RepeatedBytes(size_t size) {
+  std::string ret(size, '\0');
+  FOR_RANGE(size_t, i, 0, size) { ret[i] = static_cast<char>('a' + i % 23); }
+  return ret;
+}
+
+}  // namespace
+
+TEST(BroadcastKV, binomial_tree) {
+  FOR_RANGE(int64_t, world_size, 1, 40) {
+    int64_t depth_bound = 0;
+    while ((int64_t{1} << depth_bound) < world_size) { ++depth_bound; }
+    FOR_RANGE(int64_t, root, 0, world_size) {
+      std::vector<int64_t> num_children(world_size, 0);
+      FOR_RANGE(int64_t, rank, 0, world_size) {
+        int64_t depth = 0;
+        int64_t cur = rank;
+        while (cur != root) {
+          const int64_t parent = BroadcastKVParentRank(cur, root, world_size);
+          ASSERT_GE(parent, 0);
+          ASSERT_LT(parent, world_size);
+          if (cur == rank) { num_children.at(parent) += 1; }
+          cur = parent;
+          ++depth;
+        }
+        ASSERT_LE(depth, depth_bound);
+      }
+      ASSERT_EQ(BroadcastKVParentRank(root, root, world_size), -1);
+      for (int64_t n : num_children) { ASSERT_LE(n, depth_bound); }
+    }
+  }
+}
+
+#ifdef RPC_BACKEND_LOCAL
+TEST(BroadcastKV, threads_as_ranks) {
+  ProcessCtx process_ctx;
+  process_ctx.add_ctrl_addr()->set_host("localhost");
+  process_ctx.set_rank(0);
+  process_ctx.set_node_size(1);
+  LocalCtrlClient client(process_ctx);
+  // Below the compression threshold, and above the default chunk size of 4MB both compressible
+  // and not, so that the compressed value is split into one and into several chunks.
+  const std::vector<std::string> values{RandomBytes(1000), RepeatedBytes(9 << 20),
+                                        RandomBytes(9 << 20)};
+  for (int64_t world_size : {1, 3, 8}) {
+    const std::string barrier = "barrier" + std::to_string(world_size);
+    std::vector<std::thread> threads;
+    FOR_RANGE(int64_t, rank, 0, world_size) {
+      threads.emplace_back([&, rank]() {
+        FOR_RANGE(size_t, i, 0, values.size()) {
+          // The key is taken again for every value, which only works if it has been cleared.
+          const int64_t root = i % world_size;
+          std::string v;
+          if (rank == root) { v = values.at(i); }
+          BroadcastKV(&client, rank, world_size, "key", root, &v);
+          EXPECT_EQ(v.size(), values.at(i).size());
+          EXPECT_TRUE(v == values.at(i));
+          client.Barrier(barrier, world_size);
+          ClearBroadcastKV(&client, rank, "key");
+          client.Barrier(barrier, world_size);
+        }
+      });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+  }
+}
+#endif  // RPC_BACKEND_LOCAL
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -129,8 +129,12 @@ void TensorViewInstructionType::Compute(vm::Instruction* instruction) const {
   OfBlob input_ofblob(device_ctx->stream(), ptr->eager_blob_object()->mut_blob());
   OfBlob view_ofblob(device_ctx->stream(), ptr->view_eager_blob_object()->mut_blob());
 
-  void* input_ptr = input_ofblob.mut_blob()->mut_dptr();
-  view_ofblob.mut_blob()->reset_dptr(static_cast<char*>(input_ptr));
+  // The view starts storage_offset elements after the start of the storage, as the input does.
+  const int64_t offset = ptr->view_eager_blob_object()->storage_offset()
+                         - ptr->eager_blob_object()->storage_offset();
+  char* input_ptr = static_cast<char*>(input_ofblob.mut_blob()->mut_dptr());
+  view_ofblob.mut_blob()->reset_dptr(
+      input_ptr + offset * GetSizeOfDataType(view_ofblob.blob().data_type()));
 }
 
 void AccessBlobByCallbackInstructionType::Compute(vm::Instruction* instruction) const {
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/framework/to_string.h"
 #include "oneflow/core/framework/shut_down_util.h"
 #include "oneflow/core/common/shape_vec.h"
+#include "oneflow/core/memory/memory_case_util.h"
 
 namespace oneflow {
 namespace vm {
@@ -84,5 +85,27 @@ Maybe<void> EagerBlobObject::TryAllocateBlobBodyMemory(DeviceCtx* device_ctx) {
   return Maybe<void>::Ok();
 }
 
+Maybe<bool> EagerBlobObject::TryTakeOverBlobBodyMemory(EagerBlobObject* donor) {
+  Blob* blob = mut_blob();
+  CHECK_NOTNULL_OR_RETURN(blob);
+  TensorStorage* donor_storage = donor->tensor_storage().get();
+  if (donor_storage == tensor_storage_.get()) { return false; }
+  if (tensor_storage_->blob_dptr() != nullptr || donor_storage->blob_dptr() == nullptr) {
+    return false;
+  }
+  if (donor->mut_blob() == nullptr || !(donor->mem_case() == mem_case())) { return false; }
+  const DataType data_type = blob_desc_.data_type();
+  if (data_type != donor->blob_desc().data_type() || !IsPODDataType(data_type)) { return false; }
+  if (storage_offset_ != 0 || donor->storage_offset() != 0) { return false; }
+  const size_t required_body_bytes = blob->AlignedByteSizeOfBlobBody();
+  if (required_body_bytes == 0 || required_body_bytes != donor->blob().AlignedByteSizeOfBlobBody()
+      || required_body_bytes > donor_storage->blob_bytes()) {
+    return false;
+  }
+  tensor_storage_->TakeOverBlobDptr(donor_storage);
+  blob->reset_dptr(tensor_storage_->blob_dptr());
+  return true;
+}
+
 }  // namespace vm
 }  // namespace oneflow
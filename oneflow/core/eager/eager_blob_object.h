@@ -33,7 +33,8 @@ class TensorStorage {
   TensorStorage()
       : non_pod_allocator_(std::make_unique<MemoryAllocator>()),
         producer_op_device_(NullOpt),
-        last_used_device_(NullOpt) {}
+        last_used_device_(NullOpt),
+        producer_vm_stream_index_(-1) {}
 
   size_t blob_bytes() const { return blob_bytes_; }
 
@@ -45,6 +46,12 @@ class TensorStorage {
     blob_dptr_ = std::move(blob_dptr);
     blob_bytes_ = bytes;
   }
+  // Moves the memory of `donor` into this storage, leaving `donor` without memory.
+  void TakeOverBlobDptr(TensorStorage* donor) {
+    blob_dptr_ = std::move(donor->blob_dptr_);
+    blob_bytes_ = donor->blob_bytes_;
+    donor->blob_bytes_ = 0;
+  }
 
   const Optional<Symbol<Device>>& producer_op_device() const { return producer_op_device_; }
   Maybe<void> init_producer_op_device(Symbol<Device> producer_op_device) {
@@ -58,12 +65,19 @@ class TensorStorage {
     last_used_device_ = last_used_device;
   }
 
+  // Stream of the device on which the latest instruction writing this storage runs, -1 if none.
+  int64_t producer_vm_stream_index() const { return producer_vm_stream_index_; }
+  void set_producer_vm_stream_index(int64_t vm_stream_index) {
+    producer_vm_stream_index_ = vm_stream_index;
+  }
+
  private:
   size_t blob_bytes_;
   std::unique_ptr<char, std::function<void(char*)>> blob_dptr_;
   std::unique_ptr<MemoryAllocator> non_pod_allocator_;
   Optional<Symbol<Device>> producer_op_device_;
   Optional<Symbol<Device>> last_used_device_;
+  int64_t producer_vm_stream_index_;
 };
 
 class EagerBlobObject final : public BlobObject {
@@ -95,6 +109,10 @@ class EagerBlobObject final : public BlobObject {
   Maybe<void> InitBlob();
 
   Maybe<void> TryAllocateBlobBodyMemory(DeviceCtx* device_ctx) override;
+  // Takes over the memory of `donor` instead of allocating, if both have the same POD data type,
+  // the same body size and no storage offset. Returns false if nothing has been taken over.
+  // `donor` must be read by nobody but the caller from now on.
+  Maybe<bool> TryTakeOverBlobBodyMemory(EagerBlobObject* donor);
   Maybe<void> DeallocateBlobDataPtr() override {
     tensor_storage_.reset(new TensorStorage);
     return Maybe<void>::Ok();
@@ -128,6 +146,11 @@ class EagerBlobObject final : public BlobObject {
     tensor_storage_->set_last_used_device(last_used_device);
   }
 
+  int64_t producer_vm_stream_index() const { return tensor_storage_->producer_vm_stream_index(); }
+  void set_producer_vm_stream_index(int64_t vm_stream_index) {
+    tensor_storage_->set_producer_vm_stream_index(vm_stream_index);
+  }
+
  private:
   EagerBlobObject(const std::shared_ptr<MemoryCase>& mem_case, const std::shared_ptr<Shape>& shape,
                   DataType data_type, const std::shared_ptr<TensorStorage>& tensor_storage,
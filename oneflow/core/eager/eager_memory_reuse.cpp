@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/eager/eager_memory_reuse.h"
+#include <atomic>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace {
+
+std::atomic<bool>* MutEagerMemoryReuseEnabled() {
+  static std::atomic<bool> enabled(ParseBooleanFromEnv("ONEFLOW_EAGER_MEMORY_REUSE", false));
+  return &enabled;
+}
+
+std::atomic<int64_t> num_reused_blobs(0);
+std::atomic<int64_t> num_reused_bytes(0);
+
+}  // namespace
+
+bool IsEagerMemoryReuseEnabled() {
+  return MutEagerMemoryReuseEnabled()->load(std::memory_order_relaxed);
+}
+
+void SetEagerMemoryReuseEnabled(bool enabled) {
+  MutEagerMemoryReuseEnabled()->store(enabled, std::memory_order_relaxed);
+}
+
+EagerMemoryReuseStats GetEagerMemoryReuseStats() {
+  EagerMemoryReuseStats stats{};
+  stats.num_reused_blobs = num_reused_blobs.load(std::memory_order_relaxed);
+  stats.num_reused_bytes = num_reused_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void AddEagerMemoryReuseStats(int64_t reused_bytes) {
+  num_reused_blobs.fetch_add(1, std::memory_order_relaxed);
+  num_reused_bytes.fetch_add(reused_bytes, std::memory_order_relaxed);
+}
+
+void ResetEagerMemoryReuseStats() {
+  num_reused_blobs.store(0, std::memory_order_relaxed);
+  num_reused_bytes.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace oneflow
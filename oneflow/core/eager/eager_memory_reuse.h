@@ -0,0 +1,43 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EAGER_EAGER_MEMORY_REUSE_H_
+#define ONEFLOW_CORE_EAGER_EAGER_MEMORY_REUSE_H_
+
+#include <cstdint>
+
+namespace oneflow {
+
+// Eager memory reuse lets an op write its output into the memory of an input read by nothing after
+// the op: the tensor of the input has been dropped together with its views and the tensors autograd
+// saved for backward, so that its ReleaseTensor instruction is all that is left. The outputs and
+// inputs sharing memory are the ones the kernel proposes to be inplace, see
+// OpKernelRegistry::SetInplaceProposalFn. Off unless ONEFLOW_EAGER_MEMORY_REUSE is set.
+bool IsEagerMemoryReuseEnabled();
+void SetEagerMemoryReuseEnabled(bool enabled);
+
+struct EagerMemoryReuseStats {
+  int64_t num_reused_blobs;
+  int64_t num_reused_bytes;
+};
+
+// Outputs that have taken over the memory of an input in this process, and the bytes of them.
+EagerMemoryReuseStats GetEagerMemoryReuseStats();
+void AddEagerMemoryReuseStats(int64_t num_reused_bytes);
+void ResetEagerMemoryReuseStats();
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EAGER_EAGER_MEMORY_REUSE_H_
@@ -20,9 +20,35 @@ limitations under the License.
 namespace oneflow {
 namespace vm {
 
+LocalCallOpKernelPhyInstrOperand::LocalCallOpKernelPhyInstrOperand(
+    const std::shared_ptr<one::StatefulLocalOpKernel>& opkernel,
+    const one::EagerBlobObjectListPtr& inputs, const one::EagerBlobObjectListPtr& outputs,
+    const std::shared_ptr<const one::ConsistentTensorInferResult>& consistent_tensor_infer_result,
+    const one::OpExprInterpContext& op_interp_ctx,
+    const one::DevVmDepObjectConsumeMode dev_vm_dep_object_consume_mode)
+    : opkernel_(opkernel),
+      inputs_(inputs),
+      outputs_(outputs),
+      consistent_tensor_infer_result_(consistent_tensor_infer_result),
+      op_interp_ctx_(op_interp_ctx),
+      dev_vm_dep_object_consume_mode_(dev_vm_dep_object_consume_mode),
+      vm_stream_index_(0),
+      input_dependences_(),
+      output_dependences_() {
+  input_dependences_.reserve(opkernel->input_tuple_indexes4const_ibns().size());
+  // Plus the transport and the schedule dependences of the device.
+  output_dependences_.reserve(opkernel->input_tuple_indexes4mut_ibns().size()
+                              + opkernel->output_tuple_indexes4mut_obns().size()
+                              + opkernel->output_tuple_indexes4mut2_obns().size() + 2);
+  ForEachConstMirroredObject(SetInserter(&input_dependences_));
+  ForEachMutMirroredObject(SetInserter(&output_dependences_));
+  ForEachMut2MirroredObject(SetInserter(&output_dependences_));
+}
+
 Maybe<void> LocalCallOpKernelPhyInstrOperand::Init() {
-  JUST(mut_opkernel()->ChooseOpKernel(&user_opkernel_, &need_temp_storage_, attrs(), inputs().get(),
-                                      outputs().get(), consistent_tensor_infer_result().get()));
+  JUST(mut_opkernel()->ChooseOpKernel(&user_opkernel_, &user_opkernel_stateless_,
+                                      &need_temp_storage_, attrs(), inputs().get(), outputs().get(),
+                                      consistent_tensor_infer_result().get()));
   return Maybe<void>::Ok();
 }
 
@@ -47,8 +73,11 @@ void LocalCallOpKernelPhyInstrOperand::ForEachMutMirroredObject(
     // Sequantialize nccl instructions to avoid deadlock
     DoEach(device_schedule_dep_object->mut_mirrored_object());
   } else {
-    // Sequantialize instructions to avoid explosive memory allocation of source ops
-    if (dev_vm_dep_object_consume_mode() == one::DevVmDepObjectConsumeMode::MUTABLE) {
+    // Sequantialize instructions to avoid explosive memory allocation of source ops. Instructions
+    // on the other streams of the device are sequentialized by their streams, and consuming the
+    // object there would serialize the streams.
+    if (dev_vm_dep_object_consume_mode() == one::DevVmDepObjectConsumeMode::MUTABLE
+        && vm_stream_index() == 0) {
       DoEach(device_schedule_dep_object->mut_mirrored_object());
     }
   }
@@ -63,6 +63,9 @@ class LocalCallOpKernelPhyInstrOperand final : public vm::PhyInstrOperand {
   const one::DevVmDepObjectConsumeMode& dev_vm_dep_object_consume_mode() const {
     return dev_vm_dep_object_consume_mode_;
   }
+  // Picked by the builder once the kernel is chosen, see NewVmStreamIndex.
+  int64_t vm_stream_index() const { return vm_stream_index_; }
+  void set_vm_stream_index(int64_t vm_stream_index) { vm_stream_index_ = vm_stream_index; }
 
   one::StatefulLocalOpKernel* mut_opkernel() { return opkernel_.get(); }
 
@@ -83,6 +86,10 @@ class LocalCallOpKernelPhyInstrOperand final : public vm::PhyInstrOperand {
 
   bool need_temp_storage() const { return need_temp_storage_; }
   const user_op::OpKernel* user_opkernel() const { return user_opkernel_; }
+  bool user_opkernel_stateless() const {
+    return user_opkernel_stateless_->load(std::memory_order_acquire);
+  }
+  std::atomic<bool>* mut_user_opkernel_stateless() { return user_opkernel_stateless_; }
 
   const std::shared_ptr<const one::ConsistentTensorInferResult>& consistent_tensor_infer_result()
       const {
@@ -95,19 +102,7 @@ class LocalCallOpKernelPhyInstrOperand final : public vm::PhyInstrOperand {
       const one::EagerBlobObjectListPtr& inputs, const one::EagerBlobObjectListPtr& outputs,
       const std::shared_ptr<const one::ConsistentTensorInferResult>& consistent_tensor_infer_result,
       const one::OpExprInterpContext& op_interp_ctx_,
-      const one::DevVmDepObjectConsumeMode dev_vm_dep_object_consume_mode)
-      : opkernel_(opkernel),
-        inputs_(inputs),
-        outputs_(outputs),
-        consistent_tensor_infer_result_(consistent_tensor_infer_result),
-        op_interp_ctx_(op_interp_ctx_),
-        dev_vm_dep_object_consume_mode_(dev_vm_dep_object_consume_mode),
-        input_dependences_(),
-        output_dependences_() {
-    ForEachConstMirroredObject(SetInserter(&input_dependences_));
-    ForEachMutMirroredObject(SetInserter(&output_dependences_));
-    ForEachMut2MirroredObject(SetInserter(&output_dependences_));
-  }
+      const one::DevVmDepObjectConsumeMode dev_vm_dep_object_consume_mode);
 
   Maybe<void> Init();
 
@@ -117,8 +112,10 @@ class LocalCallOpKernelPhyInstrOperand final : public vm::PhyInstrOperand {
   std::shared_ptr<const one::ConsistentTensorInferResult> consistent_tensor_infer_result_;
   const one::OpExprInterpContext op_interp_ctx_;
   const user_op::OpKernel* user_opkernel_;
+  std::atomic<bool>* user_opkernel_stateless_;
   bool need_temp_storage_;
   const one::DevVmDepObjectConsumeMode dev_vm_dep_object_consume_mode_;
+  int64_t vm_stream_index_;
   DependenceVector input_dependences_;
   DependenceVector output_dependences_;
 };
@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/operator/operator.h"
 #include "oneflow/core/eager/opkernel_object.h"
 #include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/eager/eager_memory_reuse.h"
 #include "oneflow/core/vm/object_wrapper.h"
 #include "oneflow/core/vm/string_object.h"
 #include "oneflow/core/vm/stream.h"
@@ -446,8 +447,13 @@ Maybe<T*> GetSharedOpKernel(vm::Instruction* instruction, DeviceType device_type
 struct LocalCallOpKernelUtil final {
   static inline Maybe<void> Compute(vm::Instruction* instruction) {
     auto* operand = LocalCallOpKernelUtil::GetLocalCallOpKernelPhyInstrOperand(instruction);
-    operand->mut_opkernel()->composed_attrs_for_scheduler_thread()->ResetPrior(operand->attrs());
+    operand->mut_opkernel()
+        ->composed_attrs_for_scheduler_thread(operand->vm_stream_index())
+        ->ResetPrior(operand->attrs());
     DeviceCtx* device_ctx = instruction->stream().device_ctx().get();
+    if (unlikely(IsEagerMemoryReuseEnabled())) {
+      JUST(TryReuseInputBlobsMemory(instruction, operand));
+    }
     JUST(AllocateOutputBlobsMemory(operand, device_ctx));
     if (unlikely(operand->need_temp_storage())) {
       InferTempStorageBlobDesc(operand);
@@ -473,10 +479,12 @@ struct LocalCallOpKernelUtil final {
  private:
   static inline void InferTempStorageBlobDesc(LocalCallOpKernelPhyInstrOperand* operand) {
     const auto& InferTmpSizeFn = operand->opkernel().GetInferTmpSizeFn(operand->user_opkernel());
-    auto* temp_blob_desc = operand->mut_opkernel()->mut_temp_blob_object()->mut_blob_desc();
+    const int64_t vm_stream_index = operand->vm_stream_index();
+    auto* temp_blob_desc =
+        operand->mut_opkernel()->mut_temp_blob_object(vm_stream_index)->mut_blob_desc();
     CHECK(temp_blob_desc->data_type() == DataType::kChar);
     one::LocalUserOpInferContext* op_infer_ctx =
-        operand->opkernel().op_infer_ctx_for_scheduler_thread();
+        operand->opkernel().op_infer_ctx_for_scheduler_thread(vm_stream_index);
     op_infer_ctx->Update(operand->inputs().get(), operand->outputs().get(),
                          operand->consistent_tensor_infer_result().get());
     size_t temp_size = InferTmpSizeFn(op_infer_ctx);
@@ -486,7 +494,7 @@ struct LocalCallOpKernelUtil final {
   }
 
   static inline Maybe<void> ResetTempStorageBlob(LocalCallOpKernelPhyInstrOperand* operand) {
-    return operand->mut_opkernel()->mut_temp_blob_object()->InitBlob();
+    return operand->mut_opkernel()->mut_temp_blob_object(operand->vm_stream_index())->InitBlob();
   }
 
   static inline void TryInitOpKernelStateAndCache(LocalCallOpKernelPhyInstrOperand* operand,
@@ -500,8 +508,53 @@ struct LocalCallOpKernelUtil final {
       state = nullptr;
     }
     operand->mut_opkernel()->TryInitOpKernelStateAndCache(
-        operand->user_opkernel(), device_ctx, operand->inputs().get(), operand->outputs().get(),
-        operand->consistent_tensor_infer_result().get(), state, cache);
+        operand->vm_stream_index(), operand->user_opkernel(),
+        operand->mut_user_opkernel_stateless(), device_ctx, operand->inputs().get(),
+        operand->outputs().get(), operand->consistent_tensor_infer_result().get(), state, cache);
+  }
+
+  // Lets outputs take over the memory of the inputs this instruction is the last to read, as far
+  // as the kernel proposes to compute them inplace, see eager_memory_reuse.h.
+  static inline Maybe<void> TryReuseInputBlobsMemory(vm::Instruction* instruction,
+                                                     LocalCallOpKernelPhyInstrOperand* operand) {
+    std::vector<const vm::MirroredObject*> last_read_objects;
+    INTRUSIVE_UNSAFE_FOR_EACH_PTR(access, instruction->mut_access_list()) {
+      if (unlikely(access->is_last_read())) {
+        last_read_objects.push_back(&access->mirrored_object());
+      }
+    }
+    if (likely(last_read_objects.empty())) { return Maybe<void>::Ok(); }
+    const auto* inplace_out_in_indexes = JUST(operand->mut_opkernel()->GetInplaceOutInIndexes(
+        operand->vm_stream_index(), operand->user_opkernel(), operand->inputs().get(),
+        operand->outputs().get(), operand->consistent_tensor_infer_result().get()));
+    for (const auto& pair : *inplace_out_in_indexes) {
+      vm::EagerBlobObject* out_blob_object = operand->outputs()->at(pair.first).get();
+      vm::EagerBlobObject* in_blob_object = operand->inputs()->at(pair.second).get();
+      const auto* mirrored_object =
+          &JUST(in_blob_object->compute_local_dep_object())->mirrored_object();
+      if (std::find(last_read_objects.begin(), last_read_objects.end(), mirrored_object)
+          == last_read_objects.end()) {
+        continue;
+      }
+      if (NumUsesOfStorage(operand, in_blob_object->tensor_storage().get()) != 1) { continue; }
+      JUST(out_blob_object->TryInitBlob());
+      if (JUST(out_blob_object->TryTakeOverBlobBodyMemory(in_blob_object))) {
+        AddEagerMemoryReuseStats(out_blob_object->tensor_storage()->blob_bytes());
+      }
+    }
+    return Maybe<void>::Ok();
+  }
+
+  static inline int64_t NumUsesOfStorage(LocalCallOpKernelPhyInstrOperand* operand,
+                                         const vm::TensorStorage* tensor_storage) {
+    int64_t num_uses = 0;
+    for (const auto& blob_object : *operand->inputs()) {
+      if (blob_object->tensor_storage().get() == tensor_storage) { ++num_uses; }
+    }
+    for (const auto& blob_object : *operand->outputs()) {
+      if (blob_object->tensor_storage().get() == tensor_storage) { ++num_uses; }
+    }
+    return num_uses;
   }
 
   static inline Maybe<void> AllocateOutputBlobsMemory(LocalCallOpKernelPhyInstrOperand* operand,
@@ -516,24 +569,29 @@ struct LocalCallOpKernelUtil final {
 
   static inline Maybe<void> TryAllocateTempStorageBlobMemory(
       LocalCallOpKernelPhyInstrOperand* operand, DeviceCtx* device_ctx) {
-    return operand->mut_opkernel()->mut_temp_blob_object()->TryAllocateBlobBodyMemory(device_ctx);
+    return operand->mut_opkernel()
+        ->mut_temp_blob_object(operand->vm_stream_index())
+        ->TryAllocateBlobBodyMemory(device_ctx);
   }
 
   static inline void OpKernelCompute(LocalCallOpKernelPhyInstrOperand* operand,
                                      DeviceCtx* device_ctx, user_op::OpKernelState* state,
                                      const user_op::OpKernelCache* cache) {
     auto* opkernel = operand->mut_opkernel();
-    auto* compute_ctx =
-        opkernel->UpdateComputeContext(operand->inputs().get(), operand->outputs().get(),
-                                       operand->consistent_tensor_infer_result().get(), device_ctx);
+    const int64_t vm_stream_index = operand->vm_stream_index();
+    auto* compute_ctx = opkernel->UpdateComputeContext(
+        vm_stream_index, operand->inputs().get(), operand->outputs().get(),
+        operand->consistent_tensor_infer_result().get(), device_ctx);
     operand->user_opkernel()->Compute(compute_ctx, state, cache);
     // tensor tuples are not allowed to be hold by StatefulLocalOpKernel
-    opkernel->UpdateComputeContext(nullptr, nullptr, nullptr, nullptr);
+    opkernel->UpdateComputeContext(vm_stream_index, nullptr, nullptr, nullptr, nullptr);
   }
 
   static inline Maybe<void> DeallocateTempStorageBlobMemory(
       LocalCallOpKernelPhyInstrOperand* operand, DeviceCtx* device_ctx) {
-    return operand->mut_opkernel()->mut_temp_blob_object()->DeallocateBlobDataPtr();
+    return operand->mut_opkernel()
+        ->mut_temp_blob_object(operand->vm_stream_index())
+        ->DeallocateBlobDataPtr();
   }
 };
 
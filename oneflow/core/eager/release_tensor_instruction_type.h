@@ -27,6 +27,8 @@ class ReleaseTensorInstructionType : public vm::InstructionType {
   ReleaseTensorInstructionType() = default;
   ~ReleaseTensorInstructionType() override = default;
 
+  bool IsFreeingMutOperands() const override { return true; }
+
   void Infer(vm::Instruction* instruction) const override;
   void Compute(vm::Instruction* instruction) const override;
 };
@@ -0,0 +1,220 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/cached_key_value_store.h"
+#include <list>
+
+namespace oneflow {
+
+namespace embedding {
+
+class CachedKeyValueStore::Shard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Shard);
+  Shard(int64_t capacity, const CachedKeyValueStoreOptions& options, PersistentTable* table)
+      : value_length_(options.value_length),
+        initializer_(options.initializer),
+        table_(table),
+        values_(capacity * options.value_length),
+        slots_(capacity),
+        stats_() {
+    free_slots_.reserve(capacity);
+    for (int64_t i = capacity - 1; i >= 0; --i) { free_slots_.emplace_back(i); }
+  }
+  ~Shard() = default;
+
+  void Get(const int64_t* keys, const std::vector<int64_t>& indices, float* values) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int64_t i : indices) {
+      const float* slot_ptr = SlotPtr(FindOrLoad(keys[i], true));
+      std::copy(slot_ptr, slot_ptr + value_length_, values + i * value_length_);
+    }
+  }
+
+  void Put(const int64_t* keys, const std::vector<int64_t>& indices, const float* values) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int64_t i : indices) {
+      const int64_t slot = FindOrLoad(keys[i], false);
+      std::copy(values + i * value_length_, values + (i + 1) * value_length_, SlotPtr(slot));
+      if (!slots_.at(slot).dirty) {
+        slots_.at(slot).dirty = true;
+        dirty_slots_.emplace_back(slot);
+      }
+    }
+  }
+
+  void WriteBack() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A slot may be listed more than once if it has been evicted and dirtied again meanwhile.
+    for (int64_t slot : dirty_slots_) { WriteBackSlot(slot); }
+    dirty_slots_.clear();
+  }
+
+  void AddStats(CachedKeyValueStoreStats* stats) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats->num_hits += stats_.num_hits;
+    stats->num_misses += stats_.num_misses;
+    stats->num_evictions += stats_.num_evictions;
+    stats->num_written_back += stats_.num_written_back;
+  }
+
+ private:
+  struct Slot {
+    int64_t key = 0;
+    bool dirty = false;
+    std::list<int64_t>::iterator lru_it;
+  };
+
+  float* SlotPtr(int64_t slot) { return values_.data() + slot * value_length_; }
+
+  int64_t FindOrLoad(int64_t key, bool load) {
+    const auto it = key2slot_.find(key);
+    if (it != key2slot_.end()) {
+      stats_.num_hits += 1;
+      lru_.splice(lru_.begin(), lru_, slots_.at(it->second).lru_it);
+      return it->second;
+    }
+    stats_.num_misses += 1;
+    const int64_t slot = AcquireSlot();
+    // The value is overwritten right away by Put, so there is no need to read it.
+    if (load && !table_->Get(key, SlotPtr(slot))) { initializer_(key, SlotPtr(slot)); }
+    lru_.push_front(slot);
+    slots_.at(slot).key = key;
+    slots_.at(slot).dirty = false;
+    slots_.at(slot).lru_it = lru_.begin();
+    key2slot_.emplace(key, slot);
+    return slot;
+  }
+
+  int64_t AcquireSlot() {
+    if (!free_slots_.empty()) {
+      const int64_t slot = free_slots_.back();
+      free_slots_.pop_back();
+      return slot;
+    }
+    const int64_t slot = lru_.back();
+    lru_.pop_back();
+    WriteBackSlot(slot);
+    key2slot_.erase(slots_.at(slot).key);
+    stats_.num_evictions += 1;
+    return slot;
+  }
+
+  void WriteBackSlot(int64_t slot) {
+    Slot& s = slots_.at(slot);
+    if (!s.dirty) { return; }
+    table_->Put(s.key, SlotPtr(slot));
+    s.dirty = false;
+    stats_.num_written_back += 1;
+  }
+
+  const int64_t value_length_;
+  const std::function<void(int64_t, float*)> initializer_;
+  PersistentTable* table_;
+  std::vector<float> values_;
+  std::vector<Slot> slots_;
+  std::vector<int64_t> free_slots_;
+  std::vector<int64_t> dirty_slots_;
+  // Most recently used first.
+  std::list<int64_t> lru_;
+  HashMap<int64_t, int64_t> key2slot_;
+  CachedKeyValueStoreStats stats_;
+  mutable std::mutex mutex_;
+};
+
+CachedKeyValueStore::CachedKeyValueStore(const CachedKeyValueStoreOptions& options)
+    : options_(options), shutdown_(false) {
+  CHECK_GT(options_.value_length, 0);
+  CHECK_GT(options_.cache_capacity, 0);
+  CHECK_GT(options_.num_shards, 0);
+  CHECK_GT(options_.flush_interval_ms, 0);
+  CHECK_GT(options_.persist_interval_ms, 0);
+  CHECK(options_.initializer);
+  table_.reset(new PersistentTable(options_.path, options_.value_length));
+  const int64_t shard_capacity =
+      RoundUp(options_.cache_capacity, options_.num_shards) / options_.num_shards;
+  FOR_RANGE(int64_t, i, 0, options_.num_shards) {
+    shards_.emplace_back(new Shard(shard_capacity, options_, table_.get()));
+  }
+  write_back_thread_ = std::thread(&CachedKeyValueStore::WriteBackLoop, this);
+}
+
+CachedKeyValueStore::~CachedKeyValueStore() {
+  {
+    std::lock_guard<std::mutex> lock(write_back_mutex_);
+    shutdown_ = true;
+  }
+  write_back_cond_.notify_all();
+  write_back_thread_.join();
+  Flush();
+}
+
+void CachedKeyValueStore::Get(int64_t num_keys, const int64_t* keys, float* values) {
+  ForEachShardKeys(num_keys, keys, [&](Shard* shard, const std::vector<int64_t>& indices) {
+    shard->Get(keys, indices, values);
+  });
+}
+
+void CachedKeyValueStore::Put(int64_t num_keys, const int64_t* keys, const float* values) {
+  ForEachShardKeys(num_keys, keys, [&](Shard* shard, const std::vector<int64_t>& indices) {
+    shard->Put(keys, indices, values);
+  });
+}
+
+void CachedKeyValueStore::Flush() {
+  for (auto& shard : shards_) { shard->WriteBack(); }
+  table_->Flush();
+}
+
+CachedKeyValueStoreStats CachedKeyValueStore::GetStats() const {
+  CachedKeyValueStoreStats stats{};
+  for (const auto& shard : shards_) { shard->AddStats(&stats); }
+  return stats;
+}
+
+void CachedKeyValueStore::ForEachShardKeys(
+    int64_t num_keys, const int64_t* keys,
+    const std::function<void(Shard* shard, const std::vector<int64_t>& indices)>& Handler) {
+  std::vector<std::vector<int64_t>> shard2indices(shards_.size());
+  FOR_RANGE(int64_t, i, 0, num_keys) {
+    // The low bits pick the owner rank of the key, see embedding_kernels.cpp.
+    shard2indices.at((HashEmbeddingKey(keys[i]) >> 32) % shards_.size()).emplace_back(i);
+  }
+  FOR_RANGE(size_t, i, 0, shards_.size()) {
+    if (!shard2indices.at(i).empty()) { Handler(shards_.at(i).get(), shard2indices.at(i)); }
+  }
+}
+
+void CachedKeyValueStore::WriteBackLoop() {
+  std::unique_lock<std::mutex> lock(write_back_mutex_);
+  auto last_persist_time = std::chrono::steady_clock::now();
+  while (!shutdown_) {
+    write_back_cond_.wait_for(lock, std::chrono::milliseconds(options_.flush_interval_ms),
+                              [&]() { return shutdown_; });
+    if (shutdown_) { break; }
+    lock.unlock();
+    for (auto& shard : shards_) { shard->WriteBack(); }
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_persist_time >= std::chrono::milliseconds(options_.persist_interval_ms)) {
+      table_->Flush();
+      last_persist_time = now;
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace embedding
+
+}  // namespace oneflow
@@ -0,0 +1,100 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EMBEDDING_CACHED_KEY_VALUE_STORE_H_
+#define ONEFLOW_CORE_EMBEDDING_CACHED_KEY_VALUE_STORE_H_
+
+#include <condition_variable>
+#include <thread>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/embedding/persistent_table.h"
+
+namespace oneflow {
+
+namespace embedding {
+
+// Mixes the bits of key, to pick the shard and the owner rank of a key.
+inline uint64_t HashEmbeddingKey(int64_t key) {
+  uint64_t x = static_cast<uint64_t>(key) + 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+struct CachedKeyValueStoreOptions {
+  std::string path;
+  int64_t value_length = 0;
+  // Rows kept in RAM over all the shards.
+  int64_t cache_capacity = 0;
+  int64_t num_shards = 16;
+  int64_t flush_interval_ms = 100;
+  // How often the write back thread also flushes the persistent table, so that the rows survive a
+  // crash and the key index need not be rebuilt when the table is reopened.
+  int64_t persist_interval_ms = 10000;
+  // Fills the value of a key that is got before it has ever been put. It must be deterministic,
+  // since a row that has not been put is dropped instead of written back when it is evicted.
+  std::function<void(int64_t key, float* value)> initializer;
+};
+
+struct CachedKeyValueStoreStats {
+  int64_t num_hits;
+  int64_t num_misses;
+  int64_t num_evictions;
+  int64_t num_written_back;
+};
+
+// A key-value store of fixed length float rows. The rows in use are cached in RAM in shards picked
+// by key hash, each with its own lock and LRU list, in front of a PersistentTable that holds all
+// the rows on disk. The cache is write-back: Put only marks the cached row dirty, and a background
+// thread writes the dirty rows back every flush_interval_ms, so that evicting a row on a miss
+// rarely has to wait for the disk. It flushes the persistent table every persist_interval_ms.
+class CachedKeyValueStore final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CachedKeyValueStore);
+  explicit CachedKeyValueStore(const CachedKeyValueStoreOptions& options);
+  ~CachedKeyValueStore();
+
+  int64_t value_length() const { return options_.value_length; }
+
+  // Thread safe. Keys may repeat.
+  void Get(int64_t num_keys, const int64_t* keys, float* values);
+  void Put(int64_t num_keys, const int64_t* keys, const float* values);
+  // Writes all the dirty rows back and flushes the persistent table.
+  void Flush();
+
+  CachedKeyValueStoreStats GetStats() const;
+
+ private:
+  class Shard;
+
+  void ForEachShardKeys(
+      int64_t num_keys, const int64_t* keys,
+      const std::function<void(Shard* shard, const std::vector<int64_t>& indices)>& Handler);
+  void WriteBackLoop();
+
+  CachedKeyValueStoreOptions options_;
+  std::unique_ptr<PersistentTable> table_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::mutex write_back_mutex_;
+  std::condition_variable write_back_cond_;
+  bool shutdown_;
+  std::thread write_back_thread_;
+};
+
+}  // namespace embedding
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EMBEDDING_CACHED_KEY_VALUE_STORE_H_
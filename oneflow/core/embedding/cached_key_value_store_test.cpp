@@ -0,0 +1,179 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include "oneflow/core/embedding/cached_key_value_store.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+namespace embedding {
+
+namespace test {
+
+namespace {
+
+constexpr int64_t kValueLength = 4;
+
+std::string MakeTempDir() {
+  char path[] = "/tmp/oneflow_embedding_test_XXXXXX";
+  CHECK_NOTNULL(mkdtemp(path));
+  return path;
+}
+
+void InitValue(int64_t key, float* value) {
+  FOR_RANGE(int64_t, i, 0, kValueLength) { value[i] = -key - i; }
+}
+
+std::vector<float> MakeValues(const std::vector<int64_t>& keys, float offset) {
+  std::vector<float> values(keys.size() * kValueLength);
+  FOR_RANGE(size_t, i, 0, keys.size()) {
+    FOR_RANGE(int64_t, j, 0, kValueLength) {
+      values[i * kValueLength + j] = keys[i] * 10 + j + offset;
+    }
+  }
+  return values;
+}
+
+CachedKeyValueStoreOptions MakeOptions(const std::string& path, int64_t cache_capacity) {
+  CachedKeyValueStoreOptions options;
+  options.path = path;
+  options.value_length = kValueLength;
+  options.cache_capacity = cache_capacity;
+  options.num_shards = 4;
+  options.flush_interval_ms = 10;
+  options.initializer = InitValue;
+  return options;
+}
+
+}  // namespace
+
+TEST(PersistentTable, put_get_and_reopen) {
+  const std::string path = MakeTempDir();
+  std::vector<int64_t> keys(100 * 1000);
+  FOR_RANGE(size_t, i, 0, keys.size()) { keys[i] = i * 7919 - 123456; }
+  const std::vector<float> values = MakeValues(keys, 0);
+  {
+    PersistentTable table(path, kValueLength);
+    FOR_RANGE(size_t, i, 0, keys.size()) { table.Put(keys[i], values.data() + i * kValueLength); }
+    // Put again does not add a row.
+    table.Put(keys[0], values.data());
+    ASSERT_EQ(table.size(), static_cast<int64_t>(keys.size()));
+    std::vector<float> value(kValueLength);
+    ASSERT_FALSE(table.Get(1, value.data()));
+  }
+  {
+    PersistentTable table(path, kValueLength);
+    ASSERT_EQ(table.size(), static_cast<int64_t>(keys.size()));
+    std::vector<float> value(kValueLength);
+    FOR_RANGE(size_t, i, 0, keys.size()) {
+      ASSERT_TRUE(table.Get(keys[i], value.data()));
+      FOR_RANGE(int64_t, j, 0, kValueLength) {
+        ASSERT_EQ(value[j], values[i * kValueLength + j]);
+      }
+    }
+  }
+  LocalFS()->RecursivelyDeleteDir(path);
+}
+
+// The child dies without closing the table, so the index it has dirtied since its last Flush is
+// rebuilt from the flushed rows on reopen.
+TEST(PersistentTable, rebuild_index_after_crash) {
+  const std::string path = MakeTempDir();
+  std::vector<int64_t> keys(1000);
+  FOR_RANGE(size_t, i, 0, keys.size()) { keys[i] = i * 13; }
+  const std::vector<float> values = MakeValues(keys, 0);
+  const size_t num_flushed_keys = keys.size() / 2;
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    PersistentTable* table = new PersistentTable(path, kValueLength);
+    FOR_RANGE(size_t, i, 0, keys.size()) {
+      if (i == num_flushed_keys) { table->Flush(); }
+      table->Put(keys[i], values.data() + i * kValueLength);
+    }
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  {
+    PersistentTable table(path, kValueLength);
+    ASSERT_EQ(table.size(), static_cast<int64_t>(num_flushed_keys));
+    std::vector<float> value(kValueLength);
+    FOR_RANGE(size_t, i, 0, keys.size()) {
+      ASSERT_EQ(table.Get(keys[i], value.data()), i < num_flushed_keys);
+      if (i < num_flushed_keys) { ASSERT_EQ(value[0], values[i * kValueLength]); }
+    }
+  }
+  LocalFS()->RecursivelyDeleteDir(path);
+}
+
+// Far more keys than the cache holds, so that rows keep being evicted to the table and loaded back.
+TEST(CachedKeyValueStore, tiering) {
+  const std::string path = MakeTempDir();
+  std::vector<int64_t> keys(10000);
+  FOR_RANGE(size_t, i, 0, keys.size()) { keys[i] = i * 31; }
+  const std::vector<float> values = MakeValues(keys, 0.5);
+  {
+    CachedKeyValueStore store(MakeOptions(path, 100));
+    std::vector<float> got(keys.size() * kValueLength);
+    // Rows that have never been put are initialized lazily.
+    store.Get(keys.size(), keys.data(), got.data());
+    FOR_RANGE(size_t, i, 0, keys.size()) {
+      ASSERT_EQ(got[i * kValueLength + 1], static_cast<float>(-keys[i] - 1));
+    }
+    store.Put(keys.size(), keys.data(), values.data());
+    store.Get(keys.size(), keys.data(), got.data());
+    ASSERT_EQ(got, values);
+    const CachedKeyValueStoreStats stats = store.GetStats();
+    ASSERT_GT(stats.num_evictions, 0);
+    ASSERT_GE(stats.num_written_back, static_cast<int64_t>(keys.size()) - 100);
+  }
+  {
+    CachedKeyValueStore store(MakeOptions(path, 100));
+    std::vector<float> got(keys.size() * kValueLength);
+    store.Get(keys.size(), keys.data(), got.data());
+    ASSERT_EQ(got, values);
+  }
+  LocalFS()->RecursivelyDeleteDir(path);
+}
+
+TEST(CachedKeyValueStore, background_write_back) {
+  const std::string path = MakeTempDir();
+  const std::vector<int64_t> keys = {3, 1, 4, 1, 5};
+  const std::vector<float> values = MakeValues(keys, 0);
+  {
+    CachedKeyValueStore store(MakeOptions(path, 1000));
+    store.Put(keys.size(), keys.data(), values.data());
+    // Nothing is evicted, so only the write back thread writes the rows to the table.
+    for (int i = 0; i < 500 && store.GetStats().num_written_back < 4; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const CachedKeyValueStoreStats stats = store.GetStats();
+    ASSERT_EQ(stats.num_evictions, 0);
+    ASSERT_EQ(stats.num_written_back, 4);
+  }
+  LocalFS()->RecursivelyDeleteDir(path);
+}
+
+}  // namespace test
+
+}  // namespace embedding
+
+}  // namespace oneflow
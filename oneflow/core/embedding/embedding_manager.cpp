@@ -0,0 +1,52 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/embedding_manager.h"
+
+namespace oneflow {
+
+embedding::CachedKeyValueStore* EmbeddingMgr::GetOrCreateStore(
+    const std::string& name, int64_t parallel_id,
+    const std::function<embedding::CachedKeyValueStoreOptions()>& MakeOptions) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& store = name2parallel_id2store_[name][parallel_id];
+  if (!store) { store.reset(new embedding::CachedKeyValueStore(MakeOptions())); }
+  return store.get();
+}
+
+Maybe<embedding::CachedKeyValueStore*> EmbeddingMgr::GetStore(const std::string& name,
+                                                              int64_t parallel_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto name_it = name2parallel_id2store_.find(name);
+  CHECK_OR_RETURN(name_it != name2parallel_id2store_.end()
+                  && name_it->second.find(parallel_id) != name_it->second.end())
+      << "embedding " << name << " has not been looked up on parallel_id " << parallel_id;
+  return name_it->second.at(parallel_id).get();
+}
+
+void EmbeddingMgr::FlushStores(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = name2parallel_id2store_.find(name);
+  // A table that has not been looked up in this process has nothing to flush.
+  if (it == name2parallel_id2store_.end()) { return; }
+  for (auto& pair : it->second) { pair.second->Flush(); }
+}
+
+void EmbeddingMgr::CloseStores(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  name2parallel_id2store_.erase(name);
+}
+
+}  // namespace oneflow
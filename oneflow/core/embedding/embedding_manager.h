@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EMBEDDING_EMBEDDING_MANAGER_H_
+#define ONEFLOW_CORE_EMBEDDING_EMBEDDING_MANAGER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/embedding/cached_key_value_store.h"
+
+namespace oneflow {
+
+// Owns the stores of the embedding tables in this process. A table is identified by its name and
+// has one store per rank of its placement, each holding the keys owned by that rank. The stores
+// live until they are closed or the env is destroyed, when their dirty rows are written back to
+// disk. A store that has been closed is reopened by the next lookup.
+class EmbeddingMgr final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(EmbeddingMgr);
+  ~EmbeddingMgr() = default;
+
+  embedding::CachedKeyValueStore* GetOrCreateStore(
+      const std::string& name, int64_t parallel_id,
+      const std::function<embedding::CachedKeyValueStoreOptions()>& MakeOptions);
+  Maybe<embedding::CachedKeyValueStore*> GetStore(const std::string& name, int64_t parallel_id);
+  // Writes the dirty rows of the stores of the table in this process back and flushes them to disk.
+  void FlushStores(const std::string& name);
+  // Flushes and destroys the stores of the table in this process. No lookup or update of the table
+  // may be running.
+  void CloseStores(const std::string& name);
+
+ private:
+  friend class Global<EmbeddingMgr>;
+  EmbeddingMgr() = default;
+
+  HashMap<std::string, HashMap<int64_t, std::unique_ptr<embedding::CachedKeyValueStore>>>
+      name2parallel_id2store_;
+  std::mutex mutex_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EMBEDDING_EMBEDDING_MANAGER_H_
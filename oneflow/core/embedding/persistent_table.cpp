@@ -0,0 +1,294 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/embedding/persistent_table.h"
+#include "oneflow/core/persistence/file_system.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace oneflow {
+
+namespace embedding {
+
+namespace {
+
+constexpr int64_t kNumRowsPerChunk = 64 * 1024;
+constexpr uint64_t kIndexMagic = 0x4F46494E44455831ULL;
+constexpr int64_t kMinIndexCapacity = 64 * 1024;
+// The header takes a page, so that it can be synced alone.
+constexpr int64_t kIndexHeaderBytes = 4096;
+
+std::string ChunkPath(const std::string& path, int64_t chunk_id) {
+  return JoinPath(path, "chunk-" + std::to_string(chunk_id));
+}
+
+std::string NumRowsPath(const std::string& path) { return JoinPath(path, "num_rows"); }
+
+std::string IndexPath(const std::string& path) { return JoinPath(path, "index"); }
+
+// The shift that leaves the top log2(capacity) bits of a 64 bit hash.
+int IndexShift(int64_t capacity) {
+  int shift = 64;
+  while ((int64_t{1} << (64 - shift)) < capacity) { --shift; }
+  return shift;
+}
+
+}  // namespace
+
+struct PersistentTable::IndexHeader {
+  uint64_t magic;
+  int64_t capacity;
+  // The number of rows when the index was flushed, and whether it has not changed since.
+  int64_t num_rows;
+  int64_t clean;
+};
+
+// row_plus_one is 0 for an empty slot.
+struct PersistentTable::IndexSlot {
+  int64_t key;
+  int64_t row_plus_one;
+};
+
+// A row is the key followed by the value.
+PersistentTable::PersistentTable(const std::string& path, int64_t value_length)
+    : path_(path),
+      value_length_(value_length),
+      row_size_(sizeof(int64_t) + value_length * sizeof(float)),
+      num_rows_(0),
+      index_fd_(-1),
+      index_ptr_(nullptr),
+      index_capacity_(0),
+      index_shift_(0),
+      index_dirty_(false) {
+  CHECK_GT(value_length_, 0);
+  LocalFS()->RecursivelyCreateDirIfNotExist(path_);
+  std::ifstream num_rows_file(NumRowsPath(path_));
+  if (num_rows_file.is_open()) { CHECK(num_rows_file >> num_rows_) << NumRowsPath(path_); }
+  // Rows added after the last Flush are dropped, since they may be partly written.
+  FOR_RANGE(int64_t, i, 0, RoundUp(num_rows_, kNumRowsPerChunk) / kNumRowsPerChunk) {
+    MapChunk(i, false);
+  }
+  if (!OpenIndex()) { RebuildIndex(); }
+}
+
+PersistentTable::~PersistentTable() {
+  Flush();
+  for (const Chunk& chunk : chunks_) {
+    PCHECK(munmap(chunk.ptr, kNumRowsPerChunk * row_size_) == 0);
+    PCHECK(close(chunk.fd) == 0);
+  }
+  UnmapIndex();
+}
+
+int64_t PersistentTable::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_rows_;
+}
+
+bool PersistentTable::Get(int64_t key, float* value) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const IndexSlot* slot = FindIndexSlot(key);
+  if (slot->row_plus_one == 0) { return false; }
+  std::memcpy(value, RowPtr(slot->row_plus_one - 1) + sizeof(int64_t),
+              value_length_ * sizeof(float));
+  return true;
+}
+
+void PersistentTable::Put(int64_t key, const float* value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t row = -1;
+  const IndexSlot* slot = FindIndexSlot(key);
+  if (slot->row_plus_one == 0) {
+    row = num_rows_;
+    if (row % kNumRowsPerChunk == 0) { MapChunk(row / kNumRowsPerChunk, true); }
+    std::memcpy(RowPtr(row), &key, sizeof(key));
+    num_rows_ += 1;
+    AddToIndex(key, row);
+  } else {
+    row = slot->row_plus_one - 1;
+  }
+  std::memcpy(RowPtr(row) + sizeof(int64_t), value, value_length_ * sizeof(float));
+}
+
+void PersistentTable::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const Chunk& chunk : chunks_) {
+    PCHECK(msync(chunk.ptr, kNumRowsPerChunk * row_size_, MS_SYNC) == 0);
+  }
+  // The index is marked clean only once the rows and the slots are on disk, and is trusted on
+  // reopen only if it was flushed with the same number of rows.
+  const int64_t index_bytes = kIndexHeaderBytes + index_capacity_ * sizeof(IndexSlot);
+  PCHECK(msync(index_ptr_, index_bytes, MS_SYNC) == 0);
+  index_header()->num_rows = num_rows_;
+  index_header()->clean = 1;
+  PCHECK(msync(index_ptr_, kIndexHeaderBytes, MS_SYNC) == 0);
+  index_dirty_ = false;
+  WriteNumRows();
+}
+
+char* PersistentTable::RowPtr(int64_t row) const {
+  return chunks_.at(row / kNumRowsPerChunk).ptr + (row % kNumRowsPerChunk) * row_size_;
+}
+
+void PersistentTable::MapChunk(int64_t chunk_id, bool create) {
+  CHECK_EQ(chunk_id, static_cast<int64_t>(chunks_.size()));
+  const std::string chunk_path = ChunkPath(path_, chunk_id);
+  const int64_t chunk_bytes = kNumRowsPerChunk * row_size_;
+  const int fd = open(chunk_path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+  PCHECK(fd >= 0) << chunk_path;
+  if (create) {
+    // The file is sparse, so that disk space is only taken by the rows written.
+    PCHECK(ftruncate(fd, chunk_bytes) == 0) << chunk_path;
+  } else {
+    struct stat st {};
+    PCHECK(fstat(fd, &st) == 0) << chunk_path;
+    CHECK_EQ(st.st_size, chunk_bytes) << chunk_path << " does not match value_length "
+                                      << value_length_;
+  }
+  void* ptr = mmap(nullptr, chunk_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(ptr != MAP_FAILED) << chunk_path;
+  chunks_.emplace_back(Chunk{fd, static_cast<char*>(ptr)});
+}
+
+void PersistentTable::WriteNumRows() const {
+  // Written aside and renamed, so that a crash leaves either the old or the new count.
+  const std::string num_rows_path = NumRowsPath(path_);
+  const std::string tmp_path = num_rows_path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    out << num_rows_;
+    CHECK(out.good()) << tmp_path;
+  }
+  PCHECK(std::rename(tmp_path.c_str(), num_rows_path.c_str()) == 0) << num_rows_path;
+}
+
+bool PersistentTable::OpenIndex() {
+  const std::string index_path = IndexPath(path_);
+  const int fd = open(index_path.c_str(), O_RDWR);
+  if (fd < 0) { return false; }
+  IndexHeader header{};
+  struct stat st {};
+  PCHECK(fstat(fd, &st) == 0) << index_path;
+  const bool valid =
+      st.st_size >= kIndexHeaderBytes && pread(fd, &header, sizeof(header), 0) == sizeof(header)
+      && header.magic == kIndexMagic && header.capacity >= kMinIndexCapacity
+      && (header.capacity & (header.capacity - 1)) == 0
+      && st.st_size == kIndexHeaderBytes + header.capacity * static_cast<int64_t>(sizeof(IndexSlot))
+      && header.clean == 1 && header.num_rows == num_rows_;
+  if (!valid) {
+    PCHECK(close(fd) == 0);
+    return false;
+  }
+  void* ptr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(ptr != MAP_FAILED) << index_path;
+  index_fd_ = fd;
+  index_ptr_ = static_cast<char*>(ptr);
+  index_capacity_ = header.capacity;
+  index_shift_ = IndexShift(index_capacity_);
+  return true;
+}
+
+void PersistentTable::CreateIndex(int64_t capacity) {
+  // Built aside and renamed, so that the index file is never half built.
+  const std::string index_path = IndexPath(path_);
+  const std::string tmp_path = index_path + ".tmp";
+  const int64_t index_bytes = kIndexHeaderBytes + capacity * sizeof(IndexSlot);
+  const int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  PCHECK(fd >= 0) << tmp_path;
+  PCHECK(ftruncate(fd, index_bytes) == 0) << tmp_path;
+  void* ptr = mmap(nullptr, index_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(ptr != MAP_FAILED) << tmp_path;
+  const int old_fd = index_fd_;
+  char* old_ptr = index_ptr_;
+  const int64_t old_capacity = index_capacity_;
+  index_fd_ = fd;
+  index_ptr_ = static_cast<char*>(ptr);
+  index_capacity_ = capacity;
+  index_shift_ = IndexShift(index_capacity_);
+  index_header()->magic = kIndexMagic;
+  index_header()->capacity = capacity;
+  index_header()->num_rows = 0;
+  index_header()->clean = 0;
+  index_dirty_ = true;
+  if (old_ptr != nullptr) {
+    const IndexSlot* old_slots = reinterpret_cast<const IndexSlot*>(old_ptr + kIndexHeaderBytes);
+    FOR_RANGE(int64_t, i, 0, old_capacity) {
+      if (old_slots[i].row_plus_one != 0) { *FindIndexSlot(old_slots[i].key) = old_slots[i]; }
+    }
+    PCHECK(munmap(old_ptr, kIndexHeaderBytes + old_capacity * sizeof(IndexSlot)) == 0);
+    PCHECK(close(old_fd) == 0);
+  }
+  PCHECK(std::rename(tmp_path.c_str(), index_path.c_str()) == 0) << index_path;
+}
+
+void PersistentTable::RebuildIndex() {
+  int64_t capacity = kMinIndexCapacity;
+  while (capacity < 2 * num_rows_) { capacity *= 2; }
+  CreateIndex(capacity);
+  FOR_RANGE(int64_t, row, 0, num_rows_) {
+    int64_t key = 0;
+    std::memcpy(&key, RowPtr(row), sizeof(key));
+    IndexSlot* slot = FindIndexSlot(key);
+    CHECK_EQ(slot->row_plus_one, 0) << "duplicated key " << key << " in " << path_;
+    *slot = IndexSlot{key, row + 1};
+  }
+}
+
+void PersistentTable::UnmapIndex() {
+  if (index_ptr_ == nullptr) { return; }
+  PCHECK(munmap(index_ptr_, kIndexHeaderBytes + index_capacity_ * sizeof(IndexSlot)) == 0);
+  PCHECK(close(index_fd_) == 0);
+  index_ptr_ = nullptr;
+  index_fd_ = -1;
+}
+
+PersistentTable::IndexHeader* PersistentTable::index_header() const {
+  return reinterpret_cast<IndexHeader*>(index_ptr_);
+}
+
+PersistentTable::IndexSlot* PersistentTable::FindIndexSlot(int64_t key) const {
+  IndexSlot* slots = reinterpret_cast<IndexSlot*>(index_ptr_ + kIndexHeaderBytes);
+  // Fibonacci hashing takes the high bits, the low bits of the keys of a store are alike since
+  // they pick its rank. The index is at most half full, so the probing ends.
+  int64_t i = static_cast<int64_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL)
+                                   >> index_shift_);
+  while (slots[i].row_plus_one != 0 && slots[i].key != key) { i = (i + 1) & (index_capacity_ - 1); }
+  return slots + i;
+}
+
+void PersistentTable::AddToIndex(int64_t key, int64_t row) {
+  MarkIndexDirty();
+  if (2 * num_rows_ > index_capacity_) { CreateIndex(2 * index_capacity_); }
+  IndexSlot* slot = FindIndexSlot(key);
+  CHECK_EQ(slot->row_plus_one, 0);
+  *slot = IndexSlot{key, row + 1};
+}
+
+void PersistentTable::MarkIndexDirty() {
+  if (index_dirty_) { return; }
+  // On disk before any slot changes, so that a crash before the next Flush leads to a rebuild.
+  index_header()->clean = 0;
+  PCHECK(msync(index_ptr_, kIndexHeaderBytes, MS_SYNC) == 0);
+  index_dirty_ = true;
+}
+
+}  // namespace embedding
+
+}  // namespace oneflow
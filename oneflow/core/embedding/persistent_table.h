@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EMBEDDING_PERSISTENT_TABLE_H_
+#define ONEFLOW_CORE_EMBEDDING_PERSISTENT_TABLE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace embedding {
+
+// Rows of value_length floats stored in memory-mapped chunk files under path, so that the table
+// may be much larger than RAM and the kernel pages cold rows out to disk. The key to row index is
+// an open addressing hash table in a memory-mapped file as well. It is reused when the table is
+// reopened after a Flush, and rebuilt from the rows otherwise.
+class PersistentTable final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PersistentTable);
+  PersistentTable(const std::string& path, int64_t value_length);
+  ~PersistentTable();
+
+  int64_t value_length() const { return value_length_; }
+  int64_t size() const;
+
+  // Returns false if key has never been put.
+  bool Get(int64_t key, float* value) const;
+  void Put(int64_t key, const float* value);
+  // Writes the mapped rows, the index and the number of rows back to the files.
+  void Flush();
+
+ private:
+  struct Chunk {
+    int fd;
+    char* ptr;
+  };
+  struct IndexHeader;
+  struct IndexSlot;
+
+  char* RowPtr(int64_t row) const;
+  void MapChunk(int64_t chunk_id, bool create);
+  void WriteNumRows() const;
+
+  // Maps the index file if it has been flushed with the rows, returns false otherwise.
+  bool OpenIndex();
+  void CreateIndex(int64_t capacity);
+  void RebuildIndex();
+  void UnmapIndex();
+  IndexHeader* index_header() const;
+  // The slot of key, or the empty slot it goes to.
+  IndexSlot* FindIndexSlot(int64_t key) const;
+  void AddToIndex(int64_t key, int64_t row);
+  void MarkIndexDirty();
+
+  std::string path_;
+  int64_t value_length_;
+  int64_t row_size_;
+  int64_t num_rows_;
+  std::vector<Chunk> chunks_;
+  int index_fd_;
+  char* index_ptr_;
+  int64_t index_capacity_;
+  int index_shift_;
+  bool index_dirty_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace embedding
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EMBEDDING_PERSISTENT_TABLE_H_
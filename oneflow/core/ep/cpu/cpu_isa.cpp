@@ -0,0 +1,61 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+
+namespace oneflow {
+
+namespace ep {
+
+namespace {
+
+CpuIsa DetectCpuIsa() {
+#if OF_CPU_SIMD_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+      && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")) {
+    return CpuIsa::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return CpuIsa::kAvx2; }
+#endif  // OF_CPU_SIMD_DISPATCH
+  return CpuIsa::kDefault;
+}
+
+CpuIsa GetMaxCpuIsaFromEnv() {
+  const char* env = std::getenv("ONEFLOW_CPU_ISA");
+  if (env == nullptr) { return CpuIsa::kAvx512; }
+  const std::string isa(env);
+  if (isa == "default") {
+    return CpuIsa::kDefault;
+  } else if (isa == "avx2") {
+    return CpuIsa::kAvx2;
+  } else if (isa == "avx512") {
+    return CpuIsa::kAvx512;
+  } else {
+    LOG(WARNING) << "Unknown ONEFLOW_CPU_ISA: " << isa;
+    return CpuIsa::kAvx512;
+  }
+}
+
+}  // namespace
+
+CpuIsa GetCpuIsa() {
+  static const CpuIsa isa = std::min(DetectCpuIsa(), GetMaxCpuIsaFromEnv());
+  return isa;
+}
+
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
+#define ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
+
+#include "oneflow/core/common/util.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OF_CPU_SIMD_DISPATCH 1
+#include <immintrin.h>
+#define OF_CPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define OF_CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma")))
+#else
+#define OF_CPU_SIMD_DISPATCH 0
+#define OF_CPU_TARGET_AVX2
+#define OF_CPU_TARGET_AVX512
+#endif
+
+namespace oneflow {
+
+namespace ep {
+
+// Instruction set the CPU kernels dispatch to at runtime. Kernels are compiled for every level with
+// target attributes, so the binary still runs on machines without AVX.
+enum class CpuIsa {
+  kDefault = 0,
+  kAvx2 = 1,
+  kAvx512 = 2,
+};
+
+// Detected once per process. ONEFLOW_CPU_ISA=default|avx2|avx512 caps the detected level.
+CpuIsa GetCpuIsa();
+
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
@@ -13,6 +13,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_BINARY_FUNCTOR_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_BINARY_FUNCTOR_H_
+
 #include "oneflow/core/ep/common/primitive/binary_functor.h"
 
 namespace oneflow {
@@ -37,3 +40,5 @@ struct BinaryFunctor<DeviceType::kCPU, BinaryOp::kPow, float16, float16> {
 }  // namespace primitive
 }  // namespace ep
 }  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_BINARY_FUNCTOR_H_
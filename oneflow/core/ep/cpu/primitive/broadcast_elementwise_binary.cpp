@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/ep/include/primitive/broadcast_elementwise_binary.h"
 #include "oneflow/core/ep/common/primitive/broadcast_elementwise_binary.h"
 #include "oneflow/core/ep/cpu/primitive/binary_functor.h"
+#include "oneflow/core/ep/cpu/primitive/simd_elementwise.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
 #include "oneflow/core/ndarray/ndarray_util.h"
 #include "oneflow/core/ndarray/xpu_var_ndarray.h"
@@ -52,17 +53,15 @@ class BroadcastElementwiseBinaryImpl : public BroadcastElementwiseBinary {
               const void* src1, void* dst) override {
     int64_t elem_cnt = GetElementCount(num_src1_dims, src1_dims);
     Src src0_val = GetValue<Src>(src0);
-    binary_func(stream, XpuVarNdarray<Dst>(Shape({elem_cnt}), reinterpret_cast<Dst*>(dst), 1),
-                XpuVarNdarray<const Src>(Shape({1}), &src0_val, 1),
-                XpuVarNdarray<const Src>(Shape({elem_cnt}), reinterpret_cast<const Src*>(src1), 1));
+    simd_elementwise::LaunchBinary1D<binary_op, Src, Dst, true, false>(
+        elem_cnt, &src0_val, reinterpret_cast<const Src*>(src1), reinterpret_cast<Dst*>(dst));
   }
   void Launch(Stream* stream, size_t num_src0_dims, const int64_t* src0_dims, const void* src0,
               Scalar src1, void* dst) override {
     int64_t elem_cnt = GetElementCount(num_src0_dims, src0_dims);
     Src src1_val = GetValue<Src>(src1);
-    binary_func(stream, XpuVarNdarray<Dst>(Shape({elem_cnt}), reinterpret_cast<Dst*>(dst), 1),
-                XpuVarNdarray<const Src>(Shape({elem_cnt}), reinterpret_cast<const Src*>(src0), 1),
-                XpuVarNdarray<const Src>(Shape({1}), &src1_val, 1));
+    simd_elementwise::LaunchBinary1D<binary_op, Src, Dst, false, true>(
+        elem_cnt, reinterpret_cast<const Src*>(src0), &src1_val, reinterpret_cast<Dst*>(dst));
   }
   void Launch(Stream* stream, size_t num_src0_dims, const int64_t* src0_dims, const void* src0,
               size_t num_src1_dims, const int64_t* src1_dims, const void* src1,
@@ -79,6 +78,12 @@ class BroadcastElementwiseBinaryImpl : public BroadcastElementwiseBinary {
                                        simplified_dst_dims);
     CheckInplace(num_dims, simplified_src0_dims, src0, simplified_src1_dims, src1,
                  simplified_dst_dims, dst);
+    if (simd_elementwise::TryLaunchBinary<binary_op, Src, Dst>(
+            num_dims, simplified_src0_dims, reinterpret_cast<const Src*>(src0),
+            simplified_src1_dims, reinterpret_cast<const Src*>(src1), simplified_dst_dims,
+            reinterpret_cast<Dst*>(dst))) {
+      return;
+    }
     for (int64_t i = 0; i < num_dims; ++i) {
       src0_dim_vec.push_back(simplified_src0_dims[i]);
       src1_dim_vec.push_back(simplified_src1_dims[i]);
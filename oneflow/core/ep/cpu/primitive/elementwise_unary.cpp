@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/ep/common/primitive/elementwise_unary.h"
 #include "oneflow/core/ep/cpu/primitive/unary_functor.h"
+#include "oneflow/core/ep/cpu/primitive/simd_elementwise.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
 
 namespace oneflow {
@@ -32,11 +33,8 @@ class ElementwiseUnaryImpl : public ElementwiseUnary {
   ~ElementwiseUnaryImpl() override = default;
 
   void Launch(Stream* stream, const void* src_ptr, void* dst_ptr, size_t count) override {
-    Dst* dst = reinterpret_cast<Dst*>(dst_ptr);
-    const Src* src = reinterpret_cast<const Src*>(src_ptr);
-    for (size_t i = 0; i < count; ++i) {
-      dst[i] = UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src>()(src[i]);
-    }
+    simd_elementwise::LaunchUnary<unary_op, Src, Dst>(
+        count, reinterpret_cast<const Src*>(src_ptr), reinterpret_cast<Dst*>(dst_ptr));
   }
 };
 
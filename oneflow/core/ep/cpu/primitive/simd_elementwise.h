@@ -0,0 +1,358 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_SIMD_ELEMENTWISE_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_SIMD_ELEMENTWISE_H_
+
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/cpu/primitive/binary_functor.h"
+#include "oneflow/core/ep/cpu/primitive/unary_functor.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace simd_elementwise {
+
+// Loops shorter than this stay on the calling thread.
+constexpr size_t kMinParallelElemCnt = 32768;
+
+// Calls DoRange(begin, end) on chunks of [0, n) of at least `grain` items on the global thread
+// pool.
+template<typename DoRangeT>
+void ParallelFor(size_t n, size_t grain, const DoRangeT& DoRange) {
+  MultiThreadRangeLoop(n, n / std::max<size_t>(grain, 1), DoRange);
+}
+
+#if OF_CPU_SIMD_DISPATCH
+
+// Explicit float vector instructions for the ops that map to a single instruction. Max and min
+// keep the `a > b ? a : b` semantics of the scalar functors, including for NaN.
+template<BinaryOp binary_op>
+struct FloatVecBinaryOp {
+  static constexpr bool kSupported = false;
+};
+
+#define DEFINE_FLOAT_VEC_BINARY_OP(binary_op, avx2_intrinsic, avx512_intrinsic)                 \
+  template<>                                                                                    \
+  struct FloatVecBinaryOp<binary_op> {                                                          \
+    static constexpr bool kSupported = true;                                                    \
+    OF_CPU_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return avx2_intrinsic(a, b); } \
+    OF_CPU_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) {                              \
+      return avx512_intrinsic(a, b);                                                            \
+    }                                                                                           \
+  };
+
+DEFINE_FLOAT_VEC_BINARY_OP(BinaryOp::kAdd, _mm256_add_ps, _mm512_add_ps)
+DEFINE_FLOAT_VEC_BINARY_OP(BinaryOp::kSub, _mm256_sub_ps, _mm512_sub_ps)
+DEFINE_FLOAT_VEC_BINARY_OP(BinaryOp::kMul, _mm256_mul_ps, _mm512_mul_ps)
+DEFINE_FLOAT_VEC_BINARY_OP(BinaryOp::kDiv, _mm256_div_ps, _mm512_div_ps)
+DEFINE_FLOAT_VEC_BINARY_OP(BinaryOp::kMax, _mm256_max_ps, _mm512_max_ps)
+DEFINE_FLOAT_VEC_BINARY_OP(BinaryOp::kMin, _mm256_min_ps, _mm512_min_ps)
+
+#undef DEFINE_FLOAT_VEC_BINARY_OP
+
+template<BinaryOp binary_op, bool src0_scalar, bool src1_scalar,
+         bool supported = FloatVecBinaryOp<binary_op>::kSupported>
+struct FloatVecBinaryLoop {
+  static bool Run(CpuIsa isa, size_t n, const float* src0, const float* src1, float* dst) {
+    return false;
+  }
+};
+
+template<BinaryOp binary_op, bool src0_scalar, bool src1_scalar>
+struct FloatVecBinaryLoop<binary_op, src0_scalar, src1_scalar, true> {
+  using Op = FloatVecBinaryOp<binary_op>;
+
+  OF_CPU_TARGET_AVX2 static void RunAvx2(size_t n, const float* src0, const float* src1,
+                                         float* dst) {
+    const __m256 src0_broadcast = _mm256_set1_ps(src0[0]);
+    const __m256 src1_broadcast = _mm256_set1_ps(src1[0]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      const __m256 a = src0_scalar ? src0_broadcast : _mm256_loadu_ps(src0 + i);
+      const __m256 b = src1_scalar ? src1_broadcast : _mm256_loadu_ps(src1 + i);
+      _mm256_storeu_ps(dst + i, Op::Apply(a, b));
+    }
+    broadcast_elementwise_binary::BinaryFunctor<DeviceType::kCPU, binary_op, float, float> functor;
+    for (; i < n; ++i) { dst[i] = functor(src0[src0_scalar ? 0 : i], src1[src1_scalar ? 0 : i]); }
+  }
+
+  OF_CPU_TARGET_AVX512 static void RunAvx512(size_t n, const float* src0, const float* src1,
+                                             float* dst) {
+    const __m512 src0_broadcast = _mm512_set1_ps(src0[0]);
+    const __m512 src1_broadcast = _mm512_set1_ps(src1[0]);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      const __m512 a = src0_scalar ? src0_broadcast : _mm512_loadu_ps(src0 + i);
+      const __m512 b = src1_scalar ? src1_broadcast : _mm512_loadu_ps(src1 + i);
+      _mm512_storeu_ps(dst + i, Op::Apply(a, b));
+    }
+    if (i < n) {
+      // Masked tail, no scalar epilogue.
+      const __mmask16 mask = static_cast<__mmask16>((1U << (n - i)) - 1);
+      const __m512 a = src0_scalar ? src0_broadcast : _mm512_maskz_loadu_ps(mask, src0 + i);
+      const __m512 b = src1_scalar ? src1_broadcast : _mm512_maskz_loadu_ps(mask, src1 + i);
+      _mm512_mask_storeu_ps(dst + i, mask, Op::Apply(a, b));
+    }
+  }
+
+  static bool Run(CpuIsa isa, size_t n, const float* src0, const float* src1, float* dst) {
+    if (n == 0) { return true; }
+    if (isa == CpuIsa::kAvx512) {
+      RunAvx512(n, src0, src1, dst);
+    } else if (isa == CpuIsa::kAvx2) {
+      RunAvx2(n, src0, src1, dst);
+    } else {
+      return false;
+    }
+    return true;
+  }
+};
+
+template<BinaryOp binary_op, bool src0_scalar, bool src1_scalar, typename Src, typename Dst>
+bool TryRunExplicitSimd(CpuIsa isa, size_t n, const Src* src0, const Src* src1, Dst* dst) {
+  return false;
+}
+
+template<BinaryOp binary_op, bool src0_scalar, bool src1_scalar>
+bool TryRunExplicitSimd(CpuIsa isa, size_t n, const float* src0, const float* src1, float* dst) {
+  return FloatVecBinaryLoop<binary_op, src0_scalar, src1_scalar>::Run(isa, n, src0, src1, dst);
+}
+
+template<UnaryOp unary_op, typename Src, typename Dst>
+struct UnaryExplicitSimd {
+  static bool Run(CpuIsa isa, size_t n, const Src* src, Dst* dst) { return false; }
+};
+
+OF_CPU_TARGET_AVX2 inline void FloatReluAvx2(size_t n, const float* src, float* dst) {
+  const __m256 zero = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_max_ps(_mm256_loadu_ps(src + i), zero));
+  }
+  for (; i < n; ++i) { dst[i] = src[i] > 0.0f ? src[i] : 0.0f; }
+}
+
+OF_CPU_TARGET_AVX512 inline void FloatReluAvx512(size_t n, const float* src, float* dst) {
+  const __m512 zero = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(dst + i, _mm512_max_ps(_mm512_loadu_ps(src + i), zero));
+  }
+  if (i < n) {
+    const __mmask16 mask = static_cast<__mmask16>((1U << (n - i)) - 1);
+    const __m512 x = _mm512_maskz_loadu_ps(mask, src + i);
+    _mm512_mask_storeu_ps(dst + i, mask, _mm512_max_ps(x, zero));
+  }
+}
+
+template<>
+struct UnaryExplicitSimd<UnaryOp::kRelu, float, float> {
+  static bool Run(CpuIsa isa, size_t n, const float* src, float* dst) {
+    if (isa == CpuIsa::kAvx512) {
+      FloatReluAvx512(n, src, dst);
+    } else if (isa == CpuIsa::kAvx2) {
+      FloatReluAvx2(n, src, dst);
+    } else {
+      return false;
+    }
+    return true;
+  }
+};
+
+#endif  // OF_CPU_SIMD_DISPATCH
+
+// dst[i] = f(src0[i], src1[i]), a scalar operand is read from its first element. Besides the
+// explicit float paths, the loop is compiled once per instruction set so that the compiler
+// vectorizes the remaining ops and types for the widest registers the machine has.
+template<BinaryOp binary_op, typename Src, typename Dst, bool src0_scalar, bool src1_scalar>
+struct BinaryLoop {
+  static void RunDefault(size_t n, const Src* src0, const Src* src1, Dst* dst) {
+    broadcast_elementwise_binary::BinaryFunctor<DeviceType::kCPU, binary_op, Src, Dst> functor;
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = functor(src0[src0_scalar ? 0 : i], src1[src1_scalar ? 0 : i]);
+    }
+  }
+
+#if OF_CPU_SIMD_DISPATCH
+  OF_CPU_TARGET_AVX2 static void RunAvx2(size_t n, const Src* src0, const Src* src1, Dst* dst) {
+    broadcast_elementwise_binary::BinaryFunctor<DeviceType::kCPU, binary_op, Src, Dst> functor;
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = functor(src0[src0_scalar ? 0 : i], src1[src1_scalar ? 0 : i]);
+    }
+  }
+
+  OF_CPU_TARGET_AVX512 static void RunAvx512(size_t n, const Src* src0, const Src* src1,
+                                             Dst* dst) {
+    broadcast_elementwise_binary::BinaryFunctor<DeviceType::kCPU, binary_op, Src, Dst> functor;
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = functor(src0[src0_scalar ? 0 : i], src1[src1_scalar ? 0 : i]);
+    }
+  }
+#endif  // OF_CPU_SIMD_DISPATCH
+
+  static void Run(size_t n, const Src* src0, const Src* src1, Dst* dst) {
+#if OF_CPU_SIMD_DISPATCH
+    const CpuIsa isa = GetCpuIsa();
+    if (TryRunExplicitSimd<binary_op, src0_scalar, src1_scalar>(isa, n, src0, src1, dst)) {
+      return;
+    }
+    if (isa == CpuIsa::kAvx512) {
+      RunAvx512(n, src0, src1, dst);
+    } else if (isa == CpuIsa::kAvx2) {
+      RunAvx2(n, src0, src1, dst);
+    } else {
+      RunDefault(n, src0, src1, dst);
+    }
+#else
+    RunDefault(n, src0, src1, dst);
+#endif  // OF_CPU_SIMD_DISPATCH
+  }
+};
+
+template<UnaryOp unary_op, typename Src, typename Dst>
+struct UnaryLoop {
+  static void RunDefault(size_t n, const Src* src, Dst* dst) {
+    UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src> functor;
+    for (size_t i = 0; i < n; ++i) { dst[i] = functor(src[i]); }
+  }
+
+#if OF_CPU_SIMD_DISPATCH
+  OF_CPU_TARGET_AVX2 static void RunAvx2(size_t n, const Src* src, Dst* dst) {
+    UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src> functor;
+    for (size_t i = 0; i < n; ++i) { dst[i] = functor(src[i]); }
+  }
+
+  OF_CPU_TARGET_AVX512 static void RunAvx512(size_t n, const Src* src, Dst* dst) {
+    UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src> functor;
+    for (size_t i = 0; i < n; ++i) { dst[i] = functor(src[i]); }
+  }
+#endif  // OF_CPU_SIMD_DISPATCH
+
+  static void Run(size_t n, const Src* src, Dst* dst) {
+#if OF_CPU_SIMD_DISPATCH
+    const CpuIsa isa = GetCpuIsa();
+    if (UnaryExplicitSimd<unary_op, Src, Dst>::Run(isa, n, src, dst)) { return; }
+    if (isa == CpuIsa::kAvx512) {
+      RunAvx512(n, src, dst);
+    } else if (isa == CpuIsa::kAvx2) {
+      RunAvx2(n, src, dst);
+    } else {
+      RunDefault(n, src, dst);
+    }
+#else
+    RunDefault(n, src, dst);
+#endif  // OF_CPU_SIMD_DISPATCH
+  }
+};
+
+template<UnaryOp unary_op, typename Src, typename Dst>
+void LaunchUnary(size_t count, const Src* src, Dst* dst) {
+  ParallelFor(count, kMinParallelElemCnt, [&](size_t begin, size_t end) {
+    UnaryLoop<unary_op, Src, Dst>::Run(end - begin, src + begin, dst + begin);
+  });
+}
+
+// 1-d case: every operand either has `count` elements or is a scalar.
+template<BinaryOp binary_op, typename Src, typename Dst, bool src0_scalar, bool src1_scalar>
+void LaunchBinary1D(size_t count, const Src* src0, const Src* src1, Dst* dst) {
+  ParallelFor(count, kMinParallelElemCnt, [&](size_t begin, size_t end) {
+    BinaryLoop<binary_op, Src, Dst, src0_scalar, src1_scalar>::Run(
+        end - begin, src0_scalar ? src0 : src0 + begin, src1_scalar ? src1 : src1 + begin,
+        dst + begin);
+  });
+}
+
+// 2-d case on a [rows, cols] output: an operand of shape [1, cols] is broadcast along rows
+// (row broadcast), one of shape [rows, 1] along cols (column broadcast).
+template<BinaryOp binary_op, typename Src, typename Dst, bool src0_scalar, bool src1_scalar>
+void LaunchBinary2D(size_t rows, size_t cols, const Src* src0, size_t src0_row_stride,
+                    const Src* src1, size_t src1_row_stride, Dst* dst) {
+  using Loop = BinaryLoop<binary_op, Src, Dst, src0_scalar, src1_scalar>;
+  if (cols >= kMinParallelElemCnt) {
+    FOR_RANGE(size_t, row, 0, rows) {
+      const Src* src0_row = src0 + row * src0_row_stride;
+      const Src* src1_row = src1 + row * src1_row_stride;
+      Dst* dst_row = dst + row * cols;
+      ParallelFor(cols, kMinParallelElemCnt, [&](size_t begin, size_t end) {
+        Loop::Run(end - begin, src0_scalar ? src0_row : src0_row + begin,
+                  src1_scalar ? src1_row : src1_row + begin, dst_row + begin);
+      });
+    }
+  } else {
+    const size_t grain = (kMinParallelElemCnt + cols - 1) / cols;
+    ParallelFor(rows, grain, [&](size_t begin, size_t end) {
+      FOR_RANGE(size_t, row, begin, end) {
+        Loop::Run(cols, src0 + row * src0_row_stride, src1 + row * src1_row_stride,
+                  dst + row * cols);
+      }
+    });
+  }
+}
+
+// Returns false if the simplified broadcast pattern has no fast path, the caller should then use
+// the generic ndarray implementation.
+template<BinaryOp binary_op, typename Src, typename Dst>
+bool TryLaunchBinary(size_t num_dims, const int64_t* src0_dims, const Src* src0,
+                     const int64_t* src1_dims, const Src* src1, const int64_t* dst_dims,
+                     Dst* dst) {
+  if (num_dims == 1) {
+    const size_t count = dst_dims[0];
+    const bool src0_scalar = src0_dims[0] == 1 && count != 1;
+    const bool src1_scalar = src1_dims[0] == 1 && count != 1;
+    if (src0_scalar) {
+      LaunchBinary1D<binary_op, Src, Dst, true, false>(count, src0, src1, dst);
+    } else if (src1_scalar) {
+      LaunchBinary1D<binary_op, Src, Dst, false, true>(count, src0, src1, dst);
+    } else {
+      LaunchBinary1D<binary_op, Src, Dst, false, false>(count, src0, src1, dst);
+    }
+    return true;
+  } else if (num_dims == 2) {
+    const size_t rows = dst_dims[0];
+    const size_t cols = dst_dims[1];
+    const size_t src0_row_stride = src0_dims[0] == 1 ? 0 : src0_dims[1];
+    const size_t src1_row_stride = src1_dims[0] == 1 ? 0 : src1_dims[1];
+    const bool src0_scalar = src0_dims[1] == 1;
+    const bool src1_scalar = src1_dims[1] == 1;
+    if (src0_scalar && !src1_scalar) {
+      LaunchBinary2D<binary_op, Src, Dst, true, false>(rows, cols, src0, src0_row_stride, src1,
+                                                       src1_row_stride, dst);
+    } else if (!src0_scalar && src1_scalar) {
+      LaunchBinary2D<binary_op, Src, Dst, false, true>(rows, cols, src0, src0_row_stride, src1,
+                                                       src1_row_stride, dst);
+    } else if (!src0_scalar && !src1_scalar) {
+      LaunchBinary2D<binary_op, Src, Dst, false, false>(rows, cols, src0, src0_row_stride, src1,
+                                                        src1_row_stride, dst);
+    } else {
+      return false;
+    }
+    return true;
+  } else {
+    return false;
+  }
+}
+
+}  // namespace simd_elementwise
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_SIMD_ELEMENTWISE_H_
@@ -0,0 +1,87 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <random>
+#include <gtest/gtest.h>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/core/ep/common/primitive/util.h"
+#include "oneflow/core/ep/cpu/primitive/simd_elementwise.h"
+#include "oneflow/core/ndarray/ndarray_util.h"
+#include "oneflow/core/ndarray/xpu_var_ndarray.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+using test::ElapsedMs;
+using test::HardwareThreadNum;
+using test::ThreadPoolGuard;
+
+namespace {
+
+std::vector<float> RandomData(size_t count) {
+  std::mt19937 gen(count);
+  std::uniform_real_distribution<float> dis(-100, 100);
+  std::vector<float> data(count);
+  for (float& val : data) { val = dis(gen); }
+  return data;
+}
+
+}  // namespace
+
+// Logs the time of the fast paths against the ndarray implementation they replace.
+TEST(SimdElementwiseBenchmark, binary_add) {
+  ThreadPoolGuard guard(HardwareThreadNum());
+  const int64_t rows = 1024;
+  const int64_t cols = 4096;
+  const std::vector<float> src0 = RandomData(rows * cols);
+  const std::vector<float> src1 = RandomData(rows * cols);
+  std::vector<float> dst(rows * cols);
+  const std::vector<std::pair<std::string, std::vector<int64_t>>> cases = {
+      {"same shape", {rows, cols}}, {"scalar", {1, 1}}, {"row", {1, cols}}, {"column", {rows, 1}}};
+  for (const auto& c : cases) {
+    const int64_t src0_dims[2] = {rows, cols};
+    const int64_t* src1_dims = c.second.data();
+    const double simd_ms = ElapsedMs(
+        [&]() {
+          size_t num_dims = 0;
+          int64_t simplified_src0_dims[2];
+          int64_t simplified_src1_dims[2];
+          int64_t simplified_dst_dims[2];
+          SimplifyBroadcastDims<2>(2, src0_dims, 2, src1_dims, &num_dims, simplified_src0_dims,
+                                   simplified_src1_dims, simplified_dst_dims);
+          CHECK((simd_elementwise::TryLaunchBinary<BinaryOp::kAdd, float, float>(
+              num_dims, simplified_src0_dims, src0.data(), simplified_src1_dims, src1.data(),
+              simplified_dst_dims, dst.data())));
+        },
+        10);
+    const double ndarray_ms = ElapsedMs(
+        [&]() {
+          NdarrayUtil<DeviceType::kCPU, float>::BroadcastAdd(
+              nullptr, XpuVarNdarray<float>(Shape({rows, cols}), dst.data(), 2),
+              XpuVarNdarray<const float>(Shape({rows, cols}), src0.data(), 2),
+              XpuVarNdarray<const float>(Shape({src1_dims[0], src1_dims[1]}), src1.data(), 2));
+        },
+        10);
+    LOG(INFO) << "add [" << rows << ", " << cols << "] " << c.first << ": simd " << simd_ms
+              << "ms, ndarray " << ndarray_ms << "ms";
+  }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
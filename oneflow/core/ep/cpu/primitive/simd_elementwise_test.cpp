@@ -0,0 +1,114 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/core/ep/common/primitive/util.h"
+#include "oneflow/core/ep/cpu/primitive/simd_elementwise.h"
+#include "oneflow/core/ndarray/ndarray_util.h"
+#include "oneflow/core/ndarray/xpu_var_ndarray.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+using test::ThreadPoolGuard;
+
+namespace {
+
+template<typename T>
+std::vector<T> RandomData(size_t count) {
+  std::mt19937 gen(count);
+  std::uniform_int_distribution<int> dis(-100, 100);
+  std::vector<T> data(count);
+  for (T& val : data) { val = static_cast<T>(dis(gen)); }
+  return data;
+}
+
+template<BinaryOp binary_op, typename Src, typename Dst>
+void TestBinary2D(int64_t rows, int64_t cols, bool src0_row_broadcast, bool src0_col_broadcast,
+                  bool src1_row_broadcast, bool src1_col_broadcast) {
+  const int64_t src0_dims[2] = {src0_row_broadcast ? 1 : rows, src0_col_broadcast ? 1 : cols};
+  const int64_t src1_dims[2] = {src1_row_broadcast ? 1 : rows, src1_col_broadcast ? 1 : cols};
+  const int64_t dst_dims[2] = {rows, cols};
+  const std::vector<Src> src0 = RandomData<Src>(src0_dims[0] * src0_dims[1]);
+  std::vector<Src> src1 = RandomData<Src>(src1_dims[0] * src1_dims[1] + 1);
+  for (Src& val : src1) {
+    if (val == static_cast<Src>(0)) { val = static_cast<Src>(1); }
+  }
+  std::vector<Dst> dst(rows * cols);
+  ASSERT_TRUE((simd_elementwise::TryLaunchBinary<binary_op, Src, Dst>(
+      2, src0_dims, src0.data(), src1_dims, src1.data(), dst_dims, dst.data())));
+  broadcast_elementwise_binary::BinaryFunctor<DeviceType::kCPU, binary_op, Src, Dst> functor;
+  FOR_RANGE(int64_t, i, 0, rows) {
+    FOR_RANGE(int64_t, j, 0, cols) {
+      const int64_t src0_offset =
+          (src0_row_broadcast ? 0 : i) * src0_dims[1] + (src0_col_broadcast ? 0 : j);
+      const int64_t src1_offset =
+          (src1_row_broadcast ? 0 : i) * src1_dims[1] + (src1_col_broadcast ? 0 : j);
+      const Src a = src0[src0_offset];
+      const Src b = src1[src1_offset];
+      ASSERT_EQ(dst[i * cols + j], functor(a, b));
+    }
+  }
+}
+
+template<BinaryOp binary_op, typename Src, typename Dst>
+void TestBinaryAllPatterns(int64_t rows, int64_t cols) {
+  // Same shape.
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, false, false, false, false);
+  // Scalar operand.
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, false, false, true, true);
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, true, true, false, false);
+  // Row broadcast.
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, false, false, true, false);
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, true, false, false, false);
+  // Column broadcast.
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, false, false, false, true);
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, false, true, false, false);
+  // Outer.
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, true, false, false, true);
+  TestBinary2D<binary_op, Src, Dst>(rows, cols, false, true, true, false);
+}
+
+}  // namespace
+
+TEST(SimdElementwise, binary) {
+  ThreadPoolGuard guard(4);
+  for (const auto& shape : std::vector<std::pair<int64_t, int64_t>>{{3, 37}, {129, 1000}}) {
+    TestBinaryAllPatterns<BinaryOp::kAdd, float, float>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kSub, float, float>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kDiv, float, float>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kMax, float, float>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kMul, double, double>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kMin, int32_t, int32_t>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kAdd, int64_t, int64_t>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kLessThan, float, int8_t>(shape.first, shape.second);
+    TestBinaryAllPatterns<BinaryOp::kEqual, int8_t, int8_t>(shape.first, shape.second);
+  }
+}
+
+TEST(SimdElementwise, relu) {
+  const std::vector<float> src = RandomData<float>(1001);
+  std::vector<float> dst(src.size());
+  simd_elementwise::LaunchUnary<UnaryOp::kRelu, float, float>(src.size(), src.data(), dst.data());
+  FOR_RANGE(size_t, i, 0, src.size()) { ASSERT_EQ(dst[i], src[i] > 0 ? src[i] : 0); }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -13,6 +13,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_UNARY_FUNCTOR_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_UNARY_FUNCTOR_H_
+
 #include "oneflow/core/ep/common/primitive/unary_functor.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
 #include <cmath>
@@ -37,3 +40,5 @@ struct UnaryFunctor<DeviceType::kCPU, UnaryOp::kTanh, Dst, Src> {
 }  // namespace primitive
 }  // namespace ep
 }  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_UNARY_FUNCTOR_H_
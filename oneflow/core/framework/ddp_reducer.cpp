@@ -0,0 +1,143 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/ddp_reducer.h"
+#include <algorithm>
+#include "oneflow/core/autograd/autograd_engine.h"
+#include "oneflow/core/autograd/autograd_meta.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/framework/device.h"
+#include "oneflow/core/framework/tensor.h"
+#include "oneflow/core/framework/tensor_tuple.h"
+#include "oneflow/core/functional/functional.h"
+
+namespace oneflow {
+namespace one {
+
+DDPReducer::DDPReducer(const std::vector<std::shared_ptr<Tensor>>& params)
+    : params_(params.cbegin(), params.cend()),
+      param_index2bucket_(params.size()),
+      param_ready_(params.size(), false),
+      next_bucket_(0) {}
+
+/* static */ Maybe<DDPReducer> DDPReducer::New(const std::vector<std::shared_ptr<Tensor>>& params,
+                                               int64_t bucket_cap_bytes) {
+  CHECK_GT_OR_RETURN(bucket_cap_bytes, 0);
+  std::shared_ptr<DDPReducer> reducer(new DDPReducer(params));
+  // A bucket only holds gradients of the same data type on the same device, as they are
+  // concatenated into one tensor.
+  Symbol<DType> bucket_dtype;
+  Symbol<Device> bucket_device;
+  int64_t bucket_bytes = 0;
+  FOR_RANGE(size_t, i, 0, params.size()) {
+    const auto& param = params.at(i);
+    CHECK_OR_RETURN(param->is_local()) << "DDPReducer only supports local tensors";
+    CHECK_OR_RETURN(param->requires_grad()) << "DDPReducer only supports tensors requiring grad";
+    const Symbol<DType> dtype = param->dtype();
+    const Symbol<Device> device = JUST(param->device());
+    const int64_t bytes = param->shape()->elem_cnt() * GetSizeOfDataType(dtype->data_type());
+    if (reducer->buckets_.empty() || dtype != bucket_dtype || device != bucket_device
+        || bucket_bytes + bytes > bucket_cap_bytes) {
+      reducer->buckets_.emplace_back(Bucket{{}, 0});
+      bucket_dtype = dtype;
+      bucket_device = device;
+      bucket_bytes = 0;
+    }
+    reducer->buckets_.back().param_indices.emplace_back(i);
+    reducer->param_index2bucket_.at(i) = reducer->buckets_.size() - 1;
+    bucket_bytes += bytes;
+  }
+  reducer->Reset();
+  JUST(reducer->RegisterHooks());
+  return reducer;
+}
+
+void DDPReducer::Reset() {
+  for (Bucket& bucket : buckets_) { bucket.num_pending = bucket.param_indices.size(); }
+  std::fill(param_ready_.begin(), param_ready_.end(), false);
+  next_bucket_ = 0;
+}
+
+Maybe<void> DDPReducer::RegisterHooks() {
+  const std::weak_ptr<DDPReducer> weak_reducer = shared_from_this();
+  FOR_RANGE(size_t, i, 0, params_.size()) {
+    const auto param = params_.at(i).lock();
+    CHECK_NOTNULL_OR_RETURN(param);
+    // The leaf tensor needs an accumulate node to have its gradient accumulated in backward.
+    if (!param->grad_fn_node()) { JUST(AddAccumulateFunctionNode(param)); }
+    param->mut_autograd_meta()->add_post_acc_grad_hook([weak_reducer, i]() -> Maybe<void> {
+      const auto reducer = weak_reducer.lock();
+      if (reducer) { JUST(reducer->MarkParamReady(i)); }
+      return Maybe<void>::Ok();
+    });
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> DDPReducer::MarkParamReady(size_t param_index) {
+  CHECK_OR_RETURN(!param_ready_.at(param_index))
+      << "the gradient of a data parallel parameter is accumulated twice, run forward before "
+         "every backward";
+  param_ready_.at(param_index) = true;
+  Bucket& bucket = buckets_.at(param_index2bucket_.at(param_index));
+  CHECK_GT_OR_RETURN(bucket.num_pending, 0);
+  bucket.num_pending -= 1;
+  // Buckets may get ready out of order, but they have to be all-reduced in the same order on all
+  // ranks.
+  while (next_bucket_ < buckets_.size() && buckets_.at(next_bucket_).num_pending == 0) {
+    JUST(ReduceBucket(buckets_.at(next_bucket_)));
+    next_bucket_ += 1;
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> DDPReducer::ReduceBucket(const Bucket& bucket) {
+  const int64_t world_size = GlobalProcessCtx::WorldSize();
+  std::vector<std::shared_ptr<Tensor>> params;
+  TensorTuple flat_grads;
+  std::vector<int64_t> split_sizes;
+  for (size_t param_index : bucket.param_indices) {
+    const auto param = params_.at(param_index).lock();
+    CHECK_NOTNULL_OR_RETURN(param);
+    const auto& grad = JUST(param->acc_grad());
+    CHECK_NOTNULL_OR_RETURN(grad);
+    flat_grads.emplace_back(JUST(functional::Reshape(grad, Shape({grad->shape()->elem_cnt()}))));
+    split_sizes.emplace_back(grad->shape()->elem_cnt());
+    params.emplace_back(param);
+  }
+  std::shared_ptr<Tensor> flat_grad;
+  if (flat_grads.size() == 1) {
+    flat_grad = flat_grads.at(0);
+  } else {
+    flat_grad = JUST(functional::Concat(flat_grads, 0));
+  }
+  flat_grad = JUST(functional::ScalarDiv(flat_grad, Scalar(world_size)));
+  flat_grad = JUST(functional::LocalAllReduce(flat_grad));
+  if (params.size() == 1) {
+    const auto& param = params.at(0);
+    JUST(param->set_acc_grad(JUST(functional::Reshape(flat_grad, *param->shape()))));
+  } else {
+    const auto& grads = JUST(functional::SplitWithSize(flat_grad, split_sizes, 0));
+    CHECK_EQ_OR_RETURN(grads->size(), params.size());
+    FOR_RANGE(size_t, i, 0, params.size()) {
+      const auto& param = params.at(i);
+      JUST(param->set_acc_grad(JUST(functional::Reshape(grads->at(i), *param->shape()))));
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace one
+}  // namespace oneflow
@@ -0,0 +1,72 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_FRAMEWORK_DDP_REDUCER_H_
+#define ONEFLOW_CORE_FRAMEWORK_DDP_REDUCER_H_
+
+#include <memory>
+#include <vector>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+
+namespace oneflow {
+namespace one {
+
+class Tensor;
+
+// Averages the gradients of data parallel parameters over all ranks during backward. The
+// parameters, expected in the reverse of the order they are used in forward, are packed into
+// buckets of at most bucket_cap_bytes. A bucket is flattened and all-reduced as soon as the
+// gradients of all its parameters have been accumulated, so that the all-reduce of a bucket runs
+// on the device while backward goes on for the rest. Buckets are launched in the same order on
+// every rank.
+class DDPReducer final : public std::enable_shared_from_this<DDPReducer> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(DDPReducer);
+  ~DDPReducer() = default;
+
+  static Maybe<DDPReducer> New(const std::vector<std::shared_ptr<Tensor>>& params,
+                               int64_t bucket_cap_bytes);
+
+  // Called before every backward, as the ready flags are only reset here.
+  void Reset();
+
+  size_t num_buckets() const { return buckets_.size(); }
+  const std::vector<size_t>& bucket_param_indices(size_t bucket) const {
+    return buckets_.at(bucket).param_indices;
+  }
+
+ private:
+  struct Bucket {
+    std::vector<size_t> param_indices;
+    size_t num_pending;
+  };
+
+  explicit DDPReducer(const std::vector<std::shared_ptr<Tensor>>& params);
+  Maybe<void> RegisterHooks();
+  Maybe<void> MarkParamReady(size_t param_index);
+  Maybe<void> ReduceBucket(const Bucket& bucket);
+
+  std::vector<std::weak_ptr<Tensor>> params_;
+  std::vector<Bucket> buckets_;
+  std::vector<size_t> param_index2bucket_;
+  std::vector<bool> param_ready_;
+  size_t next_bucket_;
+};
+
+}  // namespace one
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_FRAMEWORK_DDP_REDUCER_H_
@@ -39,6 +39,7 @@ limitations under the License.
 #include "oneflow/core/vm/consume_local_dep_object_phy_instr_operand.h"
 #include "oneflow/core/vm/release_tensor_arg_phy_instr_operand.h"
 #include "oneflow/core/vm/virtual_machine.h"
+#include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/framework/consistent_tensor_infer_cache.h"
 #include "oneflow/core/eager/local_dep_object.h"
 #include "oneflow/core/framework/tensor.h"
@@ -179,6 +180,29 @@ Maybe<compatible_py::BlobObject> CreateDelegateBlobObject(
   return Fetch(x_blob_object, op_arg_parallel_attr);
 }
 
+// Picks the stream of `op_device` to run an instruction on. Instructions follow the producer of
+// their first input to keep dependent chains on one stream, and independent ones are spread over
+// the streams round-robin.
+Maybe<int64_t> NewVmStreamIndex(const vm::LocalCallOpKernelPhyInstrOperand& operand,
+                                Symbol<Device> op_device) {
+  const int64_t vm_stream_num = operand.opkernel().vm_stream_num();
+  if (vm_stream_num == 1) { return 0; }
+  // Kernels with states passed in, e.g. random ones sharing the generator of the device, kernels
+  // which may create states of their own, e.g. readers or seeded ones, and ops without inputs stay
+  // on the first stream of the device, so that a state is used by one stream in order.
+  const auto& inputs = *operand.inputs();
+  if (operand.op_interp_ctx().state || !operand.user_opkernel_stateless() || inputs.empty()) {
+    return 0;
+  }
+  const auto& first_input = inputs.at(0);
+  const int64_t producer_vm_stream_index = first_input->producer_vm_stream_index();
+  if (producer_vm_stream_index >= 0 && JUST(first_input->last_used_device()) == op_device) {
+    return producer_vm_stream_index % vm_stream_num;
+  }
+  static std::atomic<int64_t> counter(0);
+  return counter.fetch_add(1, std::memory_order_relaxed) % vm_stream_num;
+}
+
 }  // namespace
 
 namespace detail {
@@ -259,7 +283,7 @@ static constexpr auto* GetCriticalSectionDevice =
 template<typename PhyInstrOperandT>
 Maybe<void> InstructionsBuilder::MakeCriticalSectionBegin(
     const std::shared_ptr<PhyInstrOperandT>& phy_instr_operand) {
-  auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+  auto instruction = vm::NewInstructionMsg(
       Global<VirtualMachine>::Get()->mut_vm(), "CriticalSectionBegin",
       std::shared_ptr<const ParallelDesc>(), phy_instr_operand);
   instruction_list_->EmplaceBack(std::move(instruction));
@@ -269,7 +293,7 @@ Maybe<void> InstructionsBuilder::MakeCriticalSectionBegin(
 template<typename PhyInstrOperandT>
 Maybe<void> InstructionsBuilder::MakeCriticalSectionEnd(
     const std::shared_ptr<PhyInstrOperandT>& phy_instr_operand) {
-  auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+  auto instruction = vm::NewInstructionMsg(
       Global<VirtualMachine>::Get()->mut_vm(), "CriticalSectionEnd",
       std::shared_ptr<const ParallelDesc>(), phy_instr_operand);
   instruction_list_->EmplaceBack(std::move(instruction));
@@ -355,7 +379,7 @@ Maybe<void> InstructionsBuilder::LaunchLazyJob(const one::EagerBlobObjectListPtr
     {
       const auto& phy_instr_operand =
           std::make_shared<vm::LaunchLazyJobPhyInstrOperand>(nn_graph, parameters);
-      auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+      auto instruction = vm::NewInstructionMsg(
           Global<VirtualMachine>::Get()->mut_vm(), "LaunchLazyJob",
           std::shared_ptr<const ParallelDesc>(), phy_instr_operand);
       instruction_list_->EmplaceBack(std::move(instruction));
@@ -830,6 +854,11 @@ Maybe<void> InstructionsBuilder::LocalCallOpKernel(
     const std::shared_ptr<const one::ConsistentTensorInferResult>& consistent_tensor_infer_result,
     const one::OpExprInterpContext& ctx, Symbol<Device> op_device) {
   const auto& parallel_desc_sym = JUST(Placement4Device(op_device)).shared_from_symbol();
+  auto phy_instr_operand = JUST(vm::LocalCallOpKernelPhyInstrOperand::New(
+      opkernel, input_eager_blob_objects, output_eager_blob_objects, consistent_tensor_infer_result,
+      ctx, *one::CurrentDevVmDepObjectConsumeMode()));
+  const int64_t vm_stream_index = JUST(NewVmStreamIndex(*phy_instr_operand, op_device));
+  phy_instr_operand->set_vm_stream_index(vm_stream_index);
   for (const auto& input : *input_eager_blob_objects) {
     const auto& blob_last_used_device = JUST(input->last_used_device());
     if (blob_last_used_device != op_device) {
@@ -838,18 +867,19 @@ Maybe<void> InstructionsBuilder::LocalCallOpKernel(
     }
     input->set_last_used_device(op_device);
   }
-  auto phy_instr_operand = JUST(vm::LocalCallOpKernelPhyInstrOperand::New(
-      opkernel, input_eager_blob_objects, output_eager_blob_objects, consistent_tensor_infer_result,
-      ctx, *one::CurrentDevVmDepObjectConsumeMode()));
-  auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+  auto instruction = vm::NewInstructionMsg(
       Global<VirtualMachine>::Get()->mut_vm(), JUST(op_device->local_call_instruction_name()),
-      parallel_desc_sym, phy_instr_operand);
+      parallel_desc_sym, phy_instr_operand, vm_stream_index);
   instruction_list_->EmplaceBack(std::move(instruction));
+  // Kernels on the other devices, e.g. nccl and comm_net ones, communicate with other ranks, which
+  // may wait for them while this rank waits for something else.
+  if (Device::type_supported.count(op_device->type()) > 0) { ++bufferable_instruction_cnt_; }
   for (const auto& output : *output_eager_blob_objects) {
     if (!output->producer_op_device().has_value()) {
       JUST(output->init_producer_op_device(op_device));
     }
     output->set_last_used_device(op_device);
+    output->set_producer_vm_stream_index(vm_stream_index);
   }
   return Maybe<void>::Ok();
 }
@@ -1077,10 +1107,11 @@ Maybe<void> InstructionsBuilder::ReleaseTensor(
   LocalDepObject* compute_local_dep_object = JUST(eager_blob_object->compute_local_dep_object());
   const auto& phy_instr_operand = std::make_shared<vm::ReleaseTensorArgPhyInstrOperand>(
       eager_blob_object, compute_local_dep_object);
-  auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+  auto instruction = vm::NewInstructionMsg(
       Global<VirtualMachine>::Get()->mut_vm(), parallel_desc->device_tag() + ".ReleaseTensor",
       parallel_desc, phy_instr_operand);
   instruction_list_->EmplaceBack(std::move(instruction));
+  ++bufferable_instruction_cnt_;
   return Maybe<void>::Ok();
 }
 
@@ -1093,17 +1124,19 @@ Maybe<void> InstructionsBuilder::SoftSyncStream(LocalDepObject* compute_local_de
   {
     const auto& phy_instr_operand = std::make_shared<vm::ConsumeLocalDepObjectPhyInstrOperand>(
         compute_local_dep_object, modifier);
-    auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+    auto instruction = vm::NewInstructionMsg(
         Global<VirtualMachine>::Get()->mut_vm(), parallel_desc->device_tag() + ".RecordEvent",
         parallel_desc, phy_instr_operand);
     instruction_list_->EmplaceBack(std::move(instruction));
+    ++bufferable_instruction_cnt_;
   }
   {
     const auto& phy_instr_operand = std::make_shared<vm::ConsumeLocalDepObjectPhyInstrOperand>(
         compute_local_dep_object, modifier);
-    auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+    auto instruction = vm::NewInstructionMsg(
         Global<VirtualMachine>::Get()->mut_vm(), "Touch", parallel_desc, phy_instr_operand);
     instruction_list_->EmplaceBack(std::move(instruction));
+    ++bufferable_instruction_cnt_;
   }
   OF_PROFILER_RANGE_POP();
   return Maybe<void>::Ok();
@@ -1146,7 +1179,7 @@ Maybe<void> InstructionsBuilder::TensorView(const T input_tensor, const T view_t
   const auto& phy_instr_operand = std::make_shared<vm::TensorViewOperand>(
       eager_blob_object, view_eager_blob_object, local_dep_object);
   // prepare instruction
-  auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+  auto instruction = vm::NewInstructionMsg(
       Global<VirtualMachine>::Get()->mut_vm(), parallel_desc->device_tag() + ".TensorView",
       parallel_desc, phy_instr_operand);
   // assign the data pointer to output view blob
@@ -1191,7 +1224,7 @@ Maybe<void> InstructionsBuilder::AccessBlobByCallback(const T tensor,
   LocalDepObject* compute_local_dep_object = JUST(tensor->compute_local_dep_object());
   const auto& phy_instr_operand = std::make_shared<vm::AccessBlobArgCbPhyInstrOperand>(
       eager_blob_object, compute_local_dep_object, callback, modifier);
-  auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+  auto instruction = vm::NewInstructionMsg(
       Global<VirtualMachine>::Get()->mut_vm(),
       parallel_desc->device_tag() + ".AccessBlobByCallback", parallel_desc, phy_instr_operand);
   instruction_list_->EmplaceBack(std::move(instruction));
@@ -1209,7 +1242,7 @@ template Maybe<void> InstructionsBuilder::AccessBlobByCallback(
 Maybe<void> InstructionsBuilder::ComputeRankFrontSeqCallback(
     const std::function<void()>& callback) {
   const auto& phy_instr_operand = std::make_shared<vm::NoArgCbPhyInstrOperand>(callback);
-  auto instruction = intrusive::make_shared<vm::InstructionMsg>(
+  auto instruction = vm::NewInstructionMsg(
       Global<VirtualMachine>::Get()->mut_vm(), "ComputeRankFrontSeqCallback",
       std::shared_ptr<const ParallelDesc>(), phy_instr_operand);
   instruction->add_int64_operand(GlobalProcessCtx::Rank());
@@ -1864,6 +1897,9 @@ Maybe<void> PhysicalRun(const std::function<Maybe<void>(InstructionsBuilder*)>&
       debug::RecordInstruction(instruction_msg);
     }
   }
+  if (instructions_builder.bufferable()) {
+    return vm::BufferedRun(instructions_builder.mut_instruction_list());
+  }
   JUST(Global<vm::EagerOneflow>::Get()->RunPhysicalInstruction(
       instructions_builder.mut_instruction_list(), instructions_builder.eager_symbol_list()));
   return Maybe<void>::Ok();
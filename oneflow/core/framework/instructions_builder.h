@@ -75,7 +75,8 @@ class InstructionsBuilder : public std::enable_shared_from_this<InstructionsBuil
       : id_generator_(id_generator),
         instruction_list_(instruction_list),
         eager_symbol_list_(eager_symbol_list),
-        release_object_([](compatible_py::Object*) {}) {}
+        release_object_([](compatible_py::Object*) {}),
+        bufferable_instruction_cnt_(0) {}
   InstructionsBuilder(const std::shared_ptr<vm::IdGenerator>& id_generator,
                       vm::InstructionMsgList* instruction_list,
                       vm::cfg::EagerSymbolList* eager_symbol_list,
@@ -83,7 +84,8 @@ class InstructionsBuilder : public std::enable_shared_from_this<InstructionsBuil
       : id_generator_(id_generator),
         instruction_list_(instruction_list),
         eager_symbol_list_(eager_symbol_list),
-        release_object_(release_object) {}
+        release_object_(release_object),
+        bufferable_instruction_cnt_(0) {}
   ~InstructionsBuilder() {
     instruction_list_->Clear();
     eager_symbol_list_->clear_eager_symbol();
@@ -99,6 +101,12 @@ class InstructionsBuilder : public std::enable_shared_from_this<InstructionsBuil
 
   vm::InstructionMsgList* mut_instruction_list() { return instruction_list_; }
 
+  // Whether all instructions built are ones nobody waits for, see VirtualMachine::BufferedReceive.
+  bool bufferable() const {
+    return bufferable_instruction_cnt_ == instruction_list_->size()
+           && eager_symbol_list_->eager_symbol_size() == 0;
+  }
+
   // Build VM execution instructions with NNGraph's inputs/outputs/parameters for NNGraph execution.
   Maybe<void> LaunchLazyJob(const one::EagerBlobObjectListPtr& inputs,
                             const one::EagerBlobObjectListPtr& outputs,
@@ -478,6 +486,7 @@ class InstructionsBuilder : public std::enable_shared_from_this<InstructionsBuil
   vm::InstructionMsgList* instruction_list_;
   vm::cfg::EagerSymbolList* eager_symbol_list_;
   std::function<void(compatible_py::Object*)> release_object_;
+  size_t bufferable_instruction_cnt_;
 };
 
 // Make VM instructions with instruction builder and run instructions with logical/consistent view.
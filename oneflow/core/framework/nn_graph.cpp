@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/nn_graph.h"
 #include "oneflow/core/common/buffer_manager.h"
 #include "oneflow/core/common/scalar.h"
+#include "oneflow/core/control/broadcast_kv.h"
 #include "oneflow/core/control/ctrl_client.h"
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/eager/eager_blob_object.h"
@@ -265,16 +266,12 @@ Maybe<void> NNGraph::CompileAndInitRuntime() {
   }
   if (GlobalProcessCtx::WorldSize() > 1) {
     std::string plan_name = "plan:" + job_name();
-    if (GlobalProcessCtx::IsThisProcessMaster()) {
-      // TODO(chengcheng): split plan for each rank.
-      Global<CtrlClient>::Get()->PushKV(plan_name, plan_);
-    } else {
-      Global<CtrlClient>::Get()->PullKV(plan_name, &plan_);
-    }
+    // TODO(chengcheng): split plan for each rank.
+    BroadcastKV(plan_name, 0, &plan_);
     OF_SESSION_BARRIER();
     // NOTE(zwx): After barrier plan is synchronized between all ranks,
     //     then it can be cleared for saving mem.
-    if (GlobalProcessCtx::IsThisProcessMaster()) { Global<CtrlClient>::Get()->ClearKV(plan_name); }
+    ClearBroadcastKV(plan_name);
   }
   // NOTE(chengcheng): recovery op_attr
   PlanUtil::PopulateOpAttribute(&plan_, plan_.job_id2op_attribute_ref_table());
@@ -26,6 +26,7 @@ limitations under the License.
 #include "oneflow/core/framework/tensor.h"
 #include "oneflow/core/framework/tensor_name_scope.h"
 #include "oneflow/core/framework/tensor_tuple.h"
+#include "oneflow/core/framework/tensor_methods.h"
 #include "oneflow/core/framework/stride.h"
 #include "oneflow/core/eager/foreign_boxing_util.h"
 #include "oneflow/core/memory/memory_case_util.h"
@@ -80,6 +81,12 @@ std::vector<TensorMeta*>* ThreadLocalDefaultOutputMutTensorMetas(int64_t size) {
   return &ptr_vec;
 }
 
+Maybe<UserOpExpr> ToStridedOpExpr() {
+  return OpBuilder("to_strided", *JUST(UniqueStr("to_strided"))).Input("in").Output("out").Build();
+}
+
+auto* CachedToStridedOpExpr = DECORATE(&ToStridedOpExpr, ThreadLocal);
+
 }  // namespace
 
 Maybe<void> NaiveInterpret(const UserOpExpr& user_op_expr, const TensorTuple& inputs,
@@ -93,12 +100,27 @@ Maybe<void> NaiveInterpret(const UserOpExpr& user_op_expr, const TensorTuple& in
     if (i > 0) {
       CHECK_OR_RETURN(*default_device == *input_device) << Error::InputDeviceNotMatchError();
     }
-    input_eager_blob_objects->at(i) = JUST(inputs.at(i)->eager_blob_object());
+    if (user_op_expr.op_type_name() != "to_contiguous" && !JUST(IsContiguous(inputs.at(i)))) {
+      // Kernels address their inputs by shape only, so strided views are copied before.
+      autograd::AutoGradMode mode(false);
+      const auto& contiguous_input = JUST(functional::ToContiguous(inputs.at(i)));
+      input_eager_blob_objects->at(i) = JUST(contiguous_input->eager_blob_object());
+    } else {
+      input_eager_blob_objects->at(i) = JUST(inputs.at(i)->eager_blob_object());
+    }
   }
   std::shared_ptr<EagerBlobObjectList> output_eager_blob_objects =
       std::make_shared<EagerBlobObjectList>(outputs->size());
   auto* output_tensor_metas = ThreadLocalDefaultOutputMutTensorMetas(outputs->size());
+  // Kernels write their outputs by shape only, so an inplace operation on a strided view runs
+  // into a contiguous temporary, which is copied back through the view's strides at the end.
+  std::vector<std::pair<int, std::shared_ptr<Tensor>>> strided_inplace_outputs;
   for (int i = 0; i < outputs->size(); i++) {
+    if (outputs->at(i) && user_op_expr.op_type_name() != "to_strided"
+        && !JUST(IsContiguous(outputs->at(i)))) {
+      strided_inplace_outputs.emplace_back(i, outputs->at(i));
+      outputs->at(i).reset();
+    }
     if (!outputs->at(i)) {
       const auto& tensor_impl = std::make_shared<EagerMirroredTensorImpl>();
       outputs->at(i) = std::make_shared<MirroredTensor>(tensor_impl);
@@ -163,6 +185,18 @@ Maybe<void> NaiveInterpret(const UserOpExpr& user_op_expr, const TensorTuple& in
     return builder->LocalCallOpKernel(kernel, input_eager_blob_objects, output_eager_blob_objects,
                                       ctx, op_device);
   }));
+
+  for (const auto& pair : strided_inplace_outputs) {
+    const std::shared_ptr<Tensor>& view = pair.second;
+    const Stride& stride = *JUST(view->stride());
+    MutableAttrMap to_strided_attrs;
+    JUST(to_strided_attrs.SetAttr<std::vector<int64_t>>(
+        "stride", std::vector<int64_t>(stride.StrideVec().begin(), stride.StrideVec().end())));
+    TensorTuple view_outputs{view};
+    JUST(NaiveInterpret(*JUST(CachedToStridedOpExpr()), {outputs->at(pair.first)}, op_device,
+                        &view_outputs, OpExprInterpContext(to_strided_attrs)));
+    outputs->at(pair.first) = view;
+  }
   return Maybe<void>::Ok();
 }
 
@@ -48,18 +48,58 @@ Maybe<bool> IsContiguous(const std::shared_ptr<Tensor>& tensor) {
 
 namespace view {
 
+namespace {
+
+// Registers the backward of a view, whose input gradient is computed from the output gradient by
+// grad_fn.
+Maybe<void> AddViewBackward(
+    const std::string& op_type_name, const std::shared_ptr<Tensor>& input,
+    const std::shared_ptr<Tensor>& output,
+    const std::function<Maybe<Tensor>(const std::shared_ptr<Tensor>&)>& grad_fn) {
+  if (!(autograd::GradMode::is_enabled() && input->requires_grad())) { return Maybe<void>::Ok(); }
+  auto backward_fn =
+      std::make_shared<std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>(
+          [=](const TensorTuple& out_grads, TensorTuple* in_grads,
+              bool create_graph) -> Maybe<void> {
+            autograd::AutoGradMode mode(create_graph);
+            CHECK_EQ_OR_RETURN(out_grads.size(), 1);
+            in_grads->resize(1);
+            in_grads->at(0) = JUST(grad_fn(out_grads.at(0)));
+            return Maybe<void>::Ok();
+          });
+  TensorTuple outputs{output};
+  JUST(GetThreadLocalAutogradEngine()->AddBackwardFuncPtr(op_type_name, backward_fn, {input},
+                                                          &outputs));
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckEagerLocal(const std::shared_ptr<Tensor>& input, const std::string& name) {
+  if (!(input->is_eager() && input->is_local())) {
+    return Error::RuntimeError() << "view::" << name
+                                 << "(): input should be eager local tensor, but got "
+                                 << (input->is_lazy() ? "lazy" : "consistent");
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
 Maybe<Tensor> BasicView(const std::shared_ptr<Tensor>& input, const Shape& target_shape,
                         int64_t storage_offset) {
+  return BasicView(input, target_shape, Stride(target_shape), storage_offset);
+}
+
+Maybe<Tensor> BasicView(const std::shared_ptr<Tensor>& input, const Shape& target_shape,
+                        const Stride& target_strides, int64_t storage_offset) {
   /**
    * This function provides basic view capabilities which
-   * accept input tensor with target shape, and return viewed tensor.
+   * accept input tensor with target shape and strides, and return viewed tensor.
    *
-   * The viewed tensor shared memory with input tensor, and both of
-   * them are memory contiguous, but has different shapes/strides.
+   * The viewed tensor shared memory with input tensor, and starts storage_offset elements
+   * after the first element of input tensor.
    */
-  Stride target_strides(target_shape);
+  CHECK_EQ_OR_RETURN(target_shape.NumAxes(), target_strides.NumAxes());
   storage_offset = storage_offset + JUST(JUST(input->AsMirroredTensor())->storage_offset());
-  // TODO(): Check shape compatible.
   auto device = JUST(input->device());
   auto tensor_meta = std::make_shared<MirroredTensorMeta>(
       std::make_shared<Shape>(target_shape), input->dtype()->data_type(), device,
@@ -68,9 +108,9 @@ Maybe<Tensor> BasicView(const std::shared_ptr<Tensor>& input, const Shape& targe
   CHECK_OR_RETURN(JUST(input->has_eager_blob_object()));
   // new output tensor
   const auto& blob_object = JUST(input->eager_blob_object());
+  const bool requires_grad = autograd::GradMode::is_enabled() && input->requires_grad();
   auto tensor_impl = std::make_shared<EagerMirroredTensorImpl>(
-      tensor_meta, JUST(input->tensor_storage()), input->requires_grad(),
-      /*is_leaf=*/!input->requires_grad());
+      tensor_meta, JUST(input->tensor_storage()), requires_grad, /*is_leaf=*/!requires_grad);
   JUST(tensor_impl->InitEagerBlobObject(JUST(blob_object->compute_local_dep_object())));
   std::shared_ptr<Tensor> output(new MirroredTensor(tensor_impl));
   // run tensor view instruction
@@ -81,10 +121,10 @@ Maybe<Tensor> BasicView(const std::shared_ptr<Tensor>& input, const Shape& targe
 }
 
 Maybe<Tensor> Reshape(const std::shared_ptr<Tensor>& input, const Shape& shape) {
-  if (!(input->is_eager() && input->is_local())) {
-    return Error::RuntimeError() << "view::Reshape(): input should be eager local tensor, but got "
-                                 << (input->is_lazy() ? "lazy" : "consistent");
-  }
+  JUST(CheckEagerLocal(input, "Reshape"));
+  CHECK_OR_RETURN(JUST(IsContiguous(input)))
+      << "view::Reshape(): input should be contiguous, but got stride "
+      << JUST(input->stride())->ToString();
   int need_infer_axis = -1;
   size_t count = 1;
   for (int i = 0; i < shape.NumAxes(); ++i) {
@@ -113,22 +153,167 @@ Maybe<Tensor> Reshape(const std::shared_ptr<Tensor>& input, const Shape& shape)
     output = JUST(BasicView(input, infered_shape, 0));
   }
 
-  if (autograd::GradMode::is_enabled() && input->requires_grad()) {
-    Shape input_shape(input->shape()->dim_vec());
-    auto backward_fn =
-        std::make_shared<std::function<Maybe<void>(const TensorTuple&, TensorTuple*, bool)>>(
-            [=](const TensorTuple& out_grads, TensorTuple* in_grads,
-                bool create_graph) -> Maybe<void> {
-              autograd::AutoGradMode mode(create_graph);
-              CHECK_EQ_OR_RETURN(out_grads.size(), 1);
-              in_grads->resize(1);
-              in_grads->at(0) = JUST(functional::Reshape(out_grads.at(0), input_shape));
-              return Maybe<void>::Ok();
-            });
-    TensorTuple outputs{output};
-    JUST(GetThreadLocalAutogradEngine()->AddBackwardFuncPtr("view::reshape_backward", backward_fn,
-                                                            {input}, &outputs));
+  const Shape input_shape(input->shape()->dim_vec());
+  JUST(AddViewBackward("view::reshape_backward", input, output,
+                       [=](const std::shared_ptr<Tensor>& dy) -> Maybe<Tensor> {
+                         return functional::Reshape(dy, input_shape);
+                       }));
+  return output;
+}
+
+Maybe<Tensor> Slice(const std::shared_ptr<Tensor>& input, const std::vector<int64_t>& start,
+                    const std::vector<int64_t>& stop, const std::vector<int64_t>& step) {
+  JUST(CheckEagerLocal(input, "Slice"));
+  const Shape& shape = *input->shape();
+  const Stride& stride = *JUST(input->stride());
+  const int64_t ndim = shape.NumAxes();
+  CHECK_EQ_OR_RETURN(start.size(), ndim);
+  CHECK_EQ_OR_RETURN(stop.size(), ndim);
+  CHECK_EQ_OR_RETURN(step.size(), ndim);
+  DimVector target_dims(ndim);
+  StrideVector target_strides(ndim);
+  int64_t storage_offset = 0;
+  for (int64_t i = 0; i < ndim; ++i) {
+    CHECK_GT_OR_RETURN(step[i], 0) << "view::Slice(): step should be positive, but got " << step[i];
+    const int64_t size = shape.At(i);
+    // Same as RegulateSliceStart and RegulateSliceStop of the slice kernel.
+    int64_t begin = std::min(std::max(start[i], -size), size - 1);
+    if (begin < 0) { begin += size; }
+    int64_t end = std::min(std::max(stop[i], -size - 1), size);
+    if (end < 0) { end += size; }
+    const int64_t length = (size == 0 || end <= begin) ? 0 : (end - begin + step[i] - 1) / step[i];
+    target_dims[i] = length;
+    target_strides[i] = stride.At(i) * step[i];
+    if (length > 0) { storage_offset += begin * stride.At(i); }
+  }
+  const auto output =
+      JUST(BasicView(input, Shape(target_dims), Stride(target_strides), storage_offset));
+  const Shape input_shape(shape.dim_vec());
+  JUST(AddViewBackward("view::slice_backward", input, output,
+                       [=](const std::shared_ptr<Tensor>& dy) -> Maybe<Tensor> {
+                         return functional::SliceGrad(dy, input_shape, start, stop, step);
+                       }));
+  return output;
+}
+
+Maybe<Tensor> Narrow(const std::shared_ptr<Tensor>& input, int64_t dim, int64_t start,
+                     int64_t length) {
+  const Shape& shape = *input->shape();
+  const int64_t ndim = shape.NumAxes();
+  CHECK_OR_RETURN(dim >= 0 && dim < ndim) << "view::Narrow(): invalid dim " << dim;
+  if (start < 0) { start += shape.At(dim); }
+  CHECK_OR_RETURN(start >= 0 && length >= 0 && start + length <= shape.At(dim))
+      << "view::Narrow(): start " << start << " and length " << length
+      << " are out of range of dimension " << dim << " of size " << shape.At(dim);
+  std::vector<int64_t> starts(ndim, 0);
+  std::vector<int64_t> stops(shape.dim_vec().begin(), shape.dim_vec().end());
+  std::vector<int64_t> steps(ndim, 1);
+  starts[dim] = start;
+  stops[dim] = start + length;
+  return Slice(input, starts, stops, steps);
+}
+
+Maybe<Tensor> Transpose(const std::shared_ptr<Tensor>& input, const std::vector<int32_t>& permute) {
+  JUST(CheckEagerLocal(input, "Transpose"));
+  const Shape& shape = *input->shape();
+  const Stride& stride = *JUST(input->stride());
+  const int64_t ndim = shape.NumAxes();
+  CHECK_EQ_OR_RETURN(permute.size(), ndim);
+  DimVector target_dims(ndim);
+  StrideVector target_strides(ndim);
+  std::vector<int32_t> inverse_permute(ndim, -1);
+  for (int64_t i = 0; i < ndim; ++i) {
+    const int32_t axis = permute[i];
+    CHECK_OR_RETURN(axis >= 0 && axis < ndim && inverse_permute[axis] == -1)
+        << "view::Transpose(): invalid permute";
+    inverse_permute[axis] = i;
+    target_dims[i] = shape.At(axis);
+    target_strides[i] = stride.At(axis);
   }
+  const auto output = JUST(BasicView(input, Shape(target_dims), Stride(target_strides), 0));
+  JUST(AddViewBackward("view::transpose_backward", input, output,
+                       [=](const std::shared_ptr<Tensor>& dy) -> Maybe<Tensor> {
+                         return functional::Transpose(dy, inverse_permute);
+                       }));
+  return output;
+}
+
+Maybe<Tensor> Expand(const std::shared_ptr<Tensor>& input, const Shape& shape) {
+  JUST(CheckEagerLocal(input, "Expand"));
+  const Shape& in_shape = *input->shape();
+  const Stride& in_stride = *JUST(input->stride());
+  const int64_t ndim = shape.NumAxes();
+  const int64_t shift = ndim - in_shape.NumAxes();
+  CHECK_GE_OR_RETURN(shift, 0);
+  DimVector target_dims(ndim);
+  StrideVector target_strides(ndim);
+  for (int64_t i = 0; i < ndim; ++i) {
+    const int64_t index = i - shift;
+    if (index >= 0 && (shape.At(i) == -1 || shape.At(i) == in_shape.At(index))) {
+      target_dims[i] = in_shape.At(index);
+      target_strides[i] = in_stride.At(index);
+    } else {
+      CHECK_OR_RETURN(shape.At(i) > 0 && (index < 0 || in_shape.At(index) == 1))
+          << "view::Expand(): invalid expand shape " << shape.ToString();
+      // Broadcast dimensions read the same elements over and over again.
+      target_dims[i] = shape.At(i);
+      target_strides[i] = 0;
+    }
+  }
+  const auto output = JUST(BasicView(input, Shape(target_dims), Stride(target_strides), 0));
+  const std::vector<int32_t> logical_in_shape(in_shape.dim_vec().begin(), in_shape.dim_vec().end());
+  const std::vector<int32_t> logical_expand_shape(target_dims.begin(), target_dims.end());
+  JUST(AddViewBackward("view::expand_backward", input, output,
+                       [=](const std::shared_ptr<Tensor>& dy) -> Maybe<Tensor> {
+                         return functional::ExpandGrad(dy, logical_in_shape, logical_expand_shape);
+                       }));
+  return output;
+}
+
+Maybe<Tensor> Squeeze(const std::shared_ptr<Tensor>& input, const std::vector<int32_t>& axes) {
+  JUST(CheckEagerLocal(input, "Squeeze"));
+  const Shape& shape = *input->shape();
+  const Stride& stride = *JUST(input->stride());
+  std::vector<bool> squeezed(shape.NumAxes(), false);
+  for (int32_t axis : axes) {
+    CHECK_OR_RETURN(axis >= 0 && axis < shape.NumAxes() && shape.At(axis) == 1)
+        << "view::Squeeze(): invalid axis " << axis;
+    squeezed[axis] = true;
+  }
+  DimVector target_dims;
+  StrideVector target_strides;
+  for (int64_t i = 0; i < shape.NumAxes(); ++i) {
+    if (squeezed[i]) { continue; }
+    target_dims.push_back(shape.At(i));
+    target_strides.push_back(stride.At(i));
+  }
+  const auto output = JUST(BasicView(input, Shape(target_dims), Stride(target_strides), 0));
+  const Shape input_shape(shape.dim_vec());
+  JUST(AddViewBackward("view::squeeze_backward", input, output,
+                       [=](const std::shared_ptr<Tensor>& dy) -> Maybe<Tensor> {
+                         return functional::Reshape(dy, input_shape);
+                       }));
+  return output;
+}
+
+Maybe<Tensor> Unsqueeze(const std::shared_ptr<Tensor>& input, int32_t axis) {
+  JUST(CheckEagerLocal(input, "Unsqueeze"));
+  const Shape& shape = *input->shape();
+  const Stride& stride = *JUST(input->stride());
+  CHECK_OR_RETURN(axis >= 0 && axis <= shape.NumAxes())
+      << "view::Unsqueeze(): invalid axis " << axis;
+  DimVector target_dims(shape.dim_vec().begin(), shape.dim_vec().end());
+  StrideVector target_strides(stride.StrideVec().begin(), stride.StrideVec().end());
+  const int64_t new_stride =
+      axis < shape.NumAxes() ? stride.At(axis) * std::max<int64_t>(shape.At(axis), 1) : 1;
+  target_dims.insert(target_dims.begin() + axis, 1);
+  target_strides.insert(target_strides.begin() + axis, new_stride);
+  const auto output = JUST(BasicView(input, Shape(target_dims), Stride(target_strides), 0));
+  const Shape input_shape(shape.dim_vec());
+  JUST(AddViewBackward("view::unsqueeze_backward", input, output,
+                       [=](const std::shared_ptr<Tensor>& dy) -> Maybe<Tensor> {
+                         return functional::Reshape(dy, input_shape);
+                       }));
   return output;
 }
 
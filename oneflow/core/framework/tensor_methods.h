@@ -28,11 +28,32 @@ Maybe<bool> IsContiguous(const std::shared_ptr<Tensor>& tensor);
 
 namespace view {
 
+Maybe<Tensor> BasicView(const std::shared_ptr<Tensor>& input, const Shape& target_shape,
+                        int64_t storage_offset);
+
 Maybe<Tensor> BasicView(const std::shared_ptr<Tensor>& input, const Shape& target_shape,
                         const Stride& target_strides, int64_t storage_offset);
 
+// Views share the storage of their input and are only available for eager local tensors. Slice,
+// Narrow, Transpose and Expand may return non-contiguous views, which are copied lazily into
+// contiguous tensors by the kernels that read them and written back through their strides by the
+// inplace kernels that write them.
 Maybe<Tensor> Reshape(const std::shared_ptr<Tensor>& input, const Shape& shape);
 
+Maybe<Tensor> Slice(const std::shared_ptr<Tensor>& input, const std::vector<int64_t>& start,
+                    const std::vector<int64_t>& stop, const std::vector<int64_t>& step);
+
+Maybe<Tensor> Narrow(const std::shared_ptr<Tensor>& input, int64_t dim, int64_t start,
+                     int64_t length);
+
+Maybe<Tensor> Transpose(const std::shared_ptr<Tensor>& input, const std::vector<int32_t>& permute);
+
+Maybe<Tensor> Expand(const std::shared_ptr<Tensor>& input, const Shape& shape);
+
+Maybe<Tensor> Squeeze(const std::shared_ptr<Tensor>& input, const std::vector<int32_t>& axes);
+
+Maybe<Tensor> Unsqueeze(const std::shared_ptr<Tensor>& input, int32_t axis);
+
 }  // namespace view
 }  // namespace one
 }  // namespace oneflow
@@ -578,6 +578,9 @@ class ExpandFunctor {
       }
     }
 
+    // if input tensor is eager local, than return tensor's view
+    if (x->is_local() && !(LazyMode::is_enabled())) { return view::Expand(x, shape); }
+
     std::vector<int32_t> expand_shape(shape.NumAxes());
     for (int i = 0; i < shape.NumAxes(); ++i) { expand_shape[i] = shape.dim_vec().at(i); }
 
@@ -621,6 +624,9 @@ class ExpandDimsFunctor {
         << " Dimension out of range, expected to be in range of [" << -(ndim + 1) << ", " << ndim
         << "], but got: " << dim;
     if (dim < 0) { expand_dim = dim + ndim + 1; }
+    if (input->is_local() && !(LazyMode::is_enabled())) {
+      return view::Unsqueeze(input, expand_dim);
+    }
     MutableAttrMap attrs;
     JUST(attrs.SetAttr<int32_t>("axis", expand_dim));
     return OpInterpUtil::Dispatch<Tensor>(*op_, {input}, attrs);
@@ -960,8 +966,10 @@ class ReshapeFunctor {
     op_ = CHECK_JUST(one::OpBuilder("reshape").Input("in").Output("out").Build());
   }
   Maybe<Tensor> operator()(const std::shared_ptr<one::Tensor>& x, const Shape& shape) const {
-    // if input tensor is eager local, than return tensor's view
-    if (x->is_local() && !(LazyMode::is_enabled())) { return view::Reshape(x, shape); }
+    // if input tensor is eager local and contiguous, than return tensor's view
+    if (x->is_local() && !(LazyMode::is_enabled()) && JUST(IsContiguous(x))) {
+      return view::Reshape(x, shape);
+    }
     int need_infer_axis = -1;
     size_t count = 1;
     for (int i = 0; i < shape.NumAxes(); ++i) {
@@ -1037,6 +1045,16 @@ class SliceGradBaseFunctor {
 class SliceFunctor : public SliceBaseFunctor {
  public:
   SliceFunctor() { op_ = CHECK_JUST(one::OpBuilder("slice").Input("x").Output("y").Build()); }
+  Maybe<Tensor> operator()(const std::shared_ptr<one::Tensor>& x, const std::vector<int64_t>& start,
+                           const std::vector<int64_t>& stop,
+                           const std::vector<int64_t>& step) const {
+    // if input tensor is eager local and the steps are positive, than return tensor's view
+    if (x->is_local() && !(LazyMode::is_enabled())
+        && std::all_of(step.cbegin(), step.cend(), [](int64_t s) { return s > 0; })) {
+      return view::Slice(x, start, stop, step);
+    }
+    return SliceBaseFunctor::operator()(x, start, stop, step);
+  }
 };
 
 class SliceGradFunctor : public SliceGradBaseFunctor {
@@ -1057,6 +1075,9 @@ class NarrowFunctor {
         << " (Dimension out of range, expected to be in range of [" << -ndim << ", " << ndim - 1
         << "], but got:" << dim << ")";
     if (narrow_dim < 0) { narrow_dim += ndim; }
+    if (input->is_local() && !(LazyMode::is_enabled())) {
+      return view::Narrow(input, narrow_dim, start, length);
+    }
     MutableAttrMap attrs;
     JUST(attrs.SetAttr<int64_t>("dim", narrow_dim));
     JUST(attrs.SetAttr<int64_t>("start", start));
@@ -1168,6 +1189,7 @@ class SqueezeFunctor {
       }
     }
 
+    if (x->is_local() && !(LazyMode::is_enabled())) { return view::Squeeze(x, squeeze_dims); }
     MutableAttrMap attrs;
     JUST(attrs.SetAttr<std::vector<int32_t>>("axes", squeeze_dims));
     return OpInterpUtil::Dispatch<Tensor>(*op_, {x}, attrs);
@@ -1217,6 +1239,27 @@ class CopyFunctor {
   std::shared_ptr<OpExpr> op_;
 };
 
+class ToContiguousFunctor {
+ public:
+  ToContiguousFunctor() {
+    op_ = CHECK_JUST(one::OpBuilder("to_contiguous").Input("in").Output("out").Build());
+  }
+  Maybe<Tensor> operator()(const std::shared_ptr<one::Tensor>& input) const {
+    // Only eager local tensors may be non-contiguous views.
+    if (!input->is_local() || LazyMode::is_enabled() || JUST(IsContiguous(input))) {
+      return input;
+    }
+    const Stride& stride = *JUST(input->stride());
+    MutableAttrMap attrs;
+    JUST(attrs.SetAttr<std::vector<int64_t>>(
+        "stride", std::vector<int64_t>(stride.StrideVec().begin(), stride.StrideVec().end())));
+    return OpInterpUtil::Dispatch<Tensor>(*op_, {input}, attrs);
+  }
+
+ private:
+  std::shared_ptr<OpExpr> op_;
+};
+
 class FlipFunctor {
  public:
   FlipFunctor() { op_ = CHECK_JUST(one::OpBuilder("flip").Input("x").Output("y").Build()); }
@@ -2566,6 +2609,7 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
   m.add_functor<impl::SliceUpdateFunctor>("SliceUpdate");
   m.add_functor<impl::SqueezeFunctor>("Squeeze");
   m.add_functor<impl::CopyFunctor>("Copy");
+  m.add_functor<impl::ToContiguousFunctor>("ToContiguous");
   m.add_functor<impl::FlipFunctor>("Flip");
   m.add_functor<impl::FlipGradFunctor>("FlipGrad");
   m.add_functor<impl::UnfoldTensorFunctor>("UnfoldTensor");
@@ -324,6 +324,8 @@ class LocalToConsistentFunctor {
       input = JUST(functional::Copy(x, Device::Type4DeviceTag(parallel_desc->device_tag()),
                                     GlobalProcessCtx::LocalRank()));
     }
+    // the physical tensor of the consistent tensor shares the storage of input
+    input = JUST(functional::ToContiguous(input));
     Symbol<cfg::NdSbp> nd_sbp = JUST(GetNdSbp(sbp_parallels));
     MutableAttrMap attrs;
     JUST(attrs.SetAttr<Shape>("shape", shape));
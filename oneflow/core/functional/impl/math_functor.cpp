@@ -588,6 +588,10 @@ class TransposeFunctor {
           << ndim << " ) but got " << positive_perm[i];
     }
 
+    // if input tensor is eager local, than return tensor's view
+    if (input->is_local() && !(LazyMode::is_enabled())) {
+      return view::Transpose(input, positive_perm);
+    }
     JUST(attrs.SetAttr<std::vector<int32_t>>("perm", positive_perm));
     return OpInterpUtil::Dispatch<Tensor>(*op_, {input}, attrs);
   }
@@ -619,6 +623,7 @@ class Transpose2dimFunctor {
         << "Invalid dim1:" << dim_1 << " len(shape):" << ndim;
     for (int32_t i = 0; i < ndim; ++i) { permute.emplace_back(i); }
     std::swap(permute[dim_0], permute[dim_1]);
+    if (x->is_local() && !(LazyMode::is_enabled())) { return view::Transpose(x, permute); }
 
     JUST(attrs.SetAttr<std::vector<int32_t>>("perm", permute));
     return OpInterpUtil::Dispatch<Tensor>(*op_, {x}, attrs);
@@ -2145,6 +2145,44 @@ class RoiAlignGradFunctor {
   std::shared_ptr<OpExpr> op_;
 };
 
+class EmbeddingLookupFunctor {
+ public:
+  EmbeddingLookupFunctor() {
+    op_ = CHECK_JUST(one::OpBuilder("embedding_lookup")
+                         .Input("shadow")
+                         .Input("ids")
+                         .Input("learning_rate")
+                         .Output("embeddings")
+                         .Output("unique_ids")
+                         .Output("inverse_indices")
+                         .Output("num_unique")
+                         .Build());
+  }
+  Maybe<Tensor> operator()(const std::shared_ptr<one::Tensor>& shadow,
+                           const std::shared_ptr<one::Tensor>& ids, const std::string& name,
+                           const int64_t& embedding_dim, const std::string& path,
+                           const int64_t& cache_capacity, const std::string& optimizer,
+                           const std::shared_ptr<one::Tensor>& learning_rate,
+                           const float& epsilon, const float& initializer_min,
+                           const float& initializer_max, const int64_t& seed) const {
+    MutableAttrMap attrs;
+    JUST(attrs.SetAttr<std::string>("name", name));
+    JUST(attrs.SetAttr<int64_t>("embedding_dim", embedding_dim));
+    JUST(attrs.SetAttr<std::string>("path", path));
+    JUST(attrs.SetAttr<int64_t>("cache_capacity", cache_capacity));
+    JUST(attrs.SetAttr<std::string>("optimizer", optimizer));
+    JUST(attrs.SetAttr<float>("epsilon", epsilon));
+    JUST(attrs.SetAttr<float>("initializer_min", initializer_min));
+    JUST(attrs.SetAttr<float>("initializer_max", initializer_max));
+    JUST(attrs.SetAttr<int64_t>("seed", seed));
+    return JUST(OpInterpUtil::Dispatch<TensorTuple>(*op_, {shadow, ids, learning_rate}, attrs))
+        ->at(0);
+  }
+
+ private:
+  std::shared_ptr<OpExpr> op_;
+};
+
 }  // namespace impl
 
 ONEFLOW_FUNCTION_LIBRARY(m) {
@@ -2215,6 +2253,7 @@ ONEFLOW_FUNCTION_LIBRARY(m) {
   m.add_functor<impl::NmsFunctor>("Nms");
   m.add_functor<impl::RoiAlignFunctor>("RoiAlign");
   m.add_functor<impl::RoiAlignGradFunctor>("RoiAlignGrad");
+  m.add_functor<impl::EmbeddingLookupFunctor>("EmbeddingLookup");
 };
 
 }  // namespace functional
@@ -32,13 +32,13 @@ using namespace boxing::collective;
 
 namespace {
 
-void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
-                            const ParallelDesc& parallel_desc, int64_t parallel_id,
-                            const std::string& name, const LogicalBlobId& lbi,
-                            const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
+void InitCollectiveNode(CollectiveBoxingGenericTaskNode* node, const ParallelDesc& parallel_desc,
+                        int64_t parallel_id, const std::string& name, const LogicalBlobId& lbi,
+                        const BlobDesc& logical_blob_desc, OpType op_type, int64_t root,
+                        Backend backend, const StreamId& stream_id) {
   OperatorConf op_conf;
   op_conf.set_name(name);
-  op_conf.set_device_tag(*CHECK_JUST(DeviceTag4DeviceType(DeviceType::kCUDA)));
+  op_conf.set_device_tag(*CHECK_JUST(DeviceTag4DeviceType(stream_id.device_id().device_type())));
   CollectiveBoxingGenericOpConf* conf = op_conf.mutable_collective_boxing_generic_conf();
   *conf->mutable_lbi() = lbi;
   RankDesc* rank_desc = conf->mutable_rank_desc();
@@ -59,14 +59,47 @@ void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
   } else {
     CHECK_EQ(root, -1);
   }
-  op_desc->set_backend(Backend::kBackendNCCL);
+  op_desc->set_backend(backend);
   rank_desc->set_rank(parallel_id);
 
+  const int64_t machine_id = CHECK_JUST(parallel_desc.MachineId4ParallelId(parallel_id));
+  node->Init(machine_id, EncodeStreamIdToInt64(stream_id), lbi, op_conf);
+}
+
+void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
+                            const ParallelDesc& parallel_desc, int64_t parallel_id,
+                            const std::string& name, const LogicalBlobId& lbi,
+                            const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
   const int64_t machine_id = CHECK_JUST(parallel_desc.MachineId4ParallelId(parallel_id));
   const int64_t device_index = CHECK_JUST(parallel_desc.DeviceId4ParallelId(parallel_id));
-  const int64_t thrd_id = EncodeStreamIdToInt64(
-      GenerateNamedTaskStreamId(machine_id, DeviceType::kCUDA, device_index, "NCCL"));
-  node->Init(machine_id, thrd_id, lbi, op_conf);
+  const StreamId stream_id =
+      GenerateNamedTaskStreamId(machine_id, DeviceType::kCUDA, device_index, "NCCL");
+  InitCollectiveNode(node, parallel_desc, parallel_id, name, lbi, logical_blob_desc, op_type, root,
+                     Backend::kBackendNCCL, stream_id);
+}
+
+void CpuInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
+                           const ParallelDesc& parallel_desc, int64_t parallel_id,
+                           const std::string& name, const LogicalBlobId& lbi,
+                           const BlobDesc& logical_blob_desc, OpType op_type) {
+  const int64_t machine_id = CHECK_JUST(parallel_desc.MachineId4ParallelId(parallel_id));
+  const StreamId stream_id =
+      GenerateNamedTaskStreamId(machine_id, DeviceType::kCPU, 0, "CPU_COLLECTIVE");
+  InitCollectiveNode(node, parallel_desc, parallel_id, name, lbi, logical_blob_desc, op_type, -1,
+                     Backend::kBackendCPU, stream_id);
+}
+
+// The CPU executor backend runs one rank per process, with the data types ccl supports.
+bool IsCpuCollectiveBoxingSupported(const ParallelDesc& in_parallel_desc,
+                                    const ParallelDesc& out_parallel_desc,
+                                    const BlobDesc& logical_blob_desc) {
+  return out_parallel_desc.Equals(in_parallel_desc)
+         && !SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)
+         && IsPODDataType(logical_blob_desc.data_type())
+         && out_parallel_desc.device_type() == DeviceType::kCPU
+         && out_parallel_desc.parallel_num() > 1
+         && out_parallel_desc.parallel_num()
+                == static_cast<int64_t>(out_parallel_desc.sorted_machine_ids().size());
 }
 
 int64_t FindRootParallelId(const ParallelDesc& multi_device, const ParallelDesc& sole_device) {
@@ -532,6 +565,105 @@ class NcclCollectiveBoxingAll2AllSubTskGphBuilder final : public SubTskGphBuilde
   }
 };
 
+class CpuCollectiveBoxingAllReduceSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingAllReduceSubTskGphBuilder);
+  CpuCollectiveBoxingAllReduceSubTskGphBuilder() = default;
+  ~CpuCollectiveBoxingAllReduceSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const cfg::SbpParallel& in_sbp_parallel,
+      const cfg::SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (IsCpuCollectiveBoxingSupported(in_parallel_desc, out_parallel_desc, logical_blob_desc)
+        && SubTskGphBuilderUtil::IsBoxingP2B(in_sbp_parallel, out_sbp_parallel)) {
+      const std::string op_name = "System-Boxing-CpuCollectiveBoxingAllReduce-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CpuInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                              logical_blob_desc, OpType::kOpTypeAllReduce);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->emplace_back(collective_node);
+      }
+      return TRY(BuildSubTskGphBuilderStatus("CpuCollectiveBoxingAllReduceSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CpuCollectiveBoxingReduceScatterSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingReduceScatterSubTskGphBuilder);
+  CpuCollectiveBoxingReduceScatterSubTskGphBuilder() = default;
+  ~CpuCollectiveBoxingReduceScatterSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const cfg::SbpParallel& in_sbp_parallel,
+      const cfg::SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (IsCpuCollectiveBoxingSupported(in_parallel_desc, out_parallel_desc, logical_blob_desc)
+        && logical_blob_desc.shape().At(0) % out_parallel_desc.parallel_num() == 0
+        && SubTskGphBuilderUtil::IsBoxingP2S(in_sbp_parallel, out_sbp_parallel)
+        && out_sbp_parallel.split_parallel().axis() == 0) {
+      const std::string op_name =
+          "System-Boxing-CpuCollectiveBoxingReduceScatter-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CpuInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                              logical_blob_desc, OpType::kOpTypeReduceScatter);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->emplace_back(collective_node);
+      }
+      return TRY(
+          BuildSubTskGphBuilderStatus("CpuCollectiveBoxingReduceScatterSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CpuCollectiveBoxingAllGatherSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuCollectiveBoxingAllGatherSubTskGphBuilder);
+  CpuCollectiveBoxingAllGatherSubTskGphBuilder() = default;
+  ~CpuCollectiveBoxingAllGatherSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const cfg::SbpParallel& in_sbp_parallel,
+      const cfg::SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (IsCpuCollectiveBoxingSupported(in_parallel_desc, out_parallel_desc, logical_blob_desc)
+        && logical_blob_desc.shape().At(0) % in_parallel_desc.parallel_num() == 0
+        && SubTskGphBuilderUtil::IsBoxingS2B(in_sbp_parallel, out_sbp_parallel)
+        && in_sbp_parallel.split_parallel().axis() == 0) {
+      const std::string op_name = "System-Boxing-CpuCollectiveBoxingAllGather-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CpuInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                              logical_blob_desc, OpType::kOpTypeAllGather);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->emplace_back(collective_node);
+      }
+      return TRY(BuildSubTskGphBuilderStatus("CpuCollectiveBoxingAllGatherSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
 }  // namespace
 
 CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
@@ -553,6 +685,11 @@ CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
     LOG(WARNING) << "nccl_enable_all_to_all is unavailable unless NCCL_VERSION > 2.7.0";
 #endif
   }
+  if (collective_boxing_conf.cpu_enable_collective_boxing()) {
+    builders.emplace_back(new CpuCollectiveBoxingAllReduceSubTskGphBuilder());
+    builders.emplace_back(new CpuCollectiveBoxingReduceScatterSubTskGphBuilder());
+    builders.emplace_back(new CpuCollectiveBoxingAllGatherSubTskGphBuilder());
+  }
   chain_builder_.reset(new ChainSubTskGphBuilder(builders));
 }
 
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_INTRUSIVE_OBJECT_POOL_H_
 #define ONEFLOW_CORE_INTRUSIVE_OBJECT_POOL_H_
 
+#include <mutex>
+#include <thread>
 #include <vector>
 #include "oneflow/core/intrusive/cpp_attribute.h"
 
@@ -24,6 +26,7 @@ namespace intrusive {
 
 enum ObjectPoolStrategey {
   kThreadUnsafeAndDisableDestruct,
+  kThreadSafeAndDisableDestruct,
 };
 
 template<typename T, ObjectPoolStrategey object_pool_strategy>
@@ -85,6 +88,89 @@ class ObjectPool<T, kThreadUnsafeAndDisableDestruct> {
   std::vector<T*> container_;
 };
 
+// Elements are taken on the thread constructing the pool and may be put back on any thread, e.g.
+// instruction messages made on the main thread and released on the scheduler thread. Elements put
+// back on other threads wait in returned_container_ until the owner thread runs out of elements.
+// __Delete__ is called when an element is put back so that it does not hold what it refers to.
+// Orphan() frees the elements when the owner thread exits, and those put back afterwards are freed
+// right away.
+template<typename T>
+class ObjectPool<T, kThreadSafeAndDisableDestruct> {
+ public:
+  ObjectPool() : owner_thread_id_(std::this_thread::get_id()), orphaned_(false) {
+    container_.reserve(kObjectPoolInitCap);
+  }
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool(ObjectPool&&) = delete;
+  ~ObjectPool() {
+    for (auto* elem : container_) { delete elem; }
+    for (auto* elem : returned_container_) { delete elem; }
+  }
+
+  template<typename... Args>
+  intrusive::shared_ptr<T> make_shared(Args&&... args) {
+    if (INTRUSIVE_PREDICT_FALSE(container_.empty())) {
+      std::unique_lock<std::mutex> lock(returned_mutex_);
+      container_.swap(returned_container_);
+    }
+    if (INTRUSIVE_PREDICT_FALSE(container_.empty())) {
+      auto ptr = intrusive::make_shared<T>(std::forward<Args>(args)...);
+      InitObjectPoolFields4Element(ptr.get());
+      return ptr;
+    } else {
+      auto* ptr = container_.back();
+      container_.pop_back();
+      ptr->__Init__(std::forward<Args>(args)...);
+      InitObjectPoolFields4Element(ptr);
+      return intrusive::shared_ptr<T>(ptr);
+    }
+  }
+
+  static void Put(void* raw_ptr) {
+    T* ptr = reinterpret_cast<T*>(raw_ptr);
+    ptr->__Delete__();
+    auto* object_pool = ptr->mut_object_pool();
+    if (std::this_thread::get_id() == object_pool->owner_thread_id_) {
+      // orphaned_ is only written on the owner thread.
+      if (INTRUSIVE_PREDICT_FALSE(object_pool->orphaned_)) {
+        delete ptr;
+      } else {
+        object_pool->container_.push_back(ptr);
+      }
+    } else {
+      std::unique_lock<std::mutex> lock(object_pool->returned_mutex_);
+      if (INTRUSIVE_PREDICT_FALSE(object_pool->orphaned_)) {
+        delete ptr;
+      } else {
+        object_pool->returned_container_.push_back(ptr);
+      }
+    }
+  }
+
+  // Called on the owner thread when it exits. The pool itself must outlive the elements in use.
+  void Orphan() {
+    std::unique_lock<std::mutex> lock(returned_mutex_);
+    orphaned_ = true;
+    for (auto* elem : container_) { delete elem; }
+    for (auto* elem : returned_container_) { delete elem; }
+    std::vector<T*>().swap(container_);
+    std::vector<T*>().swap(returned_container_);
+  }
+
+ private:
+  inline void InitObjectPoolFields4Element(T* ptr) {
+    ptr->set_object_pool(this);
+    ptr->mut_intrusive_ref()->set_deleter(&ObjectPool::Put);
+  }
+
+  static constexpr int kObjectPoolInitCap = 1024;
+  const std::thread::id owner_thread_id_;
+  std::vector<T*> container_;
+  std::mutex returned_mutex_;
+  bool orphaned_;
+  std::vector<T*> returned_container_;
+};
+
 }  // namespace intrusive
 }  // namespace oneflow
 
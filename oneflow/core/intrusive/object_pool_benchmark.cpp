@@ -0,0 +1,110 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/intrusive/intrusive.h"
+#include "oneflow/core/intrusive/object_pool.h"
+
+namespace oneflow {
+namespace intrusive {
+namespace test {
+
+using oneflow::test::ElapsedMs;
+
+namespace {
+
+std::atomic<int64_t> allocated_msg_cnt(0);
+
+// Stand in for instruction messages, which are about as large.
+class PlainMsg final : public intrusive::Base {
+ public:
+  PlainMsg() { allocated_msg_cnt.fetch_add(1, std::memory_order_relaxed); }
+
+  void __Init__(int64_t value) { payload_[0] = value; }
+
+  intrusive::Ref* mut_intrusive_ref() { return &intrusive_ref_; }
+
+ private:
+  intrusive::Ref intrusive_ref_;
+  int64_t payload_[32];
+};
+
+class PooledMsg final
+    : public intrusive::Base,
+      public intrusive::EnableObjectPool<PooledMsg, kThreadSafeAndDisableDestruct> {
+ public:
+  PooledMsg() { allocated_msg_cnt.fetch_add(1, std::memory_order_relaxed); }
+
+  void __Init__(int64_t value) { payload_[0] = value; }
+
+  intrusive::Ref* mut_intrusive_ref() { return &intrusive_ref_; }
+
+ private:
+  intrusive::Ref intrusive_ref_;
+  int64_t payload_[32];
+};
+
+// Makes messages in batches on this thread and releases them on another one, as the main thread
+// and the scheduler thread do with instruction messages, and logs the time and the number of
+// messages allocated per message made.
+template<typename T, typename MakeT>
+void LogMakeAndRelease(const std::string& name, const MakeT& Make) {
+  const int64_t batch_size = 1024;
+  const int64_t batch_num = 1000;
+  const int64_t allocated_msg_cnt_before = allocated_msg_cnt;
+  const double ms = ElapsedMs(
+      [&]() {
+        Channel<std::vector<intrusive::shared_ptr<T>>> batches;
+        std::thread releaser([&]() {
+          std::vector<intrusive::shared_ptr<T>> batch;
+          while (batches.Receive(&batch) == kChannelStatusSuccess) { batch.clear(); }
+        });
+        FOR_RANGE(int64_t, i, 0, batch_num) {
+          std::vector<intrusive::shared_ptr<T>> batch;
+          batch.reserve(batch_size);
+          FOR_RANGE(int64_t, j, 0, batch_size) { batch.push_back(Make(j)); }
+          batches.Send(std::move(batch));
+        }
+        batches.Close();
+        releaser.join();
+      },
+      1);
+  const int64_t msg_cnt = batch_size * batch_num;
+  LOG(INFO) << name << ": " << ms * 1e6 / msg_cnt << "ns/op, "
+            << static_cast<double>(allocated_msg_cnt - allocated_msg_cnt_before) / msg_cnt
+            << " allocations/op";
+}
+
+}  // namespace
+
+TEST(ObjectPoolBenchmark, make_on_one_thread_and_release_on_another) {
+  LogMakeAndRelease<PlainMsg>("intrusive::make_shared", [](int64_t value) {
+    return intrusive::make_shared<PlainMsg>(value);
+  });
+  ObjectPool<PooledMsg, kThreadSafeAndDisableDestruct> object_pool;
+  LogMakeAndRelease<PooledMsg>("ObjectPool::make_shared", [&](int64_t value) {
+    return object_pool.make_shared(value);
+  });
+}
+
+}  // namespace test
+}  // namespace intrusive
+}  // namespace oneflow
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <sstream>
+#include <thread>
 #define private public
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/intrusive/intrusive.h"
@@ -52,6 +53,71 @@ TEST(ObjectPool_kThreadUnsafeAndDisableDestruct, recycle) {
   ASSERT_EQ(ptr, object_pool.make_shared().get());
 }
 
+class IntrusiveBar final  // NOLINT
+    : public intrusive::Base,
+      public intrusive::EnableObjectPool<IntrusiveBar, kThreadSafeAndDisableDestruct> {  // NOLINT
+ public:
+  IntrusiveBar() = default;  // NOLINT
+
+  void __Init__() { value_ = std::make_shared<int>(0); }
+  void __Delete__() { value_.reset(); }
+
+  intrusive::Ref* mut_intrusive_ref() { return &intrusive_ref_; }
+
+ private:
+  intrusive::Ref intrusive_ref_;
+  std::shared_ptr<int> value_;
+};
+
+TEST(ObjectPool_kThreadSafeAndDisableDestruct, append_to_pool) {
+  ObjectPool<IntrusiveBar, kThreadSafeAndDisableDestruct> object_pool;
+  IntrusiveBar* ptr = nullptr;
+  { ptr = object_pool.make_shared().get(); }
+  ASSERT_EQ(ptr, object_pool.make_shared().get());
+}
+
+TEST(ObjectPool_kThreadSafeAndDisableDestruct, delete_when_put_back) {
+  ObjectPool<IntrusiveBar, kThreadSafeAndDisableDestruct> object_pool;
+  std::weak_ptr<int> value;
+  {
+    auto bar = object_pool.make_shared();
+    value = bar->value_;
+    ASSERT_FALSE(value.expired());
+  }
+  ASSERT_TRUE(value.expired());
+}
+
+TEST(ObjectPool_kThreadSafeAndDisableDestruct, put_back_on_other_thread) {
+  ObjectPool<IntrusiveBar, kThreadSafeAndDisableDestruct> object_pool;
+  auto bar = object_pool.make_shared();
+  IntrusiveBar* ptr = bar.get();
+  std::thread thread([&]() { bar.Reset(); });
+  thread.join();
+  ASSERT_TRUE(object_pool.container_.empty());
+  ASSERT_EQ(object_pool.returned_container_.size(), 1);
+  ASSERT_EQ(ptr, object_pool.make_shared().get());
+  ASSERT_TRUE(object_pool.returned_container_.empty());
+}
+
+TEST(ObjectPool_kThreadSafeAndDisableDestruct, put_back_after_orphaned) {
+  ObjectPool<IntrusiveBar, kThreadSafeAndDisableDestruct>* object_pool = nullptr;
+  intrusive::shared_ptr<IntrusiveBar> bar;
+  std::thread thread([&]() {
+    object_pool = new ObjectPool<IntrusiveBar, kThreadSafeAndDisableDestruct>();
+    { object_pool->make_shared(); }
+    bar = object_pool->make_shared();
+    ASSERT_TRUE(object_pool->container_.empty());
+    object_pool->make_shared();
+    ASSERT_EQ(object_pool->container_.size(), 1);
+    object_pool->Orphan();
+    ASSERT_TRUE(object_pool->container_.empty());
+  });
+  thread.join();
+  bar.Reset();
+  ASSERT_TRUE(object_pool->returned_container_.empty());
+  delete object_pool;
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace intrusive
@@ -0,0 +1,357 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/collective_boxing/cpu_executor_backend.h"
+#include "oneflow/core/job/collective_boxing/request_store.h"
+#include "oneflow/core/graph/boxing/collective_boxing_util.h"
+#include "oneflow/core/ccl/ccl.h"
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/parallel_desc.h"
+#include "oneflow/core/job/rank_group.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/thread/thread_consistent_id.h"
+
+#include <cstring>
+#include <thread>
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+namespace {
+
+bool IsOpTypeFusionSupported(OpType op_type) {
+  return op_type == OpType::kOpTypeAllReduce || op_type == OpType::kOpTypeReduceScatter
+         || op_type == OpType::kOpTypeAllGather;
+}
+
+// What the worker thread needs to run a group, kept apart from the group token so that a group
+// still queued does not depend on the token.
+struct CpuGroup {
+  OpType op_type;
+  DataType data_type;
+  // Rank of the root of a broadcast or reduce.
+  int64_t root;
+  Symbol<ParallelDesc> parallel_desc;
+  std::vector<int64_t> elem_cnts;
+};
+
+Maybe<void> LaunchCollective(const CpuGroup& group, const void* send_buff, void* recv_buff,
+                             int64_t elem_cnt) {
+  const int64_t num_ranks = group.parallel_desc->parallel_num();
+  const DataType data_type = group.data_type;
+  if (group.op_type == OpType::kOpTypeAllReduce) {
+    JUST(ccl::AllReduce<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt, data_type, ccl::kSum,
+                                          group.parallel_desc, nullptr));
+  } else if (group.op_type == OpType::kOpTypeReduceScatter) {
+    CHECK_EQ_OR_RETURN(elem_cnt % num_ranks, 0);
+    JUST(ccl::ReduceScatter<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt / num_ranks,
+                                              data_type, ccl::kSum, group.parallel_desc,
+                                              nullptr));
+  } else if (group.op_type == OpType::kOpTypeAllGather) {
+    CHECK_EQ_OR_RETURN(elem_cnt % num_ranks, 0);
+    JUST(ccl::AllGather<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt / num_ranks, data_type,
+                                          group.parallel_desc, nullptr));
+  } else if (group.op_type == OpType::kOpTypeReduce) {
+    JUST(ccl::Reduce<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt, data_type, ccl::kSum,
+                                       group.root, group.parallel_desc, nullptr));
+  } else if (group.op_type == OpType::kOpTypeBroadcast) {
+    JUST(ccl::Broadcast<DeviceType::kCPU>(send_buff, recv_buff, elem_cnt, data_type, group.root,
+                                          group.parallel_desc, nullptr));
+  } else {
+    UNIMPLEMENTED_THEN_RETURN();
+  }
+  return Maybe<void>::Ok();
+}
+
+// Runs the requests of a group as one collective on a buffer that holds all of them, laid out so
+// that every rank's part of the buffer is the concatenation of its parts of the requests.
+Maybe<void> LaunchFusedCollective(
+    const CpuGroup& group,
+    const std::vector<std::shared_ptr<const RuntimeRequestInfo>>& runtime_request_infos,
+    std::vector<char>* buffer) {
+  const int64_t num_ranks = group.parallel_desc->parallel_num();
+  const int64_t size_of_data_type = GetSizeOfDataType(group.data_type);
+  const int64_t request_count = group.elem_cnts.size();
+  // Bytes of each request in a rank's part, and their offsets in it.
+  std::vector<int64_t> part_sizes(request_count);
+  std::vector<int64_t> part_offsets(request_count);
+  int64_t part_size = 0;
+  for (int64_t i = 0; i < request_count; ++i) {
+    const int64_t elem_cnt = group.elem_cnts.at(i);
+    if (group.op_type == OpType::kOpTypeAllReduce) {
+      part_sizes.at(i) = elem_cnt * size_of_data_type;
+    } else {
+      CHECK_EQ_OR_RETURN(elem_cnt % num_ranks, 0);
+      part_sizes.at(i) = elem_cnt / num_ranks * size_of_data_type;
+    }
+    part_offsets.at(i) = part_size;
+    part_size += part_sizes.at(i);
+  }
+  if (group.op_type == OpType::kOpTypeAllReduce) {
+    if (buffer->size() < static_cast<size_t>(part_size)) { buffer->resize(part_size); }
+    char* fused = buffer->data();
+    for (int64_t i = 0; i < request_count; ++i) {
+      std::memcpy(fused + part_offsets.at(i), runtime_request_infos.at(i)->send_buff,
+                  part_sizes.at(i));
+    }
+    JUST(LaunchCollective(group, fused, fused, part_size / size_of_data_type));
+    for (int64_t i = 0; i < request_count; ++i) {
+      std::memcpy(runtime_request_infos.at(i)->recv_buff, fused + part_offsets.at(i),
+                  part_sizes.at(i));
+    }
+  } else if (group.op_type == OpType::kOpTypeAllGather) {
+    const size_t fused_size = (num_ranks + 1) * part_size;
+    if (buffer->size() < fused_size) { buffer->resize(fused_size); }
+    char* fused_send = buffer->data();
+    char* fused_recv = fused_send + part_size;
+    for (int64_t i = 0; i < request_count; ++i) {
+      std::memcpy(fused_send + part_offsets.at(i), runtime_request_infos.at(i)->send_buff,
+                  part_sizes.at(i));
+    }
+    JUST(LaunchCollective(group, fused_send, fused_recv,
+                          num_ranks * part_size / size_of_data_type));
+    for (int64_t i = 0; i < request_count; ++i) {
+      char* recv_buff = static_cast<char*>(runtime_request_infos.at(i)->recv_buff);
+      for (int64_t rank = 0; rank < num_ranks; ++rank) {
+        std::memcpy(recv_buff + rank * part_sizes.at(i),
+                    fused_recv + rank * part_size + part_offsets.at(i), part_sizes.at(i));
+      }
+    }
+  } else if (group.op_type == OpType::kOpTypeReduceScatter) {
+    const size_t fused_size = (num_ranks + 1) * part_size;
+    if (buffer->size() < fused_size) { buffer->resize(fused_size); }
+    char* fused_send = buffer->data();
+    char* fused_recv = fused_send + num_ranks * part_size;
+    for (int64_t i = 0; i < request_count; ++i) {
+      const char* send_buff = static_cast<const char*>(runtime_request_infos.at(i)->send_buff);
+      for (int64_t rank = 0; rank < num_ranks; ++rank) {
+        std::memcpy(fused_send + rank * part_size + part_offsets.at(i),
+                    send_buff + rank * part_sizes.at(i), part_sizes.at(i));
+      }
+    }
+    JUST(LaunchCollective(group, fused_send, fused_recv,
+                          num_ranks * part_size / size_of_data_type));
+    for (int64_t i = 0; i < request_count; ++i) {
+      std::memcpy(runtime_request_infos.at(i)->recv_buff, fused_recv + part_offsets.at(i),
+                  part_sizes.at(i));
+    }
+  } else {
+    UNIMPLEMENTED_THEN_RETURN();
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+struct CpuExecutorBackend::Impl {
+  Impl(const CollectiveBoxingConf& conf, std::shared_ptr<RequestStore> request_store)
+      : conf(conf), request_store(std::move(request_store)) {
+    CHECK_GE(conf.cpu_fusion_threshold_mb(), 0);
+    CHECK_GT(conf.cpu_fusion_max_ops(), 0);
+    fusion_threshold = conf.cpu_fusion_threshold_mb() * 1024 * 1024;
+    worker = std::thread([this]() {
+      // Transport tokens of the collectives carry the consistent id of the thread, it has to be
+      // the same on all ranks.
+      CHECK_JUST(
+          InitThisThreadConsistentId(kThreadConsistentIdCollectiveBoxing, "collective_boxing"));
+      std::function<void()> task;
+      while (task_channel.Receive(&task) == kChannelStatusSuccess) { task(); }
+    });
+  }
+  ~Impl() {
+    task_channel.Close();
+    worker.join();
+  }
+
+  void InitParallelDesc(int64_t job_id) {
+    request_store->ForEachMutRequestEntryInJob(
+        job_id, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const auto& request = request_entry->desc();
+          if (request.op_desc().backend() != Backend::kBackendCPU) { return; }
+          if (!request_entry->HasRankOnThisNode()) { return; }
+          const DeviceSet& device_set = request.device_set();
+          if (device_set2parallel_desc.count(device_set) > 0) { return; }
+          // ccl numbers the ranks of a group in increasing order, which has to be the order of
+          // the devices.
+          std::set<int64_t> ranks;
+          for (const DeviceDesc& device : device_set.device()) {
+            CHECK_EQ(device.device_type(), DeviceType::kCPU);
+            CHECK(ranks.empty() || device.machine_id() > *ranks.rbegin());
+            ranks.insert(device.machine_id());
+          }
+          device_set2parallel_desc.emplace(
+              device_set, CHECK_JUST(RankGroup::GetDefaultParallelDesc(
+                              DeviceType::kCPU, CHECK_JUST(RankGroup::New(ranks)))));
+        });
+  }
+
+  bool CanRequestEntryFuse(const RequestEntry* lhs, const RequestEntry* rhs) const {
+    const OpDesc& lhs_op_desc = lhs->desc().op_desc();
+    const OpDesc& rhs_op_desc = rhs->desc().op_desc();
+    return lhs->device_set_symbol() == rhs->device_set_symbol()
+           && IsOpTypeFusionSupported(lhs_op_desc.op_type())
+           && lhs_op_desc.op_type() == rhs_op_desc.op_type()
+           && lhs_op_desc.data_type() == rhs_op_desc.data_type();
+  }
+
+  void GroupRequests(const std::vector<RequestId>& request_ids,
+                     const std::function<void(std::vector<RequestId>&&, void*)>& Handler) {
+    std::vector<RequestId> group;
+    int64_t group_size = 0;
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        request_ids, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const int64_t size = request_entry->size_in_bytes();
+          if (group.empty()
+              || !CanRequestEntryFuse(request_store->MutRequestEntry(group.back()), request_entry)
+              || group_size + size > fusion_threshold
+              || static_cast<int64_t>(group.size()) >= conf.cpu_fusion_max_ops()) {
+            if (!group.empty()) {
+              void* token = CreateGroupToken(group);
+              Handler(std::move(group), token);
+              group.clear();
+              group_size = 0;
+            }
+          }
+          group.emplace_back(request_id);
+          group_size += size;
+        });
+    if (!group.empty()) {
+      void* token = CreateGroupToken(group);
+      Handler(std::move(group), token);
+    }
+  }
+
+  struct GroupToken {
+    GroupToken(const std::vector<RequestId>& group, std::shared_ptr<const CpuGroup> cpu_group)
+        : request_ids(group), cpu_group(std::move(cpu_group)) {}
+    std::vector<RequestId> request_ids;
+    std::shared_ptr<const CpuGroup> cpu_group;
+  };
+
+  void* CreateGroupToken(const std::vector<RequestId>& group) {
+    CHECK_GT(group.size(), 0);
+    const RequestDesc& first_request = request_store->MutRequestEntry(group.front())->desc();
+    auto it = device_set2parallel_desc.find(first_request.device_set());
+    CHECK(it != device_set2parallel_desc.end());
+    auto cpu_group = std::make_shared<CpuGroup>();
+    cpu_group->op_type = first_request.op_desc().op_type();
+    cpu_group->data_type = first_request.op_desc().data_type();
+    // ccl only reduces POD data types, IsCpuCollectiveBoxingSupported keeps the others on regular
+    // boxing.
+    CHECK(IsPODDataType(cpu_group->data_type)) << DataType_Name(cpu_group->data_type);
+    cpu_group->root = -1;
+    if (cpu_group->op_type == OpType::kOpTypeBroadcast
+        || cpu_group->op_type == OpType::kOpTypeReduce) {
+      CHECK_EQ(group.size(), 1);
+      const int64_t root_parallel_id = first_request.op_desc().root();
+      cpu_group->root = first_request.device_set().device(root_parallel_id).machine_id();
+    }
+    cpu_group->parallel_desc = it->second;
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        group, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          const OpDesc& op_desc = request_entry->desc().op_desc();
+          CHECK(request_entry->desc().device_set() == first_request.device_set());
+          CHECK_EQ(op_desc.op_type(), cpu_group->op_type);
+          CHECK_EQ(op_desc.data_type(), cpu_group->data_type);
+          if (op_desc.has_reduce_method()) {
+            CHECK_EQ(op_desc.reduce_method(), ReduceMethod::kReduceMethodSum);
+          }
+          cpu_group->elem_cnts.emplace_back(request_entry->elem_cnt());
+        });
+    return new GroupToken(group, cpu_group);
+  }
+
+  void DestroyGroupToken(void* group_token) {
+    GroupToken* token = static_cast<GroupToken*>(group_token);
+    delete token;
+  }
+
+  void ExecuteGroup(void* group_token) {
+    GroupToken* token = static_cast<GroupToken*>(group_token);
+    const std::vector<RequestId>& request_ids = token->request_ids;
+    if (request_ids.empty()) { return; }
+    // Entries take the requests of the next iteration once reset, so they are moved out here.
+    std::vector<std::shared_ptr<const RuntimeRequestInfo>> runtime_request_infos;
+    runtime_request_infos.reserve(request_ids.size());
+    request_store->ForEachMutRequestEntryForIdsInJob(
+        request_ids, [&](RequestEntry* request_entry, int32_t i, const RequestId& request_id) {
+          CHECK_EQ(request_entry->LocalRankCount(), 1);
+          runtime_request_infos.emplace_back(
+              std::move(request_entry->ResetRuntimeRequest().front()));
+        });
+    // The coordinator executes the groups in the same order on every rank, the channel keeps it.
+    std::shared_ptr<const CpuGroup> cpu_group = token->cpu_group;
+    task_channel.Send([this, cpu_group, runtime_request_infos]() {
+      if (runtime_request_infos.size() == 1) {
+        CHECK_JUST(LaunchCollective(*cpu_group, runtime_request_infos.front()->send_buff,
+                                    runtime_request_infos.front()->recv_buff,
+                                    cpu_group->elem_cnts.front()));
+      } else {
+        CHECK_JUST(LaunchFusedCollective(*cpu_group, runtime_request_infos, &fusion_buffer));
+      }
+      for (auto& runtime_request_info : runtime_request_infos) {
+        runtime_request_info->callback(Maybe<void>::Ok());
+      }
+    });
+  }
+
+  CollectiveBoxingConf conf;
+  int64_t fusion_threshold;
+  std::shared_ptr<RequestStore> request_store;
+  HashMap<DeviceSet, Symbol<ParallelDesc>> device_set2parallel_desc;
+  // Only touched by the worker thread.
+  std::vector<char> fusion_buffer;
+  Channel<std::function<void()>> task_channel;
+  std::thread worker;
+};
+
+CpuExecutorBackend::CpuExecutorBackend() = default;
+
+CpuExecutorBackend::~CpuExecutorBackend() = default;
+
+void CpuExecutorBackend::Init(std::shared_ptr<RequestStore> request_store) {
+  impl_ = std::make_unique<Impl>(Global<ResourceDesc, ForSession>::Get()->collective_boxing_conf(),
+                                 request_store);
+}
+
+void CpuExecutorBackend::InitJob(int64_t job_id) { impl_->InitParallelDesc(job_id); }
+
+void CpuExecutorBackend::DeinitJob(int64_t job_id) {}
+
+void CpuExecutorBackend::GroupRequests(
+    const std::vector<RequestId>& request_ids,
+    const std::function<void(std::vector<RequestId>&&, void*)>& Handler) {
+  impl_->GroupRequests(request_ids, Handler);
+}
+
+void* CpuExecutorBackend::CreateGroupToken(const std::vector<RequestId>& group) {
+  return impl_->CreateGroupToken(group);
+}
+
+void CpuExecutorBackend::DestroyGroupToken(void* group_token) {
+  return impl_->DestroyGroupToken(group_token);
+}
+
+void CpuExecutorBackend::ExecuteGroup(void* group_token) { impl_->ExecuteGroup(group_token); }
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
@@ -1060,6 +1060,80 @@ void AddDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
   }
 }
 
+void AddDiffCompression(JobPassCtx* ctx, const OpGraph& op_graph, JobBuilder* job_builder,
+                        HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
+  const JobConfigProto& job_conf = ctx->job_desc().job_conf();
+  if (!job_conf.has_gradient_compression_conf()) { return; }
+  const GradientCompressionConf& conf = job_conf.gradient_compression_conf();
+  const std::string& method = conf.method();
+  CHECK(method == "fp16" || method == "bf16" || method == "topk" || method == "onebit")
+      << "unknown gradient compression method " << method;
+  for (auto& pair : *lbi2diff_lbi) {
+    const LogicalBlobId& lbi = pair.first;
+    LogicalBlobId& diff_lbi = pair.second;
+    const OpNode* model_op_node = op_graph.OpNode4OpName(lbi.op_name());
+    const ParallelDesc& parallel_desc = model_op_node->parallel_desc();
+    // Only the gradients of data parallel models are summed up across ranks.
+    if (parallel_desc.parallel_num() <= 1 || parallel_desc.hierarchy()->NumAxes() != 1) {
+      continue;
+    }
+    if (!model_op_node->NdSbp4BnInOp("out").sbp_parallel(0).has_broadcast_parallel()) {
+      continue;
+    }
+    const BlobDesc& blob_desc = op_graph.GetLogicalBlobDesc(lbi);
+    if (blob_desc.data_type() != DataType::kFloat
+        || blob_desc.shape().elem_cnt() < conf.min_elem_cnt()) {
+      continue;
+    }
+    const int64_t scope_symbol_id = model_op_node->op().op_conf().scope_symbol_id();
+    const auto BuildParallelCast = [&](const std::string& in_lbn) {
+      return user_op::UserOpConfWrapperBuilder("System-AutoGrad-Compression-ParallelCast-"
+                                               + NewUniqueId())
+          .Op("hierarchical_parallel_cast")
+          .Input("in", in_lbn)
+          .Output("out")
+          .Attr<std::vector<std::string>>("nd_sbp", {"B"})
+          .Attr<std::string>("grad_mode", "auto")
+          .Attr<std::vector<std::string>>("grad_nd_sbp", std::vector<std::string>())
+          .ScopeSymbolId(scope_symbol_id)
+          .Build();
+    };
+    // The cast methods narrow the partial gradients, which are then summed up by an all-reduce
+    // in the narrow type since casting is linear. The payloads of the other methods are gathered
+    // and summed up by every rank.
+    const bool is_cast = method == "fp16" || method == "bf16";
+    // The CPU has no bfloat16 kernels.
+    CHECK(method != "bf16" || parallel_desc.device_type() == DeviceType::kCUDA)
+        << "bf16 gradient compression needs a cuda placement, use fp16 instead";
+    const auto compress_op =
+        user_op::UserOpConfWrapperBuilder("System-AutoGrad-Compression-Compress-" + NewUniqueId())
+            .Op("grad_compress")
+            .Input("in", GenLogicalBlobName(diff_lbi))
+            .Output("out")
+            .Attr<std::string>("method", method)
+            .Attr<float>("topk_ratio", conf.topk_ratio())
+            .Attr<bool>("error_feedback", !is_cast && conf.error_feedback())
+            .ScopeSymbolId(scope_symbol_id)
+            .Build();
+    const auto parallel_cast_op = BuildParallelCast(compress_op.output("out", 0));
+    const auto decompress_op =
+        user_op::UserOpConfWrapperBuilder("System-AutoGrad-Compression-Decompress-"
+                                          + NewUniqueId())
+            .Op("grad_decompress")
+            .Input("in", parallel_cast_op.output("out", 0))
+            .Output("out")
+            .Attr<std::string>("method", method)
+            .Attr<float>("topk_ratio", conf.topk_ratio())
+            .Attr<Shape>("shape", blob_desc.shape())
+            .ScopeSymbolId(scope_symbol_id)
+            .Build();
+    diff_lbi = GenLogicalBlobId(decompress_op.output("out", 0));
+    job_builder->AddOps(parallel_desc.parallel_conf(),
+                        {compress_op.op_conf(), parallel_cast_op.op_conf(),
+                         decompress_op.op_conf()});
+  }
+}
+
 void AddDiffStaticShapeCast(const OpGraph& op_graph, JobBuilder* job_builder,
                             HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi) {
   for (auto& pair : *lbi2diff_lbi) {
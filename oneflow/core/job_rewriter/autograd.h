@@ -33,6 +33,8 @@ void AddDiffParallelCast(const OpGraph& op_graph, JobBuilder* job_builder,
                          HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
 void AddDiffStaticShapeCast(const OpGraph& op_graph, JobBuilder* job_builder,
                             HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
+void AddDiffCompression(JobPassCtx* ctx, const OpGraph& op_graph, JobBuilder* job_builder,
+                        HashMap<LogicalBlobId, LogicalBlobId>* lbi2diff_lbi);
 Maybe<void> CountNotFiniteIfNeeded(JobPassCtx* ctx, const OpGraph& op_graph,
                                    JobBuilder* job_builder,
                                    const HashMap<LogicalBlobId, LogicalBlobId>& lbi2diff_lbi);
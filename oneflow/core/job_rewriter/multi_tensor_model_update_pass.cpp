@@ -0,0 +1,173 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// A multi tensor update op waits for the diffs of all of its models, so do not let it grow
+// without bound.
+constexpr size_t kMaxNumModelsPerOp = 64;
+
+// The args holding one tensor per model, max_v is left out since amsgrad is not supported.
+const HashSet<std::string>& ModelArgNames() {
+  static const HashSet<std::string> arg_names{"model", "model_diff", "momentum", "m",
+                                              "v",     "beta1_t",    "beta2_t"};
+  return arg_names;
+}
+
+bool IsSupportedUpdateOp(const user_op::UserOpConfWrapper& conf) {
+  const std::string& op_type_name = conf.op_type_name();
+  if (op_type_name == "adam_update") { return !conf.attr<bool>("amsgrad"); }
+  return op_type_name == "sgd_update" || op_type_name == "momentum_update"
+         || op_type_name == "lamb_update";
+}
+
+// Models split along axis 0 are only grouped with each other, and lamb needs the whole models.
+std::string GetSbpKey(const OpNode* op_node, const user_op::UserOpConfWrapper& conf) {
+  if (op_node->parallel_desc().hierarchy()->NumAxes() != 1) { return std::string(); }
+  std::string key;
+  for (const auto& pair : conf.op_conf().user_conf().input()) {
+    if (ModelArgNames().count(pair.first) == 0) { continue; }
+    const cfg::SbpParallel& sbp = op_node->SbpParallel4BnInOp(GenRepeatedBn(pair.first, 0));
+    std::string sbp_key;
+    if (sbp.has_broadcast_parallel()) {
+      sbp_key = "B";
+    } else if (sbp.has_split_parallel() && sbp.split_parallel().axis() == 0
+               && conf.op_type_name() != "lamb_update") {
+      sbp_key = "S0";
+    } else {
+      return std::string();
+    }
+    if (!key.empty() && key != sbp_key) { return std::string(); }
+    key = sbp_key;
+  }
+  return key;
+}
+
+std::string GetGroupKey(const OpNode* op_node, const user_op::UserOpConfWrapper& conf) {
+  const std::string sbp_key = GetSbpKey(op_node, conf);
+  if (sbp_key.empty()) { return std::string(); }
+  std::string key = conf.op_type_name() + "\n" + sbp_key + "\n"
+                    + std::to_string(conf.op_conf().scope_symbol_id()) + "\n"
+                    + PbMessage2TxtString(op_node->parallel_desc().parallel_conf()) + "\n";
+  const auto& model = op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conf.input("model", 0)));
+  const auto& model_diff =
+      op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conf.input("model_diff", 0)));
+  key += DataType_Name(model.data_type()) + "\n" + DataType_Name(model_diff.data_type()) + "\n";
+  // Scalar inputs like learning_rate and skip_if, which the grouped ops have to share.
+  for (const auto& pair : conf.op_conf().user_conf().input()) {
+    if (ModelArgNames().count(pair.first) > 0 || pair.first == "max_v") { continue; }
+    key += pair.first + ":" + pair.second.s(0) + "\n";
+  }
+  std::map<std::string, std::string> attrs;
+  for (const auto& pair : conf.op_conf().user_conf().attr()) {
+    attrs.emplace(pair.first, PbMessage2TxtString(pair.second));
+  }
+  for (const auto& pair : attrs) { key += pair.first + ":" + pair.second + "\n"; }
+  return key;
+}
+
+OperatorConf GenMultiTensorUpdateOpConf(const std::vector<const OpNode*>& op_nodes) {
+  const OperatorConf& first_op_conf = op_nodes.front()->op().op_conf();
+  OperatorConf op_conf;
+  op_conf.set_name("System-MultiTensorModelUpdate-" + first_op_conf.name());
+  op_conf.set_scope_symbol_id(first_op_conf.scope_symbol_id());
+  UserOpConf* user_conf = op_conf.mutable_user_conf();
+  user_conf->set_op_type_name("multi_tensor_" + first_op_conf.user_conf().op_type_name());
+  for (const auto& pair : first_op_conf.user_conf().input()) {
+    if (pair.first == "max_v") { continue; }
+    auto* lbns = &(*user_conf->mutable_input())[pair.first];
+    if (ModelArgNames().count(pair.first) == 0) {
+      *lbns = pair.second;
+      continue;
+    }
+    for (const OpNode* op_node : op_nodes) {
+      *lbns->mutable_s()->Add() = op_node->op().op_conf().user_conf().input().at(pair.first).s(0);
+    }
+  }
+  for (const auto& pair : first_op_conf.user_conf().attr()) {
+    if (pair.first == "amsgrad") { continue; }
+    (*user_conf->mutable_attr())[pair.first] = pair.second;
+  }
+  return op_conf;
+}
+
+class MultiTensorModelUpdatePass final : public JobPass {
+ public:
+  MultiTensorModelUpdatePass() = default;
+  ~MultiTensorModelUpdatePass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_multi_tensor_model_update();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> MultiTensorModelUpdatePass::Apply(const OpGraph& op_graph,
+                                              JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  std::vector<std::string> group_keys;
+  HashMap<std::string, std::vector<const OpNode*>> group_key2op_nodes;
+  op_graph.TopoForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    const user_op::UserOpConfWrapper conf(op_conf);
+    if (!IsSupportedUpdateOp(conf)) { return; }
+    if (!op_conf.ctrl_in_op_name().empty() || ctrl_in_op_names.count(op_conf.name()) > 0) {
+      return;
+    }
+    const std::string key = GetGroupKey(op_node, conf);
+    if (key.empty()) { return; }
+    auto* op_nodes = &group_key2op_nodes[key];
+    if (op_nodes->empty()) { group_keys.push_back(key); }
+    op_nodes->push_back(op_node);
+  });
+  std::vector<std::string> del_op_names;
+  for (const std::string& key : group_keys) {
+    const std::vector<const OpNode*>& op_nodes = group_key2op_nodes.at(key);
+    for (size_t begin = 0; begin < op_nodes.size(); begin += kMaxNumModelsPerOp) {
+      const size_t end = std::min(begin + kMaxNumModelsPerOp, op_nodes.size());
+      if (end - begin < 2) { continue; }
+      const std::vector<const OpNode*> group(op_nodes.begin() + begin, op_nodes.begin() + end);
+      for (const OpNode* op_node : group) { del_op_names.push_back(op_node->op().op_name()); }
+      job_builder->AddOps(group.front()->parallel_desc().parallel_conf(),
+                          {GenMultiTensorUpdateOpConf(group)});
+    }
+  }
+  job_builder->DelOps(del_op_names);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("MultiTensorModelUpdatePass", MultiTensorModelUpdatePass);
+
+}  // namespace oneflow
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/job_rewriter/job_pass.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job/job_desc.h"
@@ -76,7 +77,9 @@ Maybe<void> GetDataParallelVariableAndNaiveSuccNode(
   // Find sequence like: vairable -> cast_fp32_to_fp16
   if (!start->op().op_conf().has_variable_conf()) { return Maybe<void>::Ok(); }
   const ParallelDesc& pd = start->parallel_desc();
-  if (pd.device_type() != DeviceType::kCUDA) { return Maybe<void>::Ok(); }
+  if (pd.device_type() != DeviceType::kCUDA && pd.device_type() != DeviceType::kCPU) {
+    return Maybe<void>::Ok();
+  }
   if (pd.parallel_num() == 1) { return Maybe<void>::Ok(); }
   const OpNode* cur_node = start;
   while (cur_node != nullptr) {
@@ -222,6 +225,53 @@ void ForEachModelSizeBalancedPartition(
   }
 }
 
+// Number of model sized states the optimizer of the variable keeps, which are created later by
+// GenerateBackwardAndOptimizerOpConfs from the variable op conf and thus follow its placement.
+int64_t NumOptimizerStates(const OptimizerConf& optimizer_conf) {
+  switch (optimizer_conf.normal_mdupdt_case()) {
+    case OptimizerConf::kMomentumConf: return 1;
+    case OptimizerConf::kRmspropConf: return optimizer_conf.rmsprop_conf().centered() ? 2 : 1;
+    case OptimizerConf::kLarsConf: return 1;
+    case OptimizerConf::kAdamConf: return optimizer_conf.adam_conf().amsgrad() ? 3 : 2;
+    case OptimizerConf::kLazyAdamConf: return 2;
+    case OptimizerConf::kLambConf: return 2;
+    case OptimizerConf::kAdagradConf: return 1;
+    default: return 0;
+  }
+}
+
+// Bytes of the variable of the sequence and of the optimizer states of it.
+std::function<int64_t(const SequencePtr&)> MakeGetterStateBytes4Sequence(const Job& job) {
+  HashMap<std::string, int64_t> var_op_name2num_states;
+  for (const auto& optimizer_conf : job.job_conf().train_conf().optimizer_conf()) {
+    for (const auto& var_op_name : optimizer_conf.variable_op_names()) {
+      var_op_name2num_states[var_op_name] = NumOptimizerStates(optimizer_conf);
+    }
+  }
+  return [var_op_name2num_states](const SequencePtr& sequence) {
+    const auto it = var_op_name2num_states.find(sequence->GetVariableNode()->op().op_name());
+    const int64_t num_states = it == var_op_name2num_states.end() ? 0 : it->second;
+    return sequence->model_size() * (1 + num_states);
+  };
+}
+
+// Logs the bytes each rank keeps and records them in the helper of the job for inspection.
+void ReportMemorySavings(const std::string& mode, const ParallelDesc& parallel_desc,
+                         int64_t total_bytes, const std::vector<int64_t>& parallel_id2bytes,
+                         JobBuilder* builder) {
+  auto* rank2bytes = builder->mutable_helper()->mutable_rank2optimizer_state_bytes();
+  for (int64_t i = 0; i < parallel_desc.parallel_num(); ++i) {
+    const int64_t rank = CHECK_JUST(parallel_desc.MachineId4ParallelId(i));
+    (*rank2bytes)[rank] += parallel_id2bytes.at(i);
+    LOG(INFO) << "OptimizerPlacementOptimizationPass(" << mode << ") rank " << rank << " device "
+              << CHECK_JUST(parallel_desc.DeviceId4ParallelId(i)) << " of "
+              << *CHECK_JUST(DeviceTag4DeviceType(parallel_desc.device_type()))
+              << " placement: " << parallel_id2bytes.at(i) << " bytes of parameters and optimizer "
+              << "states instead of " << total_bytes << ", saved "
+              << total_bytes - parallel_id2bytes.at(i) << " bytes";
+  }
+}
+
 Maybe<void> RewriteDistributedSplit(const OpGraph& op_graph, JobBuilder* builder) {
   const int64_t threshold = builder->job().job_conf().optimizer_placement_optimization_threshold();
   const auto IsAllowed = [threshold](const OpNode* n) -> bool {
@@ -234,8 +284,11 @@ Maybe<void> RewriteDistributedSplit(const OpGraph& op_graph, JobBuilder* builder
       return IsS0SignatureSupported(n);
     }
   };
+  const auto StateBytes4Sequence = MakeGetterStateBytes4Sequence(builder->job());
   const auto PlacementSequencesAsSplitParallel = [&](const ParallelDesc& pd,
                                                      std::vector<SequencePtr>&& sorted_sequences) {
+    int64_t total_bytes = 0;
+    std::vector<int64_t> parallel_id2bytes(pd.parallel_num(), 0);
     // For all sorted sequnence, set the variable op in the sequence to S(0)
     // and add ctrl edge to control the exectuion order between variable ops.
     // A sequence is a variable op and its cast(fp32 to fp16) op. This is because the forward pass
@@ -253,8 +306,20 @@ Maybe<void> RewriteDistributedSplit(const OpGraph& op_graph, JobBuilder* builder
       }
       builder->MutOpsOnlyOnce({new_var_op_conf});
       // Set consumers to consum this variable op's cast op's output as Broadcast.
+      // The consumers all-gather the updated parameter in the forward pass, and the gradient is
+      // reduce-scattered to the S(0) model update op in the backward pass.
       SetBroadcastParallel4Consumers(builder, sorted_sequences.at(i));
+      // Each rank keeps its BalancedSplitter share of the rows of the variable and of its states.
+      const int64_t bytes = StateBytes4Sequence(sorted_sequences.at(i));
+      const int64_t num_rows = new_var_op_conf.variable_conf().shape().dim(0);
+      const BalancedSplitter row_splitter(num_rows, pd.parallel_num());
+      for (int64_t parallel_id = 0; parallel_id < pd.parallel_num(); ++parallel_id) {
+        parallel_id2bytes.at(parallel_id) +=
+            num_rows == 0 ? 0 : bytes / num_rows * row_splitter.At(parallel_id).size();
+      }
+      total_bytes += bytes;
     }
+    ReportMemorySavings("distributed_split", pd, total_bytes, parallel_id2bytes, builder);
   };
   ForEachParallelSortedNodeSequence(op_graph, IsAllowed, SequenceCompSortedByOrderAsc,
                                     PlacementSequencesAsSplitParallel);
@@ -263,6 +328,7 @@ Maybe<void> RewriteDistributedSplit(const OpGraph& op_graph, JobBuilder* builder
 
 Maybe<void> RewriteNonDistributed(const OpGraph& op_graph, JobBuilder* builder) {
   HashMap<ParallelDesc, std::vector<SequencePtr>> new_parallel_desc2sequences;
+  const auto StateBytes4Sequence = MakeGetterStateBytes4Sequence(builder->job());
   const auto RewritePartition = [&](const ParallelDesc& new_parallel_desc,
                                     std::vector<SequencePtr>&& partition) {
     for (auto& sequence : partition) {
@@ -276,7 +342,18 @@ Maybe<void> RewriteNonDistributed(const OpGraph& op_graph, JobBuilder* builder)
   };
   const auto RewriteSequences = [&](const ParallelDesc& pd,
                                     std::vector<SequencePtr>&& sorted_sequences) {
-    ForEachModelSizeBalancedPartition(pd, std::move(sorted_sequences), RewritePartition);
+    int64_t total_bytes = 0;
+    std::vector<int64_t> parallel_id2bytes;
+    for (const auto& sequence : sorted_sequences) { total_bytes += StateBytes4Sequence(sequence); }
+    ForEachModelSizeBalancedPartition(
+        pd, std::move(sorted_sequences),
+        [&](const ParallelDesc& new_parallel_desc, std::vector<SequencePtr>&& partition) {
+          int64_t bytes = 0;
+          for (const auto& sequence : partition) { bytes += StateBytes4Sequence(sequence); }
+          parallel_id2bytes.emplace_back(bytes);
+          RewritePartition(new_parallel_desc, std::move(partition));
+        });
+    ReportMemorySavings("non_distributed", pd, total_bytes, parallel_id2bytes, builder);
   };
   const int64_t threshold = builder->job().job_conf().optimizer_placement_optimization_threshold();
   const auto IsAllowed = [threshold](const OpNode* n) -> bool {
@@ -297,7 +374,7 @@ Maybe<void> RewriteNonDistributed(const OpGraph& op_graph, JobBuilder* builder)
     for (int64_t i = 1; i < sequences.size(); ++i) {
       const OpNode* cur_var_node = sequences.at(i)->GetVariableNode();
       OperatorConf cur_var_conf(cur_var_node->op().op_conf());
-      const OpNode* prev_var_node = sequences.at(i - i)->GetVariableNode();
+      const OpNode* prev_var_node = sequences.at(i - 1)->GetVariableNode();
       cur_var_conf.add_ctrl_in_op_name(prev_var_node->op().op_name());
       builder->MutOpsOnlyOnce({cur_var_conf});
     }
@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/profiler/profiler.h"
 #include "oneflow/user/image/random_crop_generator.h"
+#include "oneflow/user/image/jpeg_decoder.h"
 #include <opencv2/opencv.hpp>
 
 #ifdef WITH_CUDA
@@ -144,6 +145,9 @@ class CpuDecodeHandle final : public DecodeHandle {
   void Synchronize() override {
     // do nothing
   }
+
+ private:
+  TensorBuffer jpeg_image_;
 };
 
 void CpuDecodeHandle::DecodeRandomCropResize(const unsigned char* data, size_t length,
@@ -151,13 +155,40 @@ void CpuDecodeHandle::DecodeRandomCropResize(const unsigned char* data, size_t l
                                              unsigned char* workspace, size_t workspace_size,
                                              unsigned char* dst, int target_width,
                                              int target_height) {
+  int width = 0;
+  int height = 0;
+  // The crop window drawn from the header size is kept for the OpenCV path in case libjpeg-turbo
+  // fails on the data, so that both paths use the same crop and draw once from the generator.
+  CropWindow crop;
+  bool has_crop = false;
+  if (JpegDecodeEnabled() && JpegGetImageSize(data, length, &width, &height)) {
+    // Only the crop is decoded, at the smallest DCT scale that is still no smaller than the
+    // target, and straight to RGB.
+    if (crop_generator) {
+      crop_generator->GenerateCropWindow({height, width}, &crop);
+      has_crop = true;
+    }
+    if (JpegDecode(data, length, "RGB", has_crop ? &crop : nullptr, target_width, target_height,
+                   &jpeg_image_)) {
+      cv::Mat image(jpeg_image_.shape().At(0), jpeg_image_.shape().At(1), CV_8UC3,
+                    jpeg_image_.mut_data<unsigned char>(), cv::Mat::AUTO_STEP);
+      cv::Mat dst_mat(target_height, target_width, CV_8UC3, dst, cv::Mat::AUTO_STEP);
+      cv::resize(image, dst_mat, cv::Size(target_width, target_height), 0, 0, cv::INTER_LINEAR);
+      return;
+    }
+  }
   cv::Mat image =
       cv::imdecode(cv::Mat(1, length, CV_8UC1, const_cast<unsigned char*>(data)), cv::IMREAD_COLOR);
   cv::Mat cropped;
   if (crop_generator) {
     cv::Rect roi;
-    GenerateRandomCropRoi(crop_generator, image.cols, image.rows, &roi.x, &roi.y, &roi.width,
-                          &roi.height);
+    // OpenCV applies the EXIF orientation, a rotated image needs a window of its own.
+    if (has_crop && image.cols == width && image.rows == height) {
+      roi = cv::Rect(crop.anchor.At(1), crop.anchor.At(0), crop.shape.At(1), crop.shape.At(0));
+    } else {
+      GenerateRandomCropRoi(crop_generator, image.cols, image.rows, &roi.x, &roi.y, &roi.width,
+                            &roi.height);
+    }
     image(roi).copyTo(cropped);
   } else {
     cropped = image;
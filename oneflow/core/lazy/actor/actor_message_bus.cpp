@@ -21,6 +21,9 @@ limitations under the License.
 
 namespace oneflow {
 
+ActorMsgBus::ActorMsgBus()
+    : dst_machine_id2comm_net_sequence_shard_(GlobalProcessCtx::WorldSize()) {}
+
 void ActorMsgBus::SendMsg(const ActorMsg& msg) {
   int64_t dst_machine_id = MachineId4ActorId(msg.dst_actor_id());
   if (dst_machine_id == GlobalProcessCtx::Rank()) {
@@ -29,11 +32,11 @@ void ActorMsgBus::SendMsg(const ActorMsg& msg) {
     if (msg.IsDataRegstMsgToConsumer()) {
       int64_t comm_net_sequence;
       {
-        std::unique_lock<std::mutex> lock(
-            regst_desc_id_dst_actor_id2comm_net_sequence_number_mutex_);
+        CommNetSequenceShard& shard = dst_machine_id2comm_net_sequence_shard_.at(dst_machine_id);
+        std::unique_lock<std::mutex> lock(shard.mutex);
         int64_t& comm_net_sequence_ref =
-            regst_desc_id_dst_actor_id2comm_net_sequence_number_[std::make_pair(
-                msg.regst_desc_id(), msg.dst_actor_id())];
+            shard.regst_desc_id_dst_actor_id2sequence_number[std::make_pair(msg.regst_desc_id(),
+                                                                            msg.dst_actor_id())];
         comm_net_sequence = comm_net_sequence_ref;
         comm_net_sequence_ref += 1;
       }
@@ -31,10 +31,15 @@ class ActorMsgBus final {
 
  private:
   friend class Global<ActorMsgBus>;
-  ActorMsgBus() = default;
-  HashMap<std::pair<int64_t, int64_t>, int64_t>
-      regst_desc_id_dst_actor_id2comm_net_sequence_number_;
-  std::mutex regst_desc_id_dst_actor_id2comm_net_sequence_number_mutex_;
+  ActorMsgBus();
+
+  // The comm net sequence numbers of the data messages to one machine, so that senders to
+  // different machines do not contend for the same lock.
+  struct CommNetSequenceShard {
+    std::mutex mutex;
+    HashMap<std::pair<int64_t, int64_t>, int64_t> regst_desc_id_dst_actor_id2sequence_number;
+  };
+  std::vector<CommNetSequenceShard> dst_machine_id2comm_net_sequence_shard_;
 };
 
 }  // namespace oneflow
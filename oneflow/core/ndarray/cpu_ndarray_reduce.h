@@ -0,0 +1,377 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_NDARRAY_CPU_NDARRAY_REDUCE_H_
+#define ONEFLOW_CORE_NDARRAY_CPU_NDARRAY_REDUCE_H_
+
+#include <cmath>
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace cpu_ndarray_reduce {
+
+// Reductions with fewer elements than this stay on the calling thread.
+constexpr int64_t kMinParallelElemCnt = 32768;
+// Contiguous floating point sums are split in halves down to blocks of this size, so the rounding
+// error grows with log(n) instead of n.
+constexpr int64_t kPairwiseBlockSize = 512;
+// Number of columns a strided reduction accumulates at once, the accumulators stay in L1.
+constexpr int64_t kColBlockSize = 256;
+
+template<typename T>
+struct AccType {
+  using type = T;
+};
+
+template<>
+struct AccType<float16> {
+  using type = float;
+};
+
+template<typename AccT, template<typename> class binary_func>
+struct IsFloatingSum
+    : std::integral_constant<bool,
+                             std::is_floating_point<AccT>::value
+                                 && std::is_same<binary_func<AccT>, BinaryFuncSum<AccT>>::value> {};
+
+// Horizontal reduction of n contiguous elements. Independent lanes let the compiler keep the
+// partial results in vector registers, the lanes are folded pairwise at the end.
+template<typename T, template<typename> class binary_func>
+ALWAYS_INLINE inline typename AccType<T>::type ReduceContiguousImpl(const T* x, int64_t n) {
+  using AccT = typename AccType<T>::type;
+  constexpr int64_t kNumLanes = 16;
+  AccT lanes[kNumLanes];
+  std::fill(lanes, lanes + kNumLanes, UnitOfBinaryFunc<AccT, binary_func>::Val());
+  int64_t i = 0;
+  for (; i + kNumLanes <= n; i += kNumLanes) {
+    for (int64_t j = 0; j < kNumLanes; ++j) {
+      lanes[j] = binary_func<AccT>::Invoke(lanes[j], static_cast<AccT>(x[i + j]));
+    }
+  }
+  for (int64_t j = 0; i < n; ++i, ++j) {
+    lanes[j] = binary_func<AccT>::Invoke(lanes[j], static_cast<AccT>(x[i]));
+  }
+  for (int64_t width = kNumLanes / 2; width > 0; width /= 2) {
+    for (int64_t j = 0; j < width; ++j) {
+      lanes[j] = binary_func<AccT>::Invoke(lanes[j], lanes[j + width]);
+    }
+  }
+  return lanes[0];
+}
+
+// acc[j] = reduce of x[r * row_stride + j] over r < num_rows, for every j < width.
+template<typename T, template<typename> class binary_func>
+ALWAYS_INLINE inline void ReduceColumnsImpl(const T* x, int64_t num_rows, int64_t row_stride,
+                                            int64_t width, typename AccType<T>::type* acc,
+                                            std::false_type /*compensated*/) {
+  using AccT = typename AccType<T>::type;
+  std::fill(acc, acc + width, UnitOfBinaryFunc<AccT, binary_func>::Val());
+  for (int64_t r = 0; r < num_rows; ++r) {
+    const T* row = x + r * row_stride;
+    for (int64_t j = 0; j < width; ++j) {
+      acc[j] = binary_func<AccT>::Invoke(acc[j], static_cast<AccT>(row[j]));
+    }
+  }
+}
+
+// Kahan summation per column. Compensation turns an infinite partial sum into nan, so the plain
+// sum is kept as well and wins whenever it is not finite.
+template<typename T, template<typename> class binary_func>
+ALWAYS_INLINE inline void ReduceColumnsImpl(const T* x, int64_t num_rows, int64_t row_stride,
+                                            int64_t width, typename AccType<T>::type* acc,
+                                            std::true_type /*compensated*/) {
+  using AccT = typename AccType<T>::type;
+  AccT plain[kColBlockSize];
+  AccT comp[kColBlockSize];
+  std::fill(acc, acc + width, static_cast<AccT>(0));
+  std::fill(plain, plain + width, static_cast<AccT>(0));
+  std::fill(comp, comp + width, static_cast<AccT>(0));
+  for (int64_t r = 0; r < num_rows; ++r) {
+    const T* row = x + r * row_stride;
+    for (int64_t j = 0; j < width; ++j) {
+      const AccT val = static_cast<AccT>(row[j]);
+      const AccT compensated = val - comp[j];
+      const AccT sum = acc[j] + compensated;
+      comp[j] = (sum - acc[j]) - compensated;
+      acc[j] = sum;
+      plain[j] += val;
+    }
+  }
+  for (int64_t j = 0; j < width; ++j) {
+    if (!std::isfinite(plain[j])) { acc[j] = plain[j]; }
+  }
+}
+
+#if OF_CPU_SIMD_DISPATCH
+
+// Explicit float vector instructions for the reductions that map to a single instruction. Max and
+// min keep the `acc > x ? acc : x` semantics of the scalar functors.
+template<template<typename> class binary_func>
+struct FloatVecReduceOp {
+  static constexpr bool kSupported = false;
+};
+
+#define DEFINE_FLOAT_VEC_REDUCE_OP(binary_func, avx2_intrinsic, avx512_intrinsic)               \
+  template<>                                                                                    \
+  struct FloatVecReduceOp<binary_func> {                                                        \
+    static constexpr bool kSupported = true;                                                    \
+    OF_CPU_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return avx2_intrinsic(a, b); } \
+    OF_CPU_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) {                              \
+      return avx512_intrinsic(a, b);                                                            \
+    }                                                                                           \
+  };
+
+DEFINE_FLOAT_VEC_REDUCE_OP(BinaryFuncSum, _mm256_add_ps, _mm512_add_ps)
+DEFINE_FLOAT_VEC_REDUCE_OP(BinaryFuncMax, _mm256_max_ps, _mm512_max_ps)
+DEFINE_FLOAT_VEC_REDUCE_OP(BinaryFuncMin, _mm256_min_ps, _mm512_min_ps)
+
+#undef DEFINE_FLOAT_VEC_REDUCE_OP
+
+template<template<typename> class binary_func,
+         bool supported = FloatVecReduceOp<binary_func>::kSupported>
+struct FloatVecReduceLoop {
+  static bool Run(ep::CpuIsa isa, const float* x, int64_t n, float* out) { return false; }
+};
+
+template<template<typename> class binary_func>
+struct FloatVecReduceLoop<binary_func, true> {
+  using Op = FloatVecReduceOp<binary_func>;
+
+  OF_CPU_TARGET_AVX2 static float RunAvx2(const float* x, int64_t n) {
+    const float unit = UnitOfBinaryFunc<float, binary_func>::Val();
+    __m256 acc0 = _mm256_set1_ps(unit);
+    __m256 acc1 = acc0;
+    __m256 acc2 = acc0;
+    __m256 acc3 = acc0;
+    int64_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+      acc0 = Op::Apply(acc0, _mm256_loadu_ps(x + i));
+      acc1 = Op::Apply(acc1, _mm256_loadu_ps(x + i + 8));
+      acc2 = Op::Apply(acc2, _mm256_loadu_ps(x + i + 16));
+      acc3 = Op::Apply(acc3, _mm256_loadu_ps(x + i + 24));
+    }
+    for (; i + 8 <= n; i += 8) { acc0 = Op::Apply(acc0, _mm256_loadu_ps(x + i)); }
+    acc0 = Op::Apply(Op::Apply(acc0, acc1), Op::Apply(acc2, acc3));
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc0);
+    float acc = unit;
+    for (int64_t j = 0; j < 8; ++j) { acc = binary_func<float>::Invoke(acc, lanes[j]); }
+    for (; i < n; ++i) { acc = binary_func<float>::Invoke(acc, x[i]); }
+    return acc;
+  }
+
+  OF_CPU_TARGET_AVX512 static float RunAvx512(const float* x, int64_t n) {
+    const float unit = UnitOfBinaryFunc<float, binary_func>::Val();
+    const __m512 unit_vec = _mm512_set1_ps(unit);
+    __m512 acc0 = unit_vec;
+    __m512 acc1 = unit_vec;
+    __m512 acc2 = unit_vec;
+    __m512 acc3 = unit_vec;
+    int64_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+      acc0 = Op::Apply(acc0, _mm512_loadu_ps(x + i));
+      acc1 = Op::Apply(acc1, _mm512_loadu_ps(x + i + 16));
+      acc2 = Op::Apply(acc2, _mm512_loadu_ps(x + i + 32));
+      acc3 = Op::Apply(acc3, _mm512_loadu_ps(x + i + 48));
+    }
+    for (; i + 16 <= n; i += 16) { acc0 = Op::Apply(acc0, _mm512_loadu_ps(x + i)); }
+    if (i < n) {
+      // Masked tail, lanes past the end read the unit of the reduction.
+      const __mmask16 mask = static_cast<__mmask16>((1U << (n - i)) - 1);
+      acc1 = Op::Apply(acc1, _mm512_mask_loadu_ps(unit_vec, mask, x + i));
+    }
+    acc0 = Op::Apply(Op::Apply(acc0, acc1), Op::Apply(acc2, acc3));
+    float lanes[16];
+    _mm512_storeu_ps(lanes, acc0);
+    float acc = unit;
+    for (int64_t j = 0; j < 16; ++j) { acc = binary_func<float>::Invoke(acc, lanes[j]); }
+    return acc;
+  }
+
+  static bool Run(ep::CpuIsa isa, const float* x, int64_t n, float* out) {
+    if (isa == ep::CpuIsa::kAvx512) {
+      *out = RunAvx512(x, n);
+      return true;
+    } else if (isa == ep::CpuIsa::kAvx2) {
+      *out = RunAvx2(x, n);
+      return true;
+    } else {
+      return false;
+    }
+  }
+};
+
+template<template<typename> class binary_func, typename T>
+bool TryReduceExplicitSimd(ep::CpuIsa isa, const T* x, int64_t n,
+                           typename AccType<T>::type* out) {
+  return false;
+}
+
+template<template<typename> class binary_func>
+bool TryReduceExplicitSimd(ep::CpuIsa isa, const float* x, int64_t n, float* out) {
+  return FloatVecReduceLoop<binary_func>::Run(isa, x, n, out);
+}
+
+#endif  // OF_CPU_SIMD_DISPATCH
+
+// The loops are compiled once per instruction set and picked at runtime, so the compiler
+// vectorizes them for the widest registers the machine has.
+template<typename T, template<typename> class binary_func>
+struct ReduceLoop {
+  using AccT = typename AccType<T>::type;
+  using Compensated = IsFloatingSum<AccT, binary_func>;
+
+  static AccT ContiguousDefault(const T* x, int64_t n) {
+    return ReduceContiguousImpl<T, binary_func>(x, n);
+  }
+  static void ColumnsDefault(const T* x, int64_t num_rows, int64_t row_stride, int64_t width,
+                             AccT* acc) {
+    ReduceColumnsImpl<T, binary_func>(x, num_rows, row_stride, width, acc, Compensated());
+  }
+
+#if OF_CPU_SIMD_DISPATCH
+  OF_CPU_TARGET_AVX2 static AccT ContiguousAvx2(const T* x, int64_t n) {
+    return ReduceContiguousImpl<T, binary_func>(x, n);
+  }
+  OF_CPU_TARGET_AVX2 static void ColumnsAvx2(const T* x, int64_t num_rows, int64_t row_stride,
+                                             int64_t width, AccT* acc) {
+    ReduceColumnsImpl<T, binary_func>(x, num_rows, row_stride, width, acc, Compensated());
+  }
+
+  OF_CPU_TARGET_AVX512 static AccT ContiguousAvx512(const T* x, int64_t n) {
+    return ReduceContiguousImpl<T, binary_func>(x, n);
+  }
+  OF_CPU_TARGET_AVX512 static void ColumnsAvx512(const T* x, int64_t num_rows, int64_t row_stride,
+                                                 int64_t width, AccT* acc) {
+    ReduceColumnsImpl<T, binary_func>(x, num_rows, row_stride, width, acc, Compensated());
+  }
+#endif  // OF_CPU_SIMD_DISPATCH
+
+  static AccT Contiguous(ep::CpuIsa isa, const T* x, int64_t n) {
+#if OF_CPU_SIMD_DISPATCH
+    AccT acc;
+    if (TryReduceExplicitSimd<binary_func>(isa, x, n, &acc)) { return acc; }
+    if (isa == ep::CpuIsa::kAvx512) {
+      return ContiguousAvx512(x, n);
+    } else if (isa == ep::CpuIsa::kAvx2) {
+      return ContiguousAvx2(x, n);
+    }
+#endif  // OF_CPU_SIMD_DISPATCH
+    return ContiguousDefault(x, n);
+  }
+
+  static void Columns(ep::CpuIsa isa, const T* x, int64_t num_rows, int64_t row_stride,
+                      int64_t width, AccT* acc) {
+#if OF_CPU_SIMD_DISPATCH
+    if (isa == ep::CpuIsa::kAvx512) {
+      ColumnsAvx512(x, num_rows, row_stride, width, acc);
+      return;
+    } else if (isa == ep::CpuIsa::kAvx2) {
+      ColumnsAvx2(x, num_rows, row_stride, width, acc);
+      return;
+    }
+#endif  // OF_CPU_SIMD_DISPATCH
+    ColumnsDefault(x, num_rows, row_stride, width, acc);
+  }
+
+  // Pairwise for floating point sums, a single pass for everything else.
+  static AccT PairwiseContiguous(ep::CpuIsa isa, const T* x, int64_t n) {
+    if (Compensated::value && n > kPairwiseBlockSize) {
+      const int64_t half = RoundUp(n / 2, kPairwiseBlockSize);
+      return binary_func<AccT>::Invoke(PairwiseContiguous(isa, x, half),
+                                       PairwiseContiguous(isa, x + half, n - half));
+    }
+    return Contiguous(isa, x, n);
+  }
+};
+
+// Reduces the middle axis of x viewed as [outer_size, reduce_size, inner_size] into y viewed as
+// [outer_size, inner_size], the outer/reduce/inner layout GetReduceSumLayout classifies. Rows are
+// reduced horizontally when inner_size is 1, otherwise blocks of columns are accumulated row by
+// row. Work is split over outer rows and column blocks, or over the reduced axis when there are
+// fewer of those than threads.
+template<typename T, typename RetT, template<typename> class binary_func>
+void Reduce(const T* x, RetT* y, int64_t outer_size, int64_t reduce_size, int64_t inner_size) {
+  using AccT = typename AccType<T>::type;
+  using Loop = ReduceLoop<T, binary_func>;
+  const ep::CpuIsa isa = ep::GetCpuIsa();
+  const int64_t col_block_size = std::min(inner_size, kColBlockSize);
+  const int64_t num_col_blocks = (inner_size + col_block_size - 1) / col_block_size;
+  const int64_t num_tiles = outer_size * num_col_blocks;
+  const int64_t elem_cnt = outer_size * reduce_size * inner_size;
+  // Reduces rows [r_begin, r_end) of tiles [tile_begin, tile_end), then hands every tile to
+  // Write(offset in y, width, accumulators).
+  auto ReduceTiles = [&](int64_t tile_begin, int64_t tile_end, int64_t r_begin, int64_t r_end,
+                         const auto& Write) {
+    AccT acc[kColBlockSize];
+    FOR_RANGE(int64_t, tile, tile_begin, tile_end) {
+      const int64_t outer = tile / num_col_blocks;
+      const int64_t col_begin = (tile % num_col_blocks) * col_block_size;
+      const int64_t width = std::min(col_block_size, inner_size - col_begin);
+      const T* tile_x = x + (outer * reduce_size + r_begin) * inner_size + col_begin;
+      if (inner_size == 1) {
+        acc[0] = Loop::PairwiseContiguous(isa, tile_x, r_end - r_begin);
+      } else {
+        Loop::Columns(isa, tile_x, r_end - r_begin, inner_size, width, acc);
+      }
+      Write(outer * inner_size + col_begin, width, acc);
+    }
+  };
+  int64_t thread_num = 1;
+  if (elem_cnt >= kMinParallelElemCnt && Global<ThreadPool>::Get() != nullptr
+      && !pthread_fork::IsForkedSubProcess()) {
+    thread_num = std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                                  elem_cnt / kMinParallelElemCnt);
+  }
+  auto WriteToY = [&](int64_t offset, int64_t width, const AccT* acc) {
+    FOR_RANGE(int64_t, j, 0, width) { y[offset + j] = static_cast<RetT>(acc[j]); }
+  };
+  if (num_tiles >= thread_num || reduce_size < thread_num) {
+    MultiThreadRangeLoop(num_tiles, thread_num, [&](int64_t tile_begin, int64_t tile_end) {
+      ReduceTiles(tile_begin, tile_end, 0, reduce_size, WriteToY);
+    });
+    return;
+  }
+  // Too few outputs to keep every thread busy, each thread reduces a chunk of the reduced axis
+  // into its own partial results.
+  const int64_t y_elem_cnt = outer_size * inner_size;
+  std::vector<AccT> partials(thread_num * y_elem_cnt);
+  const BalancedSplitter bs(reduce_size, thread_num);
+  MultiThreadLoop(thread_num, [&](int64_t chunk) {
+    AccT* chunk_partials = partials.data() + chunk * y_elem_cnt;
+    ReduceTiles(0, num_tiles, bs.At(chunk).begin(), bs.At(chunk).end(),
+                [&](int64_t offset, int64_t width, const AccT* acc) {
+                  std::copy(acc, acc + width, chunk_partials + offset);
+                });
+  });
+  FOR_RANGE(int64_t, i, 0, y_elem_cnt) {
+    AccT acc = partials.at(i);
+    FOR_RANGE(int64_t, chunk, 1, thread_num) {
+      acc = binary_func<AccT>::Invoke(acc, partials.at(chunk * y_elem_cnt + i));
+    }
+    y[i] = static_cast<RetT>(acc);
+  }
+}
+
+}  // namespace cpu_ndarray_reduce
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_NDARRAY_CPU_NDARRAY_REDUCE_H_
@@ -0,0 +1,64 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <random>
+#include <gtest/gtest.h>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/core/ndarray/cpu_ndarray_reduce.h"
+
+namespace oneflow {
+namespace test {
+
+// Logs the time of the engine against the one element at a time loop of the generic ndarray path
+// for a few layouts.
+TEST(CpuNdarrayReduceBenchmark, reduce_sum) {
+  ThreadPoolGuard guard(HardwareThreadNum());
+  const std::vector<std::vector<int64_t>> layouts = {
+      {1, 1 << 24, 1}, {4096, 4096, 1}, {1, 4096, 4096}, {64, 512, 512}, {1, 1 << 22, 4}};
+  for (const auto& layout : layouts) {
+    const int64_t outer_size = layout.at(0);
+    const int64_t reduce_size = layout.at(1);
+    const int64_t inner_size = layout.at(2);
+    std::mt19937 gen(outer_size * reduce_size * inner_size);
+    std::uniform_real_distribution<float> dis(-4, 4);
+    std::vector<float> x(outer_size * reduce_size * inner_size);
+    for (float& val : x) { val = dis(gen); }
+    std::vector<float> y(outer_size * inner_size);
+    const double baseline_ms = ElapsedMs(
+        [&]() {
+          FOR_RANGE(int64_t, i, 0, outer_size) {
+            FOR_RANGE(int64_t, k, 0, inner_size) {
+              float sum = 0;
+              FOR_RANGE(int64_t, j, 0, reduce_size) {
+                sum += x[(i * reduce_size + j) * inner_size + k];
+              }
+              y[i * inner_size + k] = sum;
+            }
+          }
+        },
+        3);
+    const double engine_ms = ElapsedMs(
+        [&]() {
+          cpu_ndarray_reduce::Reduce<float, float, BinaryFuncSum>(
+              x.data(), y.data(), outer_size, reduce_size, inner_size);
+        },
+        3);
+    LOG(INFO) << "reduce_sum [" << outer_size << ", " << reduce_size << ", " << inner_size
+              << "]: scalar loop " << baseline_ms << "ms, engine " << engine_ms << "ms";
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,116 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/core/ndarray/cpu_ndarray_reduce.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+template<typename T>
+std::vector<T> RandomData(int64_t elem_cnt) {
+  std::mt19937 gen(elem_cnt);
+  std::uniform_int_distribution<int> dis(-4, 4);
+  std::vector<T> data(elem_cnt);
+  for (T& val : data) { val = static_cast<T>(dis(gen)); }
+  return data;
+}
+
+// Integer valued inputs keep every partial sum exact, so any summation order gives the same
+// result as the reference loop.
+template<typename T, typename RetT, template<typename> class binary_func>
+void TestReduce(int64_t outer_size, int64_t reduce_size, int64_t inner_size) {
+  const std::vector<T> x = RandomData<T>(outer_size * reduce_size * inner_size);
+  // Not a std::vector, which has no data() for bool.
+  std::unique_ptr<RetT[]> y(new RetT[outer_size * inner_size]);
+  cpu_ndarray_reduce::Reduce<T, RetT, binary_func>(x.data(), y.get(), outer_size, reduce_size,
+                                                   inner_size);
+  FOR_RANGE(int64_t, i, 0, outer_size) {
+    FOR_RANGE(int64_t, k, 0, inner_size) {
+      T expected = UnitOfBinaryFunc<T, binary_func>::Val();
+      FOR_RANGE(int64_t, j, 0, reduce_size) {
+        expected = binary_func<T>::Invoke(expected, x[(i * reduce_size + j) * inner_size + k]);
+      }
+      ASSERT_EQ(y[i * inner_size + k], static_cast<RetT>(expected));
+    }
+  }
+}
+
+template<typename T, typename RetT, template<typename> class binary_func>
+void TestReduceAllLayouts() {
+  // Scalar.
+  TestReduce<T, RetT, binary_func>(1, 1000003, 1);
+  // Rows, contiguous.
+  TestReduce<T, RetT, binary_func>(300, 17, 1);
+  TestReduce<T, RetT, binary_func>(3, 100000, 1);
+  // Columns, strided.
+  TestReduce<T, RetT, binary_func>(1, 1000, 300);
+  TestReduce<T, RetT, binary_func>(1, 100000, 3);
+  // Middle axis.
+  TestReduce<T, RetT, binary_func>(7, 33, 513);
+  TestReduce<T, RetT, binary_func>(2, 50000, 2);
+}
+
+}  // namespace
+
+TEST(CpuNdarrayReduce, reduce) {
+  ThreadPoolGuard guard(4);
+  TestReduceAllLayouts<float, float, BinaryFuncSum>();
+  TestReduceAllLayouts<float, float, BinaryFuncMax>();
+  TestReduceAllLayouts<float, float, BinaryFuncMin>();
+  TestReduceAllLayouts<double, double, BinaryFuncSum>();
+  TestReduceAllLayouts<int32_t, int32_t, BinaryFuncSum>();
+  TestReduceAllLayouts<int64_t, int64_t, BinaryFuncMax>();
+  TestReduceAllLayouts<int8_t, int8_t, BinaryFuncMin>();
+  TestReduceAllLayouts<int32_t, bool, BinaryFuncAny>();
+  TestReduceAllLayouts<float, bool, BinaryFuncAll>();
+  TestReduce<float, float, BinaryFuncProd>(64, 20, 1);
+  TestReduce<float, float, BinaryFuncProd>(1, 20, 64);
+}
+
+TEST(CpuNdarrayReduce, sum_accuracy) {
+  ThreadPoolGuard guard(4);
+  const int64_t reduce_size = 1 << 22;
+  std::vector<float> x(reduce_size * 2);
+  FOR_RANGE(int64_t, i, 0, reduce_size * 2) { x[i] = 0.1f; }
+  const double expected = static_cast<double>(0.1f) * reduce_size;
+  // A naive float loop drifts by several percent after this many additions.
+  float row_sum[2];
+  cpu_ndarray_reduce::Reduce<float, float, BinaryFuncSum>(x.data(), row_sum, 2, reduce_size, 1);
+  float col_sum[2];
+  cpu_ndarray_reduce::Reduce<float, float, BinaryFuncSum>(x.data(), col_sum, 1, reduce_size, 2);
+  FOR_RANGE(int, i, 0, 2) {
+    ASSERT_NEAR(row_sum[i], expected, expected * 1e-6);
+    ASSERT_NEAR(col_sum[i], expected, expected * 1e-6);
+  }
+}
+
+TEST(CpuNdarrayReduce, sum_non_finite) {
+  std::vector<float> x(1000 * 3, 1.0f);
+  x[3 * 10 + 0] = std::numeric_limits<float>::infinity();
+  x[3 * 20 + 1] = std::numeric_limits<float>::quiet_NaN();
+  x[3 * 30 + 2] = std::numeric_limits<float>::infinity();
+  x[3 * 40 + 2] = -std::numeric_limits<float>::infinity();
+  float y[3];
+  cpu_ndarray_reduce::Reduce<float, float, BinaryFuncSum>(x.data(), y, 1, 1000, 3);
+  ASSERT_EQ(y[0], std::numeric_limits<float>::infinity());
+  ASSERT_TRUE(std::isnan(y[1]));
+  ASSERT_TRUE(std::isnan(y[2]));
+}
+
+}  // namespace test
+}  // namespace oneflow
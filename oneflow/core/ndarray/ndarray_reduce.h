@@ -52,6 +52,8 @@ struct NdarrayReduce<
       NdarrayMatrixColReduce<device_type, T, binary_func>::Reduce(stream, y, x, tmp_storage);
     } else if (NdarrayXYZCubeXZReduce<device_type, T, binary_func>::Matched(y, x)) {
       NdarrayXYZCubeXZReduce<device_type, T, binary_func>::Reduce(stream, y, x, tmp_storage);
+    } else if (NdarrayXYZCubeYReduce<device_type, T, binary_func>::Matched(y, x)) {
+      NdarrayXYZCubeYReduce<device_type, T, binary_func>::Reduce(stream, y, x, tmp_storage);
     } else {
       NdarrayDefaultReduce<device_type, T, binary_func>::Reduce(stream, y, x, tmp_storage);
     }
@@ -39,6 +39,7 @@ DECLARE_NDARRAY_REDUCE_IMPL(NdarrayScalarReduce);
 DECLARE_NDARRAY_REDUCE_IMPL(NdarrayMatrixRowReduce);
 DECLARE_NDARRAY_REDUCE_IMPL(NdarrayMatrixColReduce);
 DECLARE_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeXZReduce);
+DECLARE_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeYReduce);
 #undef DECLARE_NDARRAY_REDUCE_IMPL
 
 template<DeviceType device_type, typename T, template<typename> class binary_func,
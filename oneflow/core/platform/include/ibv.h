@@ -49,8 +49,14 @@ extern "C" typedef struct IBV {
   struct ibv_mr* (*ibv_reg_mr_wrap)(struct ibv_pd* pd, void* addr, size_t length, int access);
   int (*ibv_query_port_wrap)(struct ibv_context* context, uint8_t port_num,
                              struct ibv_port_attr* port_attr);
+  // ibv_query_gid_type is declared in infiniband/driver.h instead of verbs.h, type is set to
+  // kIBVGidTypeRoCEv2 for RoCE v2 GIDs. It fails with ENOSYS if libibverbs does not have it.
+  int (*ibv_query_gid_type_wrap)(struct ibv_context* context, uint8_t port_num, unsigned int index,
+                                 int* type);
 } IBV;
 
+constexpr int kIBVGidTypeRoCEv2 = 1;
+
 bool IsAvailable();
 
 extern IBV wrapper;
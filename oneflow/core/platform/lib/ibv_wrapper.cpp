@@ -15,6 +15,7 @@ limitations under the License.
 */
 #if defined(WITH_RDMA)
 #include "oneflow/core/platform/include/ibv.h"
+#include <cerrno>
 
 namespace oneflow {
 
@@ -77,6 +78,19 @@ int ibv_query_port_wrap(struct ibv_context* context, uint8_t port_num,
   return LoadSymbol("ibv_query_port", &wrapper.ibv_query_port_wrap)(context, port_num, port_attr);
 }
 
+int ibv_query_gid_type_wrap(struct ibv_context* context, uint8_t port_num, unsigned int index,
+                            int* type) {
+  // Only in newer libibverbs, so a missing symbol is not fatal.
+  auto fn = reinterpret_cast<decltype(wrapper.ibv_query_gid_type_wrap)>(
+      GetIBVLibrary().LoadSym("ibv_query_gid_type"));
+  if (!fn) {
+    errno = ENOSYS;
+    return -1;
+  }
+  wrapper.ibv_query_gid_type_wrap = fn;
+  return fn(context, port_num, index, type);
+}
+
 struct ibv_context* ibv_open_device(struct ibv_device* device) {
   return LoadSymbol(__func__, &wrapper.ibv_open_device)(device);
 }
@@ -124,7 +138,7 @@ IBV wrapper = {
     IBV_APIS(_REFERENCE_MEMBER)
 #undef _REFERENCE_MEMBER
         _stubs::ibv_reg_mr_wrap,
-    _stubs::ibv_query_port_wrap};
+    _stubs::ibv_query_port_wrap, _stubs::ibv_query_gid_type_wrap};
 
 }  // namespace ibv
 }  // namespace oneflow
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_RPC_INCLUDE_LOCAL_H_
 #define ONEFLOW_CORE_RPC_INCLUDE_LOCAL_H_
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include "oneflow/core/common/blocking_counter.h"
@@ -58,13 +59,34 @@ class LocalCtrlClient : public CtrlClient {
   HashSet<std::string> doing_names_;
   std::mutex done_names_mtx_;
   std::condition_variable done_names_cv_;
-  HashMap<std::string, std::string> kv_;
-  std::mutex kv_mtx_;
-  std::condition_variable kv_cv_;
-  HashMap<std::string, int32_t> counter_;
-  std::mutex counter_mtx_;
-  HashMap<std::string, std::shared_ptr<BlockingCounter>> barrier_counter_;
-  std::mutex barrier_counter_mtx_;
+
+ private:
+  // The KV store, the counters and the barriers are split into shards by key, each with its own
+  // lock, so that threads working on different keys do not wait for each other.
+  static constexpr size_t kNumShards = 64;
+
+  struct KVShard {
+    std::mutex mtx;
+    std::condition_variable cv;
+    HashMap<std::string, std::string> kv;
+  };
+  struct CounterShard {
+    std::mutex mtx;
+    HashMap<std::string, int32_t> counter;
+  };
+  struct NamedBarrier;
+  struct BarrierShard {
+    std::mutex mtx;
+    HashMap<std::string, std::shared_ptr<NamedBarrier>> barrier;
+  };
+
+  static size_t ShardId4Key(const std::string& k) {
+    return std::hash<std::string>{}(k) % kNumShards;
+  }
+
+  std::array<KVShard, kNumShards> kv_shards_;
+  std::array<CounterShard, kNumShards> counter_shards_;
+  std::array<BarrierShard, kNumShards> barrier_shards_;
 };
 
 class LocalRpcManager : public RpcManager {
@@ -20,9 +20,102 @@ limitations under the License.
 #include "oneflow/core/rpc/include/local.h"
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/common/foreign_lock_helper.h"
+
+#include <climits>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
 
 namespace oneflow {
 
+namespace {
+
+// Busy waiting this many rounds before sleeping covers the threads that arrive close together. It
+// only pays off when every thread of the barrier has a core to spin on.
+constexpr int kBarrierSpinCount = 4096;
+
+void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+void FutexWait(std::atomic<uint32_t>* addr, uint32_t val) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, val, nullptr, nullptr,
+          0);
+#else
+  std::this_thread::yield();
+#endif
+}
+
+void FutexWakeAll(std::atomic<uint32_t>* addr) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+          nullptr, 0);
+#endif
+}
+
+void WithForeignLockReleased(const std::function<void()>& Wait) {
+  if (Global<ForeignLockHelper>::Get() == nullptr) {
+    Wait();
+  } else {
+    CHECK_JUST(Global<ForeignLockHelper>::Get()->WithScopedRelease([&]() -> Maybe<void> {
+      Wait();
+      return Maybe<void>::Ok();
+    }));
+  }
+}
+
+}  // namespace
+
+// The barrier of one name, reused by all its rounds as long as some thread is in it. The last
+// thread of a round resets remaining and bumps generation, the others wait for generation to
+// change, spinning first and then sleeping on it as a futex.
+struct LocalCtrlClient::NamedBarrier {
+  explicit NamedBarrier(int32_t n)
+      : num(n),
+        spin_count(n <= static_cast<int32_t>(std::thread::hardware_concurrency())
+                       ? kBarrierSpinCount
+                       : 0),
+        remaining(n),
+        generation(0),
+        users(0) {}
+
+  void ArriveAndWait() {
+    const uint32_t cur_generation = generation.load(std::memory_order_acquire);
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      remaining.store(num, std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+      FutexWakeAll(&generation);
+      return;
+    }
+    FOR_RANGE(int, i, 0, spin_count) {
+      if (generation.load(std::memory_order_acquire) != cur_generation) { return; }
+      CpuRelax();
+    }
+    WithForeignLockReleased([&]() {
+      while (generation.load(std::memory_order_acquire) == cur_generation) {
+        FutexWait(&generation, cur_generation);
+      }
+    });
+  }
+
+  const int32_t num;
+  const int spin_count;
+  std::atomic<int32_t> remaining;
+  std::atomic<uint32_t> generation;
+  // Threads between looking the barrier up and leaving it, guarded by the lock of the shard. The
+  // last one erases the entry, so that names do not pile up and a name can be reused with another
+  // barrier_num once nobody waits on it.
+  int64_t users;
+};
+
 LocalCtrlClient::LocalCtrlClient(const ProcessCtx& process_ctx) {
   CHECK(process_ctx.ctrl_addr_size() == 1);
   CHECK(process_ctx.node_size() == 1);
@@ -33,24 +126,23 @@ void LocalCtrlClient::Barrier(const std::string& barrier_name) {
 }
 
 void LocalCtrlClient::Barrier(const std::string& barrier_name, int32_t barrier_num) {
-  std::shared_ptr<BlockingCounter> counter;
-  bool is_first = false;
+  CHECK_GT(barrier_num, 0);
+  BarrierShard* shard = &barrier_shards_.at(ShardId4Key(barrier_name));
+  std::shared_ptr<NamedBarrier> barrier;
   {
-    std::unique_lock<std::mutex> lck(barrier_counter_mtx_);
-    auto it = barrier_counter_.find(barrier_name);
-    if (it == barrier_counter_.end()) {
-      is_first = true;
-      counter = std::make_shared<BlockingCounter>(barrier_num);
-      CHECK(barrier_counter_.emplace(barrier_name, counter).second);
-    } else {
-      counter = it->second;
+    std::unique_lock<std::mutex> lck(shard->mtx);
+    auto it = shard->barrier.find(barrier_name);
+    if (it == shard->barrier.end()) {
+      it = shard->barrier.emplace(barrier_name, std::make_shared<NamedBarrier>(barrier_num)).first;
     }
+    barrier = it->second;
+    CHECK_EQ(barrier->num, barrier_num) << barrier_name;
+    ++barrier->users;
   }
-  counter->Decrease();
-  counter->WaitUntilCntEqualZero();
-  if (is_first) {
-    std::unique_lock<std::mutex> lck(barrier_counter_mtx_);
-    CHECK_EQ(barrier_counter_.erase(barrier_name), 1);
+  barrier->ArriveAndWait();
+  {
+    std::unique_lock<std::mutex> lck(shard->mtx);
+    if (--barrier->users == 0) { shard->barrier.erase(barrier_name); }
   }
 }
 
@@ -76,14 +168,14 @@ void LocalCtrlClient::NotifyDone(const std::string& name) {
 void LocalCtrlClient::WaitUntilDone(const std::string& name) {
   std::unique_lock<std::mutex> lck(done_names_mtx_);
   LOG(INFO) << "waiting for name: " << name;
-  done_names_cv_.wait(lck);
-  CHECK(done_names_.find(name) != done_names_.end());
+  done_names_cv_.wait(lck, [&]() { return done_names_.find(name) != done_names_.end(); });
 }
 
 void LocalCtrlClient::PushKV(const std::string& k, std::function<void(std::string*)> VSetter) {
-  std::unique_lock<std::mutex> lck(kv_mtx_);
-  VSetter(&kv_[k]);
-  kv_cv_.notify_all();
+  KVShard* shard = &kv_shards_.at(ShardId4Key(k));
+  std::unique_lock<std::mutex> lck(shard->mtx);
+  VSetter(&shard->kv[k]);
+  shard->cv.notify_all();
 }
 
 void LocalCtrlClient::PushKV(const std::string& k, const std::string& v) {
@@ -99,25 +191,26 @@ void LocalCtrlClient::PushMasterKV(const std::string& k, const PbMessage& msg) {
 }
 
 void LocalCtrlClient::ClearKV(const std::string& k) {
-  std::unique_lock<std::mutex> lck(kv_mtx_);
-  kv_.erase(k);
+  KVShard* shard = &kv_shards_.at(ShardId4Key(k));
+  std::unique_lock<std::mutex> lck(shard->mtx);
+  shard->kv.erase(k);
 }
 
 void LocalCtrlClient::ClearMasterKV(const std::string& k) { ClearKV(k); }
 
 void LocalCtrlClient::PullKV(const std::string& k,
                              std::function<void(const std::string&)> VGetter) {
-  std::unique_lock<std::mutex> lck(kv_mtx_);
-  while (true) {
-    auto it = kv_.find(k);
-    if (it == kv_.end()) {
-      LOG(INFO) << "waiting for key: " << k;
-      kv_cv_.wait(lck);
-    } else {
-      VGetter(it->second);
-      break;
-    }
+  KVShard* shard = &kv_shards_.at(ShardId4Key(k));
+  std::unique_lock<std::mutex> lck(shard->mtx);
+  auto it = shard->kv.find(k);
+  if (it == shard->kv.end()) {
+    LOG(INFO) << "waiting for key: " << k;
+    shard->cv.wait(lck, [&]() {
+      it = shard->kv.find(k);
+      return it != shard->kv.end();
+    });
   }
+  VGetter(it->second);
 }
 
 void LocalCtrlClient::PullKV(const std::string& k, std::string* v) {
@@ -138,29 +231,25 @@ void LocalCtrlClient::Clear() {
     done_names_.clear();
     done_names_cv_.notify_all();
   }
-  {
-    std::unique_lock<std::mutex> lck(kv_mtx_);
-    kv_.clear();
-    kv_cv_.notify_all();
+  for (KVShard& shard : kv_shards_) {
+    std::unique_lock<std::mutex> lck(shard.mtx);
+    shard.kv.clear();
+    shard.cv.notify_all();
   }
 }
 
 int32_t LocalCtrlClient::IncreaseCount(const std::string& k, int32_t v) {
-  std::unique_lock<std::mutex> lck(counter_mtx_);
-  auto it = counter_.find(k);
-  if (it == counter_.end()) {
-    counter_[k] = 1;
-    return 1;
-  } else {
-    const int32_t new_val = it->second + 1;
-    counter_[k] = new_val;
-    return new_val;
-  }
+  CounterShard* shard = &counter_shards_.at(ShardId4Key(k));
+  std::unique_lock<std::mutex> lck(shard->mtx);
+  int32_t& count = shard->counter[k];
+  count += v;
+  return count;
 }
 
 void LocalCtrlClient::EraseCount(const std::string& k) {
-  std::unique_lock<std::mutex> lck(counter_mtx_);
-  counter_.erase(k);
+  CounterShard* shard = &counter_shards_.at(ShardId4Key(k));
+  std::unique_lock<std::mutex> lck(shard->mtx);
+  shard->counter.erase(k);
 }
 
 class DryRunCtrlClient : public CtrlClient {
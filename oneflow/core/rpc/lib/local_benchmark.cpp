@@ -0,0 +1,78 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef RPC_BACKEND_LOCAL
+
+#include <thread>
+#include <gtest/gtest.h>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/core/rpc/include/local.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+void RunOnThreads(int64_t num_threads, const std::function<void(int64_t)>& Run) {
+  std::vector<std::thread> threads;
+  FOR_RANGE(int64_t, i, 0, num_threads) { threads.emplace_back(Run, i); }
+  for (auto& thread : threads) { thread.join(); }
+}
+
+}  // namespace
+
+// Logs the barrier latency and the KV throughput.
+TEST(LocalCtrlClientBenchmark, barrier_and_kv) {
+  ProcessCtx process_ctx;
+  process_ctx.add_ctrl_addr()->set_host("localhost");
+  process_ctx.set_rank(0);
+  process_ctx.set_node_size(1);
+  LocalCtrlClient client(process_ctx);
+  for (int64_t num_threads : {8, 16, 32, 64}) {
+    const int64_t num_rounds = 200;
+    const std::string barrier_name = "benchmark" + std::to_string(num_threads);
+    const double barrier_ms = ElapsedMs(
+        [&]() {
+          RunOnThreads(num_threads, [&](int64_t) {
+            FOR_RANGE(int64_t, i, 0, num_rounds) { client.Barrier(barrier_name, num_threads); }
+          });
+        },
+        1);
+    LOG(INFO) << "barrier of " << num_threads << " threads: " << barrier_ms / num_rounds * 1e3
+              << "us";
+
+    const int64_t num_ops = 2000;
+    const double kv_ms = ElapsedMs(
+        [&]() {
+          RunOnThreads(num_threads, [&](int64_t id) {
+            std::string val;
+            FOR_RANGE(int64_t, i, 0, num_ops) {
+              const std::string key = "benchmark" + std::to_string(id) + "_" + std::to_string(i);
+              client.PushKV(key, key);
+              client.PullKV(key, &val);
+              client.ClearKV(key);
+            }
+          });
+        },
+        1);
+    LOG(INFO) << "kv push/pull/clear on " << num_threads
+              << " threads: " << num_threads * num_ops / kv_ms * 1e3 << " ops/s";
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
+
+#endif  // RPC_BACKEND_LOCAL
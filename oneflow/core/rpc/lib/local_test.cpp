@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef RPC_BACKEND_LOCAL
+
+#include <atomic>
+#include <thread>
+#include <gtest/gtest.h>
+#include "oneflow/core/rpc/include/local.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+std::unique_ptr<LocalCtrlClient> NewLocalCtrlClient() {
+  ProcessCtx process_ctx;
+  process_ctx.add_ctrl_addr()->set_host("localhost");
+  process_ctx.set_rank(0);
+  process_ctx.set_node_size(1);
+  return std::unique_ptr<LocalCtrlClient>(new LocalCtrlClient(process_ctx));
+}
+
+void RunOnThreads(int64_t num_threads, const std::function<void(int64_t)>& Run) {
+  std::vector<std::thread> threads;
+  FOR_RANGE(int64_t, i, 0, num_threads) { threads.emplace_back(Run, i); }
+  for (auto& thread : threads) { thread.join(); }
+}
+
+}  // namespace
+
+TEST(LocalCtrlClient, barrier) {
+  auto client = NewLocalCtrlClient();
+  for (int64_t num_threads : {1, 3, 8}) {
+    std::atomic<int64_t> cnt(0);
+    RunOnThreads(num_threads, [&](int64_t) {
+      FOR_RANGE(int64_t, round, 0, 100) {
+        cnt += 1;
+        client->Barrier("barrier" + std::to_string(num_threads), num_threads);
+        ASSERT_EQ(cnt.load(), num_threads * (round + 1));
+        client->Barrier("barrier" + std::to_string(num_threads), num_threads);
+      }
+    });
+  }
+}
+
+TEST(LocalCtrlClient, barrier_name_reuse) {
+  auto client = NewLocalCtrlClient();
+  // The entry of a name goes away once its last thread leaves, so the name can be taken again
+  // with another number of threads.
+  for (int64_t num_threads : {4, 2, 6, 1, 4}) {
+    std::atomic<int64_t> cnt(0);
+    RunOnThreads(num_threads, [&](int64_t) {
+      FOR_RANGE(int64_t, round, 0, 10) {
+        cnt += 1;
+        client->Barrier("reused", num_threads);
+        ASSERT_EQ(cnt.load(), num_threads * (round + 1));
+        client->Barrier("reused", num_threads);
+      }
+    });
+  }
+}
+
+TEST(LocalCtrlClient, kv) {
+  auto client = NewLocalCtrlClient();
+  const int64_t num_threads = 8;
+  RunOnThreads(num_threads, [&](int64_t id) {
+    // Pulls of the keys of the other threads block until they are pushed.
+    const int64_t peer = (id + 1) % num_threads;
+    client->PushKV("key" + std::to_string(id), std::to_string(id));
+    std::string val;
+    client->PullKV("key" + std::to_string(peer), &val);
+    ASSERT_EQ(val, std::to_string(peer));
+    ASSERT_EQ(client->IncreaseCount("count", 2) % 2, 0);
+  });
+  ASSERT_EQ(client->IncreaseCount("count", 0), 2 * num_threads);
+  client->EraseCount("count");
+  ASSERT_EQ(client->IncreaseCount("count", 1), 1);
+}
+
+}  // namespace test
+}  // namespace oneflow
+
+#endif  // RPC_BACKEND_LOCAL
@@ -24,6 +24,9 @@ namespace oneflow {
 const static int kThreadConsistentIdMain = 0;
 const static int kThreadConsistentIdHook = 1;
 const static int kThreadConsistentIdScheduler = 2;
+const static int kThreadConsistentIdCollectiveBoxing = 3;
+// Worker threads of the vm count up from here, one id per transport stream type.
+const static int kThreadConsistentIdVmWorkerBegin = 4;
 
 size_t GetThreadConsistentIdCount();
 
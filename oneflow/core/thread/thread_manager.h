@@ -50,7 +50,8 @@ void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 template<typename DoEachT>
 void MultiThreadLoop(size_t num, const DoEachT& DoEach) {
   if (num == 0) { return; }
-  if (unlikely(pthread_fork::IsForkedSubProcess())) {
+  if (num == 1 || unlikely(pthread_fork::IsForkedSubProcess())
+      || Global<ThreadPool>::Get() == nullptr) {
     SingleThreadLoop(num, DoEach);
     return;
   }
@@ -70,6 +71,28 @@ void MultiThreadLoop(size_t num, const DoEachT& DoEach) {
   bc.WaitUntilCntEqualZero();
 }
 
+// Splits [0, num) into at most max_range_num balanced ranges and calls DoRange(begin, end) once
+// per range through MultiThreadLoop. A single range runs on the calling thread.
+template<typename DoRangeT>
+void MultiThreadRangeLoop(size_t num, size_t max_range_num, const DoRangeT& DoRange) {
+  if (num == 0) { return; }
+  size_t range_num = std::min(num, std::max<size_t>(max_range_num, 1));
+  if (Global<ThreadPool>::Get() == nullptr || pthread_fork::IsForkedSubProcess()) {
+    range_num = 1;
+  } else {
+    range_num = std::min(range_num, static_cast<size_t>(Global<ThreadPool>::Get()->thread_num()));
+  }
+  if (range_num == 1) {
+    DoRange(static_cast<size_t>(0), num);
+    return;
+  }
+  const BalancedSplitter bs(num, range_num);
+  MultiThreadLoop(range_num, [&](size_t range_id) {
+    const Range range = bs.At(range_id);
+    DoRange(static_cast<size_t>(range.begin()), static_cast<size_t>(range.end()));
+  });
+}
+
 }  // namespace oneflow
 
 #endif  // ONEFLOW_CORE_THREAD_THREAD_MANAGER_H_
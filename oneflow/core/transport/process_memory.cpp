@@ -0,0 +1,42 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "oneflow/core/transport/process_memory.h"
+#include <errno.h>
+#include <sys/uio.h>
+
+namespace oneflow {
+
+bool ReadProcessMemory(pid_t pid, const void* remote_ptr, void* local_ptr, std::size_t size) {
+  std::size_t offset = 0;
+  while (offset < size) {
+    iovec local_iov{static_cast<char*>(local_ptr) + offset, size - offset};
+    iovec remote_iov{static_cast<char*>(const_cast<void*>(remote_ptr)) + offset, size - offset};
+    const ssize_t n = process_vm_readv(pid, &local_iov, 1, &remote_iov, 1, 0);
+    if (n < 0) { return false; }
+    if (n == 0) {
+      errno = EFAULT;
+      return false;
+    }
+    offset += n;
+  }
+  return true;
+}
+
+}  // namespace oneflow
+
+#endif  // __linux__
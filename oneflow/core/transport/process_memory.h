@@ -0,0 +1,34 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#ifndef ONEFLOW_CORE_TRANSPORT_PROCESS_MEMORY_H_
+#define ONEFLOW_CORE_TRANSPORT_PROCESS_MEMORY_H_
+
+#include <sys/types.h>
+#include <cstddef>
+
+namespace oneflow {
+
+// Copies size bytes at remote_ptr in the process pid to local_ptr with process_vm_readv. Returns
+// false with errno set if the kernel refuses it or the range is not mapped in that process.
+bool ReadProcessMemory(pid_t pid, const void* remote_ptr, void* local_ptr, std::size_t size);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_TRANSPORT_PROCESS_MEMORY_H_
+
+#endif  // __linux__
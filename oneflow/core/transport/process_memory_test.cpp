@@ -0,0 +1,95 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifdef __linux__
+
+#include "gtest/gtest.h"
+#include "oneflow/core/transport/process_memory.h"
+#include <errno.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdint>
+#include <vector>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// Larger than one page so that the read crosses page boundaries.
+constexpr std::size_t kBufferSize = 3 * 4096 + 7;
+
+}  // namespace
+
+TEST(ProcessMemory, read_self) {
+  std::vector<uint8_t> src(kBufferSize);
+  for (std::size_t i = 0; i < src.size(); ++i) { src[i] = static_cast<uint8_t>(i * 7); }
+  std::vector<uint8_t> dst(kBufferSize, 0);
+  if (!ReadProcessMemory(getpid(), src.data(), dst.data(), src.size())) {
+    // Sandboxes may forbid process_vm_readv altogether.
+    ASSERT_TRUE(errno == EPERM || errno == ENOSYS) << errno;
+    return;
+  }
+  ASSERT_EQ(src, dst);
+}
+
+TEST(ProcessMemory, read_unmapped) {
+  uint64_t value = 0;
+  ASSERT_FALSE(ReadProcessMemory(getpid(), nullptr, &value, sizeof(value)));
+}
+
+TEST(ProcessMemory, read_child) {
+  // The child names this process as its tracer, overwrites the buffer it inherited and waits to
+  // be killed. The parent must see the child's values rather than its own.
+  std::vector<uint8_t> buffer(kBufferSize, 1);
+  int ready[2];
+  ASSERT_EQ(pipe(ready), 0);
+  const pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    prctl(PR_SET_PTRACER, getppid(), 0, 0, 0);
+    for (std::size_t i = 0; i < buffer.size(); ++i) { buffer[i] = static_cast<uint8_t>(i + 3); }
+    const char c = 0;
+    if (write(ready[1], &c, 1) != 1) { _exit(1); }
+    while (true) { pause(); }
+  }
+  char c = 0;
+  ASSERT_EQ(read(ready[0], &c, 1), 1);
+  std::vector<uint8_t> dst(kBufferSize, 0);
+  const bool ok = ReadProcessMemory(child, buffer.data(), dst.data(), buffer.size());
+  const int read_errno = errno;
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+  close(ready[0]);
+  close(ready[1]);
+  if (!ok) {
+    ASSERT_TRUE(read_errno == EPERM || read_errno == ENOSYS) << read_errno;
+    return;
+  }
+  for (std::size_t i = 0; i < dst.size(); ++i) {
+    ASSERT_EQ(dst[i], static_cast<uint8_t>(i + 3)) << i;
+  }
+  // A process that has exited can't be read.
+  ASSERT_FALSE(ReadProcessMemory(child, buffer.data(), dst.data(), buffer.size()));
+}
+
+}  // namespace test
+
+}  // namespace oneflow
+
+#endif  // __linux__
@@ -15,27 +15,89 @@ limitations under the License.
 */
 #ifdef __linux__
 
+#include "oneflow/core/control/ctrl_client.h"
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/transport/transport.h"
+#include "oneflow/core/transport/process_memory.h"
+#include <sys/prctl.h>
+#include <random>
+#include <sstream>
 
 namespace oneflow {
 
+namespace {
+
+std::string GenPeerKey(int64_t machine_id) { return "TransportPeer/" + std::to_string(machine_id); }
+
+}  // namespace
+
 Transport::Transport() {
   comm_net_ = Global<EpollCommNet>::Get();
   this_machine_id_ = GlobalProcessCtx::Rank();
   CHECK(comm_net_ != nullptr);
+  InitSameHostPeers();
   // maybe need new read id for each dst machine id, maybe need 2 * machine num read ids
   read_id_ = comm_net_->NewActorReadId();
   msg_poller_ = std::thread([this]() { PollMsgChannel(); });
+  if (same_host_read_enabled_) {
+    same_host_reader_ = std::thread([this]() { PollSameHostReadChannel(); });
+  }
 }
 
 Transport::~Transport() {
   msg_channel_.Close();
   msg_poller_.join();
+  same_host_read_channel_.Close();
+  if (same_host_reader_.joinable()) { same_host_reader_.join(); }
   CHECK(token2status_.empty());
   comm_net_->DeleteActorReadId(read_id_);
 }
 
+void Transport::InitSameHostPeers() {
+  machine_id2same_host_pid_.assign(GlobalProcessCtx::WorldSize(), -1);
+  same_host_cookie_ = 0;
+  same_host_read_enabled_ = ParseBooleanFromEnv("ONEFLOW_TRANSPORT_SAME_HOST_READ", false);
+  std::ostringstream peer;
+  if (same_host_read_enabled_) {
+    // Under Yama only the tracers a process names and their descendants may read its memory. The
+    // processes of one host are usually started by the same launcher, so name it.
+    prctl(PR_SET_PTRACER, getppid(), 0, 0, 0);
+    same_host_cookie_ = std::random_device()();
+    same_host_cookie_ = (same_host_cookie_ << 32) | std::random_device()();
+    peer << getpid() << " " << reinterpret_cast<uintptr_t>(&same_host_cookie_) << " "
+         << same_host_cookie_;
+  } else {
+    peer << -1;
+  }
+  Global<CtrlClient>::Get()->PushKV(GenPeerKey(this_machine_id_), peer.str());
+  FOR_RANGE(int64_t, machine_id, 0, machine_id2same_host_pid_.size()) {
+    if (!same_host_read_enabled_) { break; }
+    if (machine_id == this_machine_id_) { continue; }
+    if (GlobalProcessCtx::NodeId(machine_id) != GlobalProcessCtx::ThisNodeId()) { continue; }
+    std::string value;
+    Global<CtrlClient>::Get()->PullKV(GenPeerKey(machine_id), &value);
+    std::istringstream in(value);
+    pid_t pid = -1;
+    uintptr_t cookie_addr = 0;
+    uint64_t cookie = 0;
+    in >> pid >> cookie_addr >> cookie;
+    if (pid == -1) { continue; }
+    // The pid may belong to another pid namespace, or to another process by now. Only a peer
+    // whose cookie reads back is the process that published it.
+    uint64_t read_cookie = 0;
+    if (ReadProcessMemory(pid, reinterpret_cast<const void*>(cookie_addr), &read_cookie,
+                          sizeof(read_cookie))
+        && read_cookie == cookie) {
+      machine_id2same_host_pid_.at(machine_id) = pid;
+    } else {
+      LOG(WARNING) << "Can not read the memory of rank " << machine_id
+                   << ", use CommNet to receive from it";
+    }
+  }
+  OF_ENV_BARRIER();
+  Global<CtrlClient>::Get()->ClearKV(GenPeerKey(this_machine_id_));
+}
+
 void Transport::EnqueueTransportMsg(const TransportMsg& msg) {
   CHECK_EQ(msg_channel_.Send(msg), kChannelStatusSuccess);
 }
@@ -113,6 +175,7 @@ void Transport::HandlerAchievedTransportSendMsgFromSrcMachine(const TransportMsg
     CHECK(stat->src_mem_token == nullptr);
     // src_mem_token MUST init in the block protected by lock
     stat->src_mem_token = msg.src_mem_token;
+    stat->src_ptr = msg.src_ptr;
   }
 
   if (recv_before_send) {
@@ -201,6 +264,7 @@ void Transport::Send(uint64_t token, int64_t dst_machine_id, const void* ptr, st
   msg.src_mem_token = stat->src_mem_token;
   msg.dst_mem_token = stat->dst_mem_token;
   msg.type = TransportMsgType::kSend;
+  msg.src_ptr = ptr;
   comm_net_->SendTransportMsg(msg.dst_machine_id, msg);
 }
 
@@ -275,33 +339,68 @@ void Transport::DoRead(uint64_t token) {
   CHECK(stat->dst_machine_id != -1);
   CHECK(stat->size != -1);
   CHECK(stat->callback);
+  if (same_host_read_enabled_.load(std::memory_order_relaxed)
+      && machine_id2same_host_pid_.at(stat->src_machine_id) != -1 && stat->src_ptr != nullptr) {
+    // Keep Receive() and the message poller from blocking on the copy.
+    CHECK_EQ(same_host_read_channel_.Send(stat), kChannelStatusSuccess);
+    return;
+  }
+  ReadWithCommNet(stat);
+}
+
+void Transport::ReadWithCommNet(TransportStatus* stat) {
   comm_net_->Read(read_id_, stat->src_machine_id, stat->src_mem_token, stat->dst_mem_token);
-  comm_net_->AddReadCallBack(read_id_, [stat, this]() {
-    // Send ack message to source machine
-    TransportMsg msg;
-    msg.token = stat->token;
-    msg.src_machine_id = stat->src_machine_id;
-    msg.dst_machine_id = stat->dst_machine_id;
-    msg.size = stat->size;
-    msg.src_mem_token = stat->src_mem_token;
-    msg.dst_mem_token = stat->dst_mem_token;
-    msg.type = TransportMsgType::kAck;
-    comm_net_->SendTransportMsg(msg.src_machine_id, msg);
-
-    // UnRegisterMemory
-    comm_net_->UnRegisterMemory(msg.dst_mem_token);
-
-    // Do Receive callback
-    stat->callback();
+  comm_net_->AddReadCallBack(read_id_, [stat, this]() { FinishRead(stat); });
+}
 
-    // Recovery status
-    {
-      std::unique_lock<std::mutex> lock(status_mutex_);
-      auto it = token2status_.find(stat->token);
-      CHECK(it != token2status_.end());
-      token2status_.erase(it);
+void Transport::PollSameHostReadChannel() {
+  TransportStatus* stat = nullptr;
+  while (same_host_read_channel_.Receive(&stat) == kChannelStatusSuccess) {
+    if (TryReadFromSameHost(stat)) {
+      FinishRead(stat);
+    } else {
+      ReadWithCommNet(stat);
     }
-  });
+  }
+}
+
+bool Transport::TryReadFromSameHost(TransportStatus* stat) {
+  if (!same_host_read_enabled_.load(std::memory_order_relaxed)) { return false; }
+  const pid_t src_pid = machine_id2same_host_pid_.at(stat->src_machine_id);
+  if (ReadProcessMemory(src_pid, stat->src_ptr, stat->dst_ptr, stat->size)) { return true; }
+  if (same_host_read_enabled_.exchange(false)) {
+    PLOG(WARNING) << "Reading from process " << src_pid
+                  << " failed, use CommNet between processes on the same host";
+  }
+  return false;
+}
+
+void Transport::FinishRead(TransportStatus* stat) {
+  // Send ack message to source machine
+  TransportMsg msg;
+  msg.token = stat->token;
+  msg.src_machine_id = stat->src_machine_id;
+  msg.dst_machine_id = stat->dst_machine_id;
+  msg.size = stat->size;
+  msg.src_mem_token = stat->src_mem_token;
+  msg.dst_mem_token = stat->dst_mem_token;
+  msg.type = TransportMsgType::kAck;
+  msg.src_ptr = stat->src_ptr;
+  comm_net_->SendTransportMsg(msg.src_machine_id, msg);
+
+  // UnRegisterMemory
+  comm_net_->UnRegisterMemory(msg.dst_mem_token);
+
+  // Do Receive callback
+  stat->callback();
+
+  // Recovery status
+  {
+    std::unique_lock<std::mutex> lock(status_mutex_);
+    auto it = token2status_.find(stat->token);
+    CHECK(it != token2status_.end());
+    token2status_.erase(it);
+  }
 }
 
 void Transport::SendToLocalMachine(uint64_t token, void* ptr, std::size_t size,
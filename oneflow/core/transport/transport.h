@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/common/channel.h"
 #include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
 #include "oneflow/core/transport/transport_message.h"
+#include <atomic>
 
 namespace oneflow {
 
@@ -44,6 +45,14 @@ namespace oneflow {
 //
 // Transport supports send and receive data on local machine.
 //
+// With ONEFLOW_TRANSPORT_SAME_HOST_READ=1, the receiver of two processes on the same host reads the
+// data straight from the address space of the sender with process_vm_readv on a worker thread,
+// only the Send and Ack messages go through CommNet. Every process checks the pid a peer publishes
+// by reading back a random cookie of the peer, and falls back to CommNet reads when that or a later
+// read fails. Enabling it names the parent process as a Yama ptracer of each process, which lets
+// the launcher and all its descendants, e.g. every rank on the host, attach to the process and
+// read or write any of its memory. It is off by default for that reason.
+//
 class Transport {
  public:
   OF_DISALLOW_COPY_AND_MOVE(Transport);
@@ -56,10 +65,17 @@ class Transport {
   void EnqueueTransportMsg(const TransportMsg& msg);
 
  private:
+  struct TransportStatus;
+
   void PollMsgChannel();
   void HandlerAchievedTransportSendMsgFromSrcMachine(const TransportMsg& msg);
   void HandlerAchievedTransportAckMsgFromDstMachine(const TransportMsg& msg);
   void DoRead(uint64_t token);
+  void InitSameHostPeers();
+  void PollSameHostReadChannel();
+  bool TryReadFromSameHost(TransportStatus* stat);
+  void ReadWithCommNet(TransportStatus* stat);
+  void FinishRead(TransportStatus* stat);
   void SendToLocalMachine(uint64_t token, void* ptr, std::size_t size,
                           std::function<void()> callback);
   void RecvFromLocalMachine(uint64_t token, void* ptr, std::size_t max_size,
@@ -86,6 +102,7 @@ class Transport {
     void* dst_mem_token;
     // NOTE(chengcheng): must store dst_ptr in status when Receive max_size > Send size
     void* dst_ptr;
+    const void* src_ptr;
     std::size_t size;
     int64_t src_machine_id;
     int64_t dst_machine_id;
@@ -96,6 +113,8 @@ class Transport {
           is_recv_ready(false),
           src_mem_token(nullptr),
           dst_mem_token(nullptr),
+          dst_ptr(nullptr),
+          src_ptr(nullptr),
           size(-1),
           src_machine_id(-1),
           dst_machine_id(-1) {}
@@ -129,11 +148,19 @@ class Transport {
   HashMap<uint64_t, CopyStatusOnLocalMachine> token2local_copy_status_;
 
   int64_t this_machine_id_;
+  // The pid of each process on this host, -1 for the others.
+  std::vector<pid_t> machine_id2same_host_pid_;
+  std::atomic<bool> same_host_read_enabled_;
+  // Read back by the peers on this host to check they read this process.
+  uint64_t same_host_cookie_;
   void* read_id_;
   EpollCommNet* comm_net_;
 
   Channel<TransportMsg> msg_channel_;
   std::thread msg_poller_;
+
+  Channel<TransportStatus*> same_host_read_channel_;
+  std::thread same_host_reader_;
 };
 
 }  // namespace oneflow
@@ -37,6 +37,9 @@ struct TransportMsg {
   int64_t src_machine_id;
   int64_t dst_machine_id;
   TransportMsgType type;
+  // The address of the data in the source process, for the receiver on the same host to read it
+  // with process_vm_readv.
+  const void* src_ptr;
 };
 
 }  // namespace oneflow
@@ -22,9 +22,17 @@ namespace vm {
 
 void CpuAllocator::Allocate(char** mem_ptr, std::size_t size) {
   *mem_ptr = reinterpret_cast<char*>(aligned_alloc(kHostAlignSize, size));
+  const int64_t live_bytes = live_bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+  int64_t peak_bytes = peak_bytes_.load(std::memory_order_relaxed);
+  while (live_bytes > peak_bytes
+         && !peak_bytes_.compare_exchange_weak(peak_bytes, live_bytes, std::memory_order_relaxed)) {
+  }
 }
 
-void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) { std::free(mem_ptr); }
+void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  std::free(mem_ptr);
+  live_bytes_.fetch_sub(size, std::memory_order_relaxed);
+}
 
 COMMAND(Global<CpuAllocator>::SetAllocated(new CpuAllocator()));
 
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_VM_CPU_ALLOCATOR_H_
 #define ONEFLOW_CORE_VM_CPU_ALLOCATOR_H_
 
+#include <atomic>
 #include <cstdint>
 #include "oneflow/core/vm/allocator.h"
 
@@ -29,6 +30,16 @@ class CpuAllocator final : public Allocator {
 
   void Allocate(char** mem_ptr, std::size_t size) override;
   void Deallocate(char* mem_ptr, std::size_t size) override;
+
+  // Bytes allocated and not deallocated yet, and the most of them at any time since the last
+  // ResetPeakBytes.
+  int64_t live_bytes() const { return live_bytes_.load(std::memory_order_relaxed); }
+  int64_t peak_bytes() const { return peak_bytes_.load(std::memory_order_relaxed); }
+  void ResetPeakBytes() { peak_bytes_.store(live_bytes(), std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> live_bytes_{0};
+  std::atomic<int64_t> peak_bytes_{0};
 };
 
 }  // namespace vm
@@ -69,8 +69,15 @@ intrusive::shared_ptr<StreamDesc> CpuStreamType::MakeStreamDesc(const Resource&
   ret->mut_stream_type_id()->__Init__(LookupStreamType4TypeIndex<CpuStreamType>());
   ret->set_num_streams_per_machine(device_num);
   ret->set_num_streams_per_thread(device_num);
+  ret->set_num_streams_per_device(CpuStreamNumPerDevice());
   return ret;
 }
 
+int64_t CpuStreamNumPerDevice() {
+  static const int64_t stream_num =
+      std::max<int64_t>(ParseIntegerFromEnv("ONEFLOW_VM_CPU_STREAM_NUM_PER_DEVICE", 1), 1);
+  return stream_num;
+}
+
 }  // namespace vm
 }  // namespace oneflow
@@ -47,6 +47,10 @@ class CpuStreamType final : public StreamType {
   bool SupportingTransportInstructions() const override { return true; }
 };
 
+// Number of compute streams of every cpu device, read from ONEFLOW_VM_CPU_STREAM_NUM_PER_DEVICE. It
+// is 1 by default, with which all cpu instructions run on the scheduler thread.
+int64_t CpuStreamNumPerDevice();
+
 }  // namespace vm
 }  // namespace oneflow
 
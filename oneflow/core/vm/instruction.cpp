@@ -65,6 +65,7 @@ InstructionOperand* InstructionMsg::add_instr_operand() {
 void InstructionMsg::__Init__() {
   *mut_instr_type_name() = "";
   set_parallel_desc_symbol_id(0);
+  set_priority(ThreadLocalSchedulePriority());
 }
 
 void InstructionMsg::__Init__(const std::string& instr_type_name) {
@@ -76,14 +77,21 @@ void InstructionMsg::__Init__(const std::string& instr_type_name) {
 void InstructionMsg::__Init__(VirtualMachineEngine* vm, const std::string& instr_type_name,
                               const std::shared_ptr<const ParallelDesc>& phy_instr_parallel_desc,
                               const std::shared_ptr<PhyInstrOperand>& phy_instr_operand) {
+  __Init__(vm, instr_type_name, phy_instr_parallel_desc, phy_instr_operand, 0);
+}
+
+void InstructionMsg::__Init__(VirtualMachineEngine* vm, const std::string& instr_type_name,
+                              const std::shared_ptr<const ParallelDesc>& phy_instr_parallel_desc,
+                              const std::shared_ptr<PhyInstrOperand>& phy_instr_operand,
+                              int64_t stream_index) {
   __Init__();
   // There are instructions without concept of ParallelDesc, like LaunchLazyJob,
   // ComputeGlobalFrontSeqBarrier. If phy_instr_parallel_desc is empty, Instructions are run on the
   // sole stream within the StreamRtDesc.
   if (likely(phy_instr_parallel_desc)) {
     int device_id = phy_instr_parallel_desc->parallel_id2device_id().at(0);
-    vm->GetCachedInstrTypeIdAndPhyInstrStream(instr_type_name, device_id, mut_instr_type_id(),
-                                              &phy_instr_stream_);
+    vm->GetCachedInstrTypeIdAndPhyInstrStream(instr_type_name, device_id, stream_index,
+                                              mut_instr_type_id(), &phy_instr_stream_);
   } else {
     vm->GetInstrTypeIdAndSoleStream(instr_type_name, mut_instr_type_id(), &phy_instr_stream_);
   }
@@ -107,6 +115,39 @@ void InstructionMsg::__Init__(const InstructionMsg& instr_msg) {
   reset_operand_list(instr_msg.operand_list());
   phy_instr_operand_ = instr_msg.phy_instr_operand();
   if (instr_msg.phy_instr_stream() != nullptr) { phy_instr_stream_ = instr_msg.phy_instr_stream(); }
+  set_priority(instr_msg.priority());
+}
+
+void InstructionMsg::__Delete__() {
+  mut_instr_type_id()->clear();
+  instr_type_name_.clear();
+  set_parallel_desc_symbol_id(0);
+  phy_instr_parallel_desc_.reset();
+  operand_list_.Reset();
+  phy_instr_operand_.reset();
+  phy_instr_stream_ = nullptr;
+}
+
+namespace {
+
+// Frees the pooled messages of a thread when it exits. The pool itself is never destructed, since
+// messages still in use may be released to it after the thread exits.
+class InstructionMsgPoolGuard final {
+ public:
+  InstructionMsgPoolGuard() : object_pool_(new InstructionMsg::object_pool_type()) {}
+  ~InstructionMsgPoolGuard() { object_pool_->Orphan(); }
+
+  InstructionMsg::object_pool_type* object_pool() const { return object_pool_; }
+
+ private:
+  InstructionMsg::object_pool_type* object_pool_;
+};
+
+}  // namespace
+
+InstructionMsg::object_pool_type* ThreadLocalInstructionMsgPool() {
+  static thread_local InstructionMsgPoolGuard guard;
+  return guard.object_pool();
 }
 
 void InstructionMsg::ToProto(InstructionProto* proto) const {
@@ -350,6 +391,8 @@ void Instruction::Init(InstructionMsg* instr_msg, Stream* stream,
   __Init__();
   reset_instr_msg(instr_msg);
   set_stream(stream);
+  priority_ = instr_msg->priority() != kSchedulePriorityNum ? instr_msg->priority()
+                                                            : stream->priority();
   instr_msg->instr_type_id().instruction_type().InitInstructionStatusIf(this);
   *mut_parallel_desc() = parallel_desc;
 }
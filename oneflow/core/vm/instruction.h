@@ -54,7 +54,9 @@ class InstructionOperandList final : public intrusive::Base {
 
 class VirtualMachineEngine;
 
-class InstructionMsg final : public intrusive::Base {
+class InstructionMsg final
+    : public intrusive::Base,
+      public intrusive::EnableObjectPool<InstructionMsg, intrusive::kThreadSafeAndDisableDestruct> {
  public:
   // Getters
   bool has_parallel_desc_symbol_id() const { return 0 != parallel_desc_symbol_id_; }
@@ -71,8 +73,11 @@ class InstructionMsg final : public intrusive::Base {
   }
   const std::shared_ptr<PhyInstrOperand>& phy_instr_operand() const { return phy_instr_operand_; }
   Stream* phy_instr_stream() const { return phy_instr_stream_; }
+  // kSchedulePriorityNum if the instruction takes the priority of its stream.
+  SchedulePriority priority() const { return priority_; }
   // Setters
   void set_parallel_desc_symbol_id(int64_t val) { parallel_desc_symbol_id_ = val; }
+  void set_priority(SchedulePriority val) { priority_ = val; }
   InstructionOperandList* mut_operand_list() {
     if (!operand_list_) { operand_list_ = intrusive::make_shared<InstructionOperandList>(); }
     return operand_list_.Mutable();
@@ -89,9 +94,15 @@ class InstructionMsg final : public intrusive::Base {
   void __Init__(VirtualMachineEngine* vm, const std::string& instr_type_name,
                 const std::shared_ptr<const ParallelDesc>& phy_instr_parallel_desc,
                 const std::shared_ptr<PhyInstrOperand>& phy_instr_operand);
+  // Runs the instruction on the stream_index-th stream of its device, see
+  // StreamDesc::num_streams_per_device.
+  void __Init__(VirtualMachineEngine* vm, const std::string& instr_type_name,
+                const std::shared_ptr<const ParallelDesc>& phy_instr_parallel_desc,
+                const std::shared_ptr<PhyInstrOperand>& phy_instr_operand, int64_t stream_index);
   void __Init__(const InstructionProto& proto);
   void __Init__(const cfg::InstructionProto& proto);
   void __Init__(const InstructionMsg& instr_msg);
+  void __Delete__();
 
   void ToProto(InstructionProto* proto) const;
   intrusive::shared_ptr<InstructionMsg> add_parallel_desc(int64_t symbol_id);
@@ -130,6 +141,7 @@ class InstructionMsg final : public intrusive::Base {
  private:
   InstructionOperand* add_instr_operand();
   friend class intrusive::Ref;
+  friend class intrusive::ObjectPool<InstructionMsg, intrusive::kThreadSafeAndDisableDestruct>;
   intrusive::Ref* mut_intrusive_ref() { return &intrusive_ref_; }
 
   InstructionMsg()
@@ -141,6 +153,7 @@ class InstructionMsg final : public intrusive::Base {
         operand_list_(),
         phy_instr_operand_(),
         phy_instr_stream_(),
+        priority_(kSchedulePriorityNum),
         instr_msg_hook_() {}
   intrusive::Ref intrusive_ref_;
   // fields
@@ -152,6 +165,7 @@ class InstructionMsg final : public intrusive::Base {
   intrusive::shared_ptr<InstructionOperandList> operand_list_;
   std::shared_ptr<PhyInstrOperand> phy_instr_operand_;
   Stream* phy_instr_stream_;
+  SchedulePriority priority_;
 
  public:
   // list hooks
@@ -160,6 +174,15 @@ class InstructionMsg final : public intrusive::Base {
 
 using InstructionMsgList = intrusive::List<INTRUSIVE_FIELD(InstructionMsg, instr_msg_hook_)>;
 
+// The pool of instruction messages made on the current thread. Messages are mostly released on the
+// scheduler thread, and go back to the pool they were taken from.
+InstructionMsg::object_pool_type* ThreadLocalInstructionMsgPool();
+
+template<typename... Args>
+intrusive::shared_ptr<InstructionMsg> NewInstructionMsg(Args&&... args) {
+  return ThreadLocalInstructionMsgPool()->make_shared(std::forward<Args>(args)...);
+}
+
 template<OperandMemZoneModifier mem_zone_modifier>
 void CheckOperand(const Operand& operand);
 
@@ -241,6 +264,7 @@ class Instruction final : public intrusive::Base {
     return default_val.Get();
   }
   const std::shared_ptr<const ParallelDesc>& parallel_desc() const { return parallel_desc_; }
+  SchedulePriority priority() const { return priority_; }
   const InstructionStatusBuffer& status_buffer() const { return status_buffer_.Get(); }
   const intrusive::ListHook& instruction_hook() const { return instruction_hook_; }
   const intrusive::ListHook& dispatched_instruction_hook() const {
@@ -365,6 +389,7 @@ class Instruction final : public intrusive::Base {
         instr_msg_(),
         parallel_desc_(),
         stream_(),
+        priority_(kNormalSchedulePriority),
         mirrored_object_id2access_(),
         access_list_(),
         in_edges_(),
@@ -380,6 +405,7 @@ class Instruction final : public intrusive::Base {
   intrusive::shared_ptr<InstructionMsg> instr_msg_;
   std::shared_ptr<const ParallelDesc> parallel_desc_;
   Stream* stream_;
+  SchedulePriority priority_;
   // maps
   MirroredObjectId2RwMutexedObjectAccess mirrored_object_id2access_;
   // lists
@@ -34,6 +34,10 @@ class InstructionType {
   bool IsSequential() const { return IsFrontSequential(); }
   virtual bool IsFrontSequential() const { return false; }
   virtual bool ResettingIdToObjectMap() const { return false; }
+  // Instructions that do nothing but free the memory behind the objects they mutate, e.g.
+  // ReleaseTensor. The engine marks the last read before them, so that the reading instruction may
+  // reuse the memory.
+  virtual bool IsFreeingMutOperands() const { return false; }
   virtual void Compute(Instruction* instruction) const = 0;
   virtual void Infer(Instruction* instruction) const = 0;
 
@@ -16,8 +16,8 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_VM_PHY_INSTR_OPERAND_H_
 #define ONEFLOW_CORE_VM_PHY_INSTR_OPERAND_H_
 
+#include <algorithm>
 #include <functional>
-#include <set>
 #include <vector>
 #include "oneflow/core/intrusive/intrusive.h"
 
@@ -36,11 +36,13 @@ class PhyInstrOperand {
   virtual const DependenceVector& input_dependences() const = 0;
   virtual const DependenceVector& output_dependences() const = 0;
 
+  // Instructions depend on a handful of objects, so a linear search is cheaper than a std::set. It
+  // also keeps the closure small enough to be stored in std::function without allocations.
   static std::function<void(MirroredObject*)> SetInserter(DependenceVector* dependences) {
-    auto existed =
-        std::make_shared<std::set<MirroredObject*>>(dependences->begin(), dependences->end());
-    return [dependences, existed](MirroredObject* object) {
-      if (existed->insert(object).second) { dependences->push_back(object); }
+    return [dependences](MirroredObject* object) {
+      if (std::find(dependences->begin(), dependences->end(), object) == dependences->end()) {
+        dependences->push_back(object);
+      }
     };
   }
 
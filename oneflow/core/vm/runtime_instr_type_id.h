@@ -38,12 +38,14 @@ class RtInstrTypeId final {
   }
 
   const InstrTypeId& instr_type_id() const { return instr_type_id_; }
-  Stream* GetStream(int device_id) const { return (stream_rt_desc_->*get_stream_)(device_id); }
+  Stream* GetStream(int device_id, int64_t stream_index) const {
+    return (stream_rt_desc_->*get_stream_)(device_id, stream_index);
+  }
 
  private:
   const InstrTypeId instr_type_id_;
   StreamRtDesc* stream_rt_desc_;
-  Stream* (StreamRtDesc::*get_stream_)(int device_id) const;
+  Stream* (StreamRtDesc::*get_stream_)(int device_id, int64_t stream_index) const;
 };
 
 }  // namespace vm
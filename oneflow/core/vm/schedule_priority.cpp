@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/vm/schedule_priority.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+SchedulePriority* MutThreadLocalSchedulePriority() {
+  static thread_local SchedulePriority priority = kSchedulePriorityNum;
+  return &priority;
+}
+
+}  // namespace
+
+Maybe<SchedulePriority> ParseSchedulePriority(const std::string& priority) {
+  if (priority == "low") {
+    return kLowSchedulePriority;
+  } else if (priority == "normal") {
+    return kNormalSchedulePriority;
+  } else if (priority == "high") {
+    return kHighSchedulePriority;
+  } else {
+    return Error::InvalidValueError("unknown schedule priority " + priority
+                                    + ", expected low, normal or high");
+  }
+}
+
+SchedulePriority ThreadLocalSchedulePriority() { return *MutThreadLocalSchedulePriority(); }
+
+SchedulePriorityGuard::SchedulePriorityGuard(SchedulePriority priority)
+    : prev_priority_(ThreadLocalSchedulePriority()) {
+  *MutThreadLocalSchedulePriority() = priority;
+}
+
+SchedulePriorityGuard::~SchedulePriorityGuard() {
+  *MutThreadLocalSchedulePriority() = prev_priority_;
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_SCHEDULE_PRIORITY_H_
+#define ONEFLOW_CORE_VM_SCHEDULE_PRIORITY_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "oneflow/core/common/maybe.h"
+
+namespace oneflow {
+namespace vm {
+
+// Priority of instructions in the virtual machine. Among the instructions ready in a scheduling
+// round, those of higher priorities are dispatched to their workers first. Every stream has a
+// priority, instructions take the priority of their stream unless built under a
+// SchedulePriorityGuard.
+enum SchedulePriority : int32_t {
+  kLowSchedulePriority = 0,
+  kNormalSchedulePriority = 1,
+  kHighSchedulePriority = 2,
+  kSchedulePriorityNum = 3,
+};
+
+// "low", "normal" or "high".
+Maybe<SchedulePriority> ParseSchedulePriority(const std::string& priority);
+
+// The priority instructions built on this thread get, kSchedulePriorityNum if they take the
+// priority of their stream.
+SchedulePriority ThreadLocalSchedulePriority();
+
+class SchedulePriorityGuard final {
+ public:
+  explicit SchedulePriorityGuard(SchedulePriority priority);
+  ~SchedulePriorityGuard();
+
+ private:
+  SchedulePriority prev_priority_;
+};
+
+// Reorders items, given in arrival order, into the order a worker runs them in. Items of the same
+// stream keep their order, since a later one may depend on an earlier one. Among the streams, the
+// one whose remaining items have the highest priority goes first, ties in arrival order of the
+// first remaining items, so a high priority item lifts the ones queued before it on its stream.
+template<typename T, typename GetStreamT, typename GetPriorityT>
+void SortInScheduleOrder(std::vector<T>* items, const GetStreamT& GetStream,
+                         const GetPriorityT& GetPriority) {
+  struct StreamQueue {
+    decltype(GetStream(items->front())) stream;
+    std::vector<size_t> indices;
+    // max_priorities[i] is the highest priority among indices[i:].
+    std::vector<SchedulePriority> max_priorities;
+    size_t head;
+  };
+  std::vector<StreamQueue> queues;
+  for (size_t i = 0; i < items->size(); ++i) {
+    const auto stream = GetStream(items->at(i));
+    auto it = std::find_if(queues.begin(), queues.end(),
+                           [&](const StreamQueue& queue) { return queue.stream == stream; });
+    if (it == queues.end()) { it = queues.insert(queues.end(), StreamQueue{stream, {}, {}, 0}); }
+    it->indices.push_back(i);
+  }
+  if (queues.size() <= 1) { return; }
+  for (auto& queue : queues) {
+    queue.max_priorities.resize(queue.indices.size());
+    SchedulePriority max_priority = kLowSchedulePriority;
+    for (size_t i = queue.indices.size(); i > 0; --i) {
+      max_priority = std::max(max_priority, GetPriority(items->at(queue.indices.at(i - 1))));
+      queue.max_priorities.at(i - 1) = max_priority;
+    }
+  }
+  // Higher priority first, then earlier arrival.
+  const auto GoesBefore = [](const StreamQueue& lhs, const StreamQueue& rhs) {
+    const SchedulePriority lhs_priority = lhs.max_priorities.at(lhs.head);
+    const SchedulePriority rhs_priority = rhs.max_priorities.at(rhs.head);
+    if (lhs_priority != rhs_priority) { return lhs_priority > rhs_priority; }
+    return lhs.indices.at(lhs.head) < rhs.indices.at(rhs.head);
+  };
+  std::vector<T> sorted;
+  sorted.reserve(items->size());
+  while (sorted.size() < items->size()) {
+    StreamQueue* next = nullptr;
+    for (auto& queue : queues) {
+      if (queue.head == queue.indices.size()) { continue; }
+      if (next == nullptr || GoesBefore(queue, *next)) { next = &queue; }
+    }
+    sorted.push_back(items->at(next->indices.at(next->head)));
+    next->head += 1;
+  }
+  items->swap(sorted);
+}
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_SCHEDULE_PRIORITY_H_
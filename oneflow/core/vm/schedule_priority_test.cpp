@@ -0,0 +1,73 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/vm/schedule_priority.h"
+
+namespace oneflow {
+namespace vm {
+namespace test {
+
+namespace {
+
+struct Item {
+  int stream;
+  SchedulePriority priority;
+  int id;
+};
+
+std::vector<int> ScheduleOrder(std::vector<Item> items) {
+  SortInScheduleOrder(
+      &items, [](const Item& item) { return item.stream; },
+      [](const Item& item) { return item.priority; });
+  std::vector<int> ids;
+  for (const Item& item : items) { ids.push_back(item.id); }
+  return ids;
+}
+
+}  // namespace
+
+TEST(SchedulePriority, same_priority_keeps_arrival_order) {
+  ASSERT_EQ(ScheduleOrder({{0, kNormalSchedulePriority, 0},
+                           {1, kNormalSchedulePriority, 1},
+                           {0, kNormalSchedulePriority, 2}}),
+            std::vector<int>({0, 1, 2}));
+}
+
+TEST(SchedulePriority, higher_priority_stream_first) {
+  ASSERT_EQ(ScheduleOrder({{0, kLowSchedulePriority, 0},
+                           {1, kNormalSchedulePriority, 1},
+                           {2, kHighSchedulePriority, 2},
+                           {0, kLowSchedulePriority, 3}}),
+            std::vector<int>({2, 1, 0, 3}));
+}
+
+TEST(SchedulePriority, same_stream_keeps_order) {
+  // The high priority item of stream 0 lifts the low one before it above stream 1.
+  ASSERT_EQ(ScheduleOrder({{1, kNormalSchedulePriority, 0},
+                           {0, kLowSchedulePriority, 1},
+                           {0, kHighSchedulePriority, 2},
+                           {0, kLowSchedulePriority, 3}}),
+            std::vector<int>({1, 2, 0, 3}));
+}
+
+TEST(SchedulePriority, single_stream) {
+  ASSERT_EQ(ScheduleOrder({{0, kLowSchedulePriority, 0}, {0, kHighSchedulePriority, 1}}),
+            std::vector<int>({0, 1}));
+}
+
+}  // namespace test
+}  // namespace vm
+}  // namespace oneflow
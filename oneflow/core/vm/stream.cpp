@@ -46,6 +46,10 @@ const StreamTypeId& Stream::stream_type_id() const {
   return thread_ctx().stream_rt_desc().stream_type_id();
 }
 
+SchedulePriority Stream::priority() const {
+  return thread_ctx().stream_rt_desc().stream_desc().priority();
+}
+
 intrusive::shared_ptr<Instruction> Stream::NewInstruction(
     InstructionMsg* instr_msg, const std::shared_ptr<const ParallelDesc>& parallel_desc) {
   intrusive::shared_ptr<Instruction> instruction;
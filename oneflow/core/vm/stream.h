@@ -69,6 +69,7 @@ class Stream final : public intrusive::Base {
   int64_t device_id() const;
   const StreamType& stream_type() const;
   const StreamTypeId& stream_type_id() const;
+  SchedulePriority priority() const;
 
  private:
   void MoveToFreeList(intrusive::shared_ptr<Instruction>&& instruction);
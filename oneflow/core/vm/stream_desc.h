@@ -16,12 +16,14 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_VM_VPU_DESC__H_
 #define ONEFLOW_CORE_VM_VPU_DESC__H_
 
+#include <atomic>
 #include <cstring>
 #include <typeindex>
 #include "oneflow/core/intrusive/flat_msg.h"
 #include "oneflow/core/intrusive/intrusive.h"
 #include "oneflow/core/vm/id_util.h"
 #include "oneflow/core/vm/interpret_type.h"
+#include "oneflow/core/vm/schedule_priority.h"
 #include "oneflow/core/vm/stream_type_id.h"
 
 namespace oneflow {
@@ -61,10 +63,18 @@ class StreamDesc final : public intrusive::Base {
   // Getters
   int32_t num_streams_per_machine() const { return num_streams_per_machine_; }
   int32_t num_streams_per_thread() const { return num_streams_per_thread_; }
+  // Streams of every device. Instructions run on the first one unless assigned to another one
+  // explicitly. If there are more than one, each of them gets a worker thread of its own, so that
+  // instructions on different streams run concurrently.
+  int32_t num_streams_per_device() const { return num_streams_per_device_; }
   const StreamTypeId& stream_type_id() const { return stream_type_id_.key().Get(); }
+  // May be changed from any thread by SetStreamSchedulePriority while the scheduler reads it.
+  SchedulePriority priority() const { return priority_.load(std::memory_order_relaxed); }
   // Setters
   void set_num_streams_per_machine(int32_t val) { num_streams_per_machine_ = val; }
   void set_num_streams_per_thread(int32_t val) { num_streams_per_thread_ = val; }
+  void set_num_streams_per_device(int32_t val) { num_streams_per_device_ = val; }
+  void set_priority(SchedulePriority val) { priority_.store(val, std::memory_order_relaxed); }
   StreamTypeId* mut_stream_type_id() { return stream_type_id_.mut_key()->Mutable(); }
 
   // methods
@@ -82,11 +92,15 @@ class StreamDesc final : public intrusive::Base {
       : intrusive_ref_(),
         num_streams_per_machine_(),
         num_streams_per_thread_(),
+        num_streams_per_device_(1),
+        priority_(kNormalSchedulePriority),
         stream_type_id_() {}
   intrusive::Ref intrusive_ref_;
   // fields
   int32_t num_streams_per_machine_;
   int32_t num_streams_per_thread_;
+  int32_t num_streams_per_device_;
+  std::atomic<SchedulePriority> priority_;
 
  public:
   // skiplist hooks
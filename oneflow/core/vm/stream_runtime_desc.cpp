@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/vm/stream_runtime_desc.h"
+#include "oneflow/core/vm/stream_type.h"
 
 namespace oneflow {
 namespace vm {
@@ -26,5 +27,9 @@ void StreamRtDesc::__Init__(StreamDesc* stream_desc) {
 
 const StreamType& StreamRtDesc::stream_type() const { return stream_type_id().stream_type(); }
 
+bool StreamRtDesc::OnSchedulerThread() const {
+  return stream_type().OnSchedulerThread() && stream_desc().num_streams_per_device() == 1;
+}
+
 }  // namespace vm
 }  // namespace oneflow
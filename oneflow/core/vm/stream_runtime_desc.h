@@ -39,14 +39,23 @@ class StreamRtDesc final : public intrusive::Base {
     return device_id2stream_;
   }
 
-  // The value of `device_id` is ignored.
-  Stream* GetSoleStream(int device_id) const { return GetSoleStream(); }
+  // The values of `device_id` and `stream_index` are ignored.
+  Stream* GetSoleStream(int device_id, int64_t stream_index) const { return GetSoleStream(); }
   Stream* GetSoleStream() const {
     CHECK_EQ(device_id2stream().size(), 1);
     return device_id2stream().at(0).get();
   }
 
   Stream* GetDeviceStream(int device_id) const { return device_id2stream().at(device_id).get(); }
+  // The stream_index-th stream of device `device_id`, modulo StreamDesc::num_streams_per_device.
+  Stream* GetDeviceStream(int device_id, int64_t stream_index) const {
+    const auto& streams = device_id2streams_.at(device_id);
+    return streams.at(stream_index % streams.size()).get();
+  }
+
+  // Whether the streams run on the scheduler thread rather than on worker threads. Several streams
+  // of a device only run concurrently on worker threads.
+  bool OnSchedulerThread() const;
 
   // Setters
   StreamDesc* mut_stream_desc() {
@@ -55,9 +64,13 @@ class StreamRtDesc final : public intrusive::Base {
   }
   void reset_stream_desc(StreamDesc* stream_desc) { stream_desc_.Reset(stream_desc); }
   StreamTypeId* mut_stream_type_id() { return stream_type_id_.mut_key()->Mutable(); }
+  // Streams of a device are added after the first stream of the device.
   void add_stream(intrusive::shared_ptr<Stream> stream) {
-    CHECK_EQ(stream->device_id(), device_id2stream_.size());
-    device_id2stream_.emplace_back(stream);
+    if (stream->device_id() == device_id2stream_.size()) {
+      device_id2stream_.emplace_back(stream);
+      device_id2streams_.emplace_back();
+    }
+    device_id2streams_.at(stream->device_id()).emplace_back(stream);
   }
 
   // methods
@@ -68,12 +81,18 @@ class StreamRtDesc final : public intrusive::Base {
   friend class intrusive::Ref;
   intrusive::Ref* mut_intrusive_ref() { return &intrusive_ref_; }
 
-  StreamRtDesc() : intrusive_ref_(), stream_desc_(), device_id2stream_(), stream_type_id_() {}
+  StreamRtDesc()
+      : intrusive_ref_(),
+        stream_desc_(),
+        device_id2stream_(),
+        device_id2streams_(),
+        stream_type_id_() {}
   intrusive::Ref intrusive_ref_;
   // fields
   intrusive::shared_ptr<StreamDesc> stream_desc_;
   // containers
   std::vector<intrusive::shared_ptr<Stream>> device_id2stream_;
+  std::vector<std::vector<intrusive::shared_ptr<Stream>>> device_id2streams_;
 
  public:
   // skiplist hooks
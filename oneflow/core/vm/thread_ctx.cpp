@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/vm/thread_ctx.h"
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/vm/schedule_priority.h"
 
 namespace oneflow {
 namespace vm {
@@ -25,27 +26,43 @@ void ThreadCtx::LoopRun(const std::function<void(ThreadCtx*)>& Initializer) {
 }
 
 intrusive::ChannelStatus ThreadCtx::ReceiveAndRun() {
-  const StreamType& stream_type = stream_rt_desc().stream_type();
-  intrusive::List<INTRUSIVE_FIELD(Instruction, pending_instruction_hook_)> tmp_list;
+  PendingInstructionList tmp_list;
   intrusive::ChannelStatus status = mut_pending_instruction_list()->MoveTo(&tmp_list);
-  INTRUSIVE_FOR_EACH(instruction, &tmp_list) {
-    tmp_list.Erase(instruction.Mutable());
-    stream_type.Run(instruction.Mutable());
-  }
+  RunInScheduleOrder(&tmp_list);
   return status;
 }
 
 intrusive::ChannelStatus ThreadCtx::TryReceiveAndRun() {
-  const StreamType& stream_type = stream_rt_desc().stream_type();
-  intrusive::List<INTRUSIVE_FIELD(Instruction, pending_instruction_hook_)> tmp_list;
+  PendingInstructionList tmp_list;
   intrusive::ChannelStatus status = mut_pending_instruction_list()->TryMoveTo(&tmp_list);
-  INTRUSIVE_FOR_EACH_PTR(instruction, &tmp_list) {
-    CHECK_GT(instruction->ref_cnt(), 1);
-    tmp_list.Erase(instruction);
-    stream_type.Run(instruction);
-  }
+  RunInScheduleOrder(&tmp_list);
   return status;
 }
 
+void ThreadCtx::RunInScheduleOrder(PendingInstructionList* list) {
+  const StreamType& stream_type = stream_rt_desc().stream_type();
+  std::vector<intrusive::shared_ptr<Instruction>> instructions;
+  instructions.reserve(list->size());
+  bool mixed_priorities = false;
+  INTRUSIVE_FOR_EACH_PTR(instruction, list) {
+    mixed_priorities = mixed_priorities
+                       || (!instructions.empty()
+                           && instruction->priority() != instructions.front()->priority());
+    instructions.push_back(list->Erase(instruction));
+  }
+  if (mixed_priorities) {
+    using InstructionPtr = intrusive::shared_ptr<Instruction>;
+    SortInScheduleOrder(
+        &instructions, [](const InstructionPtr& instruction) { return &instruction->stream(); },
+        [](const InstructionPtr& instruction) { return instruction->priority(); });
+  }
+  for (auto& instruction : instructions) {
+    stream_type.Run(instruction.Mutable());
+    // Drops the reference of this thread right away, as the stream recycles the instruction
+    // sooner when it is the only holder.
+    instruction.Reset();
+  }
+}
+
 }  // namespace vm
 }  // namespace oneflow
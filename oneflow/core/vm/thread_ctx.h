@@ -33,6 +33,8 @@ class ThreadCtx final : public intrusive::Base {
   using StreamList = intrusive::List<INTRUSIVE_FIELD(Stream, thread_ctx_stream_hook_)>;
   using PendingInstructionChannel =
       intrusive::Channel<INTRUSIVE_FIELD(Instruction, pending_instruction_hook_)>;
+  using PendingInstructionList =
+      intrusive::List<INTRUSIVE_FIELD(Instruction, pending_instruction_hook_)>;
 
   // Getters
   bool has_stream_rt_desc() const { return stream_rt_desc_ != nullptr; }
@@ -55,6 +57,8 @@ class ThreadCtx final : public intrusive::Base {
 
  private:
   intrusive::ChannelStatus ReceiveAndRun();
+  // Runs the instructions received at once by priority, see SortInScheduleOrder.
+  void RunInScheduleOrder(PendingInstructionList* list);
 
   friend class intrusive::Ref;
   intrusive::Ref* mut_intrusive_ref() { return &intrusive_ref_; }
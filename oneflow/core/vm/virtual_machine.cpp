@@ -13,6 +13,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <algorithm>
 #include <typeinfo>
 #include "oneflow/core/vm/virtual_machine.h"
 #include "oneflow/core/vm/instruction.h"
@@ -21,6 +22,7 @@ limitations under the License.
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/common/multi_client.h"
 #include "oneflow/core/common/cpp_attribute.h"
+#include "oneflow/core/common/util.h"
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/thread/thread_consistent_id.h"
@@ -35,8 +37,7 @@ namespace {
 Maybe<void> ForEachThreadCtx(vm::VirtualMachineEngine* vm,
                              const std::function<Maybe<void>(vm::ThreadCtx*)>& DoEach) {
   INTRUSIVE_UNSAFE_FOR_EACH_PTR(thread_ctx, vm->mut_thread_ctx_list()) {
-    const auto& stream_type = thread_ctx->stream_rt_desc().stream_type_id().stream_type();
-    if (stream_type.OnSchedulerThread()) { continue; }
+    if (thread_ctx->stream_rt_desc().OnSchedulerThread()) { continue; }
     JUST(DoEach(thread_ctx));
   }
   return Maybe<void>::Ok();
@@ -75,9 +76,12 @@ void GetWorkerThreadInitializer(intrusive::shared_ptr<vm::VirtualMachineEngine>
     stream_type_indexes.insert(GetStreamTypeIndex(thread_ctx));
   }
   HashMap<std::type_index, int64_t> stream_type_index2consistent_id;
-  int64_t thread_consistent_id = kThreadConsistentIdScheduler + 1;
+  int64_t thread_consistent_id = kThreadConsistentIdVmWorkerBegin;
   for (const auto& stream_type_index : stream_type_indexes) {
     LOG(INFO) << "transport stream type: " << stream_type_index.name();
+    CHECK_LT(thread_consistent_id,
+             static_cast<int64_t>(TransportToken::MaxNumberOfThreadConsistentUId()))
+        << "too many transport stream types";
     stream_type_index2consistent_id[stream_type_index] = thread_consistent_id++;
   }
   *Initializer = [stream_type_index2consistent_id](vm::ThreadCtx* thread_ctx) {
@@ -91,11 +95,24 @@ void GetWorkerThreadInitializer(intrusive::shared_ptr<vm::VirtualMachineEngine>
   };
 }
 
+size_t InstructionBufferSize() {
+  return std::max<int64_t>(ParseIntegerFromEnv("ONEFLOW_VM_INSTRUCTION_BUFFER_SIZE", 16), 1);
+}
+
+int64_t NewVirtualMachineId() {
+  static std::atomic<int64_t> virtual_machine_cnt(0);
+  return virtual_machine_cnt++;
+}
+
 }  // namespace
 
 VirtualMachine::VirtualMachine(const Resource& resource, int64_t this_machine_id)
     : vm_(intrusive::make_shared<vm::VirtualMachineEngine>(
-        vm::MakeVmDesc(resource, this_machine_id).Get())) {
+        vm::MakeVmDesc(resource, this_machine_id).Get())),
+      id_(NewVirtualMachineId()),
+      instruction_buffer_size_(InstructionBufferSize()),
+      last_buffering_thread_id_(std::thread::id()),
+      scheduler_idle_(true) {
   OF_PROFILER_NAME_THIS_HOST_THREAD("_VM::Main");
   std::function<void()> SchedulerInitializer;
   GetSchedulerThreadInitializer(&SchedulerInitializer);
@@ -140,6 +157,57 @@ VirtualMachine::~VirtualMachine() {
 }
 
 Maybe<void> VirtualMachine::Receive(vm::InstructionMsgList* instr_list) {
+  JUST(FlushInstructionBuffers());
+  return DoReceive(instr_list);
+}
+
+Maybe<void> VirtualMachine::BufferedReceive(vm::InstructionMsgList* instr_list) {
+  if (instruction_buffer_size_ <= 1 || unlikely(pthread_fork::IsForkedSubProcess())) {
+    return Receive(instr_list);
+  }
+  const auto this_thread_id = std::this_thread::get_id();
+  if (last_buffering_thread_id_.exchange(this_thread_id) != this_thread_id) {
+    JUST(FlushInstructionBuffers());
+  }
+  auto* buffer = ThreadLocalInstructionBuffer();
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+  instr_list->MoveTo(&buffer->instr_msg_list);
+  // Checked after buffering, see Loop.
+  if (buffer->instr_msg_list.size() >= instruction_buffer_size_ || scheduler_idle_) {
+    JUST(DoReceive(&buffer->instr_msg_list));
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> VirtualMachine::FlushInstructionBuffers() {
+  std::unique_lock<std::mutex> lock(instruction_buffers_mutex_);
+  for (const auto& buffer : instruction_buffers_) {
+    std::unique_lock<std::mutex> buffer_lock(buffer->mutex);
+    if (!buffer->instr_msg_list.empty()) { JUST(DoReceive(&buffer->instr_msg_list)); }
+  }
+  // Buffers of exited threads.
+  instruction_buffers_.erase(
+      std::remove_if(instruction_buffers_.begin(), instruction_buffers_.end(),
+                     [](const std::shared_ptr<InstructionBuffer>& buffer) {
+                       return buffer.use_count() == 1 && buffer->instr_msg_list.empty();
+                     }),
+      instruction_buffers_.end());
+  return Maybe<void>::Ok();
+}
+
+VirtualMachine::InstructionBuffer* VirtualMachine::ThreadLocalInstructionBuffer() {
+  static thread_local int64_t virtual_machine_id = -1;
+  static thread_local std::shared_ptr<InstructionBuffer> buffer;
+  if (unlikely(virtual_machine_id != id_)) {
+    buffer = std::make_shared<InstructionBuffer>();
+    std::unique_lock<std::mutex> lock(instruction_buffers_mutex_);
+    instruction_buffers_.push_back(buffer);
+    virtual_machine_id = id_;
+  }
+  return buffer.get();
+}
+
+Maybe<void> VirtualMachine::DoReceive(vm::InstructionMsgList* instr_list) {
   if (unlikely(pthread_fork::IsForkedSubProcess())) {
     CHECK_OR_RETURN(JUST(IsMultiClient()));
     INTRUSIVE_FOR_EACH_PTR(instr_msg, instr_list) {
@@ -174,6 +242,7 @@ void VirtualMachine::Loop(const std::function<void()>& Initializer) {
   auto* vm = mut_vm();
   while (notifier_.WaitAndClearNotifiedCnt() == kNotifierStatusSuccess) {
     OF_PROFILER_RANGE_PUSH("VirtualMachine::Loop");
+    scheduler_idle_ = false;
     auto start = std::chrono::steady_clock::now();
     static constexpr int kWorkingMicroseconds = 1000;
     // Every time this thread wakes up, vm is scheduled for about `kWorkingMicroseconds`.
@@ -200,6 +269,10 @@ void VirtualMachine::Loop(const std::function<void()>& Initializer) {
         do { vm->Schedule(); } while (!vm->ThreadUnsafeEmpty());
       } while (++i < kNumSchedulingPerTimoutTest);
     } while (MicrosecondsFrom(start) < kWorkingMicroseconds);
+    // Instructions buffered before scheduler_idle_ is set are received here, and the ones buffered
+    // after it are received right away by BufferedReceive.
+    scheduler_idle_ = true;
+    CHECK_JUST(FlushInstructionBuffers());
     OF_PROFILER_RANGE_POP();
   }
   while (!vm->Empty()) { vm->Schedule(); }
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_VM_VIRTUAL_MACHINE_H_
 #define ONEFLOW_CORE_VM_VIRTUAL_MACHINE_H_
 
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "oneflow/core/common/notifier.h"
 #include "oneflow/core/vm/interpret_type.h"
 #include "oneflow/core/vm/vm_desc.h"
@@ -33,14 +36,30 @@ class VirtualMachine final {
   VirtualMachine(const Resource& resource, int64_t this_machine_id);
   ~VirtualMachine();
 
+  // Receives what all threads have buffered before instr_list.
   Maybe<void> Receive(vm::InstructionMsgList* instr_list);
+  // Buffers instructions nobody waits for, e.g. eager op kernels and tensor releases, in the
+  // calling thread while the scheduler is busy. They are received in bulk once
+  // ONEFLOW_VM_INSTRUCTION_BUFFER_SIZE of them are buffered, when the scheduler goes idle, or when
+  // any instruction is received unbuffered, e.g. one reading a tensor or syncing. The buffers of
+  // other threads are flushed first when the calling thread differs from the last buffering
+  // thread, as instr_list may use what they have buffered.
+  Maybe<void> BufferedReceive(vm::InstructionMsgList* instr_list);
+  Maybe<void> FlushInstructionBuffers();
 
   const vm::VirtualMachineEngine& vm() const { return *vm_; }
 
  private:
   friend class InstructionsBuilder;
 
+  struct InstructionBuffer {
+    std::mutex mutex;
+    vm::InstructionMsgList instr_msg_list;
+  };
+
   void Loop(const std::function<void()>& Initializer);
+  Maybe<void> DoReceive(vm::InstructionMsgList* instr_list);
+  InstructionBuffer* ThreadLocalInstructionBuffer();
 
   vm::VirtualMachineEngine* mut_vm() { return vm_.Mutable(); }
   void ControlSync();
@@ -50,6 +69,16 @@ class VirtualMachine final {
   std::list<std::unique_ptr<std::thread>> worker_threads_;
   std::thread schedule_thread_;
   Notifier notifier_;
+  // Distinguishes virtual machines created one after another in a process, the thread local
+  // buffers of former ones are not used.
+  const int64_t id_;
+  const size_t instruction_buffer_size_;
+  std::mutex instruction_buffers_mutex_;
+  std::vector<std::shared_ptr<InstructionBuffer>> instruction_buffers_;
+  std::atomic<std::thread::id> last_buffering_thread_id_;
+  // Set before the scheduler flushes the buffers and waits, so that nothing is left buffered while
+  // it waits.
+  std::atomic<bool> scheduler_idle_;
 };
 
 }  // namespace oneflow
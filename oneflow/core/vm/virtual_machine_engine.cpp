@@ -74,7 +74,7 @@ void VirtualMachineEngine::ReleaseInstruction(Instruction* instruction) {
     // Edges are erased only if the instruction is completed.
     out_edges->Erase(out_edge);
     out_instruction->mut_in_edges()->Erase(out_edge);
-    if (Dispatchable(out_instruction)) { mut_ready_instruction_list()->PushBack(out_instruction); }
+    if (Dispatchable(out_instruction)) { PushBackReadyInstruction(out_instruction); }
   }
 }
 
@@ -96,14 +96,14 @@ void VirtualMachineEngine::HandlePending() {
   INTRUSIVE_FOR_EACH_PTR(instruction, &new_instruction_list) {
     ConsumeMirroredObjects(mut_id2logical_object(), instruction);
     if (likely(Dispatchable(instruction))) {
-      mut_ready_instruction_list()->PushBack(instruction);
+      PushBackReadyInstruction(instruction);
       new_instruction_list.Erase(instruction);
     }
   }
   OF_PROFILER_RANGE_POP();
 }
 
-// Collect ready instructions onto ready_instruction_list_
+// Collect ready instructions onto ready_instruction_lists_
 void VirtualMachineEngine::ReleaseFinishedInstructions() {
   INTRUSIVE_FOR_EACH_PTR(stream, mut_active_stream_list()) {
     while (true) {
@@ -352,14 +352,33 @@ void VirtualMachineEngine::ConnectInstructionsByRead(RwMutexedObjectAccess* dst_
   }
 }
 
+// Accesses of finished instructions have left the access list, and writes clear the accesses before
+// them. So if the list holds one read before `freeing_access`, that read is the only access left
+// before the memory gets freed. It is marked only if it runs on the scheduler thread, where nothing
+// else runs while the mark is set.
+void VirtualMachineEngine::TryMarkLastRead(RwMutexedObjectAccess* freeing_access) {
+  auto* rw_mutexed_object = freeing_access->mut_mirrored_object()->mut_rw_mutexed_object();
+  auto* access_list = rw_mutexed_object->mut_access_list();
+  if (access_list->size() != 2) { return; }
+  auto* last_access = access_list->Begin();
+  if (!last_access->is_const_operand()) { return; }
+  if (!OnSchedulerThread(last_access->instruction().stream().thread_ctx().stream_rt_desc())) {
+    return;
+  }
+  last_access->set_is_last_read(true);
+}
+
 void VirtualMachineEngine::ConsumeMirroredObjects(Id2LogicalObject* id2logical_object,
                                                   Instruction* instruction) {
   const auto& phy_instr_operand = instruction->instr_msg().phy_instr_operand();
   if (likely(phy_instr_operand)) {
+    const bool is_freeing =
+        instruction->instr_msg().instr_type_id().instruction_type().IsFreeingMutOperands();
     // Connect instructions by write before connecting by read.
     for (auto* mirrored_object : phy_instr_operand->output_dependences()) {
-      ConnectInstructionsByWrite(
-          AccessMirroredObject(kMutableOperandAccess, mirrored_object, instruction));
+      auto* access = AccessMirroredObject(kMutableOperandAccess, mirrored_object, instruction);
+      if (unlikely(is_freeing)) { TryMarkLastRead(access); }
+      ConnectInstructionsByWrite(access);
     }
     for (auto* mirrored_object : phy_instr_operand->input_dependences()) {
       ConnectInstructionsByRead(
@@ -467,20 +486,37 @@ bool VirtualMachineEngine::Dispatchable(Instruction* instruction) const {
   return true;
 }
 
-// Dispatch ready instructions and put prescheduled instructions onto ready_instruction_list_.
+std::size_t VirtualMachineEngine::ready_instruction_cnt() const {
+  std::size_t cnt = 0;
+  for (const auto& ready_instruction_list : ready_instruction_lists_) {
+    cnt += ready_instruction_list.size();
+  }
+  return cnt;
+}
+
+// Dispatch ready instructions and put prescheduled instructions onto ready_instruction_lists_.
+// All instructions ready in this round get dispatched, from the highest priority to the lowest, so
+// priorities decide which instruction reaches its worker first but starve none of them. Workers
+// run the instructions they receive at once by priority too, see ThreadCtx::RunInScheduleOrder.
 void VirtualMachineEngine::DispatchAndPrescheduleInstructions() {
   OF_PROFILER_RANGE_PUSH("DispatchAndPrescheduleInstructions");
-  ReadyInstructionList tmp_ready_instruction_list;
-  mut_ready_instruction_list()->MoveTo(&tmp_ready_instruction_list);
-  INTRUSIVE_FOR_EACH(instruction, &tmp_ready_instruction_list) {
-    // Erases `instruction` from tmp_ready_instruction_list before dispatching, because
-    // `instruction.dispatched_instruction_hook_` are used in DispatchInstruction.
-    tmp_ready_instruction_list.Erase(instruction.Mutable());
-    DispatchInstruction(instruction.Mutable());
-    // preschedule instructions
-    INTRUSIVE_UNSAFE_FOR_EACH_PTR(edge, instruction->mut_out_edges()) {
-      if (Dispatchable(edge->mut_dst_instruction())) {
-        mut_ready_instruction_list()->PushBack(edge->mut_dst_instruction());
+  ReadyInstructionList tmp_ready_instruction_lists[kSchedulePriorityNum];
+  for (int priority = kSchedulePriorityNum - 1; priority >= 0; --priority) {
+    mut_ready_instruction_list(static_cast<SchedulePriority>(priority))
+        ->MoveTo(&tmp_ready_instruction_lists[priority]);
+  }
+  for (int priority = kSchedulePriorityNum - 1; priority >= 0; --priority) {
+    auto* tmp_ready_instruction_list = &tmp_ready_instruction_lists[priority];
+    INTRUSIVE_FOR_EACH(instruction, tmp_ready_instruction_list) {
+      // Erases `instruction` from tmp_ready_instruction_list before dispatching, because
+      // `instruction.dispatched_instruction_hook_` are used in DispatchInstruction.
+      tmp_ready_instruction_list->Erase(instruction.Mutable());
+      DispatchInstruction(instruction.Mutable());
+      // preschedule instructions
+      INTRUSIVE_UNSAFE_FOR_EACH_PTR(edge, instruction->mut_out_edges()) {
+        if (Dispatchable(edge->mut_dst_instruction())) {
+          PushBackReadyInstruction(edge->mut_dst_instruction());
+        }
       }
     }
   }
@@ -496,7 +532,7 @@ void VirtualMachineEngine::DispatchInstruction(Instruction* instruction) {
   stream->mut_running_instruction_list()->PushBack(instruction);
   if (stream->active_stream_hook().empty()) { mut_active_stream_list()->PushBack(stream); }
   const auto& stream_type = stream->stream_type();
-  if (OnSchedulerThread(stream_type)) {
+  if (OnSchedulerThread(stream->thread_ctx().stream_rt_desc())) {
     stream_type.Run(this, instruction);
   } else {
     stream->mut_thread_ctx()->mut_pending_instruction_list()->PushBack(instruction);
@@ -526,11 +562,27 @@ void VirtualMachineEngine::__Init__(const VmDesc& vm_desc) {
         thread_ctx->mut_stream_list()->PushBack(stream.Mutable());
       }
     }
+    // The other streams of every device, each on a thread of its own.
+    for (int64_t i = 1; i < stream_desc->num_streams_per_device(); ++i) {
+      for (int64_t rel_global_device_id = 0; rel_global_device_id < stream_desc->parallel_num();
+           ++rel_global_device_id) {
+        auto thread_ctx = intrusive::make_shared<ThreadCtx>(stream_rt_desc.Get());
+        mut_thread_ctx_list()->PushBack(thread_ctx.Mutable());
+        StreamId stream_id;
+        stream_id.__Init__(stream_desc->stream_type_id(),
+                           this_start_global_device_id() + rel_global_device_id);
+        auto stream = intrusive::make_shared<Stream>(
+            thread_ctx.Mutable(), stream_id, vm_resource_desc().max_device_num_per_machine());
+        stream_rt_desc->add_stream(stream);
+        thread_ctx->mut_stream_list()->PushBack(stream.Mutable());
+      }
+    }
   }
 }
 
 void VirtualMachineEngine::GetCachedInstrTypeIdAndPhyInstrStream(const std::string& instr_type_name,
                                                                  int device_id,
+                                                                 int64_t stream_index,
                                                                  InstrTypeId* instr_type_id,
                                                                  Stream** stream) {
   auto* cache = &instr_type_name2rt_instr_type_id_;
@@ -542,7 +594,7 @@ void VirtualMachineEngine::GetCachedInstrTypeIdAndPhyInstrStream(const std::stri
     iter = cache->emplace(instr_type_name, RtInstrTypeId(instr_type_id_val, stream_rt_desc)).first;
   }
   instr_type_id->CopyFrom(iter->second.instr_type_id());
-  *stream = iter->second.GetStream(device_id);
+  *stream = iter->second.GetStream(device_id, stream_index);
 }
 
 void VirtualMachineEngine::GetInstrTypeIdAndSoleStream(const std::string& instr_type_name,
@@ -554,6 +606,15 @@ void VirtualMachineEngine::GetInstrTypeIdAndSoleStream(const std::string& instr_
   *stream = stream_rt_desc->GetSoleStream();
 }
 
+Maybe<void> VirtualMachineEngine::SetStreamSchedulePriority(const std::string& instr_type_name,
+                                                            SchedulePriority priority) {
+  const auto& stream_type_id = LookupInstrTypeId(instr_type_name).stream_type_id();
+  auto* stream_rt_desc = mut_stream_type_id2stream_rt_desc()->FindPtr(stream_type_id);
+  CHECK_NOTNULL_OR_RETURN(stream_rt_desc) << "no stream runs " << instr_type_name;
+  stream_rt_desc->mut_stream_desc()->set_priority(priority);
+  return Maybe<void>::Ok();
+}
+
 int64_t InstructionMaxRunningSeconds() { return 60 * 5; }
 
 // Returns true if old pending_instruction_list is empty
@@ -598,6 +659,10 @@ bool VirtualMachineEngine::OnSchedulerThread(const StreamType& stream_type) {
   return stream_type.OnSchedulerThread() || pthread_fork::IsForkedSubProcess();
 }
 
+bool VirtualMachineEngine::OnSchedulerThread(const StreamRtDesc& stream_rt_desc) {
+  return stream_rt_desc.OnSchedulerThread() || pthread_fork::IsForkedSubProcess();
+}
+
 // Barrier instructions are run after all previous lively instructions.
 //
 // `instruction.lively_instruction_hook_` is linked to `vm.lively_instruction_list_` for all
@@ -716,7 +781,7 @@ void VirtualMachineEngine::Schedule() {
   //  to get the mutex lock.
   if (unlikely(pending_msg_list().thread_unsafe_size())) { HandlePending(); }
   // dispatch ready instructions and try to schedule out instructions in DAG onto ready list.
-  if (unlikely(mut_ready_instruction_list()->size())) { DispatchAndPrescheduleInstructions(); }
+  if (unlikely(ready_instruction_cnt())) { DispatchAndPrescheduleInstructions(); }
 }
 
 bool VirtualMachineEngine::ThreadUnsafeEmpty() const {
@@ -113,23 +113,36 @@ class VirtualMachineEngine final : public intrusive::Base {
   }
 
   void GetCachedInstrTypeIdAndPhyInstrStream(const std::string& instr_type_name, int device_id,
-                                             InstrTypeId* instr_type_id, Stream** stream);
+                                             int64_t stream_index, InstrTypeId* instr_type_id,
+                                             Stream** stream);
 
   void GetInstrTypeIdAndSoleStream(const std::string& instr_type_name, InstrTypeId* instr_type_id,
                                    Stream** stream);
 
+  // Sets the priority of the streams running instructions named instr_type_name. It may be called
+  // from any thread and takes effect on the instructions built afterwards.
+  Maybe<void> SetStreamSchedulePriority(const std::string& instr_type_name,
+                                        SchedulePriority priority);
+
  private:
   using InstructionMsgList = intrusive::List<INTRUSIVE_FIELD(InstructionMsg, instr_msg_hook_)>;
   using ReadyInstructionList =
       intrusive::List<INTRUSIVE_FIELD(Instruction, dispatched_instruction_hook_)>;
 
-  ReadyInstructionList* mut_ready_instruction_list() { return &ready_instruction_list_; }
+  ReadyInstructionList* mut_ready_instruction_list(SchedulePriority priority) {
+    return &ready_instruction_lists_[priority];
+  }
+  std::size_t ready_instruction_cnt() const;
+  void PushBackReadyInstruction(Instruction* instruction) {
+    mut_ready_instruction_list(instruction->priority())->PushBack(instruction);
+  }
 
   void ReleaseFinishedInstructions();
   void HandlePending();
   void TryRunBarrierInstruction();
   void DispatchAndPrescheduleInstructions();
   bool OnSchedulerThread(const StreamType& stream_type);
+  bool OnSchedulerThread(const StreamRtDesc& stream_rt_desc);
 
   void ReleaseInstruction(Instruction* instruction);
   void MakeInstructions(InstructionMsg*, /*out*/ InstructionList* ret_instruction_list);
@@ -167,6 +180,7 @@ class VirtualMachineEngine final : public intrusive::Base {
   void TryConnectInstruction(Instruction* src_instruction, Instruction* dst_instruction);
   void ConnectInstructionsByWrite(RwMutexedObjectAccess* dst_access);
   void ConnectInstructionsByRead(RwMutexedObjectAccess* dst_access);
+  void TryMarkLastRead(RwMutexedObjectAccess* freeing_access);
   RwMutexedObjectAccess* AccessMirroredObject(OperandAccessType access_type,
                                               MirroredObject* mirrored_object,
                                               Instruction* instrution);
@@ -191,7 +205,7 @@ class VirtualMachineEngine final : public intrusive::Base {
         id2logical_object_(),
         delete_logical_object_list_(),
         pending_msg_list_(),
-        ready_instruction_list_(),
+        ready_instruction_lists_(),
         lively_instruction_list_(),
         barrier_instruction_list_() {}
   intrusive::Ref intrusive_ref_;
@@ -207,7 +221,8 @@ class VirtualMachineEngine final : public intrusive::Base {
   Id2LogicalObject id2logical_object_;
   LogicalObjectDeleteList delete_logical_object_list_;
   InstructionMsgMutextList pending_msg_list_;
-  ReadyInstructionList ready_instruction_list_;
+  // Ready instructions bucketed by priority. Higher priorities get dispatched first.
+  ReadyInstructionList ready_instruction_lists_[kSchedulePriorityNum];
   LivelyInstructionList lively_instruction_list_;
   BarrierInstructionList barrier_instruction_list_;
   std::map<std::string, RtInstrTypeId> instr_type_name2rt_instr_type_id_;
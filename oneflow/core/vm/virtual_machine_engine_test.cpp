@@ -14,8 +14,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <iostream>
+#include <set>
 #include "oneflow/core/vm/virtual_machine_engine.h"
 #include "oneflow/core/vm/control_stream_type.h"
+#include "oneflow/core/vm/device_helper_stream_type.h"
 #include "oneflow/core/vm/vm_desc.h"
 #include "oneflow/core/vm/stream_type.h"
 #include "oneflow/core/vm/instruction_type.h"
@@ -39,6 +41,36 @@ TEST(VirtualMachineEngine, __Init__) {
   ASSERT_EQ(vm->stream_type_id2stream_rt_desc().size(), 2);
 }
 
+TEST(VirtualMachineEngine, num_streams_per_device) {
+  auto vm_desc = intrusive::make_shared<VmDesc>(TestUtil::NewVmResourceDesc().Get());
+  StreamTypeId stream_type_id;
+  stream_type_id.__Init__(LookupStreamType4TypeIndex<DeviceHelperStreamType>());
+  auto stream_desc = intrusive::make_shared<StreamDesc>(stream_type_id, 2, 2);
+  stream_desc->set_num_streams_per_device(3);
+  vm_desc->mut_stream_type_id2desc()->Insert(stream_desc.Mutable());
+  auto vm = intrusive::make_shared<VirtualMachineEngine>(vm_desc.Get());
+  // The first streams of both devices share a thread, the others get a thread each.
+  ASSERT_EQ(vm->thread_ctx_list().size(), 1 + 2 * 2);
+  const auto* stream_rt_desc = vm->mut_stream_type_id2stream_rt_desc()->FindPtr(stream_type_id);
+  ASSERT_FALSE(stream_rt_desc->OnSchedulerThread());
+  for (int device_id = 0; device_id < 2; ++device_id) {
+    std::set<const Stream*> streams;
+    std::set<const ThreadCtx*> thread_ctxs;
+    for (int64_t i = 0; i < 3; ++i) {
+      const Stream* stream = stream_rt_desc->GetDeviceStream(device_id, i);
+      ASSERT_EQ(stream->device_id(), device_id);
+      streams.insert(stream);
+      thread_ctxs.insert(&stream->thread_ctx());
+    }
+    ASSERT_EQ(streams.size(), 3);
+    ASSERT_EQ(thread_ctxs.size(), 3);
+    ASSERT_EQ(stream_rt_desc->GetDeviceStream(device_id, 0),
+              stream_rt_desc->GetDeviceStream(device_id));
+    ASSERT_EQ(stream_rt_desc->GetDeviceStream(device_id, 3),
+              stream_rt_desc->GetDeviceStream(device_id, 0));
+  }
+}
+
 }  // namespace
 
 }  // namespace test
@@ -33,6 +33,7 @@ void RwMutexedObjectAccess::__Init__(Instruction* instruction, MirroredObject* m
   set_mirrored_object(mirrored_object);
   set_rw_mutexed_object(mirrored_object->mut_rw_mutexed_object());
   set_access_type(access_type);
+  set_is_last_read(false);
   mut_mirrored_object_id()->CopyFrom(mirrored_object->mirrored_object_id());
 }
 
@@ -58,9 +58,13 @@ class RwMutexedObjectAccess final
   }
   const MirroredObjectId& mirrored_object_id() const { return mirrored_object_id_.key().Get(); }
   bool is_mirrored_object_id_inserted() const { return !mirrored_object_id_.empty(); }
+  // True if nothing but an instruction freeing the object accesses it after this read, see
+  // InstructionType::IsFreeingMutOperands.
+  bool is_last_read() const { return is_last_read_; }
 
   // Setters
   void set_access_type(OperandAccessType val) { access_type_ = val; }
+  void set_is_last_read(bool val) { is_last_read_ = val; }
   void set_instruction(Instruction* val) { instruction_ = val; }
   void set_mirrored_object(MirroredObject* val) { mirrored_object_ = val; }
   void set_rw_mutexed_object(RwMutexedObject* val) { rw_mutexed_object_ = val; }
@@ -88,6 +92,7 @@ class RwMutexedObjectAccess final
   RwMutexedObjectAccess()
       : intrusive_ref_(),
         access_type_(),
+        is_last_read_(),
         instruction_(),
         mirrored_object_(),
         rw_mutexed_object_(),
@@ -97,6 +102,7 @@ class RwMutexedObjectAccess final
   intrusive::Ref intrusive_ref_;
   // fields
   OperandAccessType access_type_;
+  bool is_last_read_;
   Instruction* instruction_;
   MirroredObject* mirrored_object_;
   RwMutexedObject* rw_mutexed_object_;
@@ -41,6 +41,12 @@ Maybe<void> Run(vm::InstructionMsgList* instr_msg_list) {
   return Maybe<void>::Ok();
 }
 
+Maybe<void> BufferedRun(vm::InstructionMsgList* instr_msg_list) {
+  auto* virtual_machine = JUST(GlobalMaybe<VirtualMachine>());
+  JUST(virtual_machine->BufferedReceive(instr_msg_list));
+  return Maybe<void>::Ok();
+}
+
 Maybe<void> ClusterSync() {
   Maybe<void> (*Run)(const std::function<Maybe<void>(InstructionsBuilder*)>& Build) =
       JUST(IsMultiClient()) ? &PhysicalRun : &LogicalRun;
@@ -28,6 +28,8 @@ struct InstructionMsg;
 intrusive::shared_ptr<InstructionMsg> NewInstruction(const std::string& instr_type_name);
 
 Maybe<void> Run(vm::InstructionMsgList* instr_msg_list);
+// See VirtualMachine::BufferedReceive.
+Maybe<void> BufferedRun(vm::InstructionMsgList* instr_msg_list);
 Maybe<void> ClusterSync();
 Maybe<void> CurrentRankSync();
 
@@ -0,0 +1,217 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/jpeg_decoder.h"
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr int kMaxScaleDenom = 8;
+constexpr int kMaxMcuSize = 16;
+constexpr unsigned int kExifOrientationTag = 0x0112;
+
+struct JpegErrorManager {
+  jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+};
+
+void JpegErrorExit(j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->setjmp_buffer, 1);
+}
+
+// Corrupt data falls back to OpenCV, which reports it, so libjpeg-turbo warnings are dropped.
+void JpegOutputMessage(j_common_ptr cinfo) {}
+
+int DivUp(int n, int d) { return (n + d - 1) / d; }
+
+// Returns the orientation in the EXIF segment of the image, 1 (the default) if there is none.
+int GetExifOrientation(const jpeg_decompress_struct& cinfo) {
+  for (jpeg_saved_marker_ptr marker = cinfo.marker_list; marker != nullptr;
+       marker = marker->next) {
+    if (marker->marker != JPEG_APP0 + 1 || marker->data_length < 14
+        || memcmp(marker->data, "Exif\0\0", 6) != 0) {
+      continue;
+    }
+    const unsigned char* tiff = marker->data + 6;
+    const size_t length = marker->data_length - 6;
+    bool little_endian = false;
+    if (tiff[0] == 'I' && tiff[1] == 'I') {
+      little_endian = true;
+    } else if (!(tiff[0] == 'M' && tiff[1] == 'M')) {
+      continue;
+    }
+    auto Read16 = [&](size_t offset) -> unsigned int {
+      return little_endian ? (tiff[offset] | (tiff[offset + 1] << 8))
+                           : ((tiff[offset] << 8) | tiff[offset + 1]);
+    };
+    auto Read32 = [&](size_t offset) -> size_t {
+      const size_t low = Read16(little_endian ? offset : offset + 2);
+      const size_t high = Read16(little_endian ? offset + 2 : offset);
+      return (high << 16) | low;
+    };
+    if (Read16(2) != 42) { continue; }
+    const size_t ifd_offset = Read32(4);
+    if (ifd_offset + 2 > length) { continue; }
+    const unsigned int num_entries = Read16(ifd_offset);
+    FOR_RANGE(unsigned int, i, 0, num_entries) {
+      const size_t entry_offset = ifd_offset + 2 + 12 * i;
+      if (entry_offset + 12 > length) { break; }
+      if (Read16(entry_offset) == kExifOrientationTag) { return Read16(entry_offset + 8); }
+    }
+  }
+  return 1;
+}
+
+// Everything between setjmp and the end of the decode is plain C state, so a longjmp out of
+// libjpeg-turbo on corrupt data skips no destructor.
+bool DecodeJpeg(const unsigned char* data, size_t length, const std::string* color_space,
+                const CropWindow* crop, int min_width, int min_height, int* width, int* height,
+                TensorBuffer* image) {
+  J_COLOR_SPACE out_color_space = JCS_UNKNOWN;
+  int num_channels = 0;
+  if (color_space != nullptr) {
+    if (*color_space == "RGB") {
+      out_color_space = JCS_RGB;
+      num_channels = 3;
+    } else if (*color_space == "BGR") {
+      out_color_space = JCS_EXT_BGR;
+      num_channels = 3;
+    } else if (*color_space == "GRAY") {
+      out_color_space = JCS_GRAYSCALE;
+      num_channels = 1;
+    } else {
+      UNIMPLEMENTED();
+    }
+  }
+  if (length < 2 || data[0] != 0xFF || data[1] != 0xD8) { return false; }
+
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager err;
+  cinfo.err = jpeg_std_error(&err.pub);
+  err.pub.error_exit = JpegErrorExit;
+  err.pub.output_message = JpegOutputMessage;
+  if (setjmp(err.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, data, length);
+  jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+  if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK || GetExifOrientation(cinfo) != 1
+      || cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  if (image == nullptr) {
+    *width = cinfo.image_width;
+    *height = cinfo.image_height;
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+  }
+
+  int crop_x = 0;
+  int crop_y = 0;
+  const int image_width = cinfo.image_width;
+  const int image_height = cinfo.image_height;
+  int crop_w = image_width;
+  int crop_h = image_height;
+  if (crop != nullptr) {
+    crop_y = crop->anchor.At(0);
+    crop_x = crop->anchor.At(1);
+    crop_h = crop->shape.At(0);
+    crop_w = crop->shape.At(1);
+    CHECK(crop_x >= 0 && crop_y >= 0 && crop_w > 0 && crop_h > 0);
+    CHECK_LE(crop_x + crop_w, image_width);
+    CHECK_LE(crop_y + crop_h, image_height);
+  }
+  int scale_denom = 1;
+  if (min_width > 0 && min_height > 0) {
+    while (scale_denom < kMaxScaleDenom && DivUp(crop_w, scale_denom * 2) >= min_width
+           && DivUp(crop_h, scale_denom * 2) >= min_height) {
+      scale_denom *= 2;
+    }
+  }
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = scale_denom;
+  cinfo.out_color_space = out_color_space;
+  jpeg_start_decompress(&cinfo);
+
+  // The crop window on the scaled image, the scaled image is output_width x output_height.
+  const JDIMENSION x_begin = crop_x / scale_denom;
+  const JDIMENSION x_end = std::min<JDIMENSION>(DivUp(crop_x + crop_w, scale_denom),
+                                                cinfo.output_width);
+  const JDIMENSION y_begin = crop_y / scale_denom;
+  const JDIMENSION y_end = std::min<JDIMENSION>(DivUp(crop_y + crop_h, scale_denom),
+                                                cinfo.output_height);
+  const JDIMENSION out_w = x_end - x_begin;
+  const JDIMENSION out_h = y_end - y_begin;
+  // jpeg_crop_scanline widens the window to iMCU boundaries and upsamples chroma at its edges as
+  // at the edges of the image, so the window is padded by one iMCU on both sides to decode the
+  // same pixels as a full decode. The extra columns are dropped when the rows are copied out.
+  const JDIMENSION pad = kMaxMcuSize / scale_denom;
+  JDIMENSION crop_xoffset = x_begin > pad ? x_begin - pad : 0;
+  JDIMENSION crop_width = std::min<JDIMENSION>(x_end + pad, cinfo.output_width) - crop_xoffset;
+  if (crop_width < cinfo.output_width) {
+    jpeg_crop_scanline(&cinfo, &crop_xoffset, &crop_width);
+  } else {
+    crop_xoffset = 0;
+  }
+  const size_t row_bytes = out_w * num_channels;
+  const size_t skip_bytes = (x_begin - crop_xoffset) * num_channels;
+  JSAMPARRAY row_buffer = nullptr;
+  if (cinfo.output_width != out_w) {
+    row_buffer = (*cinfo.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_IMAGE,
+                                            cinfo.output_width * num_channels, 1);
+  }
+  image->Resize(Shape({out_h, out_w, num_channels}), DataType::kUInt8);
+  unsigned char* dst = image->mut_data<unsigned char>();
+  if (y_begin > 0) { jpeg_skip_scanlines(&cinfo, y_begin); }
+  while (cinfo.output_scanline < y_end) {
+    unsigned char* dst_row = dst + (cinfo.output_scanline - y_begin) * row_bytes;
+    if (row_buffer == nullptr) {
+      jpeg_read_scanlines(&cinfo, &dst_row, 1);
+    } else {
+      jpeg_read_scanlines(&cinfo, row_buffer, 1);
+      memcpy(dst_row, row_buffer[0] + skip_bytes, row_bytes);
+    }
+  }
+  // Rows below the crop window are never decoded, jpeg_destroy_decompress aborts the rest.
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+
+}  // namespace
+
+bool JpegDecodeEnabled() {
+  static const bool enabled = ParseBooleanFromEnv("ONEFLOW_IMAGE_DECODE_LIBJPEG_TURBO", true);
+  return enabled;
+}
+
+bool JpegGetImageSize(const unsigned char* data, size_t length, int* width, int* height) {
+  return DecodeJpeg(data, length, nullptr, nullptr, 0, 0, width, height, nullptr);
+}
+
+bool JpegDecode(const unsigned char* data, size_t length, const std::string& color_space,
+                const CropWindow* crop, int min_width, int min_height, TensorBuffer* image) {
+  CHECK_NOTNULL(image);
+  return DecodeJpeg(data, length, &color_space, crop, min_width, min_height, nullptr, nullptr,
+                    image);
+}
+
+}  // namespace oneflow
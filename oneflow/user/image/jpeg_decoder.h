@@ -0,0 +1,45 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+#define ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/user/image/crop_window.h"
+
+namespace oneflow {
+
+// The libjpeg-turbo decode path can be turned off with ONEFLOW_IMAGE_DECODE_LIBJPEG_TURBO=0, in
+// which case every image goes through cv::imdecode.
+bool JpegDecodeEnabled();
+
+// Reads the size of a JPEG image from its header without decoding it. Returns false for data that
+// is not a JPEG, or that JpegDecode would not decode the same way as cv::imdecode (an EXIF
+// orientation other than the default), so callers can fall back to OpenCV.
+bool JpegGetImageSize(const unsigned char* data, size_t length, int* width, int* height);
+
+// Decodes a JPEG image into an HWC uint8 image with the channel order of `color_space`, which is
+// one of "RGB", "BGR" and "GRAY". When `crop` is not nullptr, only the window it selects on the
+// full size image is decoded. When `min_width` and `min_height` are positive, the image is
+// decoded at the smallest of the 1/8, 1/4 and 1/2 DCT scales that keeps the (cropped) image at
+// least that large, which is meant for callers that resize to that size afterwards. Returns false
+// if the data cannot be decoded this way, the content of `image` is unspecified in that case.
+bool JpegDecode(const unsigned char* data, size_t length, const std::string& color_space,
+                const CropWindow* crop, int min_width, int min_height, TensorBuffer* image);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
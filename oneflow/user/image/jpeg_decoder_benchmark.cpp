@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
+
+namespace oneflow {
+namespace test {
+
+// Logs the time of a random crop resize with cv::imdecode against the libjpeg-turbo path, which
+// only decodes the crop and does so at a reduced DCT scale.
+TEST(JpegDecoderBenchmark, crop_resize) {
+  cv::Mat noise(1080, 1920, CV_8UC3);
+  cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(255));
+  std::vector<unsigned char> jpeg;
+  CHECK(cv::imencode(".jpg", noise, jpeg, {cv::IMWRITE_JPEG_QUALITY, 90}));
+  CropWindow crop;
+  crop.anchor = Shape({100, 300});
+  crop.shape = Shape({720, 960});
+  const cv::Rect roi(300, 100, 960, 720);
+  const cv::Size target(224, 224);
+  const double opencv_ms = ElapsedMs(
+      [&]() {
+        cv::Mat image = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+        cv::Mat resized;
+        cv::resize(image(roi), resized, target, 0, 0, cv::INTER_LINEAR);
+        cv::cvtColor(resized, resized, cv::COLOR_BGR2RGB);
+      },
+      20);
+  TensorBuffer image;
+  const double jpeg_ms = ElapsedMs(
+      [&]() {
+        CHECK(JpegDecode(jpeg.data(), jpeg.size(), "RGB", &crop, target.width, target.height,
+                         &image));
+        cv::Mat resized;
+        cv::resize(GenCvMat4ImageBuffer(image), resized, target, 0, 0, cv::INTER_LINEAR);
+      },
+      20);
+  LOG(INFO) << "decode 1920x1080, crop 960x720, resize 224x224: opencv " << opencv_ms
+            << "ms, libjpeg-turbo " << jpeg_ms << "ms";
+}
+
+}  // namespace test
+}  // namespace oneflow
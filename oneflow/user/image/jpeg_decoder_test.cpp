@@ -0,0 +1,105 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+std::vector<unsigned char> EncodeJpeg(int width, int height) {
+  cv::Mat image(height, width, CV_8UC3);
+  FOR_RANGE(int, y, 0, height) {
+    FOR_RANGE(int, x, 0, width) {
+      image.at<cv::Vec3b>(y, x) = cv::Vec3b((x * 7 + y) % 256, (y * 3) % 256, ((x ^ y) * 5) % 256);
+    }
+  }
+  std::vector<unsigned char> jpeg;
+  CHECK(cv::imencode(".jpg", image, jpeg, {cv::IMWRITE_JPEG_QUALITY, 90}));
+  return jpeg;
+}
+
+int MaxAbsDiff(const cv::Mat& lhs, const cv::Mat& rhs) {
+  CHECK_EQ(lhs.rows, rhs.rows);
+  CHECK_EQ(lhs.cols, rhs.cols);
+  CHECK_EQ(lhs.channels(), rhs.channels());
+  cv::Mat diff;
+  cv::absdiff(lhs, rhs, diff);
+  double max_diff = 0;
+  cv::minMaxLoc(diff.reshape(1), nullptr, &max_diff);
+  return static_cast<int>(max_diff);
+}
+
+}  // namespace
+
+TEST(JpegDecoder, decode) {
+  for (const auto& size : std::vector<std::pair<int, int>>{{640, 480}, {333, 517}}) {
+    const int width = size.first;
+    const int height = size.second;
+    const std::vector<unsigned char> jpeg = EncodeJpeg(width, height);
+    int header_width = 0;
+    int header_height = 0;
+    ASSERT_TRUE(JpegGetImageSize(jpeg.data(), jpeg.size(), &header_width, &header_height));
+    ASSERT_EQ(header_width, width);
+    ASSERT_EQ(header_height, height);
+    for (const std::string& color_space : {"RGB", "BGR", "GRAY"}) {
+      cv::Mat expected = cv::imdecode(
+          jpeg, ImageUtil::IsColor(color_space) ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+      if (color_space == "RGB") { cv::cvtColor(expected, expected, cv::COLOR_BGR2RGB); }
+
+      TensorBuffer image;
+      ASSERT_TRUE(JpegDecode(jpeg.data(), jpeg.size(), color_space, nullptr, 0, 0, &image));
+      // Both are libjpeg-turbo with the same IDCT, but OpenCV may be linked to another version.
+      ASSERT_LE(MaxAbsDiff(GenCvMat4ImageBuffer(image), expected), 2);
+
+      CropWindow crop;
+      crop.anchor = Shape({37, 101});
+      crop.shape = Shape({height / 2, width / 3});
+      TensorBuffer cropped;
+      ASSERT_TRUE(JpegDecode(jpeg.data(), jpeg.size(), color_space, &crop, 0, 0, &cropped));
+      const cv::Rect roi(101, 37, width / 3, height / 2);
+      ASSERT_EQ(MaxAbsDiff(GenCvMat4ImageBuffer(cropped), GenCvMat4ImageBuffer(image)(roi)), 0);
+
+      TensorBuffer scaled;
+      ASSERT_TRUE(JpegDecode(jpeg.data(), jpeg.size(), color_space, &crop, 50, 60, &scaled));
+      // The smallest scale that keeps the crop at least 50 wide and 60 high.
+      ASSERT_GE(scaled.shape().At(0), 60);
+      ASSERT_GE(scaled.shape().At(1), 50);
+      ASSERT_TRUE(scaled.shape().At(0) < 120 || scaled.shape().At(1) < 100);
+      ASSERT_EQ(scaled.shape().At(2), cropped.shape().At(2));
+    }
+  }
+}
+
+TEST(JpegDecoder, fallback) {
+  std::vector<unsigned char> png;
+  CHECK(cv::imencode(".png", cv::Mat(8, 8, CV_8UC3, cv::Scalar(1, 2, 3)), png));
+  int width = 0;
+  int height = 0;
+  TensorBuffer image;
+  ASSERT_FALSE(JpegGetImageSize(png.data(), png.size(), &width, &height));
+  ASSERT_FALSE(JpegDecode(png.data(), png.size(), "RGB", nullptr, 0, 0, &image));
+
+  const std::vector<unsigned char> jpeg = EncodeJpeg(64, 64);
+  const std::vector<unsigned char> corrupt(jpeg.begin(), jpeg.begin() + 20);
+  ASSERT_FALSE(JpegDecode(corrupt.data(), corrupt.size(), "RGB", nullptr, 0, 0, &image));
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,282 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_SORT_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CPU_SORT_UTIL_H_
+
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace cpu_sort {
+
+// Rows shorter than this are sorted with std::sort, the histogram passes of radix sort do not pay
+// off for them.
+constexpr int64_t kRadixSortMinInstanceSize = 256;
+// Minimal number of elements handled by one thread of the thread pool.
+constexpr int64_t kMinElemCntPerThread = 16384;
+// TopK keeps a bounded heap instead of selecting over the whole index array when k is this small.
+constexpr int64_t kHeapTopKMaxK = 256;
+
+// Maps a key to an unsigned integer whose natural order is the order of the key, so that
+// floating point and signed keys can be radix sorted bytewise.
+template<typename T, typename Enable = void>
+struct RadixKey;
+
+template<typename T>
+struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+  using type = typename std::make_unsigned<T>::type;
+  static constexpr type SignMask() {
+    return std::is_signed<T>::value ? static_cast<type>(type(1) << (sizeof(T) * 8 - 1)) : type(0);
+  }
+  static type Encode(T val) { return static_cast<type>(val) ^ SignMask(); }
+  static T Decode(type val) { return static_cast<T>(val ^ SignMask()); }
+};
+
+template<typename T>
+struct RadixKey<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  using type = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+  static constexpr type SignMask() { return type(1) << (sizeof(T) * 8 - 1); }
+  static type Encode(T val) {
+    type bits;
+    std::memcpy(&bits, &val, sizeof(T));
+    // Negative values have all bits flipped, positive values only the sign bit.
+    return bits ^ ((bits & SignMask()) ? ~type(0) : SignMask());
+  }
+  static T Decode(type val) {
+    const type bits = val ^ ((val & SignMask()) ? SignMask() : ~type(0));
+    T ret;
+    std::memcpy(&ret, &bits, sizeof(T));
+    return ret;
+  }
+};
+
+// Stable LSD radix sort over 8-bit digits. Passes in which every key has the same digit are
+// skipped. The sorted keys (and values, if any) end up in `keys` and `values`.
+template<typename K, typename V>
+void RadixSort(K* keys, K* keys_tmp, V* values, V* values_tmp, int64_t n) {
+  constexpr int kNumPasses = sizeof(K);
+  constexpr int kNumBuckets = 256;
+  int64_t histogram[kNumPasses][kNumBuckets] = {};
+  FOR_RANGE(int64_t, i, 0, n) {
+    K key = keys[i];
+    FOR_RANGE(int, pass, 0, kNumPasses) {
+      ++histogram[pass][key & 0xFF];
+      key >>= 8;
+    }
+  }
+  K* src_keys = keys;
+  K* dst_keys = keys_tmp;
+  V* src_values = values;
+  V* dst_values = values_tmp;
+  FOR_RANGE(int, pass, 0, kNumPasses) {
+    const int shift = pass * 8;
+    int64_t* offsets = histogram[pass];
+    if (offsets[(src_keys[0] >> shift) & 0xFF] == n) { continue; }
+    int64_t sum = 0;
+    FOR_RANGE(int, bucket, 0, kNumBuckets) {
+      const int64_t cnt = offsets[bucket];
+      offsets[bucket] = sum;
+      sum += cnt;
+    }
+    FOR_RANGE(int64_t, i, 0, n) {
+      const int64_t pos = offsets[(src_keys[i] >> shift) & 0xFF]++;
+      dst_keys[pos] = src_keys[i];
+      if (values != nullptr) { dst_values[pos] = src_values[i]; }
+    }
+    std::swap(src_keys, dst_keys);
+    std::swap(src_values, dst_values);
+  }
+  if (src_keys != keys) {
+    std::copy(src_keys, src_keys + n, keys);
+    if (values != nullptr) { std::copy(src_values, src_values + n, values); }
+  }
+}
+
+// Runs DoRange over consecutive ranges of rows on the global thread pool. Small inputs stay on
+// the calling thread.
+template<typename DoRangeT>
+void ParallelForEachRowRange(int64_t instance_num, int64_t instance_size,
+                             const DoRangeT& DoRange) {
+  const int64_t max_range_num = instance_num * instance_size / kMinElemCntPerThread;
+  MultiThreadRangeLoop(instance_num, std::max<int64_t>(max_range_num, 1),
+                       [&](size_t begin, size_t end) { DoRange(Range(begin, end)); });
+}
+
+template<typename T>
+size_t GetSortTmpBufferSize(int64_t elem_cnt) {
+  return 2 * elem_cnt * sizeof(typename RadixKey<T>::type);
+}
+
+// Every row owns 2 key buffers and 1 index buffer. The key buffers are padded to keep the index
+// buffer aligned, e.g. for 1-byte keys of rows with odd lengths.
+template<typename T, typename IndexT>
+size_t GetArgSortKeyBytesPerInstance(int64_t instance_size) {
+  using K = typename RadixKey<T>::type;
+  return RoundUp(2 * instance_size * sizeof(K), alignof(IndexT));
+}
+
+// Padded to keep the keys and indices of the next row aligned.
+template<typename T, typename IndexT>
+size_t GetArgSortTmpBytesPerInstance(int64_t instance_size) {
+  using K = typename RadixKey<T>::type;
+  return RoundUp(GetArgSortKeyBytesPerInstance<T, IndexT>(instance_size)
+                     + instance_size * sizeof(IndexT),
+                 std::max(alignof(K), alignof(IndexT)));
+}
+
+template<typename T, typename IndexT>
+size_t GetArgSortTmpBufferSize(int64_t instance_num, int64_t instance_size) {
+  return instance_num * GetArgSortTmpBytesPerInstance<T, IndexT>(instance_size);
+}
+
+template<typename T>
+void SortRow(const T* in, T* out, int64_t n, bool descending, typename RadixKey<T>::type* tmp) {
+  using K = typename RadixKey<T>::type;
+  if (n < kRadixSortMinInstanceSize) {
+    std::copy(in, in + n, out);
+    if (descending) {
+      std::sort(out, out + n, std::greater<T>());
+    } else {
+      std::sort(out, out + n, std::less<T>());
+    }
+    return;
+  }
+  K* keys = tmp;
+  K* keys_tmp = tmp + n;
+  const K flip = descending ? ~K(0) : K(0);
+  FOR_RANGE(int64_t, i, 0, n) { keys[i] = RadixKey<T>::Encode(in[i]) ^ flip; }
+  RadixSort<K, char>(keys, keys_tmp, nullptr, nullptr, n);
+  FOR_RANGE(int64_t, i, 0, n) { out[i] = RadixKey<T>::Decode(keys[i] ^ flip); }
+}
+
+// Equal keys keep their original order, which matches the index tie-break of the comparator
+// based implementation.
+template<typename T, typename IndexT>
+void ArgSortRow(const T* in, IndexT* out, int64_t n, bool descending, void* tmp) {
+  using K = typename RadixKey<T>::type;
+  std::iota(out, out + n, 0);
+  if (n < kRadixSortMinInstanceSize) {
+    auto comp = [&](const IndexT lhs, const IndexT rhs) {
+      const T l = in[lhs];
+      const T r = in[rhs];
+      if (l == r) { return lhs < rhs; }
+      return descending ? l > r : l < r;
+    };
+    std::sort(out, out + n, comp);
+    return;
+  }
+  K* keys = static_cast<K*>(tmp);
+  K* keys_tmp = keys + n;
+  IndexT* values_tmp = reinterpret_cast<IndexT*>(
+      static_cast<char*>(tmp) + GetArgSortKeyBytesPerInstance<T, IndexT>(n));
+  const K flip = descending ? ~K(0) : K(0);
+  // -0.0 and 0.0 compare equal, give them the same key to keep the tie-break by index.
+  FOR_RANGE(int64_t, i, 0, n) {
+    keys[i] = RadixKey<T>::Encode(in[i] == T(0) ? T(0) : in[i]) ^ flip;
+  }
+  RadixSort<K, IndexT>(keys, keys_tmp, out, values_tmp, n);
+}
+
+template<typename T>
+void Sort(const T* in, T* out, int64_t instance_num, int64_t instance_size, bool descending,
+          void* tmp_buffer) {
+  using K = typename RadixKey<T>::type;
+  ParallelForEachRowRange(instance_num, instance_size, [&](const Range& range) {
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      const int64_t offset = i * instance_size;
+      SortRow<T>(in + offset, out + offset, instance_size, descending,
+                 static_cast<K*>(tmp_buffer) + 2 * offset);
+    }
+  });
+}
+
+template<typename T, typename IndexT>
+void ArgSort(const T* in, IndexT* out, int64_t instance_num, int64_t instance_size,
+             bool descending, void* tmp_buffer) {
+  const size_t tmp_bytes_per_instance = GetArgSortTmpBytesPerInstance<T, IndexT>(instance_size);
+  ParallelForEachRowRange(instance_num, instance_size, [&](const Range& range) {
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      const int64_t offset = i * instance_size;
+      ArgSortRow<T, IndexT>(in + offset, out + offset, instance_size, descending,
+                            static_cast<char*>(tmp_buffer) + i * tmp_bytes_per_instance);
+    }
+  });
+}
+
+// Writes the indices of the k largest elements of a row into out, largest first. Ties are
+// broken by the smaller index.
+template<typename T>
+void TopKRowWithHeap(const T* in, int64_t n, int64_t k, std::vector<std::pair<T, int64_t>>* heap,
+                     int64_t* out) {
+  // `better(a, b)` orders the heap so that its front is the worst of the kept elements.
+  auto better = [](const std::pair<T, int64_t>& a, const std::pair<T, int64_t>& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+  };
+  heap->clear();
+  FOR_RANGE(int64_t, i, 0, k) { heap->emplace_back(in[i], i); }
+  std::make_heap(heap->begin(), heap->end(), better);
+  FOR_RANGE(int64_t, i, k, n) {
+    // Later elements have larger indices, so only strictly larger values can replace the front.
+    if (in[i] > heap->front().first) {
+      std::pop_heap(heap->begin(), heap->end(), better);
+      heap->back() = std::make_pair(in[i], i);
+      std::push_heap(heap->begin(), heap->end(), better);
+    }
+  }
+  std::sort_heap(heap->begin(), heap->end(), better);
+  FOR_RANGE(int64_t, i, 0, k) { out[i] = heap->at(i).second; }
+}
+
+template<typename T>
+void TopKRowWithSelect(const T* in, int64_t n, int64_t k, bool sorted, int64_t* indices,
+                       int64_t* out) {
+  std::iota(indices, indices + n, 0);
+  auto comp = [&](const int64_t lhs, const int64_t rhs) {
+    const T l = in[lhs];
+    const T r = in[rhs];
+    if (l == r) { return lhs < rhs; }
+    return l > r;
+  };
+  std::nth_element(indices, indices + k, indices + n, comp);
+  if (sorted) { std::sort(indices, indices + k, comp); }
+  std::copy(indices, indices + k, out);
+}
+
+template<typename T>
+void TopK(const T* in, int64_t* indices_buffer, int64_t instance_num, int64_t instance_size,
+          int64_t k, bool sorted, int64_t* out) {
+  ParallelForEachRowRange(instance_num, instance_size, [&](const Range& range) {
+    std::vector<std::pair<T, int64_t>> heap;
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      const T* in_i = in + i * instance_size;
+      int64_t* out_i = out + i * k;
+      if (k == 1) {
+        *out_i = std::distance(in_i, std::max_element(in_i, in_i + instance_size));
+      } else if (k <= kHeapTopKMaxK && k < instance_size) {
+        TopKRowWithHeap<T>(in_i, instance_size, k, &heap, out_i);
+      } else {
+        TopKRowWithSelect<T>(in_i, instance_size, k, sorted, indices_buffer + i * instance_size,
+                             out_i);
+      }
+    }
+  });
+}
+
+}  // namespace cpu_sort
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_SORT_UTIL_H_
@@ -0,0 +1,68 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <random>
+#include <gtest/gtest.h>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/user/kernels/cpu_sort_util.h"
+
+namespace oneflow {
+namespace test {
+
+// Logs the time of the sort engine against the single thread std::sort loop it replaces for a
+// few row shapes.
+TEST(CpuSortBenchmark, sort) {
+  ThreadPoolGuard guard(HardwareThreadNum());
+  const std::vector<std::pair<int64_t, int64_t>> shapes = {
+      {1, 1 << 20}, {16, 1 << 16}, {256, 4096}, {4096, 256}, {16384, 64}};
+  for (const auto& shape : shapes) {
+    const int64_t instance_num = shape.first;
+    const int64_t instance_size = shape.second;
+    std::mt19937 gen(instance_num * instance_size);
+    std::uniform_real_distribution<float> dis(-1e6, 1e6);
+    std::vector<float> in(instance_num * instance_size);
+    for (float& val : in) { val = dis(gen); }
+    std::vector<float> out(in.size());
+    std::vector<int32_t> indices(in.size());
+    std::vector<char> tmp(
+        cpu_sort::GetArgSortTmpBufferSize<float, int32_t>(instance_num, instance_size));
+    const double baseline_ms = ElapsedMs(
+        [&]() {
+          std::copy(in.begin(), in.end(), out.begin());
+          FOR_RANGE(int64_t, i, 0, instance_num) {
+            std::sort(out.begin() + i * instance_size, out.begin() + (i + 1) * instance_size);
+          }
+        },
+        3);
+    const double sort_ms = ElapsedMs(
+        [&]() {
+          cpu_sort::Sort<float>(in.data(), out.data(), instance_num, instance_size, false,
+                                tmp.data());
+        },
+        3);
+    const double arg_sort_ms = ElapsedMs(
+        [&]() {
+          cpu_sort::ArgSort<float, int32_t>(in.data(), indices.data(), instance_num,
+                                            instance_size, false, tmp.data());
+        },
+        3);
+    LOG(INFO) << "rows: " << instance_num << ", row length: " << instance_size
+              << ", std::sort: " << baseline_ms << "ms, Sort: " << sort_ms
+              << "ms, ArgSort: " << arg_sort_ms << "ms";
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
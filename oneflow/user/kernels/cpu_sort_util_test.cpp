@@ -0,0 +1,122 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/user/kernels/cpu_sort_util.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+template<typename T>
+std::vector<T> RandomData(int64_t elem_cnt, int64_t num_distinct) {
+  std::mt19937 gen(elem_cnt);
+  std::uniform_int_distribution<int64_t> dis(-num_distinct / 2, num_distinct / 2);
+  std::vector<T> data(elem_cnt);
+  for (T& val : data) { val = static_cast<T>(dis(gen)) / static_cast<T>(3); }
+  return data;
+}
+
+template<typename T>
+void TestSort(int64_t instance_num, int64_t instance_size, bool descending) {
+  const std::vector<T> in = RandomData<T>(instance_num * instance_size, 1000);
+  std::vector<T> out(in.size());
+  std::vector<char> tmp(cpu_sort::GetSortTmpBufferSize<T>(in.size()));
+  cpu_sort::Sort<T>(in.data(), out.data(), instance_num, instance_size, descending, tmp.data());
+  std::vector<T> expected = in;
+  FOR_RANGE(int64_t, i, 0, instance_num) {
+    T* row = expected.data() + i * instance_size;
+    if (descending) {
+      std::sort(row, row + instance_size, std::greater<T>());
+    } else {
+      std::sort(row, row + instance_size, std::less<T>());
+    }
+  }
+  ASSERT_EQ(out, expected);
+}
+
+template<typename T>
+void TestArgSort(int64_t instance_num, int64_t instance_size, bool descending) {
+  const std::vector<T> in = RandomData<T>(instance_num * instance_size, 100);
+  std::vector<int32_t> out(in.size());
+  std::vector<char> tmp(cpu_sort::GetArgSortTmpBufferSize<T, int32_t>(instance_num, instance_size));
+  cpu_sort::ArgSort<T, int32_t>(in.data(), out.data(), instance_num, instance_size, descending,
+                                tmp.data());
+  FOR_RANGE(int64_t, i, 0, instance_num) {
+    const T* in_row = in.data() + i * instance_size;
+    std::vector<int32_t> expected(instance_size);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [&](int32_t lhs, int32_t rhs) {
+      return descending ? in_row[lhs] > in_row[rhs] : in_row[lhs] < in_row[rhs];
+    });
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), out.begin() + i * instance_size));
+  }
+}
+
+template<typename T>
+void TestTopK(int64_t instance_num, int64_t instance_size, int64_t k) {
+  const std::vector<T> in = RandomData<T>(instance_num * instance_size, 100);
+  std::vector<int64_t> indices(in.size());
+  std::vector<int64_t> out(instance_num * k);
+  cpu_sort::TopK<T>(in.data(), indices.data(), instance_num, instance_size, k, true, out.data());
+  FOR_RANGE(int64_t, i, 0, instance_num) {
+    const T* in_row = in.data() + i * instance_size;
+    std::vector<int64_t> expected(instance_size);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(),
+                     [&](int64_t lhs, int64_t rhs) { return in_row[lhs] > in_row[rhs]; });
+    ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + k, out.begin() + i * k));
+  }
+}
+
+}  // namespace
+
+TEST(CpuSort, sort) {
+  ThreadPoolGuard guard(4);
+  for (bool descending : {false, true}) {
+    TestSort<float>(7, 3, descending);
+    TestSort<float>(64, 1000, descending);
+    TestSort<double>(3, 5000, descending);
+    TestSort<int32_t>(16, 4096, descending);
+    TestSort<int64_t>(2, 300, descending);
+  }
+}
+
+TEST(CpuSort, arg_sort) {
+  ThreadPoolGuard guard(4);
+  for (bool descending : {false, true}) {
+    TestArgSort<float>(5, 17, descending);
+    TestArgSort<float>(64, 1000, descending);
+    TestArgSort<double>(3, 777, descending);
+    TestArgSort<int8_t>(8, 1024, descending);
+    TestArgSort<uint8_t>(8, 1024, descending);
+    // Odd lengths of 1-byte keys need padding to keep the indices aligned.
+    TestArgSort<int8_t>(7, 1001, descending);
+    TestArgSort<int64_t>(32, 4096, descending);
+  }
+}
+
+TEST(CpuSort, top_k) {
+  ThreadPoolGuard guard(4);
+  TestTopK<float>(64, 1000, 1);
+  TestTopK<float>(64, 1000, 10);
+  TestTopK<double>(16, 5000, 300);
+  TestTopK<int32_t>(8, 100, 100);
+  TestTopK<int8_t>(8, 4096, 32);
+}
+
+}  // namespace test
+}  // namespace oneflow
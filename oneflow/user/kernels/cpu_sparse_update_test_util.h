@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_SPARSE_UPDATE_TEST_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CPU_SPARSE_UPDATE_TEST_UTIL_H_
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace test {
+
+// Indices drawn from a Zipfian distribution over [0, num_rows) with exponent s, the shape of
+// embedding lookups, where a few rows take most of the hits.
+inline std::vector<int64_t> ZipfianIndices(int64_t num_indices, int64_t num_rows, double s,
+                                           uint32_t seed) {
+  std::vector<double> cdf(num_rows);
+  double sum = 0;
+  FOR_RANGE(int64_t, i, 0, num_rows) {
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+    cdf[i] = sum;
+  }
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dis(0, sum);
+  // Scatters the hot rows over the table instead of keeping them at its front.
+  std::vector<int64_t> permutation(num_rows);
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::shuffle(permutation.begin(), permutation.end(), gen);
+  std::vector<int64_t> indices(num_indices);
+  for (int64_t& index : indices) {
+    const int64_t rank = std::lower_bound(cdf.begin(), cdf.end(), dis(gen)) - cdf.begin();
+    index = permutation[std::min(rank, num_rows - 1)];
+  }
+  return indices;
+}
+
+inline std::vector<float> RandomValues(int64_t elem_cnt, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dis;
+  std::vector<float> values(elem_cnt);
+  for (float& value : values) { value = dis(gen); }
+  return values;
+}
+
+// Momentum on the rows of model and momentum, one call per distinct index.
+struct MomentumRowUpdater {
+  int64_t feature_size;
+  float* model;
+  float* momentum;
+  void operator()(int64_t row, const float* diff) const {
+    float* model_row = model + row * feature_size;
+    float* momentum_row = momentum + row * feature_size;
+    FOR_RANGE(int64_t, j, 0, feature_size) {
+      momentum_row[j] = 0.9f * momentum_row[j] - 0.1f * diff[j];
+      model_row[j] += momentum_row[j];
+    }
+  }
+};
+
+// The single thread loop the engine replaces: sums up duplicates in a hash map, then updates the
+// distinct rows in the order they first appear in.
+inline void ReferenceSumDuplicatesAndUpdate(int64_t feature_size, int64_t lower_bound,
+                                            int64_t upper_bound,
+                                            const std::vector<int64_t>& indices,
+                                            const std::vector<float>& values,
+                                            const MomentumRowUpdater& updater) {
+  std::unordered_map<int64_t, int64_t> index2unique;
+  std::vector<int64_t> unique_indices;
+  std::vector<float> sums;
+  FOR_RANGE(size_t, i, 0, indices.size()) {
+    const int64_t index = indices[i];
+    if (index < lower_bound || index >= upper_bound) { continue; }
+    const float* value = values.data() + i * feature_size;
+    auto it = index2unique.find(index);
+    if (it == index2unique.end()) {
+      index2unique.emplace(index, unique_indices.size());
+      unique_indices.push_back(index);
+      sums.insert(sums.end(), value, value + feature_size);
+    } else {
+      float* sum = sums.data() + it->second * feature_size;
+      FOR_RANGE(int64_t, j, 0, feature_size) { sum[j] += value[j]; }
+    }
+  }
+  FOR_RANGE(size_t, i, 0, unique_indices.size()) {
+    updater(unique_indices[i] - lower_bound, sums.data() + i * feature_size);
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_SPARSE_UPDATE_TEST_UTIL_H_
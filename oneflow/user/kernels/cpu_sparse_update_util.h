@@ -0,0 +1,238 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_CPU_SPARSE_UPDATE_UTIL_H_
+#define ONEFLOW_USER_KERNELS_CPU_SPARSE_UPDATE_UTIL_H_
+
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace cpu_sparse_update {
+
+// Minimal number of indices handled by one thread of the thread pool.
+constexpr int64_t kMinNumIndicesPerThread = 4096;
+// Upper bound of the number of threads, it bounds the count matrix kept in the tmp buffer.
+constexpr int64_t kMaxNumThreads = 64;
+
+// Number of the most significant bits of the hash the partition of an index is picked from.
+constexpr int32_t kNumPartitionHashBits = 6;
+static_assert((int64_t{1} << kNumPartitionHashBits) == kMaxNumThreads, "");
+
+// Fibonacci hashing, whose most significant bits are spread best for dense and for strided indices.
+// The low bits of the product only depend on the low bits of the index, so they are not used.
+inline uint64_t HashIndex(int64_t index) {
+  return static_cast<uint64_t>(index) * 0x9E3779B97F4A7C15ULL;
+}
+
+// Slot of an index in a hash table of 2^capacity_bits slots, taken from the bits of the hash right
+// below the partition bits, 0 < capacity_bits <= 64 - kNumPartitionHashBits.
+inline uint64_t HashSlot(int64_t index, int32_t capacity_bits) {
+  return (HashIndex(index) << kNumPartitionHashBits) >> (64 - capacity_bits);
+}
+
+inline int64_t GetNumThreads(int64_t num_indices) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  if (thread_pool == nullptr || pthread_fork::IsForkedSubProcess()) { return 1; }
+  const int64_t num_thread = std::min(num_indices / kMinNumIndicesPerThread,
+                                      static_cast<int64_t>(thread_pool->thread_num()));
+  return std::max<int64_t>(std::min(num_thread, kMaxNumThreads), 1);
+}
+
+// out[i] += in[i]. The loop is compiled once per instruction set, the compiler vectorizes it for
+// the widest registers the machine has.
+template<typename T>
+struct RowAdder {
+  static void RunDefault(int64_t n, const T* in, T* out) {
+    for (int64_t i = 0; i < n; ++i) { out[i] += in[i]; }
+  }
+
+#if OF_CPU_SIMD_DISPATCH
+  OF_CPU_TARGET_AVX2 static void RunAvx2(int64_t n, const T* in, T* out) {
+    for (int64_t i = 0; i < n; ++i) { out[i] += in[i]; }
+  }
+
+  OF_CPU_TARGET_AVX512 static void RunAvx512(int64_t n, const T* in, T* out) {
+    for (int64_t i = 0; i < n; ++i) { out[i] += in[i]; }
+  }
+#endif  // OF_CPU_SIMD_DISPATCH
+
+  static void Run(ep::CpuIsa isa, int64_t n, const T* in, T* out) {
+#if OF_CPU_SIMD_DISPATCH
+    if (isa == ep::CpuIsa::kAvx512) {
+      RunAvx512(n, in, out);
+    } else if (isa == ep::CpuIsa::kAvx2) {
+      RunAvx2(n, in, out);
+    } else {
+      RunDefault(n, in, out);
+    }
+#else
+    RunDefault(n, in, out);
+#endif  // OF_CPU_SIMD_DISPATCH
+  }
+};
+
+// Layout of the tmp buffer: the count matrix, the position of every index grouped by partition,
+// the distinct indices of every partition, the hash tables and the summed rows.
+template<typename T>
+class TmpBufferManager final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TmpBufferManager);
+  TmpBufferManager(void* ptr, int64_t num_indices, int64_t feature_size) : ptr_(ptr) {
+    const size_t counts_bytes =
+        GetCudaAlignedSize(kMaxNumThreads * kMaxNumThreads * sizeof(int64_t));
+    const size_t positions_bytes = GetCudaAlignedSize(num_indices * sizeof(int64_t));
+    const size_t unique_indices_bytes = GetCudaAlignedSize(num_indices * sizeof(int64_t));
+    // A partition of n indices uses a table of the smallest power of two >= 2n slots, which is
+    // less than 4n.
+    const size_t tables_bytes = GetCudaAlignedSize(4 * num_indices * sizeof(int64_t));
+    const size_t sums_bytes = GetCudaAlignedSize(num_indices * feature_size * sizeof(T));
+    positions_offset_ = counts_bytes;
+    unique_indices_offset_ = positions_offset_ + positions_bytes;
+    tables_offset_ = unique_indices_offset_ + unique_indices_bytes;
+    sums_offset_ = tables_offset_ + tables_bytes;
+    total_buffer_size_ = sums_offset_ + sums_bytes;
+  }
+  ~TmpBufferManager() = default;
+
+  size_t GetTotalBufferSize() const { return total_buffer_size_; }
+  int64_t* CountsPtr() const { return Ptr<int64_t>(0); }
+  int64_t* PositionsPtr() const { return Ptr<int64_t>(positions_offset_); }
+  int64_t* UniqueIndicesPtr() const { return Ptr<int64_t>(unique_indices_offset_); }
+  int64_t* TablesPtr() const { return Ptr<int64_t>(tables_offset_); }
+  T* SumsPtr() const { return Ptr<T>(sums_offset_); }
+
+ private:
+  template<typename U>
+  U* Ptr(size_t offset) const {
+    CHECK(ptr_ != nullptr);
+    return reinterpret_cast<U*>(reinterpret_cast<char*>(ptr_) + offset);
+  }
+
+  size_t positions_offset_;
+  size_t unique_indices_offset_;
+  size_t tables_offset_;
+  size_t sums_offset_;
+  size_t total_buffer_size_;
+  void* ptr_;
+};
+
+template<typename T>
+size_t GetTmpBufferSize(int64_t num_indices, int64_t feature_size) {
+  return TmpBufferManager<T>(nullptr, num_indices, feature_size).GetTotalBufferSize();
+}
+
+// Sums up the rows of `values` that share an index and calls UpdateRow(row, diff) once for every
+// distinct index in [lower_bound, upper_bound), with row = index - lower_bound and diff the summed
+// row of feature_size elements. Indices out of the bounds are skipped.
+//
+// The indices are partitioned across threads by their hash: every thread first counts and then
+// scatters the positions of its slice of the indices into the partitions, and then owns one
+// partition, which it deduplicates with an open addressing table and updates. A row of the model
+// and of its optimizer states is only ever touched by the thread owning its index, so no atomics
+// are needed. Duplicates are summed in the order they appear in, which keeps the result
+// independent of the number of threads.
+template<typename T, typename K, typename UpdateRowT>
+void SumDuplicatesAndUpdate(int64_t num_indices, int64_t feature_size, int64_t lower_bound,
+                            int64_t upper_bound, const K* indices, const T* values, void* tmp,
+                            const UpdateRowT& UpdateRow) {
+  if (num_indices == 0) { return; }
+  const TmpBufferManager<T> buffer_manager(tmp, num_indices, feature_size);
+  int64_t* counts = buffer_manager.CountsPtr();
+  int64_t* positions = buffer_manager.PositionsPtr();
+  const int64_t num_thread = GetNumThreads(num_indices);
+  const ep::CpuIsa isa = ep::GetCpuIsa();
+  const BalancedSplitter bs(num_indices, num_thread);
+  const auto PartitionOf = [num_thread](int64_t index) {
+    return static_cast<int64_t>(((HashIndex(index) >> 32) * num_thread) >> 32);
+  };
+  const auto InBounds = [lower_bound, upper_bound](int64_t index) {
+    return index >= lower_bound && index < upper_bound;
+  };
+  // counts[slice * num_thread + partition] is the number of indices of the partition in the slice.
+  MultiThreadLoop(num_thread, [&](int64_t slice) {
+    int64_t* slice_counts = counts + slice * num_thread;
+    std::fill(slice_counts, slice_counts + num_thread, 0);
+    const Range range = bs.At(slice);
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      const int64_t index = static_cast<int64_t>(indices[i]);
+      if (InBounds(index)) { ++slice_counts[PartitionOf(index)]; }
+    }
+  });
+  // Turns the counts into the offsets every slice writes its positions of a partition at, slices in
+  // order within a partition.
+  std::vector<int64_t> partition_offsets(num_thread + 1);
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, partition, 0, num_thread) {
+    partition_offsets[partition] = offset;
+    FOR_RANGE(int64_t, slice, 0, num_thread) {
+      int64_t* count = counts + slice * num_thread + partition;
+      const int64_t num = *count;
+      *count = offset;
+      offset += num;
+    }
+  }
+  partition_offsets[num_thread] = offset;
+  MultiThreadLoop(num_thread, [&](int64_t slice) {
+    int64_t* slice_offsets = counts + slice * num_thread;
+    const Range range = bs.At(slice);
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      const int64_t index = static_cast<int64_t>(indices[i]);
+      if (InBounds(index)) { positions[slice_offsets[PartitionOf(index)]++] = i; }
+    }
+  });
+  MultiThreadLoop(num_thread, [&](int64_t partition) {
+    const int64_t begin = partition_offsets[partition];
+    const int64_t num = partition_offsets[partition + 1] - begin;
+    if (num == 0) { return; }
+    int32_t capacity_bits = 1;
+    while ((int64_t{1} << capacity_bits) < 2 * num) { capacity_bits += 1; }
+    const int64_t capacity = int64_t{1} << capacity_bits;
+    const uint64_t mask = static_cast<uint64_t>(capacity - 1);
+    // Slots hold the number of the distinct index in the partition, -1 if empty.
+    int64_t* table = buffer_manager.TablesPtr() + 4 * begin;
+    int64_t* unique_indices = buffer_manager.UniqueIndicesPtr() + begin;
+    T* sums = buffer_manager.SumsPtr() + begin * feature_size;
+    std::fill(table, table + capacity, -1);
+    int64_t num_unique = 0;
+    FOR_RANGE(int64_t, i, begin, begin + num) {
+      const int64_t position = positions[i];
+      const int64_t index = static_cast<int64_t>(indices[position]);
+      const T* value = values + position * feature_size;
+      uint64_t slot = HashSlot(index, capacity_bits);
+      while (table[slot] != -1 && unique_indices[table[slot]] != index) {
+        slot = (slot + 1) & mask;
+      }
+      if (table[slot] == -1) {
+        table[slot] = num_unique;
+        unique_indices[num_unique] = index;
+        std::copy(value, value + feature_size, sums + num_unique * feature_size);
+        num_unique += 1;
+      } else {
+        RowAdder<T>::Run(isa, feature_size, value, sums + table[slot] * feature_size);
+      }
+    }
+    FOR_RANGE(int64_t, i, 0, num_unique) {
+      UpdateRow(unique_indices[i] - lower_bound, sums + i * feature_size);
+    }
+  });
+}
+
+}  // namespace cpu_sparse_update
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_CPU_SPARSE_UPDATE_UTIL_H_
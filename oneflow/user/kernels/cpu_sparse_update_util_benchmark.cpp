@@ -0,0 +1,62 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <unordered_set>
+#include <gtest/gtest.h>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/user/kernels/cpu_sparse_update_test_util.h"
+#include "oneflow/user/kernels/cpu_sparse_update_util.h"
+
+namespace oneflow {
+namespace test {
+
+// Logs the time of the engine against the single thread loop it replaces for Zipfian indices of a
+// few skews.
+TEST(CpuSparseUpdateBenchmark, sum_duplicates_and_update) {
+  ThreadPoolGuard guard(HardwareThreadNum());
+  const int64_t num_indices = 1 << 18;
+  const int64_t num_rows = 1 << 20;
+  for (int64_t feature_size : {16, 128}) {
+    for (double s : {0.8, 1.05, 1.4}) {
+      const std::vector<int64_t> indices = ZipfianIndices(num_indices, num_rows, s, 0);
+      const std::vector<float> values = RandomValues(num_indices * feature_size, 1);
+      std::vector<float> model(num_rows * feature_size, 0);
+      std::vector<float> momentum(model.size(), 0);
+      const MomentumRowUpdater updater{feature_size, model.data(), momentum.data()};
+      std::vector<char> tmp(cpu_sparse_update::GetTmpBufferSize<float>(num_indices, feature_size));
+      const double baseline_ms = ElapsedMs(
+          [&]() {
+            ReferenceSumDuplicatesAndUpdate(feature_size, 0, num_rows, indices, values, updater);
+          },
+          3);
+      const double engine_ms = ElapsedMs(
+          [&]() {
+            cpu_sparse_update::SumDuplicatesAndUpdate<float, int64_t>(
+                num_indices, feature_size, 0, num_rows, indices.data(), values.data(), tmp.data(),
+                updater);
+          },
+          3);
+      const int64_t num_unique =
+          std::unordered_set<int64_t>(indices.begin(), indices.end()).size();
+      LOG(INFO) << "zipf s: " << s << ", feature size: " << feature_size
+                << ", distinct indices: " << num_unique << "/" << num_indices
+                << ", single thread: " << baseline_ms << "ms, SumDuplicatesAndUpdate: " << engine_ms
+                << "ms";
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace oneflow
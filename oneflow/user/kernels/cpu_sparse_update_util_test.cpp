@@ -0,0 +1,90 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <unordered_set>
+#include "oneflow/core/common/benchmark_util.h"
+#include "oneflow/user/kernels/cpu_sparse_update_test_util.h"
+#include "oneflow/user/kernels/cpu_sparse_update_util.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+void TestSumDuplicatesAndUpdate(const std::vector<int64_t>& indices, int64_t feature_size,
+                                int64_t lower_bound, int64_t upper_bound) {
+  const int64_t num_indices = indices.size();
+  const std::vector<float> values = RandomValues(num_indices * feature_size, 1);
+  const int64_t num_model_rows = upper_bound - lower_bound;
+  std::vector<float> model = RandomValues(num_model_rows * feature_size, 2);
+  std::vector<float> momentum(model.size(), 0.5f);
+  std::vector<float> expected_model = model;
+  std::vector<float> expected_momentum = momentum;
+  ReferenceSumDuplicatesAndUpdate(
+      feature_size, lower_bound, upper_bound, indices, values,
+      MomentumRowUpdater{feature_size, expected_model.data(), expected_momentum.data()});
+  std::vector<char> tmp(cpu_sparse_update::GetTmpBufferSize<float>(num_indices, feature_size));
+  cpu_sparse_update::SumDuplicatesAndUpdate<float, int64_t>(
+      num_indices, feature_size, lower_bound, upper_bound, indices.data(), values.data(),
+      tmp.data(), MomentumRowUpdater{feature_size, model.data(), momentum.data()});
+  // Duplicates are summed in the same order, so the results are exactly equal.
+  ASSERT_EQ(model, expected_model);
+  ASSERT_EQ(momentum, expected_momentum);
+}
+
+void TestSumDuplicatesAndUpdate(int64_t num_indices, int64_t num_rows, int64_t feature_size,
+                                int64_t lower_bound, int64_t upper_bound) {
+  TestSumDuplicatesAndUpdate(ZipfianIndices(num_indices, num_rows, 1.05, num_indices),
+                             feature_size, lower_bound, upper_bound);
+}
+
+std::vector<int64_t> StridedIndices(int64_t num_indices, int64_t num_distinct, int64_t stride) {
+  std::vector<int64_t> indices(num_indices);
+  for (int64_t i = 0; i < num_indices; ++i) { indices[i] = (i * 7 % num_distinct) * stride; }
+  return indices;
+}
+
+}  // namespace
+
+TEST(CpuSparseUpdate, single_thread) {
+  TestSumDuplicatesAndUpdate(1, 10, 3, 0, 10);
+  TestSumDuplicatesAndUpdate(1000, 100, 17, 0, 100);
+  TestSumDuplicatesAndUpdate(1000, 100, 1, 20, 70);
+}
+
+TEST(CpuSparseUpdate, multi_thread) {
+  ThreadPoolGuard guard(8);
+  TestSumDuplicatesAndUpdate(100000, 1000, 16, 0, 1000);
+  TestSumDuplicatesAndUpdate(100000, 1 << 20, 33, 0, 1 << 20);
+  TestSumDuplicatesAndUpdate(65536, 5000, 8, 1000, 3000);
+}
+
+TEST(CpuSparseUpdate, strided_indices) {
+  // Indices that share their low bits must still spread over the slots of a table.
+  for (int64_t stride : {int64_t{1}, int64_t{4096}, int64_t{1} << 20, int64_t{1} << 32}) {
+    std::unordered_set<uint64_t> slots;
+    for (int64_t i = 0; i < 1024; ++i) {
+      slots.insert(cpu_sparse_update::HashSlot(i * stride, /*capacity_bits=*/11));
+    }
+    ASSERT_GE(slots.size(), 512U) << "stride " << stride;
+  }
+  TestSumDuplicatesAndUpdate(StridedIndices(30000, 10000, 256), 3, 0, 10000 * 256);
+  ThreadPoolGuard guard(8);
+  TestSumDuplicatesAndUpdate(StridedIndices(100000, 20000, 128), 1, 0, 20000 * 128);
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,227 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cmath>
+#include <random>
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/multi_thread.h"
+#include "oneflow/core/embedding/embedding_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kNumKeysPerPart = 4096;
+
+int64_t NumOptimizerStates(const std::string& optimizer) {
+  if (optimizer == "sgd") {
+    return 0;
+  } else if (optimizer == "adagrad") {
+    return 1;
+  } else {
+    UNIMPLEMENTED() << optimizer;
+    return 0;
+  }
+}
+
+// Every rank of the placement owns the keys hashed to it, and keeps their rows and the optimizer
+// states after them in its own store.
+bool IsOwnedKey(int64_t key, const ParallelContext& parallel_ctx) {
+  return embedding::HashEmbeddingKey(key) % parallel_ctx.parallel_num()
+         == parallel_ctx.parallel_id();
+}
+
+// Indices of the unique ids owned by this rank.
+std::vector<int64_t> OwnedUniqueIndices(const int64_t* unique_ids, int64_t num_unique,
+                                        const ParallelContext& parallel_ctx) {
+  std::vector<int64_t> indices;
+  FOR_RANGE(int64_t, i, 0, num_unique) {
+    if (IsOwnedKey(unique_ids[i], parallel_ctx)) { indices.emplace_back(i); }
+  }
+  return indices;
+}
+
+// Calls Handler(begin, end) on parts of [0, num) in parallel.
+void ForEachPartInParallel(int64_t num, const std::function<void(int64_t, int64_t)>& Handler) {
+  const int64_t num_parts = RoundUp(num, kNumKeysPerPart) / kNumKeysPerPart;
+  user_op::MultiThreadLoopInOpKernel(num_parts, [&](size_t part) {
+    Handler(part * kNumKeysPerPart, std::min<int64_t>((part + 1) * kNumKeysPerPart, num));
+  });
+}
+
+// Rows are initialized lazily, from the key and the seed, so that every rank and every restart
+// agrees on the rows that have never been updated.
+embedding::CachedKeyValueStoreOptions MakeStoreOptions(user_op::KernelComputeContext* ctx) {
+  const int64_t embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+  const int64_t parallel_id = ctx->parallel_ctx().parallel_id();
+  const int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+  embedding::CachedKeyValueStoreOptions options;
+  options.path = JoinPath(ctx->Attr<std::string>("path"),
+                          "part-" + std::to_string(parallel_id) + "-of-"
+                              + std::to_string(parallel_num));
+  options.value_length =
+      embedding_dim * (1 + NumOptimizerStates(ctx->Attr<std::string>("optimizer")));
+  options.cache_capacity = ctx->Attr<int64_t>("cache_capacity");
+  const float initializer_min = ctx->Attr<float>("initializer_min");
+  const float initializer_max = ctx->Attr<float>("initializer_max");
+  const uint64_t seed = ctx->Attr<int64_t>("seed");
+  const int64_t value_length = options.value_length;
+  options.initializer = [=](int64_t key, float* value) {
+    std::mt19937_64 gen(embedding::HashEmbeddingKey(key) ^ seed);
+    std::uniform_real_distribution<float> dist(initializer_min, initializer_max);
+    FOR_RANGE(int64_t, i, 0, embedding_dim) { value[i] = dist(gen); }
+    std::fill(value + embedding_dim, value + value_length, 0.0f);
+  };
+  return options;
+}
+
+template<typename IDX>
+class EmbeddingLookupCpuKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingLookupCpuKernel() = default;
+  ~EmbeddingLookupCpuKernel() override = default;
+
+ private:
+  // The store is looked up on every call rather than kept in a kernel state, since an eager kernel
+  // is shared by all the tables, and the stores of a table may be closed between the steps.
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    embedding::CachedKeyValueStore* store = Global<EmbeddingMgr>::Get()->GetOrCreateStore(
+        ctx->Attr<std::string>("name"), ctx->parallel_ctx().parallel_id(),
+        [&]() { return MakeStoreOptions(ctx); });
+    const user_op::Tensor* ids = ctx->Tensor4ArgNameAndIndex("ids", 0);
+    user_op::Tensor* embeddings = ctx->Tensor4ArgNameAndIndex("embeddings", 0);
+    user_op::Tensor* unique_ids = ctx->Tensor4ArgNameAndIndex("unique_ids", 0);
+    user_op::Tensor* inverse_indices = ctx->Tensor4ArgNameAndIndex("inverse_indices", 0);
+    user_op::Tensor* num_unique = ctx->Tensor4ArgNameAndIndex("num_unique", 0);
+    const int64_t embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+    const int64_t value_length = store->value_length();
+    const int64_t num_ids = ids->shape().elem_cnt();
+    const IDX* ids_ptr = ids->dptr<IDX>();
+    int64_t* unique_ids_ptr = unique_ids->mut_dptr<int64_t>();
+    int64_t* inverse_indices_ptr = inverse_indices->mut_dptr<int64_t>();
+
+    // Dedup, so that every row is got once and its gradients are summed up before the update.
+    HashMap<int64_t, int64_t> id2unique_index;
+    int64_t num_unique_ids = 0;
+    FOR_RANGE(int64_t, i, 0, num_ids) {
+      const int64_t id = static_cast<int64_t>(ids_ptr[i]);
+      const auto pair = id2unique_index.emplace(id, num_unique_ids);
+      if (pair.second) {
+        unique_ids_ptr[num_unique_ids] = id;
+        num_unique_ids += 1;
+      }
+      inverse_indices_ptr[i] = pair.first->second;
+    }
+    *num_unique->mut_dptr<int64_t>() = num_unique_ids;
+
+    const std::vector<int64_t> owned =
+        OwnedUniqueIndices(unique_ids_ptr, num_unique_ids, ctx->parallel_ctx());
+    std::vector<float> unique_embeddings(num_unique_ids * embedding_dim, 0.0f);
+    ForEachPartInParallel(owned.size(), [&](int64_t begin, int64_t end) {
+      std::vector<int64_t> keys(end - begin);
+      FOR_RANGE(int64_t, i, begin, end) { keys.at(i - begin) = unique_ids_ptr[owned.at(i)]; }
+      std::vector<float> values(keys.size() * value_length);
+      store->Get(keys.size(), keys.data(), values.data());
+      FOR_RANGE(int64_t, i, begin, end) {
+        const float* value = values.data() + (i - begin) * value_length;
+        std::copy(value, value + embedding_dim,
+                  unique_embeddings.data() + owned.at(i) * embedding_dim);
+      }
+    });
+    float* embeddings_ptr = embeddings->mut_dptr<float>();
+    FOR_RANGE(int64_t, i, 0, num_ids) {
+      const float* row = unique_embeddings.data() + inverse_indices_ptr[i] * embedding_dim;
+      std::copy(row, row + embedding_dim, embeddings_ptr + i * embedding_dim);
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_EMBEDDING_LOOKUP_CPU_KERNEL(idx_type)                \
+  REGISTER_USER_KERNEL("embedding_lookup")                            \
+      .SetCreateFn<EmbeddingLookupCpuKernel<idx_type>>()              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
+                       && (user_op::HobDataType("ids", 0) == GetDataType<idx_type>::value));
+
+REGISTER_EMBEDDING_LOOKUP_CPU_KERNEL(int32_t)
+REGISTER_EMBEDDING_LOOKUP_CPU_KERNEL(int64_t)
+
+// Applies the optimizer to the rows of the unique ids owned by this rank, in place in the store.
+// The lookups of the next step may run before the update of this one has finished in lazy mode,
+// the rows they get are then one step stale, as in asynchronous sparse training.
+class EmbeddingUpdateCpuKernel final : public user_op::OpKernel {
+ public:
+  EmbeddingUpdateCpuKernel() = default;
+  ~EmbeddingUpdateCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    embedding::CachedKeyValueStore* store = CHECK_JUST(Global<EmbeddingMgr>::Get()->GetStore(
+        ctx->Attr<std::string>("name"), ctx->parallel_ctx().parallel_id()));
+    const user_op::Tensor* unique_ids = ctx->Tensor4ArgNameAndIndex("unique_ids", 0);
+    const user_op::Tensor* inverse_indices = ctx->Tensor4ArgNameAndIndex("inverse_indices", 0);
+    const user_op::Tensor* num_unique = ctx->Tensor4ArgNameAndIndex("num_unique", 0);
+    const user_op::Tensor* embedding_grad = ctx->Tensor4ArgNameAndIndex("embedding_grad", 0);
+    const int64_t embedding_dim = ctx->Attr<int64_t>("embedding_dim");
+    const std::string& optimizer = ctx->Attr<std::string>("optimizer");
+    const float learning_rate = *ctx->Tensor4ArgNameAndIndex("learning_rate", 0)->dptr<float>();
+    const float epsilon = ctx->Attr<float>("epsilon");
+    const int64_t value_length = store->value_length();
+    CHECK_EQ(value_length, embedding_dim * (1 + NumOptimizerStates(optimizer)));
+    const int64_t num_ids = inverse_indices->shape().elem_cnt();
+    const int64_t num_unique_ids = *num_unique->dptr<int64_t>();
+    const int64_t* unique_ids_ptr = unique_ids->dptr<int64_t>();
+    const int64_t* inverse_indices_ptr = inverse_indices->dptr<int64_t>();
+    const float* grad_ptr = embedding_grad->dptr<float>();
+
+    std::vector<float> unique_grad(num_unique_ids * embedding_dim, 0.0f);
+    FOR_RANGE(int64_t, i, 0, num_ids) {
+      float* row_grad = unique_grad.data() + inverse_indices_ptr[i] * embedding_dim;
+      FOR_RANGE(int64_t, j, 0, embedding_dim) { row_grad[j] += grad_ptr[i * embedding_dim + j]; }
+    }
+    const std::vector<int64_t> owned =
+        OwnedUniqueIndices(unique_ids_ptr, num_unique_ids, ctx->parallel_ctx());
+    ForEachPartInParallel(owned.size(), [&](int64_t begin, int64_t end) {
+      std::vector<int64_t> keys(end - begin);
+      FOR_RANGE(int64_t, i, begin, end) { keys.at(i - begin) = unique_ids_ptr[owned.at(i)]; }
+      std::vector<float> values(keys.size() * value_length);
+      store->Get(keys.size(), keys.data(), values.data());
+      FOR_RANGE(int64_t, i, begin, end) {
+        float* model = values.data() + (i - begin) * value_length;
+        const float* grad = unique_grad.data() + owned.at(i) * embedding_dim;
+        if (optimizer == "sgd") {
+          FOR_RANGE(int64_t, j, 0, embedding_dim) { model[j] -= learning_rate * grad[j]; }
+        } else {
+          float* sum = model + embedding_dim;
+          FOR_RANGE(int64_t, j, 0, embedding_dim) {
+            sum[j] += grad[j] * grad[j];
+            model[j] -= learning_rate * grad[j] / (std::sqrt(sum[j]) + epsilon);
+          }
+        }
+      }
+      store->Put(keys.size(), keys.data(), values.data());
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+REGISTER_USER_KERNEL("embedding_update")
+    .SetCreateFn<EmbeddingUpdateCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
+                     && (user_op::HobDataType("embedding_grad", 0) == DataType::kFloat));
+
+}  // namespace
+
+}  // namespace oneflow
@@ -0,0 +1,177 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/include/primitive/cast.h"
+#include "oneflow/user/kernels/gradient_compression_util.h"
+#include "oneflow/user/kernels/op_kernel_wrapper.h"
+
+namespace oneflow {
+
+namespace {
+
+// The residual of error feedback is what this rank left out of its former payloads, it lives as
+// long as the kernel.
+class GradCompressCpuKernel final : public user_op::OpKernel {
+ public:
+  GradCompressCpuKernel() = default;
+  ~GradCompressCpuKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    if (!ctx->Attr<bool>("error_feedback")) { return nullptr; }
+    const int64_t elem_cnt = ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().elem_cnt();
+    return std::make_shared<OpKernelStateWrapper<std::vector<float>>>(elem_cnt, 0.0f);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+               const user_op::OpKernelCache*) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const auto method =
+        CHECK_JUST(ParseGradientCompressionMethod(ctx->Attr<std::string>("method")));
+    const float topk_ratio = ctx->Attr<float>("topk_ratio");
+    const int64_t elem_cnt = in->shape().elem_cnt();
+    CHECK_EQ(out->shape().elem_cnt(),
+             GradientCompressionPayloadBytes(method, elem_cnt, topk_ratio));
+    float* residual = nullptr;
+    if (state != nullptr) {
+      auto* residual_state = dynamic_cast<OpKernelStateWrapper<std::vector<float>>*>(state);
+      CHECK_NOTNULL(residual_state);
+      CHECK_EQ(residual_state->Get().size(), static_cast<size_t>(elem_cnt));
+      residual = residual_state->Mutable()->data();
+    }
+    GradientCompressionEncode(method, in->dptr<float>(), elem_cnt, topk_ratio, residual,
+                              out->mut_dptr<char>());
+    const int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+    AddGradientCompressionStats(
+        RingAllReduceSendBytes(elem_cnt * sizeof(float), parallel_num),
+        GradientCompressionSendBytes(method, elem_cnt, topk_ratio, parallel_num));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+class GradDecompressCpuKernel final : public user_op::OpKernel {
+ public:
+  GradDecompressCpuKernel() = default;
+  ~GradDecompressCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const auto method =
+        CHECK_JUST(ParseGradientCompressionMethod(ctx->Attr<std::string>("method")));
+    const float topk_ratio = ctx->Attr<float>("topk_ratio");
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    const int64_t payload_bytes = GradientCompressionPayloadBytes(method, elem_cnt, topk_ratio);
+    const int64_t num_payloads = in->shape().elem_cnt() / payload_bytes;
+    float* out_ptr = out->mut_dptr<float>();
+    std::fill(out_ptr, out_ptr + elem_cnt, 0.0f);
+    FOR_RANGE(int64_t, i, 0, num_payloads) {
+      GradientCompressionDecodeAdd(method, in->dptr<char>() + i * payload_bytes, elem_cnt,
+                                   topk_ratio, out_ptr);
+    }
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename Context>
+std::unique_ptr<ep::primitive::Cast> NewCastPrimitive(Context* ctx) {
+  const DataType in_data_type = ctx->TensorDesc4ArgNameAndIndex("in", 0)->data_type();
+  const DataType out_data_type = ctx->TensorDesc4ArgNameAndIndex("out", 0)->data_type();
+  return ep::primitive::NewPrimitive<ep::primitive::CastFactory>(ctx->device_type(), in_data_type,
+                                                                 out_data_type);
+}
+
+// The cast methods narrow the partial gradient before it is all-reduced and widen the sum after,
+// so the compressed traffic is the all-reduce of the narrowed gradient.
+class GradCastCompressKernel final : public user_op::OpKernel {
+ public:
+  GradCastCompressKernel() = default;
+  ~GradCastCompressKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const auto method =
+        CHECK_JUST(ParseGradientCompressionMethod(ctx->Attr<std::string>("method")));
+    const int64_t elem_cnt = in->shape().elem_cnt();
+    CHECK_EQ(out->shape().elem_cnt(), elem_cnt);
+    auto primitive = NewCastPrimitive(ctx);
+    CHECK(primitive);
+    primitive->Launch(ctx->stream(), in->dptr(), out->mut_dptr(), elem_cnt);
+    const int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+    AddGradientCompressionStats(
+        RingAllReduceSendBytes(elem_cnt * sizeof(float), parallel_num),
+        GradientCompressionSendBytes(method, elem_cnt, ctx->Attr<float>("topk_ratio"),
+                                     parallel_num));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+class GradCastDecompressKernel final : public user_op::OpKernel {
+ public:
+  GradCastDecompressKernel() = default;
+  ~GradCastDecompressKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    CHECK_EQ(in->shape().elem_cnt(), elem_cnt);
+    auto primitive = NewCastPrimitive(ctx);
+    CHECK(primitive);
+    primitive->Launch(ctx->stream(), in->dptr(), out->mut_dptr(), elem_cnt);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+auto CastPrimitiveExists() {
+  return hob::make_custom("CastPrimitiveExists", [](const user_op::KernelRegContext& ctx) -> bool {
+    return NewCastPrimitive(&ctx).operator bool();
+  });
+}
+
+}  // namespace
+
+REGISTER_USER_KERNEL("grad_compress")
+    .SetCreateFn<GradCompressCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
+                     && (user_op::HobDataType("in", 0) == DataType::kFloat)
+                     && (user_op::HobDataType("out", 0) == DataType::kInt8));
+
+REGISTER_USER_KERNEL("grad_decompress")
+    .SetCreateFn<GradDecompressCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
+                     && (user_op::HobDataType("in", 0) == DataType::kInt8)
+                     && (user_op::HobDataType("out", 0) == DataType::kFloat));
+
+REGISTER_USER_KERNEL("grad_compress")
+    .SetCreateFn<GradCastCompressKernel>()
+    .SetIsMatchedHob(((user_op::HobDataType("out", 0) == DataType::kFloat16)
+                      || (user_op::HobDataType("out", 0) == DataType::kBFloat16))
+                     && (CastPrimitiveExists() == true));
+
+REGISTER_USER_KERNEL("grad_decompress")
+    .SetCreateFn<GradCastDecompressKernel>()
+    .SetIsMatchedHob(((user_op::HobDataType("in", 0) == DataType::kFloat16)
+                      || (user_op::HobDataType("in", 0) == DataType::kBFloat16))
+                     && (CastPrimitiveExists() == true));
+
+}  // namespace oneflow
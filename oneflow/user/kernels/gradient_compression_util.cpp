@@ -0,0 +1,201 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/gradient_compression_util.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace oneflow {
+
+namespace {
+
+int64_t TopKCount(int64_t elem_cnt, float topk_ratio) {
+  const int64_t k = static_cast<int64_t>(std::ceil(elem_cnt * static_cast<double>(topk_ratio)));
+  return std::min(std::max<int64_t>(k, 1), elem_cnt);
+}
+
+// Payload: k int32 indices in increasing order, then k float values.
+void EncodeTopK(const float* in, int64_t elem_cnt, float topk_ratio, float* residual,
+                char* payload) {
+  const int64_t k = TopKCount(elem_cnt, topk_ratio);
+  std::vector<float> values(in, in + elem_cnt);
+  if (residual != nullptr) {
+    FOR_RANGE(int64_t, i, 0, elem_cnt) { values[i] += residual[i]; }
+  }
+  std::vector<int32_t> indices(elem_cnt);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::nth_element(indices.begin(), indices.begin() + (k - 1), indices.end(),
+                   [&](int32_t lhs, int32_t rhs) {
+                     return std::abs(values[lhs]) > std::abs(values[rhs]);
+                   });
+  indices.resize(k);
+  std::sort(indices.begin(), indices.end());
+  int32_t* out_indices = reinterpret_cast<int32_t*>(payload);
+  float* out_values = reinterpret_cast<float*>(payload + k * sizeof(int32_t));
+  FOR_RANGE(int64_t, i, 0, k) {
+    out_indices[i] = indices[i];
+    out_values[i] = values[indices[i]];
+    values[indices[i]] = 0;
+  }
+  if (residual != nullptr) { std::copy(values.cbegin(), values.cend(), residual); }
+}
+
+void DecodeAddTopK(const char* payload, int64_t elem_cnt, float topk_ratio, float* out) {
+  const int64_t k = TopKCount(elem_cnt, topk_ratio);
+  const int32_t* indices = reinterpret_cast<const int32_t*>(payload);
+  const float* values = reinterpret_cast<const float*>(payload + k * sizeof(int32_t));
+  FOR_RANGE(int64_t, i, 0, k) {
+    CHECK_GE(indices[i], 0);
+    CHECK_LT(indices[i], elem_cnt);
+    out[indices[i]] += values[i];
+  }
+}
+
+// Payload: the float scale, then a bit per element that is set for non-negative elements.
+void EncodeOneBit(const float* in, int64_t elem_cnt, float* residual, char* payload) {
+  std::vector<float> values(in, in + elem_cnt);
+  if (residual != nullptr) {
+    FOR_RANGE(int64_t, i, 0, elem_cnt) { values[i] += residual[i]; }
+  }
+  double abs_sum = 0;
+  for (float value : values) { abs_sum += std::abs(value); }
+  const float scale = static_cast<float>(abs_sum / elem_cnt);
+  std::memcpy(payload, &scale, sizeof(scale));
+  uint8_t* bits = reinterpret_cast<uint8_t*>(payload + sizeof(scale));
+  std::memset(bits, 0, RoundUp(elem_cnt, 8) / 8);
+  FOR_RANGE(int64_t, i, 0, elem_cnt) {
+    const bool positive = values[i] >= 0;
+    if (positive) { bits[i / 8] |= static_cast<uint8_t>(1 << (i % 8)); }
+    if (residual != nullptr) { residual[i] = values[i] - (positive ? scale : -scale); }
+  }
+}
+
+void DecodeAddOneBit(const char* payload, int64_t elem_cnt, float* out) {
+  float scale;
+  std::memcpy(&scale, payload, sizeof(scale));
+  const uint8_t* bits = reinterpret_cast<const uint8_t*>(payload + sizeof(scale));
+  FOR_RANGE(int64_t, i, 0, elem_cnt) {
+    out[i] += ((bits[i / 8] >> (i % 8)) & 1) ? scale : -scale;
+  }
+}
+
+std::atomic<int64_t> num_all_reduce_bytes(0);
+std::atomic<int64_t> num_wire_bytes(0);
+
+}  // namespace
+
+Maybe<GradientCompressionMethod> ParseGradientCompressionMethod(const std::string& method) {
+  if (method == "fp16") {
+    return GradientCompressionMethod::kFloat16;
+  } else if (method == "bf16") {
+    return GradientCompressionMethod::kBFloat16;
+  } else if (method == "topk") {
+    return GradientCompressionMethod::kTopK;
+  } else if (method == "onebit") {
+    return GradientCompressionMethod::kOneBit;
+  } else {
+    return Error::InvalidValueError("unknown gradient compression method " + method);
+  }
+}
+
+bool IsGradientCompressionCast(GradientCompressionMethod method) {
+  return method == GradientCompressionMethod::kFloat16
+         || method == GradientCompressionMethod::kBFloat16;
+}
+
+DataType GradientCompressionCastDataType(GradientCompressionMethod method) {
+  if (method == GradientCompressionMethod::kFloat16) {
+    return DataType::kFloat16;
+  } else if (method == GradientCompressionMethod::kBFloat16) {
+    return DataType::kBFloat16;
+  } else {
+    UNIMPLEMENTED();
+    return DataType::kInvalidDataType;
+  }
+}
+
+int64_t GradientCompressionPayloadBytes(GradientCompressionMethod method, int64_t elem_cnt,
+                                        float topk_ratio) {
+  CHECK_GT(elem_cnt, 0);
+  if (IsGradientCompressionCast(method)) {
+    return elem_cnt * GetSizeOfDataType(GradientCompressionCastDataType(method));
+  } else if (method == GradientCompressionMethod::kTopK) {
+    return TopKCount(elem_cnt, topk_ratio) * (sizeof(int32_t) + sizeof(float));
+  } else if (method == GradientCompressionMethod::kOneBit) {
+    return sizeof(float) + RoundUp(elem_cnt, 8) / 8;
+  } else {
+    UNIMPLEMENTED();
+    return 0;
+  }
+}
+
+void GradientCompressionEncode(GradientCompressionMethod method, const float* in, int64_t elem_cnt,
+                               float topk_ratio, float* residual, char* payload) {
+  if (method == GradientCompressionMethod::kTopK) {
+    EncodeTopK(in, elem_cnt, topk_ratio, residual, payload);
+  } else if (method == GradientCompressionMethod::kOneBit) {
+    EncodeOneBit(in, elem_cnt, residual, payload);
+  } else {
+    UNIMPLEMENTED();
+  }
+}
+
+void GradientCompressionDecodeAdd(GradientCompressionMethod method, const char* payload,
+                                  int64_t elem_cnt, float topk_ratio, float* out) {
+  if (method == GradientCompressionMethod::kTopK) {
+    DecodeAddTopK(payload, elem_cnt, topk_ratio, out);
+  } else if (method == GradientCompressionMethod::kOneBit) {
+    DecodeAddOneBit(payload, elem_cnt, out);
+  } else {
+    UNIMPLEMENTED();
+  }
+}
+
+int64_t RingAllReduceSendBytes(int64_t num_bytes, int64_t parallel_num) {
+  CHECK_GT(parallel_num, 0);
+  return 2 * (parallel_num - 1) * num_bytes / parallel_num;
+}
+
+int64_t GradientCompressionSendBytes(GradientCompressionMethod method, int64_t elem_cnt,
+                                     float topk_ratio, int64_t parallel_num) {
+  const int64_t payload_bytes = GradientCompressionPayloadBytes(method, elem_cnt, topk_ratio);
+  if (IsGradientCompressionCast(method)) {
+    return RingAllReduceSendBytes(payload_bytes, parallel_num);
+  } else {
+    return payload_bytes * (parallel_num - 1);
+  }
+}
+
+GradientCompressionStats GetGradientCompressionStats() {
+  GradientCompressionStats stats{};
+  stats.num_all_reduce_bytes = num_all_reduce_bytes.load(std::memory_order_relaxed);
+  stats.num_wire_bytes = num_wire_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void AddGradientCompressionStats(int64_t all_reduce_bytes, int64_t wire_bytes) {
+  num_all_reduce_bytes.fetch_add(all_reduce_bytes, std::memory_order_relaxed);
+  num_wire_bytes.fetch_add(wire_bytes, std::memory_order_relaxed);
+}
+
+void ResetGradientCompressionStats() {
+  num_all_reduce_bytes.store(0, std::memory_order_relaxed);
+  num_wire_bytes.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace oneflow
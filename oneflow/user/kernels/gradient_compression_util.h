@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_GRADIENT_COMPRESSION_UTIL_H_
+#define ONEFLOW_USER_KERNELS_GRADIENT_COMPRESSION_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/maybe.h"
+
+namespace oneflow {
+
+// Methods of the gradient compression stage. The cast methods sum the gradients up in a narrower
+// floating point type with the all-reduce of regular boxing. For the others every rank encodes its
+// partial gradient into a payload of a size known ahead of time, the payloads of all ranks are
+// gathered and each rank decodes and sums them up.
+enum class GradientCompressionMethod {
+  kFloat16,   // cast to float16
+  kBFloat16,  // cast to bfloat16
+  kTopK,      // the largest topk_ratio of the elements by magnitude, as indices and values
+  kOneBit,    // signs with the mean magnitude as scale
+};
+
+Maybe<GradientCompressionMethod> ParseGradientCompressionMethod(const std::string& method);
+
+bool IsGradientCompressionCast(GradientCompressionMethod method);
+
+// The data type the gradients of a cast method are summed up in.
+DataType GradientCompressionCastDataType(GradientCompressionMethod method);
+
+// Bytes of the compressed gradient of one rank, the cast tensor for the cast methods.
+int64_t GradientCompressionPayloadBytes(GradientCompressionMethod method, int64_t elem_cnt,
+                                        float topk_ratio);
+
+// Encodes in + residual into payload. If residual is not null it is updated to what the payload
+// leaves out, so that it is sent in a later step instead of being lost. Not for cast methods.
+void GradientCompressionEncode(GradientCompressionMethod method, const float* in, int64_t elem_cnt,
+                               float topk_ratio, float* residual, char* payload);
+
+// Adds what payload holds to out. Not for cast methods.
+void GradientCompressionDecodeAdd(GradientCompressionMethod method, const char* payload,
+                                  int64_t elem_cnt, float topk_ratio, float* out);
+
+// Bytes one rank sends in a ring all-reduce of num_bytes among parallel_num ranks.
+int64_t RingAllReduceSendBytes(int64_t num_bytes, int64_t parallel_num);
+
+// Bytes one rank sends to sum up a compressed gradient: a ring all-reduce of the cast tensor, or
+// its payload to each of the other ranks.
+int64_t GradientCompressionSendBytes(GradientCompressionMethod method, int64_t elem_cnt,
+                                     float topk_ratio, int64_t parallel_num);
+
+struct GradientCompressionStats {
+  int64_t num_all_reduce_bytes;
+  int64_t num_wire_bytes;
+};
+
+// Bytes this process would have sent to all-reduce the float gradients that went through the
+// compression stage, and bytes it sent for them instead.
+GradientCompressionStats GetGradientCompressionStats();
+void AddGradientCompressionStats(int64_t num_all_reduce_bytes, int64_t num_wire_bytes);
+void ResetGradientCompressionStats();
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_GRADIENT_COMPRESSION_UTIL_H_
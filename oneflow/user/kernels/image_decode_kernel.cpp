@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
 #include <opencv2/opencv.hpp>
 
 namespace oneflow {
@@ -27,6 +28,23 @@ void DecodeImage(const TensorBuffer& raw_bytes, TensorBuffer* image_buffer,
   // should only support kChar, but numpy ndarray maybe cannot convert to char*
   CHECK(raw_bytes.data_type() == DataType::kChar || raw_bytes.data_type() == DataType::kInt8
         || raw_bytes.data_type() == DataType::kUInt8);
+  if (JpegDecodeEnabled() && (data_type == DataType::kUInt8 || data_type == DataType::kFloat)) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(raw_bytes.data<char>());
+    if (data_type == DataType::kUInt8) {
+      if (JpegDecode(data, raw_bytes.elem_cnt(), color_space, nullptr, 0, 0, image_buffer)) {
+        return;
+      }
+    } else {
+      static thread_local TensorBuffer uint8_image;
+      if (JpegDecode(data, raw_bytes.elem_cnt(), color_space, nullptr, 0, 0, &uint8_image)) {
+        image_buffer->Resize(uint8_image.shape(), data_type);
+        const uint8_t* src = uint8_image.data<uint8_t>();
+        float* dst = image_buffer->mut_data<float>();
+        FOR_RANGE(int64_t, i, 0, uint8_image.elem_cnt()) { dst[i] = src[i]; }
+        return;
+      }
+    }
+  }
   cv::_InputArray raw_bytes_arr(raw_bytes.data<char>(), raw_bytes.elem_cnt());
   cv::Mat image_mat = cv::imdecode(
       raw_bytes_arr, (ImageUtil::IsColor(color_space) ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE)
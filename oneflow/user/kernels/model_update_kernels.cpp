@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/model_update_kernel_util.h"
 #include "oneflow/user/kernels/indexed_slices_reduce_sum_kernel_util.h"
+#include "oneflow/user/kernels/cpu_sparse_update_util.h"
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/kernel/cuda_graph_support.h"
 
@@ -173,6 +174,10 @@ user_op::InferTmpSizeFn GenInferTmpSizeFn() {
     const user_op::TensorDesc& values = ctx->InputTensorDesc("model_diff_values", 0);
     const int64_t num_indices = indices.shape().elem_cnt();
     const int64_t num_values = values.shape().elem_cnt();
+    if (device_type == DeviceType::kCPU) {
+      const int64_t feature_size = num_indices == 0 ? 0 : num_values / num_indices;
+      return cpu_sparse_update::GetTmpBufferSize<T>(num_indices, feature_size);
+    }
     TmpBufferManager<device_type, T, K> buffer_manager(nullptr, num_indices, num_values);
     return buffer_manager.GetTotalBufferSize();
   };
@@ -213,6 +218,23 @@ class IndexedSlicesSGDUpdateKernel final : public user_op::OpKernel {
     CHECK_NOTNULL(kernel_cache);
     CHECK_EQ(model->shape().At(0), kernel_cache->upper() - kernel_cache->lower());
     user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    if (device_type == DeviceType::kCPU) {
+      CHECK_GE(tmp_buffer->shape().elem_cnt(),
+               cpu_sparse_update::GetTmpBufferSize<T>(num_indices, feature_size));
+      const T lr = *learning_rate->dptr<float>();
+      T* model_ptr = model->mut_dptr<T>();
+      cpu_sparse_update::SumDuplicatesAndUpdate<T, K>(
+          num_indices, feature_size, kernel_cache->lower(), kernel_cache->upper(),
+          model_diff_indices->dptr<K>(), model_diff_values->dptr<T>(), tmp_buffer->mut_dptr(),
+          [&](int64_t row, const T* diff) {
+            const int64_t offset = row * feature_size;
+            FOR_RANGE(int64_t, i, 0, feature_size) {
+              SGDUpdateFunctor<T, T>()(diff + i, model_ptr + offset + i, static_cast<T>(1), 0.0,
+                                       0.0, weight_decay, lr);
+            }
+          });
+      return;
+    }
     TmpBufferManager<device_type, T, K> buffer_manager(tmp_buffer->mut_dptr(), num_indices,
                                                        num_values);
     CHECK_GE(tmp_buffer->shape().elem_cnt(), buffer_manager.GetTotalBufferSize());
@@ -344,6 +366,25 @@ class IndexedSlicesMomentumUpdateKernel final : public user_op::OpKernel {
     CHECK_NOTNULL(kernel_cache);
     CHECK_EQ(model->shape().At(0), kernel_cache->upper() - kernel_cache->lower());
     user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    if (device_type == DeviceType::kCPU) {
+      CHECK_GE(tmp_buffer->shape().elem_cnt(),
+               cpu_sparse_update::GetTmpBufferSize<T>(num_indices, feature_size));
+      const T lr = *learning_rate->dptr<float>();
+      T* model_ptr = model->mut_dptr<T>();
+      T* momentum_ptr = momentum->mut_dptr<T>();
+      cpu_sparse_update::SumDuplicatesAndUpdate<T, K>(
+          num_indices, feature_size, kernel_cache->lower(), kernel_cache->upper(),
+          model_diff_indices->dptr<K>(), model_diff_values->dptr<T>(), tmp_buffer->mut_dptr(),
+          [&](int64_t row, const T* diff) {
+            const int64_t offset = row * feature_size;
+            FOR_RANGE(int64_t, i, 0, feature_size) {
+              MomentumUpdateFunctor<T, T>()(diff + i, model_ptr + offset + i,
+                                            momentum_ptr + offset + i, static_cast<T>(1), 0.0, 0.0,
+                                            beta, weight_decay, lr);
+            }
+          });
+      return;
+    }
     TmpBufferManager<device_type, T, K> buffer_manager(tmp_buffer->mut_dptr(), num_indices,
                                                        num_values);
     CHECK_GE(tmp_buffer->shape().elem_cnt(), buffer_manager.GetTotalBufferSize());
@@ -596,6 +637,31 @@ class IndexedSlicesAdamUpdateKernel final : public user_op::OpKernel {
     const int64_t feature_size = num_values / num_indices;
     CHECK_EQ(feature_size, model_diff_values->shape().Count(model_diff_indices->shape().NumAxes()));
     user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    if (device_type == DeviceType::kCPU) {
+      CHECK_GE(tmp_buffer->shape().elem_cnt(),
+               cpu_sparse_update::GetTmpBufferSize<T>(num_indices, feature_size));
+      const float lr = learning_rate_ptr != nullptr ? *learning_rate_ptr : learning_rate_val;
+      const float bias_correction1 = bias_correction1_ptr != nullptr ? *bias_correction1_ptr : 1.0;
+      const float bias_correction2 = bias_correction2_ptr != nullptr ? *bias_correction2_ptr : 1.0;
+      T* model_ptr = model->mut_dptr<T>();
+      T* m_ptr = m->mut_dptr<T>();
+      T* v_ptr = v->mut_dptr<T>();
+      T* max_v_ptr = max_v->mut_dptr<T>();
+      cpu_sparse_update::SumDuplicatesAndUpdate<T, K>(
+          num_indices, feature_size, kernel_cache->lower(), kernel_cache->upper(),
+          model_diff_indices->dptr<K>(), model_diff_values->dptr<T>(), tmp_buffer->mut_dptr(),
+          [&](int64_t row, const T* diff) {
+            const int64_t offset = row * feature_size;
+            FOR_RANGE(int64_t, i, 0, feature_size) {
+              AdamUpdateFunctor<T, T>()(diff + i, model_ptr + offset + i, m_ptr + offset + i,
+                                        v_ptr + offset + i, max_v_ptr + offset + i,
+                                        /*scale=*/1.0, /*l1=*/0.0, /*l2=*/0.0, beta1, beta2,
+                                        epsilon, weight_decay, amsgrad, bias_correction1,
+                                        bias_correction2, lr);
+            }
+          });
+      return;
+    }
     TmpBufferManager<device_type, T, K> buffer_manager(tmp_buffer->mut_dptr(), num_indices,
                                                        num_values);
     CHECK_GE(tmp_buffer->shape().elem_cnt(), buffer_manager.GetTotalBufferSize());
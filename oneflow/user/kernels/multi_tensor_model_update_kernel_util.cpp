@@ -0,0 +1,182 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/multi_tensor_model_update_kernel_util.h"
+#include "oneflow/core/framework/multi_thread.h"
+
+namespace oneflow {
+
+namespace {
+
+// Models are cut into chunks of about the same size, so that threads stay busy no matter how
+// the elements are spread over the models.
+constexpr int64_t kChunkSize = 32 * 1024;
+
+struct Chunk {
+  size_t tensor_idx;
+  int64_t begin;
+  int64_t end;
+};
+
+template<typename T, typename G>
+std::vector<Chunk> SplitIntoChunks(const std::vector<MultiTensorUpdateTensors<T, G>>& tensors) {
+  std::vector<Chunk> chunks;
+  FOR_RANGE(size_t, i, 0, tensors.size()) {
+    for (int64_t begin = 0; begin < tensors.at(i).n; begin += kChunkSize) {
+      chunks.push_back(Chunk{i, begin, std::min(begin + kChunkSize, tensors.at(i).n)});
+    }
+  }
+  return chunks;
+}
+
+template<typename T, typename G, typename F>
+void ForEachChunk(const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                  const std::vector<Chunk>& chunks, const F& Handler) {
+  user_op::MultiThreadLoopInOpKernel(chunks.size(), [&](size_t i) {
+    const Chunk& chunk = chunks.at(i);
+    Handler(tensors.at(chunk.tensor_idx), chunk.begin, chunk.end);
+  });
+}
+
+}  // namespace
+
+template<typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float weight_decay, float learning_rate_val,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if) {
+    if (skip_if != nullptr && *skip_if != 0) { return; }
+    if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+    if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+    ForEachChunk(tensors, SplitIntoChunks(tensors),
+                 [&](const MultiTensorUpdateTensors<T, G>& t, int64_t begin, int64_t end) {
+                   for (int64_t i = begin; i != end; ++i) {
+                     SGDUpdateFunctor<T, G>()(t.model_diff + i, t.model + i, scale, l1, l2,
+                                              weight_decay, learning_rate_val);
+                   }
+                 });
+  }
+};
+
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+template<typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float beta, float weight_decay,
+                     float learning_rate_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if) {
+    if (skip_if != nullptr && *skip_if != 0) { return; }
+    if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+    if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+    ForEachChunk(tensors, SplitIntoChunks(tensors),
+                 [&](const MultiTensorUpdateTensors<T, G>& t, int64_t begin, int64_t end) {
+                   for (int64_t i = begin; i != end; ++i) {
+                     MomentumUpdateFunctor<T, G>()(t.model_diff + i, t.model + i, t.m + i, scale,
+                                                   l1, l2, beta, weight_decay, learning_rate_val);
+                   }
+                 });
+  }
+};
+
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+template<typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, float learning_rate_val, float bias_correction1_val,
+                     float bias_correction2_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, const float* bias_correction1,
+                     const float* bias_correction2) {
+    if (skip_if != nullptr && *skip_if != 0) { return; }
+    if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+    if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+    if (bias_correction1 != nullptr) { bias_correction1_val = *bias_correction1; }
+    if (bias_correction2 != nullptr) { bias_correction2_val = *bias_correction2; }
+    ForEachChunk(tensors, SplitIntoChunks(tensors),
+                 [&](const MultiTensorUpdateTensors<T, G>& t, int64_t begin, int64_t end) {
+                   for (int64_t i = begin; i != end; ++i) {
+                     AdamUpdateFunctor<T, G>()(t.model_diff + i, t.model + i, t.m + i, t.v + i,
+                                               nullptr, scale, l1, l2, beta1, beta2, epsilon,
+                                               weight_decay, false, bias_correction1_val,
+                                               bias_correction2_val, learning_rate_val);
+                   }
+                 });
+  }
+};
+
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+template<typename T, typename G>
+struct MultiTensorLambUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     float scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if) {
+    if (skip_if != nullptr && *skip_if != 0) { return; }
+    for (const auto& t : tensors) {
+      *t.beta1_t *= beta1;
+      *t.beta2_t *= beta2;
+    }
+    if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+    const std::vector<Chunk> chunks = SplitIntoChunks(tensors);
+    ForEachChunk(tensors, chunks,
+                 [&](const MultiTensorUpdateTensors<T, G>& t, int64_t begin, int64_t end) {
+                   for (int64_t i = begin; i != end; ++i) {
+                     LambGradFunctor<T, G>()(t.beta1_t, t.beta2_t, t.model_diff + i,
+                                             t.adam_diff + i, t.model + i, t.m + i, t.v + i, scale,
+                                             l1, l2, beta1, beta2, epsilon);
+                   }
+                 });
+    // Squared norms of every chunk, summed up per model in a fixed order.
+    std::vector<std::pair<T, T>> chunk_norms(chunks.size());
+    user_op::MultiThreadLoopInOpKernel(chunks.size(), [&](size_t c) {
+      const Chunk& chunk = chunks.at(c);
+      const MultiTensorUpdateTensors<T, G>& t = tensors.at(chunk.tensor_idx);
+      T w_norm_2 = 0;
+      T g_norm_2 = 0;
+      for (int64_t i = chunk.begin; i != chunk.end; ++i) {
+        w_norm_2 += t.model[i] * t.model[i];
+        g_norm_2 += t.adam_diff[i] * t.adam_diff[i];
+      }
+      chunk_norms.at(c) = std::make_pair(w_norm_2, g_norm_2);
+    });
+    for (const auto& t : tensors) {
+      t.norm[0] = 0;
+      t.norm[1] = 0;
+    }
+    FOR_RANGE(size_t, c, 0, chunks.size()) {
+      T* norm = tensors.at(chunks.at(c).tensor_idx).norm;
+      norm[0] += chunk_norms.at(c).first;
+      norm[1] += chunk_norms.at(c).second;
+    }
+    ForEachChunk(tensors, chunks,
+                 [&](const MultiTensorUpdateTensors<T, G>& t, int64_t begin, int64_t end) {
+                   const float lr = LambLRFunctor<T>()(*learning_rate, t.norm, t.norm + 1);
+                   for (int64_t i = begin; i != end; ++i) {
+                     LambUpdateFunctor<T>()(lr, weight_decay, t.adam_diff + i, t.model + i);
+                   }
+                 });
+  }
+};
+
+template struct MultiTensorLambUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorLambUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+}  // namespace oneflow
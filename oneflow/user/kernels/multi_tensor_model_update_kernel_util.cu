@@ -0,0 +1,359 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/multi_tensor_model_update_kernel_util.h"
+#include "oneflow/core/cuda/atomic.cuh"
+#include "oneflow/core/ep/cuda/cuda_stream.h"
+#include <cub/cub.cuh>
+
+namespace oneflow {
+
+namespace {
+
+// The tensors are passed by value as kernel params, so a launch takes at most this many of them.
+constexpr int32_t kMaxTensorsPerLaunch = 32;
+
+// Blocks [block_offset[i], block_offset[i + 1]) of a launch work on tensors[i].
+template<typename T, typename G>
+struct MultiTensorLaunchParams {
+  int32_t num_tensors;
+  int32_t block_offset[kMaxTensorsPerLaunch + 1];
+  MultiTensorUpdateTensors<T, G> tensors[kMaxTensorsPerLaunch];
+};
+
+template<typename T, typename G>
+__device__ const MultiTensorUpdateTensors<T, G>& BlockTensors(
+    const MultiTensorLaunchParams<T, G>& params, int64_t* begin, int64_t* step) {
+  int32_t idx = 0;
+  while (blockIdx.x >= params.block_offset[idx + 1]) { ++idx; }
+  *begin = static_cast<int64_t>(blockIdx.x - params.block_offset[idx]) * blockDim.x + threadIdx.x;
+  const int32_t num_blocks = params.block_offset[idx + 1] - params.block_offset[idx];
+  *step = static_cast<int64_t>(num_blocks) * blockDim.x;
+  return params.tensors[idx];
+}
+
+template<typename T, typename G>
+std::vector<MultiTensorLaunchParams<T, G>> MakeLaunchParams(
+    const std::vector<MultiTensorUpdateTensors<T, G>>& tensors) {
+  std::vector<MultiTensorLaunchParams<T, G>> ret;
+  for (const auto& t : tensors) {
+    if (ret.empty() || ret.back().num_tensors == kMaxTensorsPerLaunch) {
+      ret.emplace_back();
+      ret.back().num_tensors = 0;
+      ret.back().block_offset[0] = 0;
+    }
+    auto& params = ret.back();
+    const int64_t num_blocks =
+        std::min<int64_t>(RoundUp(t.n, kCudaThreadsNumPerBlock) / kCudaThreadsNumPerBlock,
+                          kCudaMaxBlocksNum);
+    params.tensors[params.num_tensors] = t;
+    params.block_offset[params.num_tensors + 1] =
+        params.block_offset[params.num_tensors] + num_blocks;
+    params.num_tensors += 1;
+  }
+  return ret;
+}
+
+template<typename T, typename G>
+int32_t NumBlocks(const MultiTensorLaunchParams<T, G>& params) {
+  return params.block_offset[params.num_tensors];
+}
+
+template<typename T, typename G>
+__global__ void MultiTensorSGDUpdateGpu(MultiTensorLaunchParams<T, G> params, T scale, float l1,
+                                        float l2, float weight_decay, float learning_rate_val,
+                                        const float* learning_rate, const T* scale_by_ptr,
+                                        const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  int64_t begin = 0;
+  int64_t step = 0;
+  const auto& t = BlockTensors(params, &begin, &step);
+  for (int64_t i = begin; i < t.n; i += step) {
+    SGDUpdateFunctor<T, G>()(t.model_diff + i, t.model + i, scale, l1, l2, weight_decay,
+                             learning_rate_val);
+  }
+}
+
+template<typename T, typename G>
+__global__ void MultiTensorMomentumUpdateGpu(MultiTensorLaunchParams<T, G> params, T scale,
+                                             float l1, float l2, float beta, float weight_decay,
+                                             float learning_rate_val, const float* learning_rate,
+                                             const T* scale_by_ptr, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  int64_t begin = 0;
+  int64_t step = 0;
+  const auto& t = BlockTensors(params, &begin, &step);
+  for (int64_t i = begin; i < t.n; i += step) {
+    MomentumUpdateFunctor<T, G>()(t.model_diff + i, t.model + i, t.m + i, scale, l1, l2, beta,
+                                  weight_decay, learning_rate_val);
+  }
+}
+
+template<typename T, typename G>
+__global__ void MultiTensorAdamUpdateGpu(MultiTensorLaunchParams<T, G> params, T scale, float l1,
+                                         float l2, float beta1, float beta2, float epsilon,
+                                         float weight_decay, float learning_rate_val,
+                                         float bias_correction1_val, float bias_correction2_val,
+                                         const float* learning_rate, const T* scale_by_ptr,
+                                         const int64_t* skip_if, const float* bias_correction1,
+                                         const float* bias_correction2) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (learning_rate != nullptr) { learning_rate_val = *learning_rate; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  if (bias_correction1 != nullptr) { bias_correction1_val = *bias_correction1; }
+  if (bias_correction2 != nullptr) { bias_correction2_val = *bias_correction2; }
+  int64_t begin = 0;
+  int64_t step = 0;
+  const auto& t = BlockTensors(params, &begin, &step);
+  for (int64_t i = begin; i < t.n; i += step) {
+    AdamUpdateFunctor<T, G>()(t.model_diff + i, t.model + i, t.m + i, t.v + i, nullptr, scale, l1,
+                              l2, beta1, beta2, epsilon, weight_decay, false, bias_correction1_val,
+                              bias_correction2_val, learning_rate_val);
+  }
+}
+
+// One thread per tensor.
+template<typename T, typename G>
+__global__ void MultiTensorLambBetaTGpu(MultiTensorLaunchParams<T, G> params, float beta1,
+                                        float beta2, const int64_t* skip_if) {
+  if (threadIdx.x >= params.num_tensors) { return; }
+  const auto& t = params.tensors[threadIdx.x];
+  t.norm[0] = 0;
+  t.norm[1] = 0;
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  *t.beta1_t *= beta1;
+  *t.beta2_t *= beta2;
+}
+
+template<typename T, typename G>
+__global__ void MultiTensorLambGradGpu(MultiTensorLaunchParams<T, G> params, T scale, float l1,
+                                       float l2, float beta1, float beta2, float epsilon,
+                                       const T* scale_by_ptr, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  int64_t begin = 0;
+  int64_t step = 0;
+  const auto& t = BlockTensors(params, &begin, &step);
+  for (int64_t i = begin; i < t.n; i += step) {
+    LambGradFunctor<T, G>()(t.beta1_t, t.beta2_t, t.model_diff + i, t.adam_diff + i, t.model + i,
+                            t.m + i, t.v + i, scale, l1, l2, beta1, beta2, epsilon);
+  }
+}
+
+template<typename T, typename G>
+__global__ void MultiTensorLambNormGpu(MultiTensorLaunchParams<T, G> params,
+                                       const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  int64_t begin = 0;
+  int64_t step = 0;
+  const auto& t = BlockTensors(params, &begin, &step);
+  T t_sum0 = 0;
+  T t_sum1 = 0;
+  for (int64_t i = begin; i < t.n; i += step) {
+    t_sum0 += t.model[i] * t.model[i];
+    t_sum1 += t.adam_diff[i] * t.adam_diff[i];
+  }
+  typedef cub::BlockReduce<T, kCudaThreadsNumPerBlock> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage0;
+  __shared__ typename BlockReduce::TempStorage temp_storage1;
+  T b_sum0 = BlockReduce(temp_storage0).Sum(t_sum0);
+  T b_sum1 = BlockReduce(temp_storage1).Sum(t_sum1);
+  if (threadIdx.x == 0) {
+    cuda::atomic::Add(t.norm, b_sum0);
+    cuda::atomic::Add(t.norm + 1, b_sum1);
+  }
+}
+
+template<typename T, typename G>
+__global__ void MultiTensorLambUpdateGpu(MultiTensorLaunchParams<T, G> params, float weight_decay,
+                                         const float* learning_rate, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  int64_t begin = 0;
+  int64_t step = 0;
+  const auto& t = BlockTensors(params, &begin, &step);
+  const float lr = LambLRFunctor<T>()(*learning_rate, t.norm, t.norm + 1);
+  for (int64_t i = begin; i < t.n; i += step) {
+    LambUpdateFunctor<T>()(lr, weight_decay, t.adam_diff + i, t.model + i);
+  }
+}
+
+template<typename T>
+std::vector<MultiTensorUpdateTensors<T, half>> ToHalf(
+    const std::vector<MultiTensorUpdateTensors<T, float16>>& tensors) {
+  std::vector<MultiTensorUpdateTensors<T, half>> ret(tensors.size());
+  FOR_RANGE(size_t, i, 0, tensors.size()) {
+    const auto& t = tensors.at(i);
+    auto* h = &ret.at(i);
+    h->n = t.n;
+    h->model_diff = reinterpret_cast<const half*>(t.model_diff);
+    h->model = t.model;
+    h->m = t.m;
+    h->v = t.v;
+    h->beta1_t = t.beta1_t;
+    h->beta2_t = t.beta2_t;
+    h->adam_diff = t.adam_diff;
+    h->norm = t.norm;
+  }
+  return ret;
+}
+
+}  // namespace
+
+template<typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCUDA, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float weight_decay, float learning_rate_val,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if) {
+    for (const auto& params : MakeLaunchParams(tensors)) {
+      if (NumBlocks(params) == 0) { continue; }
+      MultiTensorSGDUpdateGpu<T, G><<<NumBlocks(params), kCudaThreadsNumPerBlock, 0,
+                                      stream->As<ep::CudaStream>()->cuda_stream()>>>(
+          params, scale, l1, l2, weight_decay, learning_rate_val, learning_rate, scale_by_ptr,
+          skip_if);
+    }
+  }
+};
+
+template<typename T>
+struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCUDA, T, float16> {
+  static void Update(ep::Stream* stream,
+                     const std::vector<MultiTensorUpdateTensors<T, float16>>& tensors, T scale,
+                     float l1, float l2, float weight_decay, float learning_rate_val,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if) {
+    MultiTensorSGDUpdateKernelUtil<DeviceType::kCUDA, T, half>::Update(
+        stream, ToHalf(tensors), scale, l1, l2, weight_decay, learning_rate_val, learning_rate,
+        scale_by_ptr, skip_if);
+  }
+};
+
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCUDA, float, float>;
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCUDA, double, double>;
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCUDA, float, float16>;
+
+template<typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCUDA, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float beta, float weight_decay,
+                     float learning_rate_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if) {
+    for (const auto& params : MakeLaunchParams(tensors)) {
+      if (NumBlocks(params) == 0) { continue; }
+      MultiTensorMomentumUpdateGpu<T, G><<<NumBlocks(params), kCudaThreadsNumPerBlock, 0,
+                                           stream->As<ep::CudaStream>()->cuda_stream()>>>(
+          params, scale, l1, l2, beta, weight_decay, learning_rate_val, learning_rate,
+          scale_by_ptr, skip_if);
+    }
+  }
+};
+
+template<typename T>
+struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCUDA, T, float16> {
+  static void Update(ep::Stream* stream,
+                     const std::vector<MultiTensorUpdateTensors<T, float16>>& tensors, T scale,
+                     float l1, float l2, float beta, float weight_decay, float learning_rate_val,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if) {
+    MultiTensorMomentumUpdateKernelUtil<DeviceType::kCUDA, T, half>::Update(
+        stream, ToHalf(tensors), scale, l1, l2, beta, weight_decay, learning_rate_val,
+        learning_rate, scale_by_ptr, skip_if);
+  }
+};
+
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCUDA, float, float>;
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCUDA, double, double>;
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCUDA, float, float16>;
+
+template<typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCUDA, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, float learning_rate_val, float bias_correction1_val,
+                     float bias_correction2_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, const float* bias_correction1,
+                     const float* bias_correction2) {
+    for (const auto& params : MakeLaunchParams(tensors)) {
+      if (NumBlocks(params) == 0) { continue; }
+      MultiTensorAdamUpdateGpu<T, G><<<NumBlocks(params), kCudaThreadsNumPerBlock, 0,
+                                       stream->As<ep::CudaStream>()->cuda_stream()>>>(
+          params, scale, l1, l2, beta1, beta2, epsilon, weight_decay, learning_rate_val,
+          bias_correction1_val, bias_correction2_val, learning_rate, scale_by_ptr, skip_if,
+          bias_correction1, bias_correction2);
+    }
+  }
+};
+
+template<typename T>
+struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCUDA, T, float16> {
+  static void Update(ep::Stream* stream,
+                     const std::vector<MultiTensorUpdateTensors<T, float16>>& tensors, T scale,
+                     float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, float learning_rate_val, float bias_correction1_val,
+                     float bias_correction2_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, const float* bias_correction1,
+                     const float* bias_correction2) {
+    MultiTensorAdamUpdateKernelUtil<DeviceType::kCUDA, T, half>::Update(
+        stream, ToHalf(tensors), scale, l1, l2, beta1, beta2, epsilon, weight_decay,
+        learning_rate_val, bias_correction1_val, bias_correction2_val, learning_rate,
+        scale_by_ptr, skip_if, bias_correction1, bias_correction2);
+  }
+};
+
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCUDA, float, float>;
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCUDA, double, double>;
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCUDA, float, float16>;
+
+template<typename T, typename G>
+struct MultiTensorLambUpdateKernelUtil<DeviceType::kCUDA, T, G> {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     float scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if) {
+    cudaStream_t cuda_stream = stream->As<ep::CudaStream>()->cuda_stream();
+    for (const auto& params : MakeLaunchParams(tensors)) {
+      MultiTensorLambBetaTGpu<T, G>
+          <<<1, kMaxTensorsPerLaunch, 0, cuda_stream>>>(params, beta1, beta2, skip_if);
+      if (NumBlocks(params) == 0) { continue; }
+      MultiTensorLambGradGpu<T, G><<<NumBlocks(params), kCudaThreadsNumPerBlock, 0, cuda_stream>>>(
+          params, scale, l1, l2, beta1, beta2, epsilon, scale_by_ptr, skip_if);
+      MultiTensorLambNormGpu<T, G>
+          <<<NumBlocks(params), kCudaThreadsNumPerBlock, 0, cuda_stream>>>(params, skip_if);
+      MultiTensorLambUpdateGpu<T, G><<<NumBlocks(params), kCudaThreadsNumPerBlock, 0,
+                                       cuda_stream>>>(params, weight_decay, learning_rate,
+                                                      skip_if);
+    }
+  }
+};
+
+template<typename T>
+struct MultiTensorLambUpdateKernelUtil<DeviceType::kCUDA, T, float16> {
+  static void Update(ep::Stream* stream,
+                     const std::vector<MultiTensorUpdateTensors<T, float16>>& tensors, float scale,
+                     float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if) {
+    MultiTensorLambUpdateKernelUtil<DeviceType::kCUDA, T, half>::Update(
+        stream, ToHalf(tensors), scale, l1, l2, beta1, beta2, epsilon, weight_decay, learning_rate,
+        scale_by_ptr, skip_if);
+  }
+};
+
+template struct MultiTensorLambUpdateKernelUtil<DeviceType::kCUDA, float, float>;
+template struct MultiTensorLambUpdateKernelUtil<DeviceType::kCUDA, double, double>;
+template struct MultiTensorLambUpdateKernelUtil<DeviceType::kCUDA, float, float16>;
+
+}  // namespace oneflow
@@ -0,0 +1,74 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_MULTI_TENSOR_MODEL_UPDATE_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_MULTI_TENSOR_MODEL_UPDATE_KERNEL_UTIL_H_
+
+#include "oneflow/user/kernels/model_update_kernel_util.h"
+
+namespace oneflow {
+
+// The tensors of one model in a multi tensor update. The ones a method does not use are null.
+template<typename T, typename G>
+struct MultiTensorUpdateTensors {
+  int64_t n;
+  const G* model_diff;
+  T* model;
+  T* m;          // momentum, or the first moment of adam and lamb
+  T* v;          // the second moment of adam and lamb
+  T* beta1_t;    // lamb only
+  T* beta2_t;    // lamb only
+  T* adam_diff;  // lamb only, n elements of the tmp buffer
+  T* norm;       // lamb only, the squared norms of model and adam_diff in the tmp buffer
+};
+
+// Each of these updates every model of a list like the single tensor kernel util of the same
+// method would, but in as few passes over memory and kernel launches as possible.
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float weight_decay, float learning_rate_val,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float beta, float weight_decay,
+                     float learning_rate_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if);
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     T scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, float learning_rate_val, float bias_correction1_val,
+                     float bias_correction2_val, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if, const float* bias_correction1,
+                     const float* bias_correction2);
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorLambUpdateKernelUtil {
+  static void Update(ep::Stream* stream, const std::vector<MultiTensorUpdateTensors<T, G>>& tensors,
+                     float scale, float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if);
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_MULTI_TENSOR_MODEL_UPDATE_KERNEL_UTIL_H_
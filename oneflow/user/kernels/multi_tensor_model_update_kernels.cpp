@@ -0,0 +1,269 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/kernels/multi_tensor_model_update_kernel_util.h"
+#include "oneflow/core/kernel/cuda_graph_support.h"
+
+namespace oneflow {
+
+namespace {
+
+template<typename T, typename G>
+std::vector<MultiTensorUpdateTensors<T, G>> GetModelTensors(
+    user_op::KernelComputeContext* ctx, const std::string& m_arg_name,
+    const std::string& v_arg_name) {
+  const int32_t num_models = ctx->input_size("model");
+  std::vector<MultiTensorUpdateTensors<T, G>> tensors(num_models);
+  FOR_RANGE(int32_t, i, 0, num_models) {
+    user_op::Tensor* model = ctx->Tensor4ArgNameAndIndex("model", i);
+    auto* t = &tensors.at(i);
+    t->n = model->shape().elem_cnt();
+    t->model_diff = ctx->Tensor4ArgNameAndIndex("model_diff", i)->dptr<G>();
+    t->model = model->mut_dptr<T>();
+    if (!m_arg_name.empty()) { t->m = ctx->Tensor4ArgNameAndIndex(m_arg_name, i)->mut_dptr<T>(); }
+    if (!v_arg_name.empty()) { t->v = ctx->Tensor4ArgNameAndIndex(v_arg_name, i)->mut_dptr<T>(); }
+  }
+  return tensors;
+}
+
+const float* LearningRatePtr(user_op::KernelComputeContext* ctx) {
+  if (!ctx->has_input("learning_rate", 0)) { return nullptr; }
+  return ctx->Tensor4ArgNameAndIndex("learning_rate", 0)->dptr<float>();
+}
+
+template<typename T>
+const T* ScaleByPtr(user_op::KernelComputeContext* ctx) {
+  if (!ctx->has_input("scale_by_tensor", 0)) { return nullptr; }
+  const user_op::Tensor* scale_by_tensor = ctx->Tensor4ArgNameAndIndex("scale_by_tensor", 0);
+  CHECK_EQ(scale_by_tensor->data_type(), GetDataType<T>::value);
+  CHECK_EQ(scale_by_tensor->shape().elem_cnt(), 1);
+  return scale_by_tensor->dptr<T>();
+}
+
+const int64_t* SkipIfPtr(user_op::KernelComputeContext* ctx) {
+  if (!ctx->has_input("skip_if", 0)) { return nullptr; }
+  const user_op::Tensor* skip_if = ctx->Tensor4ArgNameAndIndex("skip_if", 0);
+  CHECK_EQ(skip_if->shape().elem_cnt(), 1);
+  return skip_if->dptr<int64_t>();
+}
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorSGDUpdateKernel final : public user_op::OpKernel,
+                                         public user_op::CudaGraphSupport {
+ public:
+  MultiTensorSGDUpdateKernel() = default;
+  ~MultiTensorSGDUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    MultiTensorSGDUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->stream(), GetModelTensors<T, G>(ctx, "", ""),
+        static_cast<T>(ctx->Attr<double>("scale")), ctx->Attr<float>("l1"),
+        ctx->Attr<float>("l2"), ctx->Attr<float>("weight_decay"),
+        ctx->Attr<float>("learning_rate_val"), LearningRatePtr(ctx), ScaleByPtr<T>(ctx),
+        SkipIfPtr(ctx));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(device, dtype, gtype)                     \
+  REGISTER_USER_KERNEL("multi_tensor_sgd_update")                                         \
+      .SetCreateFn<MultiTensorSGDUpdateKernel<device, dtype, gtype>>()                    \
+      .SetIsMatchedHob((user_op::HobDeviceType() == device)                               \
+                       && (user_op::HobDataType("model", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value));
+
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCPU, double, double);
+#ifdef WITH_CUDA
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCUDA, float, float16);
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCUDA, float, float);
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCUDA, double, double);
+#endif  // WITH_CUDA
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorMomentumUpdateKernel final : public user_op::OpKernel,
+                                              public user_op::CudaGraphSupport {
+ public:
+  MultiTensorMomentumUpdateKernel() = default;
+  ~MultiTensorMomentumUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    MultiTensorMomentumUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->stream(), GetModelTensors<T, G>(ctx, "momentum", ""),
+        static_cast<T>(ctx->Attr<double>("scale")), ctx->Attr<float>("l1"),
+        ctx->Attr<float>("l2"), ctx->Attr<float>("beta"), ctx->Attr<float>("weight_decay"),
+        ctx->Attr<float>("learning_rate_val"), LearningRatePtr(ctx), ScaleByPtr<T>(ctx),
+        SkipIfPtr(ctx));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(device, dtype, gtype)                \
+  REGISTER_USER_KERNEL("multi_tensor_momentum_update")                                    \
+      .SetCreateFn<MultiTensorMomentumUpdateKernel<device, dtype, gtype>>()               \
+      .SetIsMatchedHob((user_op::HobDeviceType() == device)                               \
+                       && (user_op::HobDataType("model", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value));
+
+REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(DeviceType::kCPU, double, double);
+#ifdef WITH_CUDA
+REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(DeviceType::kCUDA, float, float16);
+REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(DeviceType::kCUDA, float, float);
+REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(DeviceType::kCUDA, double, double);
+#endif  // WITH_CUDA
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorAdamUpdateKernel final : public user_op::OpKernel,
+                                          public user_op::CudaGraphSupport {
+ public:
+  MultiTensorAdamUpdateKernel() = default;
+  ~MultiTensorAdamUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const float* bias_correction1_ptr = nullptr;
+    if (ctx->has_input("bias_correction1", 0)) {
+      bias_correction1_ptr = ctx->Tensor4ArgNameAndIndex("bias_correction1", 0)->dptr<float>();
+    }
+    const float* bias_correction2_ptr = nullptr;
+    if (ctx->has_input("bias_correction2", 0)) {
+      bias_correction2_ptr = ctx->Tensor4ArgNameAndIndex("bias_correction2", 0)->dptr<float>();
+    }
+    MultiTensorAdamUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->stream(), GetModelTensors<T, G>(ctx, "m", "v"),
+        static_cast<T>(ctx->Attr<double>("scale")), ctx->Attr<float>("l1"),
+        ctx->Attr<float>("l2"), ctx->Attr<float>("beta1"), ctx->Attr<float>("beta2"),
+        ctx->Attr<float>("epsilon"), ctx->Attr<float>("weight_decay"),
+        ctx->Attr<float>("learning_rate_val"), ctx->Attr<float>("bias_correction1_val"),
+        ctx->Attr<float>("bias_correction2_val"), LearningRatePtr(ctx), ScaleByPtr<T>(ctx),
+        SkipIfPtr(ctx), bias_correction1_ptr, bias_correction2_ptr);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(device, dtype, gtype)                    \
+  REGISTER_USER_KERNEL("multi_tensor_adam_update")                                        \
+      .SetCreateFn<MultiTensorAdamUpdateKernel<device, dtype, gtype>>()                   \
+      .SetIsMatchedHob((user_op::HobDeviceType() == device)                               \
+                       && (user_op::HobDataType("model", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value));
+
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCPU, double, double);
+#ifdef WITH_CUDA
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCUDA, float, float16);
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCUDA, float, float);
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCUDA, double, double);
+#endif  // WITH_CUDA
+
+// The tmp buffer of multi tensor lamb: the squared norms of all models, then the adam diff of
+// every model.
+template<typename T>
+class MultiTensorLambTmpBufferManager final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MultiTensorLambTmpBufferManager);
+  MultiTensorLambTmpBufferManager(void* ptr, const std::vector<int64_t>& elem_cnts) : ptr_(ptr) {
+    size_t offset = GetCudaAlignedSize(2 * elem_cnts.size() * sizeof(T));
+    for (int64_t elem_cnt : elem_cnts) {
+      adam_diff_offsets_.push_back(offset);
+      offset += GetCudaAlignedSize(elem_cnt * sizeof(T));
+    }
+    total_buffer_size_ = offset;
+  }
+  ~MultiTensorLambTmpBufferManager() = default;
+
+  size_t GetTotalBufferSize() const { return total_buffer_size_; }
+
+  T* NormPtr(int32_t i) const {
+    CHECK(ptr_ != nullptr);
+    return reinterpret_cast<T*>(ptr_) + 2 * i;
+  }
+  T* AdamDiffPtr(int32_t i) const {
+    CHECK(ptr_ != nullptr);
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(ptr_) + adam_diff_offsets_.at(i));
+  }
+
+ private:
+  std::vector<size_t> adam_diff_offsets_;
+  size_t total_buffer_size_;
+  void* ptr_;
+};
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorLambUpdateKernel final : public user_op::OpKernel,
+                                          public user_op::CudaGraphSupport {
+ public:
+  MultiTensorLambUpdateKernel() = default;
+  ~MultiTensorLambUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    std::vector<MultiTensorUpdateTensors<T, G>> tensors = GetModelTensors<T, G>(ctx, "m", "v");
+    std::vector<int64_t> elem_cnts;
+    for (const auto& t : tensors) { elem_cnts.push_back(t.n); }
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    MultiTensorLambTmpBufferManager<T> tbm(tmp_buffer->mut_dptr(), elem_cnts);
+    FOR_RANGE(int32_t, i, 0, tensors.size()) {
+      auto* t = &tensors.at(i);
+      t->beta1_t = ctx->Tensor4ArgNameAndIndex("beta1_t", i)->mut_dptr<T>();
+      t->beta2_t = ctx->Tensor4ArgNameAndIndex("beta2_t", i)->mut_dptr<T>();
+      t->adam_diff = tbm.AdamDiffPtr(i);
+      t->norm = tbm.NormPtr(i);
+    }
+    MultiTensorLambUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->stream(), tensors, ctx->Attr<double>("scale"), ctx->Attr<float>("l1"),
+        ctx->Attr<float>("l2"), ctx->Attr<float>("beta1"), ctx->Attr<float>("beta2"),
+        ctx->Attr<float>("epsilon"), ctx->Attr<float>("weight_decay"),
+        ctx->Tensor4ArgNameAndIndex("learning_rate", 0)->dptr<float>(), ScaleByPtr<T>(ctx),
+        SkipIfPtr(ctx));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+template<typename T>
+user_op::InferTmpSizeFn MultiTensorLambGenInferTmpSizeFn() {
+  return [](user_op::InferContext* ctx) {
+    std::vector<int64_t> elem_cnts;
+    FOR_RANGE(int32_t, i, 0, ctx->input_size("model")) {
+      elem_cnts.push_back(ctx->InputShape("model", i).elem_cnt());
+    }
+    MultiTensorLambTmpBufferManager<T> tbm(nullptr, elem_cnts);
+    return tbm.GetTotalBufferSize();
+  };
+}
+
+#define REGISTER_MULTI_TENSOR_LAMB_UPDATE_KERNEL(device, dtype, gtype)                          \
+  REGISTER_USER_KERNEL("multi_tensor_lamb_update")                                              \
+      .SetCreateFn<MultiTensorLambUpdateKernel<device, dtype, gtype>>()                         \
+      .SetIsMatchedHob((user_op::HobDeviceType() == device)                                     \
+                       && (user_op::HobDataType("model", 0) == GetDataType<dtype>::value)       \
+                       && (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value)) \
+      .SetInferTmpSizeFn(MultiTensorLambGenInferTmpSizeFn<dtype>());
+
+REGISTER_MULTI_TENSOR_LAMB_UPDATE_KERNEL(DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_LAMB_UPDATE_KERNEL(DeviceType::kCPU, double, double);
+#ifdef WITH_CUDA
+REGISTER_MULTI_TENSOR_LAMB_UPDATE_KERNEL(DeviceType::kCUDA, float, float16);
+REGISTER_MULTI_TENSOR_LAMB_UPDATE_KERNEL(DeviceType::kCUDA, float, float);
+REGISTER_MULTI_TENSOR_LAMB_UPDATE_KERNEL(DeviceType::kCUDA, double, double);
+#endif  // WITH_CUDA
+
+}  // namespace
+
+}  // namespace oneflow
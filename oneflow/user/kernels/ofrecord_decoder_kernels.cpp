@@ -22,6 +22,7 @@ limitations under the License.
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/user/image/random_crop_generator.h"
 #include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
 #include "oneflow/user/kernels/random_crop_kernel_state.h"
 #include "oneflow/user/kernels/op_kernel_wrapper.h"
 #include "oneflow/user/kernels/random_seed_util.h"
@@ -172,6 +173,25 @@ void DecodeRandomCropImageFromOneRecord(const OFRecord& record, TensorBuffer* bu
   CHECK(feature.bytes_list().value_size() == 1);
   const std::string& src_data = feature.bytes_list().value(0);
 
+  // JPEG images are cropped from the header size and only the crop is decoded, the crop window is
+  // kept for the OpenCV path in case libjpeg-turbo fails on the data.
+  const unsigned char* jpeg_data = reinterpret_cast<const unsigned char*>(src_data.data());
+  CropWindow jpeg_crop;
+  bool has_jpeg_crop = false;
+  int jpeg_width = 0;
+  int jpeg_height = 0;
+  if (JpegDecodeEnabled()
+      && JpegGetImageSize(jpeg_data, src_data.size(), &jpeg_width, &jpeg_height)) {
+    if (random_crop_gen != nullptr) {
+      random_crop_gen->GenerateCropWindow({jpeg_height, jpeg_width}, &jpeg_crop);
+      has_jpeg_crop = true;
+    }
+    if (JpegDecode(jpeg_data, src_data.size(), color_space, has_jpeg_crop ? &jpeg_crop : nullptr,
+                   0, 0, buffer)) {
+      return;
+    }
+  }
+
   // cv::_InputArray image_data(src_data.data(), src_data.size());
   // cv::Mat image = cv::imdecode(image_data, cv::IMREAD_ANYCOLOR);
   cv::Mat image =
@@ -185,7 +205,11 @@ void DecodeRandomCropImageFromOneRecord(const OFRecord& record, TensorBuffer* bu
     CHECK(image.data != nullptr);
     cv::Mat image_roi;
     CropWindow crop;
-    random_crop_gen->GenerateCropWindow({H, W}, &crop);
+    if (has_jpeg_crop) {
+      crop = jpeg_crop;
+    } else {
+      random_crop_gen->GenerateCropWindow({H, W}, &crop);
+    }
     const int y = crop.anchor.At(0);
     const int x = crop.anchor.At(1);
     const int newH = crop.shape.At(0);
@@ -23,10 +23,20 @@ limitations under the License.
 #include "oneflow/core/framework/consistent_tensor_infer_cache.h"
 #include "oneflow/core/operator/operator.h"
 #include "oneflow/core/profiler/profiler.h"
+#include "oneflow/core/vm/cpu_stream_type.h"
 
 namespace oneflow {
 namespace one {
 
+namespace {
+
+// Only cpu devices have several compute streams.
+int64_t VmStreamNum(const Device& device) {
+  return device.type() == "cpu" ? vm::CpuStreamNumPerDevice() : 1;
+}
+
+}  // namespace
+
 int32_t TryGetTensorTupleIndex(const std::unordered_map<std::string, std::vector<int32_t>>&
                                    arg_name2bn_index2tensor_tuple_index,
                                const std::string& arg_name, const int32_t arg_index) {
@@ -380,24 +390,27 @@ Maybe<void> InitTensorTupleIndexes4Bns(const std::shared_ptr<const OperatorConf>
   opkernel->op_conf_ = op_conf;
   opkernel->user_op_conf_.reset(new user_op::UserOpConfWrapper(op_conf));
   opkernel->device_ = device;
-  opkernel->composed_attrs_for_scheduler_thread_.reset(new ComposedAttrMap(base_attrs));
   opkernel->composed_attrs_for_main_thread_.reset(new ComposedAttrMap(base_attrs));
   opkernel->input_arg_tuple_ = input_arg_tuple;
   opkernel->output_arg_tuple_ = output_arg_tuple;
   opkernel->need_check_mem_case_ = true;
 
-  opkernel->tmp_blob_object_.reset(
-      new vm::EagerBlobObject(opkernel->mem_case(), std::make_shared<Shape>(), DataType::kChar,
-                              std::make_shared<vm::TensorStorage>()));
-
   const std::string& device_tag = op_conf->device_tag();
   const user_op::UserOpConfWrapper* user_op_conf = opkernel->user_op_conf_.get();
-  opkernel->op_infer_ctx_for_scheduler_thread_.reset(new LocalUserOpInferContext(
-      user_op_conf, opkernel->composed_attrs_for_scheduler_thread_.get(), input_arg_tuple,
-      output_arg_tuple));
-  opkernel->compute_ctx_.reset(new LocalUserKernelComputeContext(
-      nullptr, device_tag, user_op_conf, opkernel->composed_attrs_for_scheduler_thread_.get(),
-      input_arg_tuple, output_arg_tuple, opkernel->mut_temp_blob_object()));
+  // Created up front, so that the streams never change vm_stream_ctxs_ while others read it.
+  for (int64_t i = 0; i < VmStreamNum(*device); ++i) {
+    auto* ctx = new VmStreamContext();
+    opkernel->vm_stream_ctxs_.emplace_back(ctx);
+    ctx->composed_attrs.reset(new ComposedAttrMap(base_attrs));
+    ctx->op_infer_ctx.reset(new LocalUserOpInferContext(user_op_conf, ctx->composed_attrs.get(),
+                                                         input_arg_tuple, output_arg_tuple));
+    ctx->tmp_blob_object.reset(
+        new vm::EagerBlobObject(opkernel->mem_case(), std::make_shared<Shape>(), DataType::kChar,
+                                std::make_shared<vm::TensorStorage>()));
+    ctx->compute_ctx.reset(new LocalUserKernelComputeContext(
+        nullptr, device_tag, user_op_conf, ctx->composed_attrs.get(), input_arg_tuple,
+        output_arg_tuple, ctx->tmp_blob_object.get()));
+  }
   opkernel->reg_ctx_.reset(new LocalUserKernelRegContext(
       device_tag, user_op_conf, opkernel->composed_attrs_for_main_thread_.get(), input_arg_tuple,
       output_arg_tuple));
@@ -423,8 +436,9 @@ Maybe<void> InitTensorTupleIndexes4Bns(const std::shared_ptr<const OperatorConf>
 StatefulLocalOpKernel::~StatefulLocalOpKernel() = default;
 
 Maybe<void> StatefulLocalOpKernel::ChooseOpKernel(
-    const user_op::OpKernel** user_opkernel, bool* need_temp_storage, const AttrMap& attrs,
-    EagerBlobObjectListRawPtr inputs, EagerBlobObjectListRawPtr outputs,
+    const user_op::OpKernel** user_opkernel, std::atomic<bool>** user_opkernel_stateless,
+    bool* need_temp_storage, const AttrMap& attrs, EagerBlobObjectListRawPtr inputs,
+    EagerBlobObjectListRawPtr outputs,
     ConsistentTensorInferResultRawPtr consistent_tensor_infer_result) {
   OF_PROFILER_RANGE_GUARD("ChooseOpKernel");
   reg_ctx_->Update(attrs, inputs, outputs, consistent_tensor_infer_result);
@@ -438,11 +452,12 @@ Maybe<void> StatefulLocalOpKernel::ChooseOpKernel(
     // do nothing
   }
 
-  for (const auto& pair : dtype2cached_kernels_[primary_dtype]) {
-    if (likely(pair.first->is_matched_hob->get(*reg_ctx_))) {
+  for (const auto& cached_kernel : dtype2cached_kernels_[primary_dtype]) {
+    if (likely(cached_kernel.registry_result->is_matched_hob->get(*reg_ctx_))) {
       reg_ctx_->Update(AttrMap{}, nullptr, nullptr, nullptr);
-      *need_temp_storage = pair.first->need_temp_storage;
-      *user_opkernel = pair.second.get();
+      *need_temp_storage = cached_kernel.registry_result->need_temp_storage;
+      *user_opkernel = cached_kernel.kernel.get();
+      *user_opkernel_stateless = cached_kernel.stateless.get();
       return Maybe<void>::Ok();
     }
   }
@@ -454,25 +469,31 @@ Maybe<void> StatefulLocalOpKernel::ChooseOpKernel(
       JUST(user_op::UserOpRegistryMgr::Get().GetOpKernelRegistryResult(op_type_name, *reg_ctx_));
   CHECK_NOTNULL(kernel_reg_val);
   auto* kernel = kernel_reg_val->create_fn();
+  const auto stateless = std::make_shared<std::atomic<bool>>(false);
   dtype2cached_kernels_[primary_dtype].push_back(
-      {kernel_reg_val, std::shared_ptr<const user_op::OpKernel>(kernel)});
+      {kernel_reg_val, std::shared_ptr<const user_op::OpKernel>(kernel), stateless});
 
   infer_tmp_size_fn_map_.emplace(kernel, &kernel_reg_val->infer_tmp_size_fn);
+  inplace_proposal_fn_map_.emplace(kernel, &kernel_reg_val->inplace_proposal_fn);
   reg_ctx_->Update(AttrMap{}, nullptr, nullptr, nullptr);
   *need_temp_storage = kernel_reg_val->need_temp_storage;
   *user_opkernel = kernel;
+  *user_opkernel_stateless = stateless.get();
   return Maybe<void>::Ok();
 }
 
 void StatefulLocalOpKernel::TryInitOpKernelStateAndCache(
-    const user_op::OpKernel* op_kernel, DeviceCtx* device_ctx, EagerBlobObjectListRawPtr inputs,
-    EagerBlobObjectListRawPtr outputs,
+    int64_t vm_stream_index, const user_op::OpKernel* op_kernel,
+    std::atomic<bool>* op_kernel_stateless, DeviceCtx* device_ctx,
+    EagerBlobObjectListRawPtr inputs, EagerBlobObjectListRawPtr outputs,
     ConsistentTensorInferResultRawPtr consistent_tensor_infer_result,
     user_op::OpKernelState** state, user_op::OpKernelCache** cache) {
+  VmStreamContext* ctx = vm_stream_ctxs_.at(vm_stream_index).get();
   LocalUserKernelInitAndCacheContext init_and_cache_ctx(
       device_ctx, op_conf_->device_tag(), user_op_conf_.get(), input_arg_tuple_, output_arg_tuple_,
-      inputs, outputs, consistent_tensor_infer_result, composed_attrs_for_scheduler_thread());
-  if (state != nullptr) {
+      inputs, outputs, consistent_tensor_infer_result, ctx->composed_attrs.get());
+  // Kernels run on the other streams only once they are known to create no state.
+  if (state != nullptr && vm_stream_index == 0) {
     auto it = op_kernel_state_map_.find(op_kernel);
     if (it != op_kernel_state_map_.end()) {
       *state = it->second.get();
@@ -480,11 +501,12 @@ void StatefulLocalOpKernel::TryInitOpKernelStateAndCache(
       auto created_state = op_kernel->CreateOpKernelState(&init_and_cache_ctx);
       op_kernel_state_map_.emplace(op_kernel, created_state);
       *state = created_state.get();
+      if (!created_state) { op_kernel_stateless->store(true, std::memory_order_release); }
     }
   }
 
   {
-    auto& cache_in_map = op_kernel_cache_map_[op_kernel];
+    auto& cache_in_map = ctx->op_kernel_cache_map[op_kernel];
     op_kernel->InitOpKernelCache(&init_and_cache_ctx, user_op::OpKernelCache::kAllMayChanged,
                                  &cache_in_map);
     *cache = cache_in_map.get();
@@ -496,8 +518,39 @@ const user_op::InferTmpSizeFn& StatefulLocalOpKernel::GetInferTmpSizeFn(
   return *infer_tmp_size_fn_map_.at(op_kernel);
 }
 
-vm::EagerBlobObject* StatefulLocalOpKernel::mut_temp_blob_object() {
-  return tmp_blob_object_.get();
+Maybe<const std::vector<std::pair<int64_t, int64_t>>*>
+StatefulLocalOpKernel::GetInplaceOutInIndexes(
+    int64_t vm_stream_index, const user_op::OpKernel* op_kernel, EagerBlobObjectListRawPtr inputs,
+    EagerBlobObjectListRawPtr outputs,
+    ConsistentTensorInferResultRawPtr consistent_tensor_infer_result) {
+  VmStreamContext* ctx = vm_stream_ctxs_.at(vm_stream_index).get();
+  const auto& iter = ctx->op_kernel2inplace_out_in_indexes.find(op_kernel);
+  if (likely(iter != ctx->op_kernel2inplace_out_in_indexes.end())) { return &iter->second; }
+  std::vector<std::pair<int64_t, int64_t>> inplace_out_in_indexes;
+  user_op::AddInplaceArgPair AddInplaceArgPair =
+      [&](const std::string& out_arg_name, int32_t out_arg_index, const std::string& in_arg_name,
+          int32_t in_arg_index, bool is_mutable) -> Maybe<void> {
+    const int32_t out_index =
+        output_arg_tuple_->TensorTupleIndex4ArgNameAndIndex(out_arg_name, out_arg_index);
+    const int32_t in_index =
+        input_arg_tuple_->TensorTupleIndex4ArgNameAndIndex(in_arg_name, in_arg_index);
+    if (out_index >= 0 && in_index >= 0) {
+      inplace_out_in_indexes.emplace_back(out_index, in_index);
+    }
+    return Maybe<void>::Ok();
+  };
+  const auto& InplaceProposalFn = *inplace_proposal_fn_map_.at(op_kernel);
+  ctx->op_infer_ctx->Update(inputs, outputs, consistent_tensor_infer_result);
+  const Maybe<void> maybe_ok = InplaceProposalFn(*ctx->op_infer_ctx, AddInplaceArgPair);
+  ctx->op_infer_ctx->Update(nullptr, nullptr, nullptr);
+  JUST(maybe_ok);
+  auto* ret = &ctx->op_kernel2inplace_out_in_indexes[op_kernel];
+  *ret = std::move(inplace_out_in_indexes);
+  return ret;
+}
+
+vm::EagerBlobObject* StatefulLocalOpKernel::mut_temp_blob_object(int64_t vm_stream_index) {
+  return vm_stream_ctxs_.at(vm_stream_index)->tmp_blob_object.get();
 }
 
 user_op::TensorDescInferFn StatefulLocalOpKernel::TensorDescInferFn() const {
@@ -509,10 +562,11 @@ user_op::DataTypeInferFn StatefulLocalOpKernel::DataTypeInferFn() const {
 }
 
 LocalUserKernelComputeContext* StatefulLocalOpKernel::UpdateComputeContext(
-    EagerBlobObjectListRawPtr inputs, EagerBlobObjectListRawPtr outputs,
+    int64_t vm_stream_index, EagerBlobObjectListRawPtr inputs, EagerBlobObjectListRawPtr outputs,
     ConsistentTensorInferResultRawPtr consistent_tensor_infer_result, DeviceCtx* device_ctx) {
-  compute_ctx_->Update(inputs, outputs, consistent_tensor_infer_result, device_ctx);
-  return compute_ctx_.get();
+  auto* compute_ctx = vm_stream_ctxs_.at(vm_stream_index)->compute_ctx.get();
+  compute_ctx->Update(inputs, outputs, consistent_tensor_infer_result, device_ctx);
+  return compute_ctx;
 }
 
 }  // namespace one
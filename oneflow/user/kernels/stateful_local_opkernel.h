@@ -384,6 +384,10 @@ class StatefulLocalOpKernel final {
                                           const std::shared_ptr<const ArgTuple>& output_arg_tuple);
   ~StatefulLocalOpKernel();
   const Symbol<Device>& device() const { return device_; }
+  // Number of streams of the device the instructions of this opkernel may run on. Each of them has
+  // its own contexts and caches, so that instructions on different streams may run concurrently.
+  // Kernel states are kept once per opkernel and only used on stream 0, see ChooseOpKernel.
+  int64_t vm_stream_num() const { return vm_stream_ctxs_.size(); }
   const std::shared_ptr<MemoryCase>& mem_case() const { return device_->mem_case(); }
   const std::string& op_type_name() const { return op_conf_->user_conf().op_type_name(); }
   const std::vector<int64_t>& input_tuple_indexes4const_ibns() const {
@@ -399,59 +403,82 @@ class StatefulLocalOpKernel final {
     return output_tuple_indexes4mut2_obns_;
   }
 
-  ComposedAttrMap* composed_attrs_for_scheduler_thread() const {
-    return composed_attrs_for_scheduler_thread_.get();
+  ComposedAttrMap* composed_attrs_for_scheduler_thread(int64_t vm_stream_index) const {
+    return vm_stream_ctxs_.at(vm_stream_index)->composed_attrs.get();
   }
 
   ComposedAttrMap* composed_attrs_for_main_thread() const {
     return composed_attrs_for_main_thread_.get();
   }
 
-  LocalUserOpInferContext* op_infer_ctx_for_scheduler_thread() const {
-    return op_infer_ctx_for_scheduler_thread_.get();
+  LocalUserOpInferContext* op_infer_ctx_for_scheduler_thread(int64_t vm_stream_index) const {
+    return vm_stream_ctxs_.at(vm_stream_index)->op_infer_ctx.get();
   }
 
   void set_need_check_mem_case(bool value) { need_check_mem_case_ = value; }
 
-  Maybe<void> ChooseOpKernel(const user_op::OpKernel** user_opkernel, bool* need_temp_storage,
+  // Also returns whether the kernel is known to create no state, which is set once its state was
+  // initialized on stream 0. The instructions of kernels not known to be stateless run on stream 0.
+  Maybe<void> ChooseOpKernel(const user_op::OpKernel** user_opkernel,
+                             std::atomic<bool>** user_opkernel_stateless, bool* need_temp_storage,
                              const AttrMap& attrs, EagerBlobObjectListRawPtr inputs,
                              EagerBlobObjectListRawPtr outputs,
                              ConsistentTensorInferResultRawPtr consistent_tensor_infer_result);
 
  private:
   friend struct vm::LocalCallOpKernelUtil;
+  // What the instructions running on a stream change.
+  struct VmStreamContext {
+    std::unique_ptr<ComposedAttrMap> composed_attrs;
+    std::unique_ptr<LocalUserOpInferContext> op_infer_ctx;
+    std::unique_ptr<vm::EagerBlobObject> tmp_blob_object;
+    std::unique_ptr<LocalUserKernelComputeContext> compute_ctx;
+    HashMap<const user_op::OpKernel*, std::shared_ptr<user_op::OpKernelCache>> op_kernel_cache_map;
+    HashMap<const user_op::OpKernel*, std::vector<std::pair<int64_t, int64_t>>>
+        op_kernel2inplace_out_in_indexes;
+  };
+
+  // A kernel chosen for a dtype and whether it is known to create no state.
+  struct CachedOpKernel {
+    const user_op::OpKernelRegistryResult* registry_result;
+    std::shared_ptr<const user_op::OpKernel> kernel;
+    std::shared_ptr<std::atomic<bool>> stateless;
+  };
+
   StatefulLocalOpKernel() = default;
   LocalUserKernelComputeContext* UpdateComputeContext(
-      EagerBlobObjectListRawPtr inputs, EagerBlobObjectListRawPtr outputs,
+      int64_t vm_stream_index, EagerBlobObjectListRawPtr inputs, EagerBlobObjectListRawPtr outputs,
       ConsistentTensorInferResultRawPtr consistent_tensor_infer_result, DeviceCtx* device_ctx);
 
   user_op::TensorDescInferFn TensorDescInferFn() const;
   user_op::DataTypeInferFn DataTypeInferFn() const;
 
   void TryInitOpKernelStateAndCache(
-      const user_op::OpKernel* op_kernel, DeviceCtx* device_ctx, EagerBlobObjectListRawPtr inputs,
-      EagerBlobObjectListRawPtr outputs,
+      int64_t vm_stream_index, const user_op::OpKernel* op_kernel,
+      std::atomic<bool>* op_kernel_stateless, DeviceCtx* device_ctx,
+      EagerBlobObjectListRawPtr inputs, EagerBlobObjectListRawPtr outputs,
       ConsistentTensorInferResultRawPtr consistent_tensor_infer_result,
       user_op::OpKernelState** state, user_op::OpKernelCache** cache);
 
-  vm::EagerBlobObject* mut_temp_blob_object();
-
-  user_op::OpKernelState* mut_opkernel_state(const user_op::OpKernel* opkernel) {
-    return op_kernel_state_map_.at(opkernel).get();
-  }
+  vm::EagerBlobObject* mut_temp_blob_object(int64_t vm_stream_index);
 
   bool need_check_mem_case() const { return need_check_mem_case_; }
 
   const user_op::InferTmpSizeFn& GetInferTmpSizeFn(const user_op::OpKernel* op_kernel) const;
 
+  // Pairs of output and input indexes `op_kernel` may compute inplace, as proposed by its
+  // registry. Only called on the thread of stream vm_stream_index.
+  Maybe<const std::vector<std::pair<int64_t, int64_t>>*> GetInplaceOutInIndexes(
+      int64_t vm_stream_index, const user_op::OpKernel* op_kernel, EagerBlobObjectListRawPtr inputs,
+      EagerBlobObjectListRawPtr outputs,
+      ConsistentTensorInferResultRawPtr consistent_tensor_infer_result);
+
   std::shared_ptr<OperatorConf> op_conf_;
-  std::unique_ptr<ComposedAttrMap> composed_attrs_for_scheduler_thread_;
   std::unique_ptr<ComposedAttrMap> composed_attrs_for_main_thread_;
   std::unique_ptr<user_op::UserOpConfWrapper> user_op_conf_;
   Symbol<Device> device_;
+  std::vector<std::unique_ptr<VmStreamContext>> vm_stream_ctxs_;
   std::unique_ptr<LocalUserKernelRegContext> reg_ctx_;
-  std::unique_ptr<LocalUserOpInferContext> op_infer_ctx_for_scheduler_thread_;
-  std::unique_ptr<LocalUserKernelComputeContext> compute_ctx_;
   std::shared_ptr<const ArgTuple> input_arg_tuple_;
   std::shared_ptr<const ArgTuple> output_arg_tuple_;
   bool need_check_mem_case_;
@@ -459,14 +486,11 @@ class StatefulLocalOpKernel final {
   user_op::DataTypeInferFn data_type_infer_fn_;
   // NOTE: every device has its own stateful local opkernel instance,
   // so only group kernels by dtype
-  std::array<std::vector<std::pair<const user_op::OpKernelRegistryResult*,
-                                   std::shared_ptr<const user_op::OpKernel>>>,
-             DataType_MAX>
-      dtype2cached_kernels_;
+  std::array<std::vector<CachedOpKernel>, DataType_MAX> dtype2cached_kernels_;
+  // Only used on stream 0.
   HashMap<const user_op::OpKernel*, std::shared_ptr<user_op::OpKernelState>> op_kernel_state_map_;
-  HashMap<const user_op::OpKernel*, std::shared_ptr<user_op::OpKernelCache>> op_kernel_cache_map_;
   HashMap<const user_op::OpKernel*, const user_op::InferTmpSizeFn*> infer_tmp_size_fn_map_;
-  std::unique_ptr<vm::EagerBlobObject> tmp_blob_object_;
+  HashMap<const user_op::OpKernel*, const user_op::InplaceProposalFn*> inplace_proposal_fn_map_;
   std::vector<int64_t> input_tuple_indexes4const_ibns_;
   std::vector<int64_t> input_tuple_indexes4mut_ibns_;
   std::vector<int64_t> output_tuple_indexes4mut_obns_;
@@ -0,0 +1,38 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/to_contiguous_kernel.h"
+
+namespace oneflow {
+
+template<typename T>
+struct ToContiguousFunctor<DeviceType::kCPU, T> final {
+  void operator()(ep::Stream* stream, const StridedCopyParams& params, int64_t elem_cnt,
+                  const T* in, T* out) {
+    FOR_RANGE(int64_t, i, 0, elem_cnt) { out[i] = in[StridedCopyOffset(params, i)]; }
+  }
+};
+
+template<typename T>
+struct ToStridedFunctor<DeviceType::kCPU, T> final {
+  void operator()(ep::Stream* stream, const StridedCopyParams& params, int64_t elem_cnt,
+                  const T* in, T* out) {
+    FOR_RANGE(int64_t, i, 0, elem_cnt) { out[StridedCopyOffset(params, i)] = in[i]; }
+  }
+};
+
+REGISTER_STRIDED_COPY_KERNELS(DeviceType::kCPU)
+
+}  // namespace oneflow
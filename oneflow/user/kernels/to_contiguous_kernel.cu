@@ -0,0 +1,56 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/to_contiguous_kernel.h"
+#include "oneflow/core/device/cuda_util.h"
+#include "oneflow/core/ep/cuda/cuda_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+template<typename T>
+__global__ void ToContiguousGpu(StridedCopyParams params, int64_t elem_cnt, const T* in, T* out) {
+  CUDA_1D_KERNEL_LOOP_T(int64_t, i, elem_cnt) { out[i] = in[StridedCopyOffset(params, i)]; }
+}
+
+template<typename T>
+__global__ void ToStridedGpu(StridedCopyParams params, int64_t elem_cnt, const T* in, T* out) {
+  CUDA_1D_KERNEL_LOOP_T(int64_t, i, elem_cnt) { out[StridedCopyOffset(params, i)] = in[i]; }
+}
+
+}  // namespace
+
+template<typename T>
+struct ToContiguousFunctor<DeviceType::kCUDA, T> final {
+  void operator()(ep::Stream* stream, const StridedCopyParams& params, int64_t elem_cnt,
+                  const T* in, T* out) {
+    ToContiguousGpu<T><<<BlocksNum4ThreadsNum(elem_cnt), kCudaThreadsNumPerBlock, 0,
+                         stream->As<ep::CudaStream>()->cuda_stream()>>>(params, elem_cnt, in, out);
+  }
+};
+
+template<typename T>
+struct ToStridedFunctor<DeviceType::kCUDA, T> final {
+  void operator()(ep::Stream* stream, const StridedCopyParams& params, int64_t elem_cnt,
+                  const T* in, T* out) {
+    ToStridedGpu<T><<<BlocksNum4ThreadsNum(elem_cnt), kCudaThreadsNumPerBlock, 0,
+                      stream->As<ep::CudaStream>()->cuda_stream()>>>(params, elem_cnt, in, out);
+  }
+};
+
+REGISTER_STRIDED_COPY_KERNELS(DeviceType::kCUDA)
+
+}  // namespace oneflow
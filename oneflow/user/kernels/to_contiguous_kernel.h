@@ -0,0 +1,121 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_TO_CONTIGUOUS_KERNEL_H_
+#define ONEFLOW_USER_KERNELS_TO_CONTIGUOUS_KERNEL_H_
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// The strided side of a copy, with the dimensions the copy is able to walk through as one
+// merged in advance.
+struct StridedCopyParams {
+  int32_t ndim;
+  int64_t dims[SHAPE_MAX_AXIS_SIZE];
+  int64_t stride[SHAPE_MAX_AXIS_SIZE];
+};
+
+OF_DEVICE_FUNC int64_t StridedCopyOffset(const StridedCopyParams& params, int64_t index) {
+  int64_t offset = 0;
+  for (int32_t i = params.ndim - 1; i >= 0; --i) {
+    offset += (index % params.dims[i]) * params.stride[i];
+    index /= params.dims[i];
+  }
+  return offset;
+}
+
+template<DeviceType device_type, typename T>
+struct ToContiguousFunctor final {
+  void operator()(ep::Stream* stream, const StridedCopyParams& params, int64_t elem_cnt,
+                  const T* in, T* out);
+};
+
+// The inverse of ToContiguousFunctor: a contiguous input is scattered into a strided output.
+template<DeviceType device_type, typename T>
+struct ToStridedFunctor final {
+  void operator()(ep::Stream* stream, const StridedCopyParams& params, int64_t elem_cnt,
+                  const T* in, T* out);
+};
+
+inline StridedCopyParams MakeStridedCopyParams(const ShapeView& shape,
+                                               const std::vector<int64_t>& stride) {
+  CHECK_EQ(shape.NumAxes(), stride.size());
+  StridedCopyParams params;
+  params.ndim = 0;
+  FOR_RANGE(int64_t, i, 0, shape.NumAxes()) {
+    if (shape.At(i) == 1) { continue; }
+    if (params.ndim > 0 && params.stride[params.ndim - 1] == stride.at(i) * shape.At(i)) {
+      params.dims[params.ndim - 1] *= shape.At(i);
+      params.stride[params.ndim - 1] = stride.at(i);
+    } else {
+      params.dims[params.ndim] = shape.At(i);
+      params.stride[params.ndim] = stride.at(i);
+      params.ndim += 1;
+    }
+  }
+  return params;
+}
+
+template<DeviceType device_type, template<DeviceType, typename> class CopyFunctor>
+class StridedCopyKernel final : public user_op::OpKernel {
+ public:
+  StridedCopyKernel() = default;
+  ~StridedCopyKernel() = default;
+
+ private:
+  using user_op::OpKernel::Compute;
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t elem_cnt = out->shape().elem_cnt();
+    if (elem_cnt == 0) { return; }
+    const StridedCopyParams params =
+        MakeStridedCopyParams(in->shape(), ctx->Attr<std::vector<int64_t>>("stride"));
+    // Elements are copied as they are, so only their size matters.
+    const size_t size_of_data_type = GetSizeOfDataType(in->data_type());
+    if (size_of_data_type == 1) {
+      Copy<uint8_t>(ctx->stream(), params, elem_cnt, in, out);
+    } else if (size_of_data_type == 2) {
+      Copy<uint16_t>(ctx->stream(), params, elem_cnt, in, out);
+    } else if (size_of_data_type == 4) {
+      Copy<uint32_t>(ctx->stream(), params, elem_cnt, in, out);
+    } else if (size_of_data_type == 8) {
+      Copy<uint64_t>(ctx->stream(), params, elem_cnt, in, out);
+    } else {
+      UNIMPLEMENTED();
+    }
+  }
+
+  template<typename T>
+  void Copy(ep::Stream* stream, const StridedCopyParams& params, int64_t elem_cnt,
+            const user_op::Tensor* in, user_op::Tensor* out) const {
+    CopyFunctor<device_type, T>()(stream, params, elem_cnt, reinterpret_cast<const T*>(in->dptr()),
+                                  reinterpret_cast<T*>(out->mut_dptr()));
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_STRIDED_COPY_KERNELS(device)                        \
+  REGISTER_USER_KERNEL("to_contiguous")                              \
+      .SetCreateFn<StridedCopyKernel<device, ToContiguousFunctor>>() \
+      .SetIsMatchedHob(user_op::HobDeviceType() == device);          \
+  REGISTER_USER_KERNEL("to_strided")                                 \
+      .SetCreateFn<StridedCopyKernel<device, ToStridedFunctor>>()    \
+      .SetIsMatchedHob(user_op::HobDeviceType() == device);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_TO_CONTIGUOUS_KERNEL_H_
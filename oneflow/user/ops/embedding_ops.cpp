@@ -0,0 +1,162 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/op_generated.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<void> CheckEmbeddingAttrs(const user_op::UserOpConfWrapper& conf) {
+  CHECK_OR_RETURN(!conf.attr<std::string>("name").empty()) << "embedding name is empty";
+  CHECK_GT_OR_RETURN(conf.attr<int64_t>("embedding_dim"), 0);
+  const std::string& optimizer = conf.attr<std::string>("optimizer");
+  CHECK_OR_RETURN(optimizer == "sgd" || optimizer == "adagrad")
+      << "unsupported embedding optimizer " << optimizer;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+/* static */ Maybe<void> EmbeddingLookupOp::CheckAttr(const user_op::UserOpDefWrapper&,
+                                                      const user_op::UserOpConfWrapper& conf) {
+  JUST(CheckEmbeddingAttrs(conf));
+  CHECK_OR_RETURN(!conf.attr<std::string>("path").empty()) << "embedding path is empty";
+  CHECK_GT_OR_RETURN(conf.attr<int64_t>("cache_capacity"), 0);
+  CHECK_LE_OR_RETURN(conf.attr<float>("initializer_min"), conf.attr<float>("initializer_max"));
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> EmbeddingLookupOp::InferLogicalTensorDesc(user_op::InferContext* ctx) {
+  const Shape& ids_shape = ctx->InputShape("ids", 0);
+  CHECK_EQ_OR_RETURN(ctx->InputShape("learning_rate", 0).elem_cnt(), 1);
+  DimVector embeddings_dim_vec = ids_shape.dim_vec();
+  embeddings_dim_vec.push_back(ctx->Attr<int64_t>("embedding_dim"));
+  *ctx->OutputShape("embeddings", 0) = Shape(embeddings_dim_vec);
+  *ctx->OutputShape("unique_ids", 0) = Shape({ids_shape.elem_cnt()});
+  *ctx->OutputShape("inverse_indices", 0) = ids_shape;
+  *ctx->OutputShape("num_unique", 0) = Shape({1});
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> EmbeddingLookupOp::InferPhysicalTensorDesc(user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+// Every rank gets all the ids and looks up the ones it owns, leaving zeros for the others, so the
+// embeddings are the partial sum over the ranks and boxing them to split(0) exchanges the rows.
+/* static */ Maybe<void> EmbeddingLookupOp::GetSbp(user_op::SbpContext* ctx) {
+  ctx->NewBuilder()
+      .Broadcast(user_op::OpArg("shadow", 0))
+      .Broadcast(user_op::OpArg("ids", 0))
+      .Broadcast(user_op::OpArg("learning_rate", 0))
+      .PartialSum(user_op::OpArg("embeddings", 0))
+      .Broadcast(user_op::OpArg("unique_ids", 0))
+      .Broadcast(user_op::OpArg("inverse_indices", 0))
+      .Broadcast(user_op::OpArg("num_unique", 0))
+      .Build();
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> EmbeddingLookupOp::ModifyInputArg(
+    const GetInputArgModifier& GetInputArgModifierFn, const user_op::UserOpConfWrapper&) {
+  user_op::InputArgModifier* ids_modifier = GetInputArgModifierFn("ids", 0);
+  CHECK_OR_RETURN(ids_modifier != nullptr);
+  ids_modifier->set_requires_grad(false);
+  user_op::InputArgModifier* learning_rate_modifier = GetInputArgModifierFn("learning_rate", 0);
+  CHECK_OR_RETURN(learning_rate_modifier != nullptr);
+  learning_rate_modifier->set_requires_grad(false);
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> EmbeddingLookupOp::InferDataType(user_op::InferContext* ctx) {
+  CHECK_EQ_OR_RETURN(ctx->InputDType("shadow", 0), DataType::kFloat);
+  CHECK_OR_RETURN(IsIndexDataType(ctx->InputDType("ids", 0)));
+  CHECK_EQ_OR_RETURN(ctx->InputDType("learning_rate", 0), DataType::kFloat);
+  *ctx->OutputDType("embeddings", 0) = DataType::kFloat;
+  *ctx->OutputDType("unique_ids", 0) = DataType::kInt64;
+  *ctx->OutputDType("inverse_indices", 0) = DataType::kInt64;
+  *ctx->OutputDType("num_unique", 0) = DataType::kInt64;
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> EmbeddingUpdateOp::CheckAttr(const user_op::UserOpDefWrapper&,
+                                                      const user_op::UserOpConfWrapper& conf) {
+  return CheckEmbeddingAttrs(conf);
+}
+
+/* static */ Maybe<void> EmbeddingUpdateOp::InferLogicalTensorDesc(user_op::InferContext* ctx) {
+  const Shape& inverse_indices_shape = ctx->InputShape("inverse_indices", 0);
+  const Shape& embedding_grad_shape = ctx->InputShape("embedding_grad", 0);
+  CHECK_EQ_OR_RETURN(ctx->InputShape("unique_ids", 0).elem_cnt(),
+                     inverse_indices_shape.elem_cnt());
+  CHECK_EQ_OR_RETURN(embedding_grad_shape.NumAxes(), inverse_indices_shape.NumAxes() + 1);
+  CHECK_EQ_OR_RETURN(embedding_grad_shape.elem_cnt(),
+                     inverse_indices_shape.elem_cnt() * ctx->Attr<int64_t>("embedding_dim"));
+  CHECK_EQ_OR_RETURN(ctx->InputShape("learning_rate", 0).elem_cnt(), 1);
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> EmbeddingUpdateOp::InferPhysicalTensorDesc(user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> EmbeddingUpdateOp::GetSbp(user_op::SbpContext* ctx) {
+  ctx->NewBuilder().Broadcast(ctx->inputs()).Build();
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> EmbeddingUpdateOp::InferDataType(user_op::InferContext* ctx) {
+  CHECK_EQ_OR_RETURN(ctx->InputDType("unique_ids", 0), DataType::kInt64);
+  CHECK_EQ_OR_RETURN(ctx->InputDType("inverse_indices", 0), DataType::kInt64);
+  CHECK_EQ_OR_RETURN(ctx->InputDType("num_unique", 0), DataType::kInt64);
+  CHECK_EQ_OR_RETURN(ctx->InputDType("embedding_grad", 0), DataType::kFloat);
+  CHECK_EQ_OR_RETURN(ctx->InputDType("learning_rate", 0), DataType::kFloat);
+  return Maybe<void>::Ok();
+}
+
+// The rows are updated in place by embedding_update, so the gradient of shadow is zeros. shadow
+// only exists to make the lookup part of the backward graph.
+REGISTER_USER_OP_GRAD("embedding_lookup")
+    .SetGenBackwardOpConfFn([](const user_op::UserOpWrapper& op,
+                               user_op::AddOpFn AddOp) -> Maybe<void> {
+      user_op::UserOpConfWrapperBuilder update_builder(op.op_name() + "_update");
+      user_op::UserOpConfWrapper update_op =
+          update_builder.Op("embedding_update")
+              .Input("unique_ids", op.output("unique_ids", 0))
+              .Input("inverse_indices", op.output("inverse_indices", 0))
+              .Input("num_unique", op.output("num_unique", 0))
+              .Input("embedding_grad", op.GetGradTensorWithOpOutput("embeddings", 0))
+              .Input("learning_rate", op.input("learning_rate", 0))
+              .Attr("name", op.attr<std::string>("name"))
+              .Attr("embedding_dim", op.attr<int64_t>("embedding_dim"))
+              .Attr("optimizer", op.attr<std::string>("optimizer"))
+              .Attr("epsilon", op.attr<float>("epsilon"))
+              .Build();
+      AddOp(update_op);
+      if (op.NeedGenGradTensor4OpInput("shadow", 0)) {
+        user_op::UserOpConfWrapperBuilder zero_grad_builder(op.op_name() + "_shadow_grad");
+        user_op::UserOpConfWrapper zero_grad_op = zero_grad_builder.Op("zero_like")
+                                                      .Input("like", op.input("shadow", 0))
+                                                      .Output("out")
+                                                      .Build();
+        op.BindGradTensorWithOpInput(zero_grad_op.output("out", 0), "shadow", 0);
+        AddOp(zero_grad_op);
+      }
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -0,0 +1,115 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/op_generated.h"
+#include "oneflow/user/kernels/gradient_compression_util.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<int64_t> PayloadBytes(user_op::InferContext* ctx, const Shape& shape) {
+  const auto method = JUST(ParseGradientCompressionMethod(ctx->Attr<std::string>("method")));
+  CHECK_GT_OR_RETURN(shape.elem_cnt(), 0);
+  return GradientCompressionPayloadBytes(method, shape.elem_cnt(), ctx->Attr<float>("topk_ratio"));
+}
+
+template<typename Context>
+Maybe<bool> IsCast(Context* ctx) {
+  return IsGradientCompressionCast(
+      JUST(ParseGradientCompressionMethod(ctx->template Attr<std::string>("method"))));
+}
+
+}  // namespace
+
+// grad_compress turns the partial gradient of every rank into its payload, so that the logical
+// output is the concatenation of the payloads of all ranks. The cast methods only narrow the data
+// type, which keeps the gradient partial.
+/* static */ Maybe<void> GradCompressOp::InferLogicalTensorDesc(user_op::InferContext* ctx) {
+  if (JUST(IsCast(ctx))) {
+    *ctx->OutputShape("out", 0) = ctx->InputShape("in", 0);
+    return Maybe<void>::Ok();
+  }
+  const int64_t payload_bytes = JUST(PayloadBytes(ctx, ctx->InputShape("in", 0)));
+  *ctx->OutputShape("out", 0) = Shape({ctx->parallel_num() * payload_bytes});
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> GradCompressOp::InferPhysicalTensorDesc(user_op::InferContext* ctx) {
+  if (JUST(IsCast(ctx))) {
+    *ctx->OutputShape("out", 0) = ctx->InputShape("in", 0);
+    return Maybe<void>::Ok();
+  }
+  *ctx->OutputShape("out", 0) = Shape({JUST(PayloadBytes(ctx, ctx->InputShape("in", 0)))});
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> GradCompressOp::GetSbp(user_op::SbpContext* ctx) {
+  if (JUST(IsCast(ctx))) {
+    ctx->NewBuilder()
+        .PartialSum(user_op::OpArg("in", 0))
+        .PartialSum(user_op::OpArg("out", 0))
+        .Build();
+    return Maybe<void>::Ok();
+  }
+  ctx->NewBuilder().PartialSum(user_op::OpArg("in", 0)).Split(user_op::OpArg("out", 0), 0).Build();
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> GradCompressOp::InferDataType(user_op::InferContext* ctx) {
+  CHECK_EQ_OR_RETURN(ctx->InputDType("in", 0), DataType::kFloat);
+  const auto method = JUST(ParseGradientCompressionMethod(ctx->Attr<std::string>("method")));
+  *ctx->OutputDType("out", 0) = IsGradientCompressionCast(method)
+                                    ? GradientCompressionCastDataType(method)
+                                    : DataType::kInt8;
+  return Maybe<void>::Ok();
+}
+
+// grad_decompress sums up the payloads of all ranks into the gradient, or casts the summed up
+// gradient of a cast method back to float.
+/* static */ Maybe<void> GradDecompressOp::InferLogicalTensorDesc(user_op::InferContext* ctx) {
+  const Shape& shape = ctx->Attr<Shape>("shape");
+  const Shape& in_shape = ctx->InputShape("in", 0);
+  if (JUST(IsCast(ctx))) {
+    CHECK_EQ_OR_RETURN(in_shape, shape);
+  } else {
+    const int64_t payload_bytes = JUST(PayloadBytes(ctx, shape));
+    CHECK_EQ_OR_RETURN(in_shape.NumAxes(), 1);
+    CHECK_EQ_OR_RETURN(in_shape.elem_cnt() % payload_bytes, 0);
+  }
+  *ctx->OutputShape("out", 0) = shape;
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> GradDecompressOp::InferPhysicalTensorDesc(user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> GradDecompressOp::GetSbp(user_op::SbpContext* ctx) {
+  ctx->NewBuilder().Broadcast(ctx->inputs()).Broadcast(ctx->outputs()).Build();
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> GradDecompressOp::InferDataType(user_op::InferContext* ctx) {
+  const auto method = JUST(ParseGradientCompressionMethod(ctx->Attr<std::string>("method")));
+  CHECK_EQ_OR_RETURN(ctx->InputDType("in", 0), IsGradientCompressionCast(method)
+                                                   ? GradientCompressionCastDataType(method)
+                                                   : DataType::kInt8);
+  *ctx->OutputDType("out", 0) = DataType::kFloat;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
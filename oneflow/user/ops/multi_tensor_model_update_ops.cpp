@@ -0,0 +1,233 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/op_generated.h"
+
+namespace oneflow {
+
+namespace {
+
+Maybe<void> CheckScalarDesc(const user_op::TensorDesc& tensor_desc, DataType data_type) {
+  CHECK_EQ_OR_RETURN(tensor_desc.shape(), Shape({1}));
+  CHECK_EQ_OR_RETURN(tensor_desc.data_type(), data_type);
+  return Maybe<void>::Ok();
+}
+
+// Every variadic arg of a multi tensor update op holds one tensor per model, in the same order.
+Maybe<void> CheckModelArgSizes(const user_op::UserOpConfWrapper& conf,
+                               const std::vector<std::string>& arg_names) {
+  const int32_t num_models = conf.input_size("model");
+  CHECK_GE_OR_RETURN(num_models, 1);
+  for (const auto& arg_name : arg_names) {
+    CHECK_EQ_OR_RETURN(conf.input_size(arg_name), num_models);
+  }
+  return Maybe<void>::Ok();
+}
+
+// Checks that model_diff and the state args are like model, and the optional scalar inputs.
+Maybe<void> InferMultiTensorUpdateTensorDesc(user_op::InferContext* ctx,
+                                             const std::vector<std::string>& state_arg_names) {
+  const int32_t num_models = ctx->input_size("model");
+  const DataType data_type = ctx->InputDType("model", 0);
+  FOR_RANGE(int32_t, i, 0, num_models) {
+    const user_op::TensorDesc& model = ctx->InputTensorDesc("model", i);
+    CHECK_EQ_OR_RETURN(model.data_type(), data_type);
+    CHECK_EQ_OR_RETURN(ctx->InputShape("model_diff", i), model.shape());
+    CHECK_EQ_OR_RETURN(ctx->InputDType("model_diff", i), ctx->InputDType("model_diff", 0));
+    for (const auto& arg_name : state_arg_names) {
+      CHECK_EQ_OR_RETURN(ctx->InputShape(arg_name, i), model.shape());
+      CHECK_EQ_OR_RETURN(ctx->InputDType(arg_name, i), data_type);
+    }
+  }
+  if (ctx->has_input("learning_rate", 0)) {
+    JUST(CheckScalarDesc(ctx->InputTensorDesc("learning_rate", 0), DataType::kFloat));
+  }
+  if (ctx->has_input("scale_by_tensor", 0)) {
+    JUST(CheckScalarDesc(ctx->InputTensorDesc("scale_by_tensor", 0), data_type));
+  }
+  if (ctx->has_input("skip_if", 0)) {
+    CHECK_EQ_OR_RETURN(ctx->InputShape("skip_if", 0).elem_cnt(), 1);
+  }
+  return Maybe<void>::Ok();
+}
+
+// All broadcast, or every model shaped arg split along axis 0 when all models have one.
+Maybe<void> GetMultiTensorUpdateSbp(user_op::SbpContext* ctx,
+                                    const std::vector<std::string>& model_like_arg_names) {
+  ctx->NewBuilder().Broadcast(ctx->inputs()).Build();
+  const int32_t num_models = ctx->user_op_conf().input_size("model");
+  FOR_RANGE(int32_t, i, 0, num_models) {
+    if (ctx->LogicalTensorDesc4InputArgNameAndIndex("model", i).shape().NumAxes() == 0) {
+      return Maybe<void>::Ok();
+    }
+  }
+  auto builder = ctx->NewBuilder();
+  builder.Broadcast(ctx->inputs());
+  for (const auto& arg_name : model_like_arg_names) {
+    FOR_RANGE(int32_t, i, 0, num_models) { builder.Split(user_op::OpArg(arg_name, i), 0); }
+  }
+  builder.Build();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> SetInputArgsMutable(const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                                const user_op::UserOpConfWrapper& conf,
+                                const std::vector<std::string>& arg_names) {
+  for (const auto& arg_name : arg_names) {
+    FOR_RANGE(int32_t, i, 0, conf.input_size(arg_name)) {
+      user_op::InputArgModifier* arg_modifier = GetInputArgModifierFn(arg_name, i);
+      CHECK_NOTNULL_OR_RETURN(arg_modifier);
+      arg_modifier->set_is_mutable(true);
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+/* static */ Maybe<void> MultiTensorSgdUpdateOp::CheckAttr(
+    const user_op::UserOpDefWrapper&, const user_op::UserOpConfWrapper& conf) {
+  return CheckModelArgSizes(conf, {"model_diff"});
+}
+
+/* static */ Maybe<void> MultiTensorSgdUpdateOp::InferLogicalTensorDesc(
+    user_op::InferContext* ctx) {
+  return InferMultiTensorUpdateTensorDesc(ctx, {});
+}
+
+/*static*/ Maybe<void> MultiTensorSgdUpdateOp::InferPhysicalTensorDesc(
+    user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> MultiTensorSgdUpdateOp::GetSbp(user_op::SbpContext* ctx) {
+  return GetMultiTensorUpdateSbp(ctx, {"model", "model_diff"});
+}
+
+/* static */ Maybe<void> MultiTensorSgdUpdateOp::ModifyInputArg(
+    const GetInputArgModifier& GetInputArgModifierFn, const user_op::UserOpConfWrapper& conf) {
+  return SetInputArgsMutable(GetInputArgModifierFn, conf, {"model"});
+}
+
+/* static */ Maybe<void> MultiTensorSgdUpdateOp::InferDataType(user_op::InferContext* ctx) {
+  return InferMultiTensorUpdateTensorDesc(ctx, {});
+}
+
+/* static */ Maybe<void> MultiTensorMomentumUpdateOp::CheckAttr(
+    const user_op::UserOpDefWrapper&, const user_op::UserOpConfWrapper& conf) {
+  return CheckModelArgSizes(conf, {"model_diff", "momentum"});
+}
+
+/* static */ Maybe<void> MultiTensorMomentumUpdateOp::InferLogicalTensorDesc(
+    user_op::InferContext* ctx) {
+  return InferMultiTensorUpdateTensorDesc(ctx, {"momentum"});
+}
+
+/*static*/ Maybe<void> MultiTensorMomentumUpdateOp::InferPhysicalTensorDesc(
+    user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> MultiTensorMomentumUpdateOp::GetSbp(user_op::SbpContext* ctx) {
+  return GetMultiTensorUpdateSbp(ctx, {"model", "model_diff", "momentum"});
+}
+
+/* static */ Maybe<void> MultiTensorMomentumUpdateOp::ModifyInputArg(
+    const GetInputArgModifier& GetInputArgModifierFn, const user_op::UserOpConfWrapper& conf) {
+  return SetInputArgsMutable(GetInputArgModifierFn, conf, {"model", "momentum"});
+}
+
+/* static */ Maybe<void> MultiTensorMomentumUpdateOp::InferDataType(user_op::InferContext* ctx) {
+  return InferMultiTensorUpdateTensorDesc(ctx, {"momentum"});
+}
+
+/* static */ Maybe<void> MultiTensorAdamUpdateOp::CheckAttr(
+    const user_op::UserOpDefWrapper&, const user_op::UserOpConfWrapper& conf) {
+  return CheckModelArgSizes(conf, {"model_diff", "m", "v"});
+}
+
+/* static */ Maybe<void> MultiTensorAdamUpdateOp::InferLogicalTensorDesc(
+    user_op::InferContext* ctx) {
+  JUST(InferMultiTensorUpdateTensorDesc(ctx, {"m", "v"}));
+  for (const std::string& arg_name : {"bias_correction1", "bias_correction2"}) {
+    if (ctx->has_input(arg_name, 0)) {
+      JUST(CheckScalarDesc(ctx->InputTensorDesc(arg_name, 0), DataType::kFloat));
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+/*static*/ Maybe<void> MultiTensorAdamUpdateOp::InferPhysicalTensorDesc(
+    user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> MultiTensorAdamUpdateOp::GetSbp(user_op::SbpContext* ctx) {
+  return GetMultiTensorUpdateSbp(ctx, {"model", "model_diff", "m", "v"});
+}
+
+/* static */ Maybe<void> MultiTensorAdamUpdateOp::ModifyInputArg(
+    const GetInputArgModifier& GetInputArgModifierFn, const user_op::UserOpConfWrapper& conf) {
+  return SetInputArgsMutable(GetInputArgModifierFn, conf, {"model", "m", "v"});
+}
+
+/* static */ Maybe<void> MultiTensorAdamUpdateOp::InferDataType(user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> MultiTensorLambUpdateOp::CheckAttr(
+    const user_op::UserOpDefWrapper&, const user_op::UserOpConfWrapper& conf) {
+  return CheckModelArgSizes(conf, {"model_diff", "m", "v", "beta1_t", "beta2_t"});
+}
+
+/* static */ Maybe<void> MultiTensorLambUpdateOp::InferLogicalTensorDesc(
+    user_op::InferContext* ctx) {
+  const float beta1 = ctx->Attr<float>("beta1");
+  const float beta2 = ctx->Attr<float>("beta2");
+  CHECK_GE_OR_RETURN(beta1, 0);
+  CHECK_LT_OR_RETURN(beta1, 1);
+  CHECK_GE_OR_RETURN(beta2, 0);
+  CHECK_LT_OR_RETURN(beta2, 1);
+  JUST(InferMultiTensorUpdateTensorDesc(ctx, {"m", "v"}));
+  const DataType data_type = ctx->InputDType("model", 0);
+  FOR_RANGE(int32_t, i, 0, ctx->input_size("model")) {
+    JUST(CheckScalarDesc(ctx->InputTensorDesc("beta1_t", i), data_type));
+    JUST(CheckScalarDesc(ctx->InputTensorDesc("beta2_t", i), data_type));
+  }
+  return Maybe<void>::Ok();
+}
+
+/*static*/ Maybe<void> MultiTensorLambUpdateOp::InferPhysicalTensorDesc(
+    user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> MultiTensorLambUpdateOp::GetSbp(user_op::SbpContext* ctx) {
+  // The trust ratio needs the norms of whole models.
+  return user_op::GetSbpFnUtil::DefaultBroadcastToBroadcast(ctx);
+}
+
+/* static */ Maybe<void> MultiTensorLambUpdateOp::ModifyInputArg(
+    const GetInputArgModifier& GetInputArgModifierFn, const user_op::UserOpConfWrapper& conf) {
+  return SetInputArgsMutable(GetInputArgModifierFn, conf,
+                             {"model", "m", "v", "beta1_t", "beta2_t"});
+}
+
+/* static */ Maybe<void> MultiTensorLambUpdateOp::InferDataType(user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+}  // namespace oneflow
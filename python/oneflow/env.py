@@ -77,3 +77,81 @@ def is_multi_client():
 
     """
     return oneflow._oneflow_internal.IsMultiClient()
+
+
+def schedule_priority(priority):
+    """Returns a context manager under which the eager instructions built by the current thread
+    get dispatched with the given priority, instead of the priority of their streams.
+    The priority is set when the context is entered and restored when it is exited.
+    Among the instructions ready at the same time, those of higher priorities are dispatched
+    first, and a worker thread runs the instructions it receives at once by priority too,
+    keeping the order of the instructions of each stream. Results are the same whatever the
+    priorities.
+
+    Args:
+        priority (str): "low", "normal" or "high".
+
+    For example:
+
+    .. code-block:: python
+
+        >>> import oneflow as flow
+        >>> x = flow.ones(2, 3)
+        >>> with flow.env.schedule_priority("high"):
+        ...     y = x + 1
+        >>> y.numpy()
+        array([[2., 2., 2.],
+               [2., 2., 2.]], dtype=float32)
+
+    """
+    return oneflow._oneflow_internal.vm.SchedulePriorityScope(priority)
+
+
+def set_stream_schedule_priority(device_type, priority):
+    """Sets the priority of the streams running the eager compute instructions of a device type.
+    Instructions built afterwards take this priority unless built under
+    :func:`oneflow.env.schedule_priority`. Streams default to "normal".
+
+    Args:
+        device_type (str): the device type, e.g. "cpu" or "cuda".
+        priority (str): "low", "normal" or "high".
+
+    """
+    oneflow._oneflow_internal.vm.SetStreamSchedulePriority(device_type, priority)
+
+
+def enable_eager_memory_reuse(enabled=True):
+    """Turns eager memory reuse on or off. When on, an op writes its output into the memory of an
+    input nothing reads after the op, i.e. an input whose tensor, together with its views and
+    the tensors autograd saved for backward, has already been dropped. Only the outputs and
+    inputs the kernel is able to compute inplace share memory, e.g. those of relu or sigmoid,
+    and only on devices whose instructions run on the scheduler thread of the virtual machine.
+    Results are the same either way. Defaults to the ONEFLOW_EAGER_MEMORY_REUSE environment
+    variable, off if unset.
+
+    Args:
+        enabled (bool): whether to reuse the memory.
+
+    """
+    oneflow._oneflow_internal.vm.SetEagerMemoryReuseEnabled(enabled)
+
+
+def eager_memory_stats():
+    """Returns a dict of the eager memory counters of this process:
+
+    - num_reused_blobs: outputs that have taken over the memory of an input.
+    - num_reused_bytes: bytes of them, i.e. the allocations saved.
+    - cpu_live_bytes: bytes of cpu tensors allocated and not freed yet.
+    - cpu_peak_bytes: the most cpu_live_bytes has been since the last
+      :func:`oneflow.env.reset_eager_memory_stats`.
+
+    """
+    return oneflow._oneflow_internal.vm.GetEagerMemoryStats()
+
+
+def reset_eager_memory_stats():
+    """Resets the reuse counters of :func:`oneflow.env.eager_memory_stats` to zero and the peak
+    bytes to the live bytes.
+
+    """
+    oneflow._oneflow_internal.vm.ResetEagerMemoryStats()
@@ -151,8 +151,7 @@ def _xor(self, other):
 
 
 def _contiguous(self):
-    # TODO: support stride mechanism
-    return self
+    return flow._C.to_contiguous(self)
 
 
 def _norm(self, ord=None, dim=None, keepdim=False, dtype=None):
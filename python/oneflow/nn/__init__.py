@@ -127,6 +127,7 @@ from oneflow.nn.modules.pooling import (
     AdaptiveAvgPool3d,
 )
 from oneflow.nn.modules.sparse import Embedding
+from oneflow.nn.modules.sharded_embedding import ShardedEmbedding
 from oneflow.nn.modules.upsampling import (
     Upsample,
     UpsamplingBilinear2d,
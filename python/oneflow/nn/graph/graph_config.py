@@ -72,6 +72,15 @@ class GraphConfig(object):
         """
         self.proto.set_enable_fuse_model_update_ops(mode)
 
+    def allow_multi_tensor_model_update(self, mode: bool = True):
+        """If true, update the models of the same optimizer with the same placement in
+        multi tensor sgd/momentum/adam/lamb ops, which take many models per kernel launch.
+
+        Args:
+            mode (bool, optional): [description]. Default is True.
+        """
+        self.proto.set_enable_multi_tensor_model_update(mode)
+
     def allow_fuse_add_to_output(self, mode: bool = True):
         """If true, try to fuse a binary element-wise add to one of the predecessors to improve performance.
 
@@ -99,8 +108,8 @@ class GraphConfig(object):
     def set_zero_redundancy_optimizer_mode(self, mode: str = "distributed_split"):
         """Set mode to remove redundancy of optimizer states.
         This optimzation will reduce optimizer states memory consumption as described
-        by ZeRO https://arxiv.org/abs/1910.02054 .
-
+        by ZeRO https://arxiv.org/abs/1910.02054 . It works on both cuda and cpu placements,
+        and logs how many bytes of parameters and optimizer states each rank saves.
 
         Args:
             mode (str): "distributed_split" or "non_distributed". "distributed_split" mode
@@ -120,6 +129,35 @@ class GraphConfig(object):
         assert value >= 1
         self.proto.set_optimizer_placement_optimization_threshold(value)
 
+    def set_gradient_compression(
+        self,
+        method: str,
+        topk_ratio: float = 0.01,
+        error_feedback: bool = True,
+        min_size: int = 1024,
+    ):
+        """Compress the gradients of data parallel parameters before they are summed up
+        across ranks.
+
+        Args:
+            method (str): "fp16" and "bf16" sum the gradients up in float16 or bfloat16
+                          with an all-reduce, "bf16" needs a cuda placement. "topk" and
+                          "onebit" gather the largest topk_ratio of the gradients by
+                          magnitude, or their signs and mean magnitude, from all ranks.
+            topk_ratio (float): ratio of the gradients "topk" sends.
+            error_feedback (bool): whether what a rank leaves out of its gradients is added
+                                   to them in the next step. Ignored by "fp16" and "bf16".
+            min_size (int): gradients with fewer elements are not compressed.
+        """
+        assert method in ("fp16", "bf16", "topk", "onebit")
+        assert 0 < topk_ratio <= 1
+        assert isinstance(min_size, int)
+        conf = self.proto.mutable_gradient_compression_conf()
+        conf.set_method(method)
+        conf.set_topk_ratio(topk_ratio)
+        conf.set_error_feedback(error_feedback)
+        conf.set_min_elem_cnt(min_size)
+
     def enable_xla_jit(self, value=True):
         """Whether use xla_jit in xrt or not. When this option enable, oneflow will check all operators is supported by 
            xla_jit or not. Clustering supported operators as subgraph, then runing subgraph by xla_jit.
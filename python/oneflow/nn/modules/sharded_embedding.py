@@ -0,0 +1,113 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+from typing import Tuple
+
+import oneflow as flow
+from oneflow.nn.module import Module
+
+
+class ShardedEmbedding(Module):
+    """An embedding table of integer ids that may be much larger than RAM.
+
+    The rows live in memory-mapped files under :attr:`path`, and the rows in use are
+    cached in RAM. On a placement of several ranks every rank owns the ids hashed to
+    it and keeps their rows, the ids are gathered to all the ranks and the embeddings
+    are summed up from the owners. A row is initialized the first time its id is
+    looked up.
+
+    The rows are not parameters. They are updated in place by :attr:`optimizer` in the
+    backward pass, after the gradients of repeated ids have been summed up. The only
+    parameter is a placeholder that gets zero gradients, so the optimizer the module
+    parameters are added to leaves the table alone. The learning rate is the
+    :attr:`learning_rate` buffer, a tensor read when the update runs, so that it can be
+    changed with :meth:`set_lr` between the steps, also of a graph that has been built.
+
+    The rows are written to disk in the background, :meth:`checkpoint` makes all the
+    rows updated so far survive a crash, and :meth:`close` releases the files.
+
+    Args:
+        name (str): identifies the table, modules with the same name share the rows
+        embedding_dim (int): the size of each embedding vector
+        path (str): the directory of the rows, with a subdirectory per rank
+        cache_capacity (int): the number of rows cached in RAM by each rank
+        optimizer (str): "sgd" or "adagrad". Default: "sgd"
+        lr (float): initial learning rate of :attr:`optimizer`. Default: 0.01
+        eps (float): term added to the denominator of adagrad. Default: 1e-10
+        initializer_range (Tuple[float, float]): rows are drawn uniformly from this
+            range. Default: (-0.05, 0.05)
+        seed (int): seed of the row initializer. Default: 0
+    """
+
+    def __init__(
+        self,
+        name: str,
+        embedding_dim: int,
+        path: str,
+        cache_capacity: int,
+        optimizer: str = "sgd",
+        lr: float = 0.01,
+        eps: float = 1e-10,
+        initializer_range: Tuple[float, float] = (-0.05, 0.05),
+        seed: int = 0,
+    ):
+        super().__init__()
+        assert optimizer in ("sgd", "adagrad"), f"unsupported optimizer {optimizer}"
+        self.table_name = name
+        self.embedding_dim = embedding_dim
+        self.path = path
+        self.cache_capacity = cache_capacity
+        self.optimizer = optimizer
+        self.register_buffer("learning_rate", flow.tensor([lr], dtype=flow.float32))
+        self.eps = eps
+        self.initializer_range = initializer_range
+        self.seed = seed
+        self.shadow = flow.nn.Parameter(flow.zeros(1))
+
+    def forward(self, ids):
+        return flow._C.embedding_lookup(
+            self.shadow,
+            ids,
+            self.table_name,
+            self.embedding_dim,
+            self.path,
+            self.cache_capacity,
+            self.optimizer,
+            self.learning_rate,
+            self.eps,
+            self.initializer_range[0],
+            self.initializer_range[1],
+            self.seed,
+        )
+
+    def set_lr(self, lr: float):
+        """Sets the learning rate of the updates issued from now on."""
+        self.learning_rate.fill_(lr)
+
+    def checkpoint(self):
+        """Waits for the lookups and updates issued so far, then writes the rows of
+        this process to disk together with their index, so that reopening the table
+        after a crash neither loses them nor rebuilds the index.
+        """
+        flow._oneflow_internal.eager.multi_client.Sync()
+        flow._oneflow_internal.FlushEmbedding(self.table_name)
+
+    def close(self):
+        """Waits for the lookups and updates issued so far, then writes the rows of
+        this process to disk and releases their files, for example before :attr:`path`
+        is removed. The next lookup of the table opens the files again.
+        """
+        flow._oneflow_internal.eager.multi_client.Sync()
+        flow._oneflow_internal.CloseEmbedding(self.table_name)
@@ -187,19 +187,26 @@ class AdamW(Optimizer):
                     "amsgrad": param_group["amsgrad"],
                 }
 
+                params = self._multi_tensor_params(param_group)
+                if params is not None and not param_group["amsgrad"]:
+                    op = self._multi_tensor_op(
+                        "multi_tensor_adam_update",
+                        ["model", "model_diff", "m", "v"],
+                        len(params),
+                    )
+                    grads = [param.grad for param in params]
+                    states = [self._get_state_tensors(param) for param in params]
+                    ms = [state[0] for state in states]
+                    vs = [state[1] for state in states]
+                    kwargs.pop("amsgrad")
+                    flow._C.dispatch_multi_tensor_adam_update(
+                        op, (*params, *grads, *ms, *vs), **kwargs
+                    )
+                    continue
                 for param in param_group.parameters:
                     if param.grad is None:
                         continue
-
-                    if "exp_avg" not in self._state[param]:
-                        self._state[param]["exp_avg"] = flow.zeros_like(param)
-                    if "exp_avg_sq" not in self._state[param]:
-                        self._state[param]["exp_avg_sq"] = flow.zeros_like(param)
-                    if "max_exp_avg_sq" not in self._state[param]:
-                        self._state[param]["max_exp_avg_sq"] = flow.zeros_like(param)
-                    m_tensor = self._state[param]["exp_avg"]
-                    v_tensor = self._state[param]["exp_avg_sq"]
-                    max_v_tensor = self._state[param]["max_exp_avg_sq"]
+                    m_tensor, v_tensor, max_v_tensor = self._get_state_tensors(param)
                     flow._C.dispatch_adam_update(
                         self._op,
                         (param, param.grad, m_tensor, v_tensor, max_v_tensor),
@@ -209,6 +216,19 @@ class AdamW(Optimizer):
             self._state["step"] += 1
             return loss
 
+    def _get_state_tensors(self, param):
+        if "exp_avg" not in self._state[param]:
+            self._state[param]["exp_avg"] = flow.zeros_like(param)
+        if "exp_avg_sq" not in self._state[param]:
+            self._state[param]["exp_avg_sq"] = flow.zeros_like(param)
+        if "max_exp_avg_sq" not in self._state[param]:
+            self._state[param]["max_exp_avg_sq"] = flow.zeros_like(param)
+        return (
+            self._state[param]["exp_avg"],
+            self._state[param]["exp_avg_sq"],
+            self._state[param]["max_exp_avg_sq"],
+        )
+
     def _generate_conf_for_graph(self, train_conf, vars_conf):
         new_opt_confs = []
         for param_group in self.param_groups:
@@ -19,6 +19,7 @@ from copy import deepcopy
 from itertools import chain
 from typing import Any, Callable, Dict, Union
 
+import oneflow as flow
 from oneflow.framework.tensor import Tensor
 from oneflow.nn.graph.block import TensorBlock
 from oneflow.nn.parameter import Parameter
@@ -81,6 +82,7 @@ class Optimizer(object):
         self._default_options = options
         self._state = dict()
         self._state["step"] = 0
+        self._multi_tensor_ops = dict()
 
         self._parse_input_parameters(parameters)
 
@@ -281,6 +283,34 @@ class Optimizer(object):
                 f"params argument given to the optimizer should be an iterable of Tensors or dicts, but got {type(parameters)}"
             )
 
+    def _multi_tensor_params(self, param_group):
+        """The parameters of param_group with a grad if all of them can be updated by one
+        multi tensor op, which needs local tensors on the same device with the same dtypes.
+        Returns None if they have to be updated one by one.
+        """
+        params = [param for param in param_group.parameters if param.grad is not None]
+        if len(params) < 2:
+            return None
+        first = params[0]
+        for param in params:
+            if (
+                param.is_consistent
+                or param.device != first.device
+                or param.dtype != first.dtype
+                or param.grad.dtype != first.grad.dtype
+            ):
+                return None
+        return params
+
+    def _multi_tensor_op(self, op_type_name, input_names, num_tensors):
+        key = (op_type_name, num_tensors)
+        if key not in self._multi_tensor_ops:
+            builder = flow.stateful_op(op_type_name)
+            for input_name in input_names:
+                builder = builder.Input(input_name, num_tensors)
+            self._multi_tensor_ops[key] = builder.Build()
+        return self._multi_tensor_ops[key]
+
     def _generate_grad_clip_conf_for_optim_conf(self, param_group, optimizer_conf):
         if param_group._enable_clip_grad:
             if (
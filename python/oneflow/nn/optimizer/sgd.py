@@ -135,21 +135,45 @@ class SGD(Optimizer):
             for param_group in self.param_groups:
                 lr = param_group["lr"]
                 l2 = param_group["weight_decay"]
+                beta = param_group["momentum"]
+                params = self._multi_tensor_params(param_group)
+                if params is not None:
+                    grads = [param.grad for param in params]
+                    if beta == 0.0:
+                        op = self._multi_tensor_op(
+                            "multi_tensor_sgd_update",
+                            ["model", "model_diff"],
+                            len(params),
+                        )
+                        flow._C.dispatch_sgd_update(
+                            op, (*params, *grads), learning_rate=lr, l2=l2
+                        )
+                    else:
+                        op = self._multi_tensor_op(
+                            "multi_tensor_momentum_update",
+                            ["model", "model_diff", "momentum"],
+                            len(params),
+                        )
+                        momentum_bufs = [self._momentum_buf(param) for param in params]
+                        flow._C.dispatch_momentum_update(
+                            op,
+                            (*params, *grads, *momentum_bufs),
+                            learning_rate=lr,
+                            l2=l2,
+                            beta=beta,
+                        )
+                    continue
                 for param in param_group.parameters:
                     if param.grad is None:
                         continue
-                    if param_group["momentum"] == 0.0:
+                    if beta == 0.0:
                         flow._C.dispatch_sgd_update(
                             self._sgd, (param, param.grad), learning_rate=lr, l2=l2
                         )
                     else:
-                        if "momentum_buf" not in self._state[param]:
-                            self._state[param]["momentum_buf"] = flow.zeros_like(param)
-                        momentum_buf = self._state[param]["momentum_buf"]
-                        beta = param_group["momentum"]
                         flow._C.dispatch_momentum_update(
                             self._momentum_sgd,
-                            (param, param.grad, momentum_buf),
+                            (param, param.grad, self._momentum_buf(param)),
                             learning_rate=lr,
                             l2=l2,
                             beta=beta,
@@ -157,6 +181,11 @@ class SGD(Optimizer):
             self._state["step"] = self._state["step"] + 1
             return loss
 
+    def _momentum_buf(self, param):
+        if "momentum_buf" not in self._state[param]:
+            self._state[param]["momentum_buf"] = flow.zeros_like(param)
+        return self._state[param]["momentum_buf"]
+
     def _generate_conf_for_graph(self, train_conf, vars_conf):
         new_opt_confs = []
         for param_group in self.param_groups:
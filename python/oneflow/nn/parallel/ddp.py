@@ -13,36 +13,16 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 """
-from collections import OrderedDict
-
 import oneflow as flow
 from oneflow.framework.tensor_tuple_util import convert_to_tensor_tuple
 
 
-def allreduce_fn(ddp_state_for_reversed_params, param):
-    def allreduce(grad):
-        ddp_state_for_reversed_params[param][0] = True
-        ret = None
-        for cur_param, (ready, deleted) in ddp_state_for_reversed_params.items():
-            if deleted:
-                continue
-            if ready:
-                ddp_state_for_reversed_params[cur_param][1] = True
-                if cur_param is param:
-                    ret = flow._C.local_all_reduce(grad)
-                else:
-                    cur_param.grad = flow._C.local_all_reduce(cur_param.grad)
-            else:
-                break
-        return ret
-
-    return allreduce
-
-
 def DistributedDataParallel(
-    module: "flow.nn.Module", *, broadcast_buffers: bool = True
+    module: "flow.nn.Module",
+    *,
+    broadcast_buffers: bool = True,
+    bucket_cap_mb: float = 25,
 ):
-    world_size = flow.env.get_world_size()
     with flow.no_grad():
         for x in module.parameters():
             requires_grad = x.requires_grad
@@ -51,18 +31,17 @@ def DistributedDataParallel(
             # after flow._C.broadcast
             x.requires_grad_(requires_grad)
 
-    ddp_state_for_reversed_params = OrderedDict(
-        reversed([(x, [False, False]) for x in module.parameters() if x.requires_grad])
+    reversed_params = [x for x in module.parameters() if x.requires_grad][::-1]
+    module._ddp_reversed_params = reversed_params
+    # Gradients are averaged in buckets of about bucket_cap_mb, each of which is
+    # all-reduced as soon as backward has produced all the gradients in it.
+    module._ddp_reducer = flow._oneflow_internal.DDPReducer(
+        reversed_params, int(bucket_cap_mb * 1024 * 1024)
     )
-    module._ddp_state_for_reversed_params = ddp_state_for_reversed_params
-    for param in module.parameters():
-        param.register_hook(lambda grad: grad / world_size)
-        param.register_hook(allreduce_fn(ddp_state_for_reversed_params, param))
 
     def post_forward_hook(module, input, output):
-        ddp_state_for_reversed_params = module._ddp_state_for_reversed_params
-        for state in ddp_state_for_reversed_params.values():
-            state[0], state[1] = False, False
+        reversed_params = module._ddp_reversed_params
+        module._ddp_reducer.reset()
         if isinstance(output, (tuple, list)):
             if isinstance(output[0], dict):
                 # For List[Dict[Tensor]] return type.
@@ -75,7 +54,7 @@ def DistributedDataParallel(
                     out_val_list.extend(out_values)
                 out_values = flow._C.select_top_n(
                     convert_to_tensor_tuple(
-                        [*out_val_list, *ddp_state_for_reversed_params.keys()]
+                        [*out_val_list, *reversed_params]
                     ),
                     n=len(out_val_list),
                 )
@@ -89,7 +68,7 @@ def DistributedDataParallel(
                 # For List[Tensor] return type.
                 output = flow._C.select_top_n(
                     convert_to_tensor_tuple(
-                        [*output, *ddp_state_for_reversed_params.keys()]
+                        [*output, *reversed_params]
                     ),
                     n=len(output),
                 )
@@ -99,7 +78,7 @@ def DistributedDataParallel(
             out_values = list(output.values())
             out_values = flow._C.select_top_n(
                 convert_to_tensor_tuple(
-                    [*out_values, *ddp_state_for_reversed_params.keys()]
+                    [*out_values, *reversed_params]
                 ),
                 n=len(out_values),
             )
@@ -108,7 +87,7 @@ def DistributedDataParallel(
             # For Tensor return type.
             output = flow._C.select_top_n(
                 convert_to_tensor_tuple(
-                    [output, *ddp_state_for_reversed_params.keys()]
+                    [output, *reversed_params]
                 ),
                 n=1,
             )[0]
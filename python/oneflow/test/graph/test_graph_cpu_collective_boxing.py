@@ -0,0 +1,60 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _test_cpu_collective_boxing(test_case, in_sbp, out_sbp):
+    flow.boxing.cpu.enable_collective_boxing(True)
+    rank = flow.env.get_rank()
+    placement = flow.placement("cpu", {0: range(flow.env.get_world_size())})
+    # integer valued, so sums are exact whatever the order they are taken in
+    local = np.arange(8 * 3, dtype=np.float32).reshape(8, 3) * (rank + 1)
+    x = flow.tensor(local).to_consistent(placement=placement, sbp=in_sbp)
+
+    class BoxingGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+
+        def build(self, x):
+            return x.to_consistent(sbp=out_sbp)
+
+    y = BoxingGraph()(x)
+    expected = x.to_consistent(sbp=out_sbp)
+    test_case.assertEqual(y.sbp, expected.sbp)
+    test_case.assertTrue(
+        np.array_equal(y.to_local().numpy(), expected.to_local().numpy())
+    )
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestGraphCpuCollectiveBoxing(flow.unittest.TestCase):
+    def test_p2b(test_case):
+        _test_cpu_collective_boxing(test_case, flow.sbp.partial_sum, flow.sbp.broadcast)
+
+    def test_p2s(test_case):
+        _test_cpu_collective_boxing(test_case, flow.sbp.partial_sum, flow.sbp.split(0))
+
+    def test_s2b(test_case):
+        _test_cpu_collective_boxing(test_case, flow.sbp.split(0), flow.sbp.broadcast)
+
+
+if __name__ == "__main__":
+    unittest.main()
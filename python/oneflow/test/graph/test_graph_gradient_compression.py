@@ -0,0 +1,79 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _test_linear_train_graph_with_gradient_compression(test_case, method, device="cpu"):
+    P = flow.placement(device, {0: [0, 1]})
+    B = flow.sbp.broadcast
+    S0 = flow.sbp.split(0)
+    linear = flow.nn.Linear(64, 1, bias=False)
+    linear = linear.to_consistent(placement=P, sbp=B)
+    flow.nn.init.constant_(linear.weight, 0)
+    of_sgd = flow.optim.SGD(linear.parameters(), lr=0.1)
+
+    np.random.seed(0)
+    target = np.random.randn(64, 1).astype(np.float32)
+    x_np = np.random.randn(128, 64).astype(np.float32)
+    x = flow.tensor(x_np, placement=P, sbp=S0)
+    y = flow.tensor(np.matmul(x_np, target), placement=P, sbp=S0)
+
+    class LinearTrainGraphWithGradientCompression(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+            self.linear = linear
+            self.add_optimizer(of_sgd)
+            self.config.set_gradient_compression(method, topk_ratio=0.1, min_size=1)
+
+        def build(self, x, y):
+            loss = flow.mean((self.linear(x) - y) ** 2)
+            loss.backward()
+            return loss
+
+    graph = LinearTrainGraphWithGradientCompression()
+    flow._oneflow_internal.ResetGradientCompressionStats()
+    losses = [graph(x, y).to_local().numpy() for _ in range(50)]
+    test_case.assertLess(losses[-1], losses[0] * 0.1)
+
+    stats = flow._oneflow_internal.GetGradientCompressionStats()
+    test_case.assertGreater(stats["num_all_reduce_bytes"], 0)
+    test_case.assertLess(stats["num_wire_bytes"], stats["num_all_reduce_bytes"])
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestLinearTrainGraphWithGradientCompression(oneflow.unittest.TestCase):
+    def test_fp16(test_case):
+        _test_linear_train_graph_with_gradient_compression(test_case, "fp16")
+
+    @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
+    def test_bf16(test_case):
+        _test_linear_train_graph_with_gradient_compression(test_case, "bf16", "cuda")
+
+    def test_topk(test_case):
+        _test_linear_train_graph_with_gradient_compression(test_case, "topk")
+
+    def test_onebit(test_case):
+        _test_linear_train_graph_with_gradient_compression(test_case, "onebit")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,148 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+class _GraphLAMB(flow.optim.Adam):
+    # There is no eager LAMB optimizer, so generate the lamb_conf of the graph job
+    # from the param groups of Adam.
+    def _generate_conf_for_graph(self, train_conf, vars_conf):
+        new_opt_confs = []
+        for param_group in self.param_groups:
+            optimizer_conf = train_conf.mutable_optimizer_conf().Add()
+            optimizer_conf.set_base_learning_rate(param_group["lr"])
+            lamb_conf = optimizer_conf.mutable_lamb_conf()
+            lamb_conf.set_beta1(param_group["betas"][0])
+            lamb_conf.set_beta2(param_group["betas"][1])
+            lamb_conf.set_epsilon(param_group["eps"])
+            for param in param_group.parameters:
+                vars_conf[param].l2 = param_group["weight_decay"]
+                if param.requires_grad:
+                    optimizer_conf.add_variable_op_names(vars_conf[param].name)
+            new_opt_confs.append(optimizer_conf)
+        return new_opt_confs
+
+
+_optimizers = {
+    "sgd": lambda params: flow.optim.SGD(params, lr=0.1, weight_decay=0.01),
+    "momentum": lambda params: flow.optim.SGD(params, lr=0.1, momentum=0.9),
+    "adam": lambda params: flow.optim.Adam(params, lr=0.01, weight_decay=0.01),
+    "lamb": lambda params: _GraphLAMB(params, lr=0.01),
+}
+
+
+def _shape(i):
+    return (i % 7 + 1, 3)
+
+
+def _train(device, optimizer_name, multi_tensor, init_values, inputs):
+    class Model(flow.nn.Module):
+        def __init__(self):
+            super().__init__()
+            for i, value in enumerate(init_values):
+                tensor = flow.tensor(value, device=flow.device(device))
+                setattr(self, "param%d" % i, flow.nn.Parameter(tensor))
+
+        def forward(self, x):
+            loss = 0
+            for i in range(len(init_values)):
+                param = getattr(self, "param%d" % i)
+                loss = loss + flow.sum(param * x[: param.shape[0]])
+            return loss
+
+    model = Model()
+    optimizer = _optimizers[optimizer_name](model.parameters())
+
+    class TrainGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+            self.model = model
+            self.add_optimizer(optimizer)
+            self.config.allow_multi_tensor_model_update(multi_tensor)
+
+        def build(self, x):
+            loss = self.model(x)
+            loss.backward()
+            return loss
+
+    graph = TrainGraph()
+    for x in inputs:
+        graph(flow.tensor(x, device=flow.device(device)))
+    update_ops = [
+        op.user_conf
+        for op in graph._full_graph_proto.net.op
+        if op.HasField("user_conf")
+        and op.user_conf.op_type_name.endswith(optimizer_name + "_update")
+    ]
+    params = [getattr(model, "param%d" % i) for i in range(len(init_values))]
+    return [param.numpy() for param in params], update_ops
+
+
+def _test_multi_tensor_model_update(test_case, device, optimizer_name, num_params):
+    init_values = [
+        np.random.uniform(size=_shape(i)).astype(np.float32) for i in range(num_params)
+    ]
+    inputs = [np.random.uniform(size=(7, 3)).astype(np.float32) for _ in range(5)]
+    expected, single_ops = _train(device, optimizer_name, False, init_values, inputs)
+    actual, multi_ops = _train(device, optimizer_name, True, init_values, inputs)
+    for e, a in zip(expected, actual):
+        test_case.assertTrue(np.allclose(e, a, rtol=1e-5, atol=1e-6))
+
+    test_case.assertEqual(len(single_ops), num_params)
+    for conf in single_ops:
+        test_case.assertEqual(conf.op_type_name, optimizer_name + "_update")
+    # At most 64 models per op, all of them in multi tensor ops.
+    num_models = 0
+    for conf in multi_ops:
+        test_case.assertEqual(
+            conf.op_type_name, "multi_tensor_" + optimizer_name + "_update"
+        )
+        test_case.assertLessEqual(len(conf.input["model"].s), 64)
+        num_models += len(conf.input["model"].s)
+    test_case.assertEqual(num_models, num_params)
+    test_case.assertEqual(len(multi_ops), (num_params + 63) // 64)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestGraphMultiTensorModelUpdate(flow.unittest.TestCase):
+    # More than the 32 models a CUDA launch takes, and more than the 64 models of an op.
+    def _test(test_case, optimizer_name):
+        for device in ["cpu", "cuda"]:
+            for num_params in [40, 70]:
+                _test_multi_tensor_model_update(
+                    test_case, device, optimizer_name, num_params
+                )
+
+    def test_sgd(test_case):
+        test_case._test("sgd")
+
+    def test_momentum(test_case):
+        test_case._test("momentum")
+
+    def test_adam(test_case):
+        test_case._test("adam")
+
+    def test_lamb(test_case):
+        test_case._test("lamb")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -16,6 +16,8 @@ limitations under the License.
 import os
 import unittest
 
+import numpy as np
+
 import oneflow as flow
 import oneflow.unittest
 
@@ -70,5 +72,59 @@ class GraphSparseOptimizerTest(oneflow.unittest.TestCase):
         test_case.assertTrue(sparse_optimizer_found)
 
 
+# After a single step from zero states, rows that are not gathered are left untouched
+# by the dense optimizers as well, so the sparse update matches the dense one.
+def _test_sparse_optimizer_on_cpu(test_case, make_optimizer):
+    np.random.seed(0)
+    init = np.random.randn(10, 10).astype(np.float32)
+    indices = flow.tensor([1, 3, 3, 7, 1, 3, 0, 9], dtype=flow.int64)
+
+    sparse_module = MyModule()
+    sparse_module.weight = flow.nn.Parameter(flow.tensor(init))
+
+    class SparseOptimizerGraph(flow.nn.Graph):
+        def __init__(self):
+            super().__init__()
+            self.m = sparse_module
+            optimizer = make_optimizer(sparse_module.parameters())
+            self.add_optimizer(flow.optim.utils.SparseOptimizer(optimizer))
+
+        def build(self, input):
+            self.m(input).mean().backward()
+
+    SparseOptimizerGraph()(indices)
+
+    dense_module = MyModule()
+    dense_module.weight = flow.nn.Parameter(flow.tensor(init))
+    dense_optimizer = make_optimizer(dense_module.parameters())
+    dense_module(indices).mean().backward()
+    dense_optimizer.step()
+
+    test_case.assertTrue(
+        np.allclose(
+            sparse_module.weight.numpy(), dense_module.weight.numpy(), 1e-5, 1e-5
+        )
+    )
+
+
+@flow.unittest.skip_unless_1n1d()
+class GraphSparseOptimizerCpuTest(oneflow.unittest.TestCase):
+    def test_sgd(test_case):
+        _test_sparse_optimizer_on_cpu(
+            test_case, lambda params: flow.optim.SGD(params, lr=0.1)
+        )
+
+    def test_momentum(test_case):
+        _test_sparse_optimizer_on_cpu(
+            test_case, lambda params: flow.optim.SGD(params, lr=0.1, momentum=0.9)
+        )
+
+    def test_adam(test_case):
+        _test_sparse_optimizer_on_cpu(
+            test_case,
+            lambda params: flow.optim.Adam(params, lr=0.1, do_bias_correction=False),
+        )
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -100,6 +100,65 @@ def _test_linear_train_graph_with_zero(test_case, zero_stage=1):
     graph_check_list = train_with_graph(iter_num)
 
 
+def _test_linear_train_graph_with_zero_on_cpu(test_case, mode):
+    def train_with_graph(use_zero, iter_num=5):
+        P = flow.placement("cpu", {0: [0, 1]})
+        B = flow.sbp.broadcast
+        S0 = flow.sbp.split(0)
+        linear = flow.nn.Linear(8, 4)
+        linear = linear.to_consistent(placement=P, sbp=B)
+        flow.nn.init.constant_(linear.weight, 0.068758)
+        flow.nn.init.constant_(linear.bias, 0.23)
+        of_adam = flow.optim.Adam(linear.parameters(), lr=0.01)
+
+        np.random.seed(0)
+        x = flow.tensor(np.random.randn(4, 8).astype(np.float32), placement=P, sbp=S0)
+
+        class LinearTrainGraphWithZeRO(flow.nn.Graph):
+            def __init__(self):
+                super().__init__()
+                self.linear = linear
+                self.add_optimizer(of_adam)
+                if use_zero:
+                    self.config.set_zero_redundancy_optimizer_mode(mode)
+                    self.config.set_zero_redundancy_optimizer_min_size_after_split(1)
+
+            def build(self, x):
+                loss = (self.linear(x) ** 2).sum()
+                loss.backward()
+                return loss
+
+        linear_t_g = LinearTrainGraphWithZeRO()
+        losses = [linear_t_g(x).to_local().numpy() for _ in range(iter_num)]
+        if use_zero and mode == "distributed_split":
+            # Parameters and the Adam states are split across the ranks.
+            test_case.assertEqual(linear.weight.sbp[0], S0)
+            test_case.assertEqual(linear.bias.sbp[0], S0)
+        if use_zero:
+            # The fp32 weight (4, 8) and bias (4,) each come with two Adam states,
+            # split by rows or placed whole on the rank with the least bytes so far.
+            rank2bytes = linear_t_g._full_graph_proto.helper.rank2optimizer_state_bytes
+            expected_rank2bytes = {
+                "distributed_split": {0: 192 + 24, 1: 192 + 24},
+                "non_distributed": {0: 384, 1: 48},
+            }
+            test_case.assertEqual(dict(rank2bytes), expected_rank2bytes[mode])
+        return losses
+
+    test_case.assertTrue(
+        np.allclose(train_with_graph(True), train_with_graph(False), 1e-4, 1e-4)
+    )
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestLinearTrainGraphWithZeROOnCPU(oneflow.unittest.TestCase):
+    def test_distributed_split(test_case):
+        _test_linear_train_graph_with_zero_on_cpu(test_case, "distributed_split")
+
+    def test_non_distributed(test_case):
+        _test_linear_train_graph_with_zero_on_cpu(test_case, "non_distributed")
+
+
 @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
 @flow.unittest.skip_unless_1n2d()
 class TestLinearTrainGraphWithZeRO(oneflow.unittest.TestCase):
@@ -0,0 +1,60 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Logs the bus bandwidth of the cpu all-reduce of the network path, run with
+# python3 -m oneflow.distributed.launch --nproc_per_node 4 cpu_all_reduce_benchmark.py
+
+import os
+import time
+
+import numpy as np
+
+os.environ.setdefault("ONEFLOW_CCL_SHM", "0")
+
+import oneflow as flow
+
+
+def _all_reduce(x):
+    return x.to_consistent(sbp=flow.sbp.broadcast)
+
+
+def _partial_sum_tensor(np_arr):
+    placement = flow.placement("cpu", {0: range(flow.env.get_world_size())})
+    return flow.tensor(np_arr).to_consistent(
+        placement=placement, sbp=flow.sbp.partial_sum
+    )
+
+
+def _log_cpu_all_reduce_bandwidth(elem_cnt, repeat):
+    world_size = flow.env.get_world_size()
+    x = _partial_sum_tensor(np.ones(elem_cnt, dtype=np.float32))
+    _all_reduce(x).to_local().numpy()
+    start = time.perf_counter()
+    for _ in range(repeat):
+        y = _all_reduce(x)
+    y.to_local().numpy()
+    seconds = (time.perf_counter() - start) / repeat
+    nbytes = elem_cnt * 4
+    bus_bandwidth = 2 * (world_size - 1) / world_size * nbytes / seconds
+    if flow.env.get_rank() == 0:
+        print(
+            "cpu all_reduce {} bytes on {} ranks: {:.3f} ms, bus bandwidth {:.3f} GB/s"
+            .format(nbytes, world_size, seconds * 1e3, bus_bandwidth / 1e9)
+        )
+
+
+if __name__ == "__main__":
+    for elem_cnt in [1 << 10, 1 << 16, 1 << 20, 1 << 24]:
+        _log_cpu_all_reduce_bandwidth(elem_cnt, 10)
@@ -0,0 +1,72 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+# Logs how much independent chains of ops overlap on the cpu streams, run with
+# python3 cpu_multi_stream_benchmark.py
+
+import os
+import time
+
+# Read once when the virtual machine starts.
+os.environ.setdefault("ONEFLOW_VM_CPU_STREAM_NUM_PER_DEVICE", "4")
+# Single threaded kernels, so that only the streams can run them in parallel.
+os.environ.setdefault("OMP_NUM_THREADS", "1")
+
+import oneflow as flow
+
+
+def _run_seconds(chains):
+    start = time.perf_counter()
+    for y in chains():
+        y.numpy()
+    return time.perf_counter() - start
+
+
+def _log_independent_chains_overlap(chain_num, chain_len, repeat):
+    w = flow.randn(256, 256) / 16
+    xs = [flow.randn(256, 256) for _ in range(chain_num)]
+
+    def dependent():
+        y = xs[0]
+        for _ in range(chain_num * chain_len):
+            y = flow.tanh(flow.matmul(y, w))
+        return [y]
+
+    def independent():
+        ys = list(xs)
+        for _ in range(chain_len):
+            ys = [flow.tanh(flow.matmul(y, w)) for y in ys]
+        return ys
+
+    _run_seconds(dependent)
+    _run_seconds(independent)
+    dependent_seconds = min(_run_seconds(dependent) for _ in range(repeat))
+    independent_seconds = min(_run_seconds(independent) for _ in range(repeat))
+    print(
+        "{} chains of {} matmul+tanh on {} cpu streams: dependent {:.3f} ms, "
+        "independent {:.3f} ms, speedup {:.2f}x".format(
+            chain_num,
+            chain_len,
+            os.environ["ONEFLOW_VM_CPU_STREAM_NUM_PER_DEVICE"],
+            dependent_seconds * 1e3,
+            independent_seconds * 1e3,
+            dependent_seconds / independent_seconds,
+        )
+    )
+
+
+if __name__ == "__main__":
+    for chain_num in [2, 4]:
+        _log_independent_chains_overlap(chain_num, 50, 3)
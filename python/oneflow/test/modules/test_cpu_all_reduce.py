@@ -0,0 +1,94 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import os
+import unittest
+
+import numpy as np
+
+# Ranks of one host would otherwise take the shared memory path of cpu_shm_comm.cpp,
+# which has tests of its own. Read when the first collective runs.
+os.environ["ONEFLOW_CCL_SHM"] = "0"
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _all_reduce(x):
+    return x.to_consistent(sbp=flow.sbp.broadcast)
+
+
+def _partial_sum_tensor(np_arr):
+    placement = flow.placement("cpu", {0: range(flow.env.get_world_size())})
+    return flow.tensor(np_arr).to_consistent(
+        placement=placement, sbp=flow.sbp.partial_sum
+    )
+
+
+def _test_cpu_all_reduce(test_case, elem_cnt):
+    rank = flow.env.get_rank()
+    world_size = flow.env.get_world_size()
+    base = np.arange(elem_cnt, dtype=np.float32) % 17
+    y = _all_reduce(_partial_sum_tensor(base + rank))
+    # integer valued, so the result is exact whatever the summation order
+    expected = base * world_size + sum(range(world_size))
+    test_case.assertTrue(np.array_equal(y.to_local().numpy(), expected))
+
+
+def _test_cpu_all_reduce_uneven(test_case, elem_cnt):
+    # every rank contributes a different multiple of a position dependent pattern, so
+    # a chunk reduced from the wrong part or overwritten before the add shows up in the
+    # sum
+    rank = flow.env.get_rank()
+    world_size = flow.env.get_world_size()
+    assert elem_cnt % world_size != 0
+    base = np.arange(elem_cnt, dtype=np.float32) % 251
+    y = _all_reduce(_partial_sum_tensor(base * (rank + 1)))
+    expected = base * (world_size * (world_size + 1) // 2)
+    test_case.assertTrue(np.array_equal(y.to_local().numpy(), expected))
+
+
+class TestCpuAllReduce(flow.unittest.TestCase):
+    # sizes below and above ONEFLOW_CCL_HALVING_DOUBLING_MAX_BYTES, the last one spans
+    # several ring chunks
+    elem_cnts = [1, 3, 1000, 65536, 1 << 20, (1 << 22) + 7]
+
+    @flow.unittest.skip_unless_1n2d()
+    def test_cpu_all_reduce_1n2d(test_case):
+        for elem_cnt in test_case.elem_cnts:
+            _test_cpu_all_reduce(test_case, elem_cnt)
+
+    @flow.unittest.skip_unless_1n4d()
+    def test_cpu_all_reduce_1n4d(test_case):
+        for elem_cnt in test_case.elem_cnts:
+            _test_cpu_all_reduce(test_case, elem_cnt)
+
+    # ring sizes whose parts differ in length, over several chunks per part
+    uneven_elem_cnts = [(1 << 18) + 1, (1 << 20) + 3, (1 << 22) + 5, (1 << 23) + 7]
+
+    @flow.unittest.skip_unless_1n2d()
+    def test_cpu_all_reduce_uneven_1n2d(test_case):
+        for elem_cnt in test_case.uneven_elem_cnts:
+            _test_cpu_all_reduce_uneven(test_case, elem_cnt)
+
+    @flow.unittest.skip_unless_1n4d()
+    def test_cpu_all_reduce_uneven_1n4d(test_case):
+        for elem_cnt in test_case.uneven_elem_cnts:
+            _test_cpu_all_reduce_uneven(test_case, elem_cnt)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,89 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import unittest
+
+import numpy as np
+
+# Read once when the virtual machine starts.
+os.environ["ONEFLOW_VM_CPU_STREAM_NUM_PER_DEVICE"] = "4"
+# Single threaded kernels, so that only the streams can run them in parallel.
+os.environ["OMP_NUM_THREADS"] = "1"
+
+import oneflow as flow
+import oneflow.unittest
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestCpuMultiStream(flow.unittest.TestCase):
+    def test_independent_chains(test_case):
+        np_xs = [np.random.randn(64, 64).astype(np.float32) for _ in range(8)]
+        np_w = np.random.randn(64, 64).astype(np.float32) / 64
+        w = flow.tensor(np_w)
+        ys = []
+        for np_x in np_xs:
+            y = flow.tensor(np_x)
+            for _ in range(5):
+                y = flow.tanh(flow.matmul(y, w))
+            ys.append(y)
+        for np_x, y in zip(np_xs, ys):
+            np_y = np_x
+            for _ in range(5):
+                np_y = np.tanh(np.matmul(np_y, np_w))
+            test_case.assertTrue(np.allclose(y.numpy(), np_y, rtol=1e-4, atol=1e-5))
+
+    def test_dependent_ops(test_case):
+        x = flow.ones(32, 32)
+        y = x
+        for i in range(50):
+            y = flow.relu(y) + flow.sigmoid(y) * 0 + 1
+        test_case.assertTrue(np.array_equal(y.numpy(), np.full((32, 32), 51)))
+
+    def test_inplace(test_case):
+        x = flow.zeros(16)
+        for _ in range(20):
+            y = flow.exp(x)
+            x.add_(1)
+        test_case.assertTrue(np.allclose(y.numpy(), np.full(16, np.exp(19))))
+
+    def test_random_ops(test_case):
+        flow.manual_seed(0)
+        a = flow.rand(100).numpy()
+        flow.manual_seed(0)
+        b = flow.rand(100).numpy()
+        test_case.assertTrue(np.array_equal(a, b))
+
+    @unittest.skipUnless(os.path.exists("/dataset/imagenet_227"), "")
+    def test_reader(test_case):
+        def read_labels(batch_size, batch_num):
+            reader = flow.nn.OFRecordReader(
+                "/dataset/imagenet_227/train/32",
+                batch_size=batch_size,
+                data_part_num=1,
+                random_shuffle=False,
+                shuffle_after_epoch=False,
+            )
+            decoder = flow.nn.OFRecordRawDecoder(
+                "class/label", shape=(), dtype=flow.int32
+            )
+            return np.concatenate([decoder(reader()).numpy() for _ in range(batch_num)])
+
+        # The state of a reader is kept once, whichever stream reads the next batch.
+        test_case.assertTrue(np.array_equal(read_labels(2, 4), read_labels(8, 1)))
+
+
+if __name__ == "__main__":
+    unittest.main()
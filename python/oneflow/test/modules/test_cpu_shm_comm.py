@@ -0,0 +1,74 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import unittest
+
+import numpy as np
+
+# Ranks of one host go through shared memory instead of the network. Read when the
+# first collective runs.
+os.environ["ONEFLOW_CCL_SHM"] = "1"
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _placement():
+    return flow.placement("cpu", {0: range(flow.env.get_world_size())})
+
+
+def _test_all_reduce(test_case, elem_cnt):
+    rank = flow.env.get_rank()
+    world_size = flow.env.get_world_size()
+    base = np.arange(elem_cnt, dtype=np.float32) % 17
+    x = flow.tensor(base * (rank + 1)).to_consistent(
+        placement=_placement(), sbp=flow.sbp.partial_sum
+    )
+    y = x.to_consistent(sbp=flow.sbp.broadcast)
+    expected = base * (world_size * (world_size + 1) // 2)
+    test_case.assertTrue(np.array_equal(y.to_local().numpy(), expected))
+
+
+def _test_all_gather(test_case, elem_cnt):
+    rank = flow.env.get_rank()
+    world_size = flow.env.get_world_size()
+    x = flow.tensor(np.full(elem_cnt, rank, dtype=np.float32)).to_consistent(
+        placement=_placement(), sbp=flow.sbp.split(0)
+    )
+    y = x.to_consistent(sbp=flow.sbp.broadcast)
+    expected = np.repeat(np.arange(world_size, dtype=np.float32), elem_cnt)
+    test_case.assertTrue(np.array_equal(y.to_local().numpy(), expected))
+
+
+class TestCpuShmComm(flow.unittest.TestCase):
+    # the last size is larger than a slot of ONEFLOW_CCL_SHM_SLOT_BYTES
+    elem_cnts = [1, 1000, (1 << 20) + 3]
+
+    @flow.unittest.skip_unless_1n2d()
+    def test_cpu_shm_comm_1n2d(test_case):
+        for elem_cnt in test_case.elem_cnts:
+            _test_all_reduce(test_case, elem_cnt)
+            _test_all_gather(test_case, elem_cnt)
+
+    @flow.unittest.skip_unless_1n4d()
+    def test_cpu_shm_comm_1n4d(test_case):
+        for elem_cnt in test_case.elem_cnts:
+            _test_all_reduce(test_case, elem_cnt)
+            _test_all_gather(test_case, elem_cnt)
+
+
+if __name__ == "__main__":
+    unittest.main()
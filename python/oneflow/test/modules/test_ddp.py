@@ -145,6 +145,43 @@ class TestDDP(flow.unittest.TestCase):
         for dev_type in test_device:
             test_case._test_out_of_order_execution(dev_type)
 
+    def _test_ddp_buckets(test_case, dev_type, bucket_cap_mb, num_buckets):
+        class Model(flow.nn.Module):
+            def __init__(self):
+                super().__init__()
+                self.w1 = flow.nn.Parameter(flow.Tensor([1, 1, 1, 1]))
+                self.w2 = flow.nn.Parameter(flow.Tensor([[2, 2], [2, 2]]))
+                self.w3 = flow.nn.Parameter(flow.Tensor([3, 3, 3, 3]))
+
+            def forward(self, x):
+                x = x * self.w1
+                x = x * self.w2.reshape(4)
+                return x * self.w3
+
+        rank = flow.env.get_rank()
+        x = flow.Tensor([1, 2, 3, 4]) * (rank + 1)
+        x = x.to(dev_type)
+        m = Model().to(dev_type)
+        m = ddp(m, bucket_cap_mb=bucket_cap_mb)
+        test_case.assertEqual(m._ddp_reducer.num_buckets, num_buckets)
+        # The mean of x over both ranks is 1.5 * [1, 2, 3, 4], and gradients accumulate
+        # over iterations.
+        for i in range(2):
+            y = m(x)
+            y.sum().backward()
+            x_mean = np.array([1.5, 3, 4.5, 6]) * (i + 1)
+            test_case.assertTrue(np_allclose_with_shape(m.w1.grad.numpy(), x_mean * 6))
+            test_case.assertTrue(
+                np_allclose_with_shape(m.w2.grad.numpy(), (x_mean * 3).reshape(2, 2))
+            )
+            test_case.assertTrue(np_allclose_with_shape(m.w3.grad.numpy(), x_mean * 2))
+
+    def test_ddp_buckets(test_case):
+        for dev_type in test_device:
+            # All parameters in a bucket, and a bucket for each parameter.
+            test_case._test_ddp_buckets(dev_type, 25, 1)
+            test_case._test_ddp_buckets(dev_type, 16 / 1024 / 1024, 3)
+
     def _test_broadcast_buffer(test_case, dev_type):
         rank = flow.env.get_rank()
 
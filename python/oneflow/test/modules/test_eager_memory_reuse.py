@@ -0,0 +1,86 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _chain(x):
+    # Every temporary is dropped right after the op reading it, so each op after the
+    # first may write into the memory of its input.
+    return flow.relu(flow.clamp(flow.nn.functional.hardtanh(flow.relu(x)), -0.5, 0.5))
+
+
+def _np_chain(x):
+    return np.clip(np.maximum(x, 0), -0.5, 0.5)
+
+
+def _run_chain(enabled):
+    flow.env.enable_eager_memory_reuse(enabled)
+    x = flow.tensor(np.random.randn(256, 1024).astype(np.float32))
+    flow._oneflow_internal.eager.multi_client.Sync()
+    flow.env.reset_eager_memory_stats()
+    live_bytes = flow.env.eager_memory_stats()["cpu_live_bytes"]
+    y = _chain(x).numpy()
+    stats = flow.env.eager_memory_stats()
+    return x.numpy(), y, stats["cpu_peak_bytes"] - live_bytes, stats
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestEagerMemoryReuse(flow.unittest.TestCase):
+    def tearDown(test_case):
+        flow.env.enable_eager_memory_reuse(False)
+
+    def test_unary_chain(test_case):
+        x, y, _, stats = _run_chain(True)
+        test_case.assertTrue(np.allclose(y, _np_chain(x)))
+        test_case.assertGreater(stats["num_reused_blobs"], 0)
+        test_case.assertGreater(stats["num_reused_bytes"], 0)
+
+    def test_disabled(test_case):
+        x, y, _, stats = _run_chain(False)
+        test_case.assertTrue(np.allclose(y, _np_chain(x)))
+        test_case.assertEqual(stats["num_reused_blobs"], 0)
+
+    def test_peak_bytes(test_case):
+        _, _, peak_without_reuse, _ = _run_chain(False)
+        _, _, peak_with_reuse, _ = _run_chain(True)
+        test_case.assertLess(peak_with_reuse, peak_without_reuse)
+
+    def test_live_input_untouched(test_case):
+        flow.env.enable_eager_memory_reuse(True)
+        x_np = np.random.randn(64, 64).astype(np.float32)
+        x = flow.tensor(x_np)
+        t = flow.relu(x)
+        y = flow.nn.functional.hardtanh(t)
+        test_case.assertTrue(np.allclose(t.numpy(), np.maximum(x_np, 0)))
+        test_case.assertTrue(np.allclose(y.numpy(), np.clip(x_np, 0, 1)))
+        test_case.assertTrue(np.array_equal(x.numpy(), x_np))
+
+    def test_backward(test_case):
+        flow.env.enable_eager_memory_reuse(True)
+        x_np = np.random.randn(64, 64).astype(np.float32)
+        x = flow.tensor(x_np, requires_grad=True)
+        _chain(x * 2).sum().backward()
+        grad = np.where((x_np > 0) & (x_np < 0.25), 2, 0).astype(np.float32)
+        test_case.assertTrue(np.allclose(x.grad.numpy(), grad))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,99 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+from oneflow.nn.parameter import Parameter
+
+_shapes = [(4, 5), (7,), (2, 3, 3)]
+
+
+def _train(device, make_optimizer, per_param, init_values, grads_seq):
+    params = [
+        Parameter(flow.tensor(value, device=flow.device(device)))
+        for value in init_values
+    ]
+    # One optimizer per parameter takes the single tensor update path.
+    if per_param:
+        optimizers = [make_optimizer([param]) for param in params]
+    else:
+        optimizers = [make_optimizer(params)]
+    for grads in grads_seq:
+        loss = 0
+        for param, grad in zip(params, grads):
+            grad_tensor = flow.tensor(grad, device=flow.device(device))
+            loss = loss + flow.sum(param * grad_tensor)
+        loss.backward()
+        for optimizer in optimizers:
+            optimizer.step()
+            optimizer.zero_grad()
+    return [param.numpy() for param in params]
+
+
+def _test_multi_tensor_update(test_case, device, make_optimizer):
+    init_values = [
+        np.random.uniform(size=shape).astype(np.float32) for shape in _shapes
+    ]
+    grads_seq = [
+        [np.random.uniform(size=shape).astype(np.float32) for shape in _shapes]
+        for _ in range(5)
+    ]
+    expected = _train(device, make_optimizer, True, init_values, grads_seq)
+    actual = _train(device, make_optimizer, False, init_values, grads_seq)
+    for e, a in zip(expected, actual):
+        test_case.assertTrue(np.allclose(e, a, rtol=1e-5, atol=1e-6))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestMultiTensorOptimizer(flow.unittest.TestCase):
+    def test_sgd(test_case):
+        for device in ["cpu", "cuda"]:
+            _test_multi_tensor_update(
+                test_case,
+                device,
+                lambda params: flow.optim.SGD(params, lr=0.1, weight_decay=0.01),
+            )
+
+    def test_momentum(test_case):
+        for device in ["cpu", "cuda"]:
+            _test_multi_tensor_update(
+                test_case,
+                device,
+                lambda params: flow.optim.SGD(params, lr=0.1, momentum=0.9),
+            )
+
+    def test_adam(test_case):
+        for device in ["cpu", "cuda"]:
+            _test_multi_tensor_update(
+                test_case,
+                device,
+                lambda params: flow.optim.Adam(params, lr=0.01, weight_decay=0.01),
+            )
+
+    def test_adamw(test_case):
+        for device in ["cpu", "cuda"]:
+            _test_multi_tensor_update(
+                test_case,
+                device,
+                lambda params: flow.optim.AdamW(params, lr=0.01, weight_decay=0.01),
+            )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,100 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _run_chain(x, w):
+    y = x
+    for _ in range(10):
+        y = flow.relu(flow.matmul(y, w)) + x
+    return y.numpy()
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestSchedulePriority(flow.unittest.TestCase):
+    def test_instruction_priority(test_case):
+        np_x = np.random.randn(16, 32).astype(np.float32)
+        np_w = np.random.randn(32, 32).astype(np.float32) / 32
+        x = flow.tensor(np_x)
+        w = flow.tensor(np_w)
+        expected = _run_chain(x, w)
+        for priority in ["low", "normal", "high"]:
+            with flow.env.schedule_priority(priority):
+                y = _run_chain(x, w)
+            test_case.assertTrue(np.array_equal(y, expected))
+
+    def test_interleaved_priorities(test_case):
+        x = flow.ones(64, 64)
+        with flow.env.schedule_priority("low"):
+            low = [x * i for i in range(20)]
+        with flow.env.schedule_priority("high"):
+            high = [x + i for i in range(20)]
+        for i in range(20):
+            test_case.assertTrue(np.array_equal(low[i].numpy(), np.full((64, 64), i)))
+            test_case.assertTrue(
+                np.array_equal(high[i].numpy(), np.full((64, 64), i + 1))
+            )
+
+    def test_priority_scope(test_case):
+        get_priority = flow._oneflow_internal.vm.ThreadLocalSchedulePriority
+        scope = flow.env.schedule_priority("high")
+        # Creating the context manager alone changes nothing.
+        test_case.assertEqual(get_priority(), "stream")
+        with scope:
+            test_case.assertEqual(get_priority(), "high")
+            with flow.env.schedule_priority("low"):
+                test_case.assertEqual(get_priority(), "low")
+            test_case.assertEqual(get_priority(), "high")
+            with test_case.assertRaises(Exception):
+                scope.__enter__()
+        test_case.assertEqual(get_priority(), "stream")
+        # A context manager may be entered again once exited.
+        with scope:
+            test_case.assertEqual(get_priority(), "high")
+        test_case.assertEqual(get_priority(), "stream")
+
+    def test_mixed_priorities_keep_dependency_order(test_case):
+        # Every op reads the output of the op before it, built under another priority,
+        # so running an op ahead of its input would change the result.
+        priorities = ["low", "high", "normal"]
+        np_y = np.ones((8, 8), dtype=np.float32)
+        y = flow.tensor(np_y)
+        for i in range(20):
+            with flow.env.schedule_priority(priorities[i % 3]):
+                y = y * 2 - i
+            np_y = np_y * 2 - i
+        test_case.assertTrue(np.array_equal(y.numpy(), np_y))
+
+    def test_stream_priority(test_case):
+        x = flow.ones(4, 4)
+        flow.env.set_stream_schedule_priority("cpu", "high")
+        try:
+            test_case.assertTrue(np.array_equal((x + x).numpy(), np.full((4, 4), 2)))
+        finally:
+            flow.env.set_stream_schedule_priority("cpu", "normal")
+
+    def test_invalid_priority(test_case):
+        with test_case.assertRaises(Exception):
+            flow.env.schedule_priority("urgent")
+
+
+if __name__ == "__main__":
+    unittest.main()
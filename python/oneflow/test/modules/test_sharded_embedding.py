@@ -0,0 +1,164 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import shutil
+import tempfile
+import unittest
+import uuid
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _make_embedding(
+    test_case, path=None, optimizer="sgd", cache_capacity=4, name=None, lr=0.1
+):
+    if path is None:
+        path = tempfile.mkdtemp()
+        test_case.addCleanup(shutil.rmtree, path)
+    embedding = flow.nn.ShardedEmbedding(
+        name=uuid.uuid4().hex if name is None else name,
+        embedding_dim=3,
+        path=path,
+        cache_capacity=cache_capacity,
+        optimizer=optimizer,
+        lr=lr,
+        seed=1,
+    )
+    # Cleanups run last in first out, so the files are released before they are removed.
+    test_case.addCleanup(embedding.close)
+    return embedding
+
+
+def _test_lookup(test_case):
+    embedding = _make_embedding(test_case)
+    ids = flow.tensor([[5, 7, 5], [100, 7, 9]], dtype=flow.int64)
+    out = embedding(ids).numpy()
+    test_case.assertEqual(out.shape, (2, 3, 3))
+    test_case.assertTrue(np.array_equal(out[0, 0], out[0, 2]))
+    test_case.assertTrue(np.array_equal(out[0, 1], out[1, 1]))
+    test_case.assertFalse(np.array_equal(out[0, 0], out[0, 1]))
+    test_case.assertTrue(np.all(np.abs(out) <= 0.05))
+    # Rows are initialized from the id and the seed, the same in every table.
+    other = _make_embedding(test_case)(flow.tensor([9, 5], dtype=flow.int32)).numpy()
+    test_case.assertTrue(np.array_equal(other, out[[1, 0], [2, 0]]))
+
+
+def _test_update(test_case, optimizer):
+    # More ids than the cache holds, so that the rows go to disk and back.
+    embedding = _make_embedding(test_case, optimizer=optimizer, cache_capacity=4)
+    ids = flow.tensor(np.arange(64).repeat(2), dtype=flow.int64)
+    before = embedding(ids).numpy()
+    embedding(ids).sum().backward()
+    after = embedding(ids).numpy()
+    # Every row has got a gradient of 2 from its two ids.
+    if optimizer == "sgd":
+        expected = before - 0.1 * 2
+    else:
+        expected = before - 0.1 * 2 / (2 + 1e-10)
+    test_case.assertTrue(np.allclose(after, expected, 1e-5, 1e-5))
+    test_case.assertTrue(np.array_equal(embedding.shadow.grad.numpy(), [0]))
+
+
+def _test_set_lr(test_case):
+    embedding = _make_embedding(test_case, lr=0.1)
+    ids = flow.tensor([1, 2, 3], dtype=flow.int64)
+    before = embedding(ids).numpy()
+    embedding(ids).sum().backward()
+    embedding.set_lr(0.5)
+    embedding(ids).sum().backward()
+    after = embedding(ids).numpy()
+    test_case.assertTrue(np.allclose(after, before - 0.1 - 0.5, 1e-5, 1e-5))
+
+
+def _test_checkpoint_and_reopen(test_case):
+    path = tempfile.mkdtemp()
+    test_case.addCleanup(shutil.rmtree, path)
+    name = uuid.uuid4().hex
+    embedding = _make_embedding(test_case, path=path, name=name)
+    ids = flow.tensor(np.arange(32), dtype=flow.int64)
+    embedding(ids).sum().backward()
+    embedding.checkpoint()
+    updated = embedding(ids).numpy()
+    embedding.close()
+    # Another table with the same path gets the updated rows back from disk.
+    other = _make_embedding(test_case, path=path, name=name, cache_capacity=16)
+    test_case.assertTrue(np.array_equal(other(ids).numpy(), updated))
+
+
+def _test_consistent_lookup(test_case):
+    P = flow.placement("cpu", {0: [0, 1]})
+    B = flow.sbp.broadcast
+    S0 = flow.sbp.split(0)
+
+    def gather(local):
+        return local.to_consistent(placement=P, sbp=S0).to_consistent(sbp=B)
+
+    # The attributes of a consistent op have to be the same on all the ranks, so every
+    # rank uses the directory named by rank 0.
+    token = gather(flow.tensor([uuid.uuid4().int >> 65], dtype=flow.int64))
+    path = os.path.join(
+        tempfile.gettempdir(),
+        "oneflow_test_sharded_embedding_%d" % token.to_local().numpy()[0],
+    )
+    os.makedirs(path, exist_ok=True)
+
+    def remove_path():
+        # Wait for the other rank to release its files too.
+        gather(flow.tensor([0], dtype=flow.int64)).to_local().numpy()
+        if flow.env.get_rank() == 0:
+            shutil.rmtree(path)
+
+    test_case.addCleanup(remove_path)
+    ids_np = np.array([3, 1, 4, 1, 5, 9, 2, 6], dtype=np.int64)
+    local_out = _make_embedding(test_case)(flow.tensor(ids_np)).numpy()
+    embedding = _make_embedding(
+        test_case, path=path, cache_capacity=16, name="consistent_lookup"
+    )
+    embedding = embedding.to_consistent(placement=P, sbp=B)
+    ids = flow.tensor(ids_np, placement=P, sbp=S0)
+    out = embedding(ids.to_consistent(sbp=B)).to_consistent(sbp=B)
+    test_case.assertTrue(np.array_equal(out.to_local().numpy(), local_out))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestShardedEmbedding(flow.unittest.TestCase):
+    def test_lookup(test_case):
+        _test_lookup(test_case)
+
+    def test_sgd_update(test_case):
+        _test_update(test_case, "sgd")
+
+    def test_adagrad_update(test_case):
+        _test_update(test_case, "adagrad")
+
+    def test_set_lr(test_case):
+        _test_set_lr(test_case)
+
+    def test_checkpoint_and_reopen(test_case):
+        _test_checkpoint_and_reopen(test_case)
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestConsistentShardedEmbedding(flow.unittest.TestCase):
+    def test_consistent_lookup(test_case):
+        _test_consistent_lookup(test_case)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,81 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import threading
+import time
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestVmInstructionBuffer(flow.unittest.TestCase):
+    def test_fewer_ops_than_buffer(test_case):
+        x = flow.ones(4, 4)
+        y = x + 1
+        test_case.assertTrue(np.array_equal(y.numpy(), np.full((4, 4), 2)))
+
+    def test_long_chain(test_case):
+        y = flow.zeros(8, 8)
+        for _ in range(100):
+            y = y + 1
+        test_case.assertTrue(np.array_equal(y.numpy(), np.full((8, 8), 100)))
+
+    def test_inplace_then_read(test_case):
+        x = flow.zeros(16)
+        for _ in range(7):
+            x.add_(2)
+        test_case.assertEqual(x.sum().item(), 16 * 14)
+
+    def test_tensor_made_on_other_thread(test_case):
+        # The ops making the tensor wait in the buffer of the other thread, and the
+        # ops using it must still run after them.
+        made = []
+
+        def Make():
+            y = flow.ones(32)
+            for _ in range(3):
+                y = y * 2
+            made.append(y)
+
+        thread = threading.Thread(target=Make)
+        thread.start()
+        thread.join()
+        z = made[0] + 1
+        test_case.assertTrue(np.array_equal(z.numpy(), np.full(32, 9)))
+
+    def test_run_without_read(test_case):
+        # Nothing reads or syncs, the buffered op must still run once the vm goes idle.
+        np_arr = np.zeros(16, dtype=np.float32)
+        x = flow.from_numpy(np_arr)
+        x.add_(1)
+        deadline = time.time() + 10
+        while not np.all(np_arr == 1) and time.time() < deadline:
+            time.sleep(0.01)
+        test_case.assertTrue(np.array_equal(np_arr, np.ones(16, dtype=np.float32)))
+
+    def test_sync(test_case):
+        x = flow.ones(4)
+        for _ in range(3):
+            x = x * 3
+        flow._oneflow_internal.eager.multi_client.Sync()
+        test_case.assertTrue(np.array_equal(x.numpy(), np.full(4, 27)))
+
+
+if __name__ == "__main__":
+    unittest.main()
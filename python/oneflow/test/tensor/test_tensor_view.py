@@ -0,0 +1,106 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+def _arange(*shape, requires_grad=False):
+    np_arr = np.arange(np.prod(shape), dtype=np.float32).reshape(shape)
+    return np_arr, flow.tensor(np_arr, requires_grad=requires_grad)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestTensorView(flow.unittest.TestCase):
+    def test_slice_view(test_case):
+        np_arr, x = _arange(3, 4)
+        y = x[:, 1:4:2]
+        test_case.assertEqual(y.shape, flow.Size([3, 2]))
+        test_case.assertEqual(y.stride(), (4, 2))
+        test_case.assertEqual(y.storage_offset(), 1)
+        test_case.assertFalse(y.is_contiguous())
+        test_case.assertTrue(np.array_equal(y.numpy(), np_arr[:, 1:4:2]))
+        x[0, 1] = -1
+        test_case.assertEqual(y[0, 0].numpy(), -1)
+
+    def test_narrow_view(test_case):
+        np_arr, x = _arange(4, 3)
+        y = x.narrow(0, 1, 2)
+        test_case.assertEqual(y.stride(), (3, 1))
+        test_case.assertEqual(y.storage_offset(), 3)
+        test_case.assertTrue(y.is_contiguous())
+        test_case.assertTrue(np.array_equal(y.numpy(), np_arr[1:3]))
+        y.add_(1)
+        test_case.assertTrue(np.array_equal(x.numpy()[1:3], np_arr[1:3] + 1))
+
+    def test_transpose_view(test_case):
+        np_arr, x = _arange(2, 3, 4)
+        y = x.permute(2, 0, 1)
+        test_case.assertEqual(y.stride(), (1, 12, 4))
+        test_case.assertFalse(y.is_contiguous())
+        test_case.assertTrue(
+            np.array_equal((y + 1).numpy(), np.transpose(np_arr, (2, 0, 1)) + 1)
+        )
+        z = y.contiguous()
+        test_case.assertTrue(z.is_contiguous())
+        test_case.assertEqual(z.stride(), (6, 3, 1))
+        test_case.assertTrue(np.array_equal(z.numpy(), np.transpose(np_arr, (2, 0, 1))))
+
+    def test_expand_squeeze_unsqueeze_view(test_case):
+        np_arr, x = _arange(3, 1)
+        y = x.expand(2, 3, 4)
+        test_case.assertEqual(y.stride(), (0, 1, 0))
+        test_case.assertTrue(
+            np.array_equal(y.sum().numpy(), np.broadcast_to(np_arr, (2, 3, 4)).sum())
+        )
+        test_case.assertEqual(x.squeeze(1).stride(), (1,))
+        _, x = _arange(2, 3)
+        test_case.assertEqual(x.t().unsqueeze(0).stride(), (3, 1, 3))
+        test_case.assertEqual(x.t().unsqueeze(2).stride(), (1, 3, 1))
+
+    def test_view_backward(test_case):
+        np_arr, x = _arange(4, 3, requires_grad=True)
+        y = x.transpose(0, 1)[1:, ::2].unsqueeze(0).expand(2, 2, 2)
+        (y * y).sum().backward()
+        np_grad = np.zeros_like(np_arr)
+        np_grad[::2, 1:] = 4 * np_arr[::2, 1:]
+        test_case.assertTrue(np.allclose(x.grad.numpy(), np_grad))
+        test_case.assertTrue(x.grad.is_contiguous())
+
+    def test_inplace_on_non_contiguous_view(test_case):
+        np_arr, x = _arange(3, 4)
+        y = x.t()
+        y.mul_(2)
+        test_case.assertFalse(y.is_contiguous())
+        test_case.assertTrue(np.array_equal(x.numpy(), np_arr * 2))
+        test_case.assertTrue(np.array_equal(y.numpy(), (np_arr * 2).T))
+
+        np_arr = np.arange(24, dtype=np.float32).reshape(2, 3, 4) - 12
+        x = flow.tensor(np_arr)
+        flow.nn.functional.relu(x.permute(2, 0, 1), inplace=True)
+        test_case.assertTrue(np.array_equal(x.numpy(), np.maximum(np_arr, 0)))
+
+        np_arr, x = _arange(3, 4)
+        x[:, 1:4:2].add_(1)
+        np_arr[:, 1:4:2] += 1
+        test_case.assertTrue(np.array_equal(x.numpy(), np_arr))
+
+
+if __name__ == "__main__":
+    unittest.main()